@@ -180,27 +180,15 @@
 /* Define to 1 if you have the `free' function. */
 #define HAVE_FREE 1
 
+/* Define to 1 if you have the `fseeko64' function. */
+#define HAVE_FSEEKO64 1
+
 /* Define to 1 if you have the `fstat' function. */
 #define HAVE_FSTAT 1
 
 /* Define to 1 if you have the `gettimeofday' function. */
 #define HAVE_GETTIMEOFDAY 1
 
-/* Define to 1 if you have the `gsl_fft_complex_backward' function. */
-#define HAVE_GSL_FFT_COMPLEX_BACKWARD 1
-
-/* Define to 1 if you have the `gsl_fft_complex_forward' function. */
-#define HAVE_GSL_FFT_COMPLEX_FORWARD 1
-
-/* Define to 1 if you have the `gsl_fft_complex_workspace_alloc' function. */
-#define HAVE_GSL_FFT_COMPLEX_WORKSPACE_ALLOC 1
-
-/* Define to 1 if you have the `gsl_fft_complex_workspace_free' function. */
-#define HAVE_GSL_FFT_COMPLEX_WORKSPACE_FREE 1
-
-/* Define to 1 if you have the <gsl/gsl_fft_complex.h> header file. */
-#define HAVE_GSL_GSL_FFT_COMPLEX_H 1
-
 /* Define to 1 if you have the <half.h> header file. */
 #define HAVE_HALF_H 1
 
@@ -435,6 +423,9 @@
 /* Define to 1 if you have the `write' function. */
 #define HAVE_WRITE 1
 
+/* Define to 1 if you have the <zlib.h> header file. */
+#define HAVE_ZLIB_H 1
+
 /* Define to 1 if the system has the type `__int64'. */
 /* #undef HAVE___INT64 */
 
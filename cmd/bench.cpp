@@ -0,0 +1,916 @@
+/*************************************************************************
+** Written by Thomas Richter (THOR Software) for Accusoft	        **
+** All Rights Reserved							**
+**************************************************************************
+
+This source file is part of difftest_ng, a universal image measuring
+and conversion framework.
+
+    difftest_ng is free software: you can redistribute it and/or modify
+    it under the terms of the GNU General Public License as published by
+    the Free Software Foundation, either version 3 of the License, or
+    (at your option) any later version.
+
+    difftest_ng is distributed in the hope that it will be useful,
+    but WITHOUT ANY WARRANTY; without even the implied warranty of
+    MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+    GNU General Public License for more details.
+
+    You should have received a copy of the GNU General Public License
+    along with difftest_ng.  If not, see <http://www.gnu.org/licenses/>.
+
+*************************************************************************/
+/*
+ * Benchmark all meters and the image loaders and savers on synthetic
+ * images, report the throughput and compare it against a baseline.
+ * 
+ * $Id$
+ */
+
+/// Includes
+#include "std/stdio.hpp"
+#include "std/string.hpp"
+#include "std/stdlib.hpp"
+#include "interface/types.hpp"
+#include "diff/psnr.hpp"
+#include "diff/pre.hpp"
+#include "diff/diffimg.hpp"
+#include "diff/suppress.hpp"
+#include "diff/fftimg.hpp"
+#include "diff/restrict.hpp"
+#include "diff/restore.hpp"
+#include "diff/thres.hpp"
+#include "diff/compare.hpp"
+#include "diff/maxfreq.hpp"
+#include "diff/fftfilt.hpp"
+#include "diff/dimension.hpp"
+#include "diff/histogram.hpp"
+#include "diff/colorhist.hpp"
+#include "diff/convertimg.hpp"
+#include "diff/invert.hpp"
+#include "diff/flip.hpp"
+#include "diff/flipextend.hpp"
+#include "diff/shift.hpp"
+#include "diff/scale.hpp"
+#include "diff/crop.hpp"
+#include "diff/mrse.hpp"
+#include "diff/ycbcr.hpp"
+#include "diff/xyz.hpp"
+#include "diff/sim2.hpp"
+#include "diff/mask.hpp"
+#include "diff/stripe.hpp"
+#include "diff/add.hpp"
+#include "diff/peakpos.hpp"
+#include "diff/mapping.hpp"
+#include "diff/downsampler.hpp"
+#include "diff/upsampler.hpp"
+#include "diff/clamp.hpp"
+#include "diff/fill.hpp"
+#include "diff/paste.hpp"
+#include "diff/bayerconv.hpp"
+#include "diff/debayer.hpp"
+#include "diff/bayercolor.hpp"
+#include "diff/tobayer.hpp"
+#include "diff/whitebalance.hpp"
+#include "diff/fromgrey.hpp"
+#include "diff/butterfly.hpp"
+#include "diff/extractfield.hpp"
+#include "diff/mergefields.hpp"
+#include "tools/threadpool.hpp"
+#include "tools/timer.hpp"
+#include "img/imglayout.hpp"
+#include "img/imgspecs.hpp"
+#include "img/blankimg.hpp"
+#include <new>
+///
+
+/// Sample types
+// The sample types the synthetic images are created in.
+static const struct SampleType {
+  const char *name;
+  UBYTE       bits;
+  bool        isfloat;
+} SampleTypes[] = {
+  {"8"    , 8,false},
+  {"10"   ,10,false},
+  {"12"   ,12,false},
+  {"16"   ,16,false},
+  {"half" ,16,true },
+  {"float",32,true },
+  {NULL   , 0,false}
+};
+///
+
+/// Image sizes
+// The dimensions of the synthetic images.
+static const struct ImageSize {
+  const char *name;
+  ULONG       width;
+  ULONG       height;
+} ImageSizes[] = {
+  {"1080p",1920,1080},
+  {"4k"   ,3840,2160},
+  {"8k"   ,7680,4320},
+  {NULL   ,   0,   0}
+};
+///
+
+/// Depths
+// The number of components of the synthetic images, zero terminated.
+static const UWORD Depths[] = {1,3,4,0};
+///
+
+/// Formats
+// The file name extensions of the formats the savers and loaders are
+// timed on. Formats that cannot represent an image are skipped.
+static const char *Formats[] = {
+  ".pnm",".pfm",".pfs",".bmp",".pgx",".tif",".png",".exr",".hdr",".dpx",NULL
+};
+///
+
+/// struct Scene
+// Everything the meters need to know about the images they measure.
+struct Scene {
+  //
+  // Dimensions of the images.
+  ULONG width,height;
+  //
+  // The largest sample value.
+  double max;
+  //
+  // The scratch file meters writing images write to, and a mask image
+  // of the size of the images.
+  char target[1024];
+  char mask[1024];
+  //
+  // One fill value, white balance factor and offset per component.
+  char fill[64];
+  char factors[64];
+  char offsets[64];
+  //
+  // The images the restore meter restores.
+  class ImageLayout *orgcpy,*dstcpy;
+  //
+  // Default specifications for the images written.
+  struct ImgSpecs specs;
+};
+///
+
+/// struct Result
+// The timing of one benchmark case.
+struct Result {
+  struct Result *next;
+  //
+  // The case, as meter/type/depth/size.
+  char   name[128];
+  //
+  // Median and minimum time of a run in seconds.
+  double median;
+  double min;
+  //
+  // The throughput in Mpixels per second, derived from the median.
+  double mpixels;
+};
+///
+
+/// class SyntheticLayout
+// The layout of a synthetic image without any memory. The memory is
+// allocated by a BlankImg created from it.
+class SyntheticLayout : public ImageLayout {
+public:
+  SyntheticLayout(ULONG width,ULONG height,UWORD depth,UBYTE bits,bool isfloat)
+  {
+    UWORD c;
+
+    CreateComponents(width,height,depth);
+    for(c = 0;c < depth;c++) {
+      m_pComponent[c].m_ucBits = bits;
+      m_pComponent[c].m_bFloat = isfloat;
+    }
+  }
+};
+///
+
+/// Synthesize
+// Fill a component with a deterministic pattern in [0,1], a ramp
+// overlaid with noise, scaled to the given maximum. The distorted
+// image adds further noise of the given amplitude.
+template<typename T>
+static void Synthesize(T *data,ULONG bpp,ULONG bpr,ULONG w,ULONG h,UWORD comp,
+		       double max,double round,double distortion)
+{
+  ULONG x,y;
+  ULONG seed  = 0x12345678UL + comp;
+  ULONG dseed = 0x9abcdef0UL + comp;
+
+  for(y = 0;y < h;y++) {
+    T *p = data;
+    for(x = 0;x < w;x++) {
+      double v;
+      seed = ULONG(seed * 1664525UL + 1013904223UL);
+      v    = ((x + 2 * y + 64 * comp) & 1023) / 1024.0 * 0.75 + ((seed >> 8) & 0xffff) / 65536.0 * 0.25;
+      if (distortion > 0.0) {
+	dseed = ULONG(dseed * 1664525UL + 1013904223UL);
+	v    += (((dseed >> 8) & 0xffff) / 65536.0 - 0.5) * distortion;
+	if (v < 0.0)
+	  v = 0.0;
+	if (v > 1.0)
+	  v = 1.0;
+      }
+      *p = T(v * max + round);
+      p  = (T *)((UBYTE *)p + bpp);
+    }
+    data = (T *)((UBYTE *)data + bpr);
+  }
+}
+///
+
+/// CreateImage
+// Create a synthetic image of the given dimensions and sample type.
+static class ImageLayout *CreateImage(ULONG width,ULONG height,UWORD depth,
+				      const struct SampleType *type,double distortion)
+{
+  class SyntheticLayout layout(width,height,depth,type->bits,type->isfloat);
+  class BlankImg *img = new class BlankImg(layout);
+  UWORD c;
+
+  try {
+    img->BlankSeparate();
+    for(c = 0;c < depth;c++) {
+      if (type->isfloat) {
+	Synthesize((FLOAT *)img->DataOf(c),img->BytesPerPixel(c),img->BytesPerRow(c),
+		   width,height,c,1.0,0.0,distortion);
+      } else if (type->bits <= 8) {
+	Synthesize((UBYTE *)img->DataOf(c),img->BytesPerPixel(c),img->BytesPerRow(c),
+		   width,height,c,(1UL << type->bits) - 1,0.5,distortion);
+      } else {
+	Synthesize((UWORD *)img->DataOf(c),img->BytesPerPixel(c),img->BytesPerRow(c),
+		   width,height,c,(1UL << type->bits) - 1,0.5,distortion);
+      }
+    }
+  } catch(...) {
+    delete img;
+    throw;
+  }
+
+  return img;
+}
+///
+
+/// CopyImage
+// Create a copy of a synthetic image including the samples, such that
+// meters modifying the images start from the same data on every run.
+static class ImageLayout *CopyImage(const class ImageLayout *src)
+{
+  class BlankImg *img = new class BlankImg(*src);
+  UWORD c;
+
+  try {
+    img->BlankSeparate();
+  } catch(...) {
+    delete img;
+    throw;
+  }
+
+  for(c = 0;c < src->DepthOf();c++) {
+    memcpy(img->DataOf(c),src->DataOf(c),size_t(src->BytesPerRow(c)) * src->HeightOf(c));
+  }
+
+  return img;
+}
+///
+
+/// CreateMask
+// Create a mask image of the given size in the scratch directory.
+static void CreateMask(const char *filename,ULONG width,ULONG height)
+{
+  class SyntheticLayout layout(width,height,1,8,false);
+  class BlankImg mask(layout);
+  class Fill fill("255");
+
+  mask.BlankSeparate();
+  fill.Measure(&mask,&mask,0.0);
+  mask.SaveImage(filename);
+}
+///
+
+/// CreateMeter
+// Create the meter with the given index for the scene and return its
+// name, or return NULL if the index is beyond the last meter.
+static class Meter *CreateMeter(ULONG idx,struct Scene &s,const char *&name)
+{
+  ULONG w = s.width;
+  ULONG h = s.height;
+  
+  switch(idx) {
+  case  0: name = "psnr";        return new class PSNR(PSNR::Mean);
+  case  1: name = "mse";         return new class PSNR(PSNR::Mean,true);
+  case  2: name = "snr";         return new class PSNR(PSNR::Mean,false,true,true);
+  case  3: name = "minpsnr";     return new class PSNR(PSNR::Min);
+  case  4: name = "ycbcrpsnr";   return new class PSNR(PSNR::YCbCr);
+  case  5: name = "swpsnr";      return new class PSNR(PSNR::SamplingWeighted);
+  case  6: name = "mrse";        return new class MRSE(MRSE::Mean);
+  case  7: name = "peak";        return new class PRE(PRE::Min);
+  case  8: name = "avgpeak";     return new class PRE(PRE::Mean);
+  case  9: name = "peakx";       return new class PeakPos(PeakPos::PeakX);
+  case 10: name = "mae";         return new class Thres(Thres::Avg);
+  case 11: name = "pae";         return new class Thres(Thres::Peak);
+  case 12: name = "drift";       return new class Thres(Thres::Drift);
+  case 13: name = "toe";         return new class Thres(Thres::Toe);
+  case 14: name = "width";       return new class Dimension(Dimension::Width);
+  case 15: name = "stripe";      return new class Stripe();
+  case 16: name = "diff";        return new class DiffImg(s.target,s.specs,true);
+  case 17: name = "butterfly";   return new class Butterfly(s.target,s.specs);
+  case 18: name = "topfield";    return new class ExtractField(false);
+  case 19: name = "mergefields"; return new class MergeFields();
+  case 20: name = "suppress";    return new class Suppress(1.0);
+  case 21: name = "mask";        return new class Mask(s.mask,false);
+  case 22: name = "convert";     return new class ConvertImg(s.target,s.specs);
+  case 23: name = "merge";       return new class AddImg(s.target,s.specs);
+  case 24: name = "fft";         return new class FFTImg(s.target,false);
+  case 25: name = "wfft";        return new class FFTImg(s.target,true);
+  case 26: name = "filt";        return new class FFTFilt(s.target,w >> 3,h >> 3,16,false,0,0);
+  case 27: name = "maxfreqr";    return new class MaxFreq(MaxFreq::MaxR);
+  case 28: name = "maxfreqv";    return new class MaxFreq(MaxFreq::Var);
+  case 29: name = "patternidx";  return new class MaxFreq(MaxFreq::Pattern);
+  case 30: name = "hist";        return new class Histogram(s.target);
+  case 31: name = "colorhist";   return new class ColorHistogram(16.0 / s.max);
+  case 32: name = "toycbcr";     return new class YCbCr(false,false,false,YCbCr::YCbCr_Trafo);
+  case 33: name = "fromycbcr";   return new class YCbCr(true ,false,false,YCbCr::YCbCr_Trafo);
+  case 34: name = "torct";       return new class YCbCr(false,false,false,YCbCr::RCT_Trafo);
+  case 35: name = "toycgco";     return new class YCbCr(false,false,false,YCbCr::YCgCo_Trafo);
+  case 36: name = "toxyz";       return new class XYZ(XYZ::RGBtoXYZ,false);
+  case 37: name = "tolms";       return new class XYZ(XYZ::RGBtoLMS,false);
+  case 38: name = "tosim2";      return new class Sim2();
+  case 39: name = "fromgrey";    return new class FromGrey();
+  case 40: name = "tobayer";     return new class BayerConv(true,false,false);
+  case 41: name = "frombayer";   return new class BayerConv(false,false,false);
+  case 42: name = "debayer";     return new class Debayer(Debayer::Bilinear,Debayer::RGGB);
+  case 43: name = "debayerahd";  return new class Debayer(Debayer::ADH,Debayer::RGGB);
+  case 44: name = "torctd1";     return new class BayerColor(false,BayerColor::RCTD,BayerColor::RGGB);
+  case 45: name = "rgbtobayer";  return new class ToBayer(ToBayer::RGGB);
+  case 46: name = "asflt";       return new class Scale(NULL,false,true,false,false,32,false,s.specs);
+  case 47: name = "ashfl";       return new class Scale(NULL,false,true,false,false,16,false,s.specs);
+  case 48: name = "asuns";       return new class Scale(NULL,true,false,true,false,16,false,s.specs);
+  case 49: name = "togamma";     return new class Mapping(NULL,Mapping::Gamma,2.2,false,16,true,s.specs);
+  case 50: name = "fromgamma";   return new class Mapping(NULL,Mapping::Gamma,2.2,true,0,true,s.specs);
+  case 51: name = "topq";        return new class Mapping(NULL,Mapping::PQ,1.0,false,12,true,s.specs);
+  case 52: name = "frompq";      return new class Mapping(NULL,Mapping::PQ,1.0,true,0,true,s.specs);
+  case 53: name = "tohlg";       return new class Mapping(NULL,Mapping::HLG,1.0,false,12,true,s.specs);
+  case 54: name = "tohalflog";   return new class Mapping(NULL,Mapping::HalfLog,1.0,false,16,true,s.specs);
+  case 55: name = "tolog";       return new class Mapping(NULL,Mapping::Log,1e-4,false,32,true,s.specs);
+  case 56: name = "topercept";   return new class Mapping(NULL,Mapping::PU2,0.0,false,32,true,s.specs);
+  case 57: name = "scale";       return new class WhiteBalance(WhiteBalance::Scale,s.factors);
+  case 58: name = "offset";      return new class WhiteBalance(WhiteBalance::Shift,s.offsets);
+  case 59: name = "sub";         return new class Downsampler(2,2,false);
+  case 60: name = "csub";        return new class Downsampler(2,2,true);
+  case 61: name = "up";          return new class Upsampler(2,2,false,Upsampler::Centered);
+  case 62: name = "coup";        return new class Upsampler(2,2,false,Upsampler::Cosited);
+  case 63: name = "boxup";       return new class Upsampler(2,2,false,Upsampler::Boxed);
+  case 64: name = "flipx";       return new class Flip(Flip::FlipX);
+  case 65: name = "flipy";       return new class Flip(Flip::FlipY);
+  case 66: name = "flipxextend"; return new class FlipExtend(FlipExtend::FlipX);
+  case 67: name = "shift";       return new class Shift(3,2,s.specs,s.specs);
+  case 68: name = "crop";        return new class Crop(w >> 2,h >> 2,(w >> 1) + (w >> 2) - 1,(h >> 1) + (h >> 2) - 1,
+						       Crop::CropBoth);
+  case 69: name = "paste";       return new class Paste(0,0);
+  case 70: name = "only";        return new class Restrict(0,1);
+  case 71: name = "invert";      return new class Invert();
+  case 72: name = "clamp";       return new class Clamp(0.0,s.max / 2);
+  case 73: name = "fill";        return new class Fill(s.fill);
+  case 74: name = "restore";     return new class Restore(s.orgcpy,s.dstcpy);
+  case 75: name = "compare";     return new class Compare(Compare::Greater,0.0);
+  }
+
+  return NULL;
+}
+///
+
+/// Median
+// Sort the run times and return their median.
+static double Median(double *times,ULONG count)
+{
+  ULONG i,j;
+
+  for(i = 1;i < count;i++) {
+    double t = times[i];
+    for(j = i;j > 0 && times[j - 1] > t;j--)
+      times[j] = times[j - 1];
+    times[j] = t;
+  }
+
+  if (count & 1)
+    return times[count >> 1];
+
+  return 0.5 * (times[(count >> 1) - 1] + times[count >> 1]);
+}
+///
+
+/// RemoveScratch
+// Remove the files an image saved under the given name consists of.
+static void RemoveScratch(const char *filename,UWORD depth)
+{
+  char buffer[1024 + 16];
+  UWORD c;
+
+  remove(filename);
+  //
+  // PGX writes the components into separate files.
+  for(c = 0;c < depth;c++) {
+    sprintf(buffer,"%s_%d.raw",filename,c);
+    remove(buffer);
+    sprintf(buffer,"%s_%d.h",filename,c);
+    remove(buffer);
+  }
+}
+///
+
+/// AddResult
+// Record the result of a benchmark case and print it.
+static struct Result *AddResult(struct Result *&last,const char *name,const char *type,
+				UWORD depth,const struct ImageSize *size,double *times,ULONG repeat)
+{
+  struct Result *r = new struct Result;
+
+  r->next    = NULL;
+  sprintf(r->name,"%.64s/%s/%d/%s",name,type,depth,size->name);
+  r->median  = Median(times,repeat);
+  r->min     = times[0];
+  r->mpixels = (r->median > 0.0)?(double(size->width) * size->height / r->median * 1e-6):(0.0);
+  last->next = r;
+  last       = r;
+
+  printf("%-32s %10.3f ms %10.3f ms %10.1f Mpixel/s\n",r->name,r->median * 1e3,r->min * 1e3,r->mpixels);
+  fflush(stdout);
+
+  return r;
+}
+///
+
+/// TimeMeter
+// Run the meter with the given index on fresh copies of the images,
+// once to warm up and then repeat times, and fill in the run times.
+// Returns NULL on success, or the reason why the meter cannot
+// measure the images.
+static const char *TimeMeter(ULONG idx,struct Scene &scene,const class ImageLayout *org,const class ImageLayout *dst,
+			     class ThreadPool *pool,ULONG repeat,double *times)
+{
+  ULONG run;
+
+  for(run = 0;run <= repeat;run++) {
+    class ImageLayout *o = CopyImage(org);
+    class ImageLayout *d = NULL;
+    class Meter *m       = NULL;
+    const char *name;
+    try {
+      Timer timer;
+      d = CopyImage(dst);
+      m = CreateMeter(idx,scene,name);
+      m->UsePool(pool);
+      timer.Start();
+      m->Measure(o,d,1.0);
+      if (run > 0)
+	times[run - 1] = timer.ElapsedOf();
+    } catch(const char *error) {
+      delete m;
+      delete d;
+      delete o;
+      return error;
+    } catch(...) {
+      delete m;
+      delete d;
+      delete o;
+      throw;
+    }
+    delete m;
+    delete d;
+    delete o;
+  }
+
+  return NULL;
+}
+///
+
+/// Checksum
+// Collects the samples read back by the loaders.
+static volatile ULONG Checksum;
+///
+
+/// Touch
+// Read all samples of an image such that loaders that map files into
+// memory are charged for bringing the data in. Returns a checksum to
+// keep the compiler from dropping the reads.
+static ULONG Touch(const class ImageLayout *img)
+{
+  ULONG sum = 0;
+  UWORD c;
+
+  for(c = 0;c < img->DepthOf();c++) {
+    const UBYTE *row = (const UBYTE *)img->DataOf(c);
+    ULONG bytes      = img->BytesPerPixel(c) * img->WidthOf(c);
+    ULONG x,y;
+    for(y = 0;y < img->HeightOf(c);y++) {
+      for(x = 0;x < bytes;x += 64)
+	sum += row[x];
+      row += img->BytesPerRow(c);
+    }
+  }
+
+  return sum;
+}
+///
+
+/// TimeFormat
+// Save the image in the format of the file name extension and load it
+// back, once to warm up and then repeat times. Returns NULL on success,
+// or the reason why the format cannot represent the image.
+static const char *TimeFormat(const char *filename,class ImageLayout *img,ULONG repeat,double *save,double *load)
+{
+  ULONG run;
+
+  for(run = 0;run <= repeat;run++) {
+    class ImageLayout *back = NULL;
+    try {
+      struct ImgSpecs specs;
+      Timer timer;
+      img->SaveImage(filename);
+      if (run > 0)
+	save[run - 1] = timer.ElapsedOf();
+      timer.Start();
+      back = ImageLayout::LoadImage(filename,specs);
+      Checksum += Touch(back);
+      if (run > 0)
+	load[run - 1] = timer.ElapsedOf();
+    } catch(const char *error) {
+      delete back;
+      RemoveScratch(filename,img->DepthOf());
+      return error;
+    } catch(...) {
+      delete back;
+      RemoveScratch(filename,img->DepthOf());
+      throw;
+    }
+    delete back;
+    RemoveScratch(filename,img->DepthOf());
+  }
+
+  return NULL;
+}
+///
+
+/// Matches
+// Check whether the name is selected by the given comma separated list,
+// where NULL and "all" select everything.
+static bool Matches(const char *name,const char *list)
+{
+  size_t len = strlen(name);
+
+  if (list == NULL || !strcmp(list,"all"))
+    return true;
+
+  while(*list) {
+    const char *end = strchr(list,',');
+    size_t l        = (end)?(size_t(end - list)):(strlen(list));
+    if (l == len && !strncmp(name,list,len))
+      return true;
+    list += l;
+    if (*list == ',')
+      list++;
+  }
+
+  return false;
+}
+///
+
+/// CheckOnly
+// Make sure that every entry of the --only list names a meter or a
+// format, as misspelled entries would otherwise silently select nothing.
+// Reports all unknown entries before failing.
+static void CheckOnly(const char *list)
+{
+  struct Scene scene;
+  bool unknown = false;
+
+  if (list == NULL || !strcmp(list,"all"))
+    return;
+  //
+  // Only the names are needed, the meters never run on this scene.
+  scene.width  = 16;
+  scene.height = 16;
+  scene.max    = 1.0;
+  scene.target[0] = scene.mask[0] = '\0';
+  strcpy(scene.fill,"1");
+  strcpy(scene.factors,"1");
+  strcpy(scene.offsets,"0");
+  scene.orgcpy = NULL;
+  scene.dstcpy = NULL;
+  //
+  while(*list) {
+    const char *end = strchr(list,',');
+    size_t l        = (end)?(size_t(end - list)):(strlen(list));
+    bool found      = false;
+    char entry[32];
+    const char **ext;
+    ULONG idx;
+    //
+    if (l < sizeof(entry) - 1) {
+      memcpy(entry,list,l);
+      entry[l] = '\0';
+      for(idx = 0;!found;idx++) {
+	const char *name;
+	class Meter *m = CreateMeter(idx,scene,name);
+	if (m == NULL)
+	  break;
+	delete m;
+	found = !strcmp(name,entry);
+      }
+      for(ext = Formats;*ext && !found;ext++) {
+	found = (!strncmp(entry,"save",4) || !strncmp(entry,"load",4)) && !strcmp(entry + 4,*ext);
+      }
+    }
+    if (!found) {
+      fprintf(stderr,"'%.*s' is neither a meter nor a format\n",int(l),list);
+      unknown = true;
+    }
+    list += l;
+    if (*list == ',')
+      list++;
+  }
+
+  if (unknown)
+    throw "--only lists unknown meters or formats";
+}
+///
+
+/// WriteJSON
+// Write the results as JSON, one case per line.
+static void WriteJSON(const char *filename,const struct Result *results,ULONG repeat,LONG threads)
+{
+  FILE *out = fopen(filename,"w");
+
+  if (out == NULL)
+    throw "cannot open the JSON output file";
+
+  fprintf(out,"{\n  \"repeat\": %lu,\n  \"threads\": %ld,\n  \"results\": [\n",(unsigned long)repeat,(long)threads);
+  while(results) {
+    fprintf(out,"    {\"case\": \"%s\", \"median\": %.6g, \"min\": %.6g, \"mpixels\": %.6g}%s\n",
+	    results->name,results->median,results->min,results->mpixels,(results->next)?(","):(""));
+    results = results->next;
+  }
+  fprintf(out,"  ]\n}\n");
+  fclose(out);
+}
+///
+
+/// CompareBaseline
+// Compare the results against the baseline written by an earlier run
+// and report all cases that got slower by more than the tolerance in
+// percent. Returns the number of such cases.
+static ULONG CompareBaseline(const char *filename,const struct Result *results,double tolerance)
+{
+  FILE *in = fopen(filename,"r");
+  char line[512];
+  ULONG slower = 0;
+  ULONG found  = 0;
+
+  if (in == NULL)
+    throw "cannot open the baseline JSON file";
+
+  printf("\nComparison against %s, tolerance %g%%:\n",filename,tolerance);
+  while(fgets(line,sizeof(line),in)) {
+    char name[128];
+    double median,min,mpixels;
+    const struct Result *r;
+    if (sscanf(line," {\"case\": \"%127[^\"]\", \"median\": %lf, \"min\": %lf, \"mpixels\": %lf",
+	       name,&median,&min,&mpixels) != 4)
+      continue;
+    for(r = results;r;r = r->next) {
+      if (!strcmp(r->name,name))
+	break;
+    }
+    if (r == NULL || mpixels <= 0.0)
+      continue;
+    found++;
+    if (r->mpixels < mpixels * (1.0 - tolerance / 100.0)) {
+      printf("%-32s %10.1f Mpixel/s, baseline %10.1f Mpixel/s, %+6.1f%% SLOWER\n",
+	     name,r->mpixels,mpixels,(r->mpixels / mpixels - 1.0) * 100.0);
+      slower++;
+    } else if (r->mpixels > mpixels * (1.0 + tolerance / 100.0)) {
+      printf("%-32s %10.1f Mpixel/s, baseline %10.1f Mpixel/s, %+6.1f%% faster\n",
+	     name,r->mpixels,mpixels,(r->mpixels / mpixels - 1.0) * 100.0);
+    }
+  }
+  fclose(in);
+  printf("%lu cases compared, %lu slower\n",(unsigned long)found,(unsigned long)slower);
+
+  return slower;
+}
+///
+
+/// Usage
+void Usage(const char *progname)
+{
+  fprintf(stderr,"Usage: %s [options]\n"
+	  "Times all meters and the savers and loaders of all formats on synthetic images\n"
+	  "and reports the median run time and the throughput in Mpixels per second.\n"
+	  "Options are:\n"
+	  "--size list        : comma separated image sizes, 1080p, 4k, 8k or all (default 1080p)\n"
+	  "--type list        : comma separated sample types, 8, 10, 12, 16, half, float or all (default all)\n"
+	  "--depth list       : comma separated component counts, 1, 3, 4 or all (default all)\n"
+	  "--only list        : comma separated meters or formats (as save.ext and load.ext) to run\n"
+	  "--repeat n         : time n runs after a warm-up run (default 5)\n"
+	  "--threads n        : offer n threads to the meters, 0 for one per processor (default 1)\n"
+	  "--tmp dir          : scratch directory for files, preferably on tmpfs (default /dev/shm)\n"
+	  "--json file        : write the results to the given JSON file (default bench.json)\n"
+	  "--baseline file    : compare the results against a JSON file from an earlier run\n"
+	  "--tolerance pct    : report cases slower than the baseline by more than pct percent (default 10)\n",
+	  progname);
+}
+///
+
+/// main
+int main(int argc,char **argv)
+{
+  const char *sizes     = "1080p";
+  const char *types     = NULL;
+  const char *depths    = NULL;
+  const char *only      = NULL;
+  const char *tmp       = "/dev/shm";
+  const char *json      = "bench.json";
+  const char *baseline  = NULL;
+  double tolerance      = 10.0;
+  LONG repeat           = 5;
+  LONG threads          = 1;
+  struct Result head;
+  struct Result *last   = &head;
+  class ThreadPool *pool = NULL;
+  class ImageLayout *org = NULL;
+  class ImageLayout *dst = NULL;
+  double *times = NULL;
+  double *load  = NULL;
+  int rc = 0;
+
+  head.next = NULL;
+
+  try {
+    const struct ImageSize *size;
+    const struct SampleType *type;
+    const UWORD *depth;
+    struct Scene scene;
+    char scratch[1024];
+    char buffer[16];
+    int i;
+    //
+    for(i = 1;i < argc;i++) {
+      const char *arg = argv[i];
+      if (!strcmp(arg,"--help")) {
+	Usage(argv[0]);
+	return 0;
+      } else if (i + 1 >= argc) {
+	Usage(argv[0]);
+	throw "unknown option or missing argument";
+      } else if (!strcmp(arg,"--size")) {
+	sizes = argv[++i];
+      } else if (!strcmp(arg,"--type")) {
+	types = argv[++i];
+      } else if (!strcmp(arg,"--depth")) {
+	depths = argv[++i];
+      } else if (!strcmp(arg,"--only")) {
+	only = argv[++i];
+      } else if (!strcmp(arg,"--repeat")) {
+	repeat = strtol(argv[++i],NULL,0);
+	if (repeat <= 0)
+	  throw "--repeat requires a positive argument";
+      } else if (!strcmp(arg,"--threads")) {
+	threads = strtol(argv[++i],NULL,0);
+	if (threads < 0)
+	  throw "--threads requires a non-negative argument";
+      } else if (!strcmp(arg,"--tmp")) {
+	tmp = argv[++i];
+      } else if (!strcmp(arg,"--json")) {
+	json = argv[++i];
+      } else if (!strcmp(arg,"--baseline")) {
+	baseline = argv[++i];
+      } else if (!strcmp(arg,"--tolerance")) {
+	tolerance = strtod(argv[++i],NULL);
+	if (tolerance < 0.0)
+	  throw "--tolerance requires a non-negative argument";
+      } else {
+	Usage(argv[0]);
+	throw "unknown option";
+      }
+    }
+    //
+    CheckOnly(only);
+    if (strlen(tmp) > sizeof(scratch) - 32)
+      throw "the scratch directory name is too long";
+    if (threads != 1)
+      pool = new class ThreadPool(threads);
+    times = new double[repeat];
+    load  = new double[repeat];
+    //
+    printf("%-32s %13s %13s %19s\n","case","median","min","throughput");
+    for(size = ImageSizes;size->name;size++) {
+      if (!Matches(size->name,sizes))
+	continue;
+      scene.width  = size->width;
+      scene.height = size->height;
+      sprintf(scene.target,"%s/difftest_bench_out.tif",tmp);
+      sprintf(scene.mask,"%s/difftest_bench_mask.pgm",tmp);
+      CreateMask(scene.mask,size->width,size->height);
+      for(type = SampleTypes;type->name;type++) {
+	if (!Matches(type->name,types))
+	  continue;
+	for(depth = Depths;*depth;depth++) {
+	  ULONG idx;
+	  UWORD c;
+	  const char **ext;
+	  const char *error;
+	  sprintf(buffer,"%d",*depth);
+	  if (!Matches(buffer,depths))
+	    continue;
+	  org = CreateImage(size->width,size->height,*depth,type,0.0);
+	  dst = CreateImage(size->width,size->height,*depth,type,0.02);
+	  //
+	  scene.max    = (type->isfloat)?(1.0):(double((1UL << type->bits) - 1));
+	  scene.orgcpy = org;
+	  scene.dstcpy = dst;
+	  scene.fill[0] = scene.factors[0] = scene.offsets[0] = '\0';
+	  for(c = 0;c < *depth;c++) {
+	    const char *sep = (c > 0)?(","):("");
+	    sprintf(scene.fill    + strlen(scene.fill)   ,"%s%s",sep,(type->isfloat)?("0.5"):("1"));
+	    sprintf(scene.factors + strlen(scene.factors),"%s1.25",sep);
+	    sprintf(scene.offsets + strlen(scene.offsets),"%s%s",sep,(type->isfloat)?("0.125"):("1"));
+	  }
+	  //
+	  for(idx = 0;;idx++) {
+	    const char *name;
+	    class Meter *m = CreateMeter(idx,scene,name);
+	    if (m == NULL)
+	      break;
+	    delete m;
+	    if (!Matches(name,only))
+	      continue;
+	    error = TimeMeter(idx,scene,org,dst,pool,repeat,times);
+	    if (error) {
+	      printf("%s/%s/%d/%s skipped: %s\n",name,type->name,*depth,size->name,error);
+	    } else {
+	      AddResult(last,name,type->name,*depth,size,times,repeat);
+	    }
+	    remove(scene.target);
+	  }
+	  //
+	  for(ext = Formats;*ext;ext++) {
+	    char save[32],loadname[32];
+	    sprintf(save,"save%s",*ext);
+	    sprintf(loadname,"load%s",*ext);
+	    if (!Matches(save,only) && !Matches(loadname,only))
+	      continue;
+	    sprintf(scratch,"%s/difftest_bench%s",tmp,*ext);
+	    error = TimeFormat(scratch,org,repeat,times,load);
+	    if (error) {
+	      printf("%s/%s/%d/%s skipped: %s\n",save,type->name,*depth,size->name,error);
+	    } else {
+	      AddResult(last,save,type->name,*depth,size,times,repeat);
+	      AddResult(last,loadname,type->name,*depth,size,load,repeat);
+	    }
+	  }
+	  //
+	  delete org;
+	  org = NULL;
+	  delete dst;
+	  dst = NULL;
+	}
+      }
+      remove(scene.mask);
+    }
+    //
+    WriteJSON(json,head.next,repeat,threads);
+    if (baseline && CompareBaseline(baseline,head.next,tolerance))
+      rc = 1;
+  } catch(const char *error) {
+    fprintf(stderr,"Program failed: %s\n",error);
+    rc = 10;
+  } catch(const std::bad_alloc &) {
+    fprintf(stderr,"Program run out of memory\n");
+    rc = 15;
+  } catch(...) {
+    fprintf(stderr,"Caught unknown exception\n");
+    rc = 20;
+  }
+
+  while(head.next) {
+    struct Result *r = head.next;
+    head.next = r->next;
+    delete r;
+  }
+  delete org;
+  delete dst;
+  delete[] times;
+  delete[] load;
+  if (pool)
+    delete pool;
+
+  return rc;
+}
+///
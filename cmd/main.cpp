@@ -80,8 +80,17 @@ and conversion framework.
 #include "diff/butterfly.hpp"
 #include "diff/extractfield.hpp"
 #include "diff/mergefields.hpp"
+#include "diff/statistics.hpp"
+#include "diff/spectra.hpp"
+#include "tools/threadpool.hpp"
+#include "tools/timer.hpp"
+#include "tools/profile.hpp"
+#include "tools/bufferpool.hpp"
 #include "img/imglayout.hpp"
 #include "img/imgspecs.hpp"
+#include "img/simpleraw.hpp"
+#include "img/bandlayout.hpp"
+#include "cmd/report.hpp"
 #include <new>
 ///
 
@@ -90,6 +99,7 @@ and conversion framework.
 void Usage(const char *progname)
 {
   fprintf(stderr,"Usage: %s [options] original distorted\n"
+	  "   or: %s [options] --batch listfile\n"
 	  "where original and distorted are ppm,pbm,pgm,pfm,pfs,bmp,pgx,tif,png,exr,rgbe or raw (craw,v12,yuv) images\n"
 	  "and options are one or more of\n"
 	  "--psnr             : measure the psnr with equal weights over all components\n"
@@ -136,24 +146,23 @@ void Usage(const char *progname)
 	  "--notmask roi      : mask the source image by the inverse of the mask\n"
 	  "--convert target   : save the original image unaltered, but possibly in a new format\n"
 	  "--merge target     : merge the two images together, add second as components of first\n"
-#ifdef USE_GSL
 	  "--fft target       : save the fft of the difference image\n"
 	  "--wfft target      : save the windowed fft of the difference image\n"
 	  "--filt x y r dst   : run a radial filter around frequency x,y with radius r, saves the filtered image as dst\n"
 	  "--nfilt x y r dst  : similar to --filt, but the output is normalized to the full range\n"
 	  "--comb x y r dst   : apply a comb filter in direction x y and radius r\n"
 	  "--ncomb x y r dst  : similar to --comb, but the output is normalized to the full range\n"
-#endif
 	  "--hist target      : generate a histogram plot. If \"target\" is -, write to stdout\n"
 	  "--thres threshold  : compute the ratio of pixels whose difference is > than threshold\n"
 	  "--colorhist size   : generate reduced histogram separately for each component using the given bucket size\n"
-#ifdef USE_GSL
 	  "--maxfreqr         : locate the absolute value of the most exposed frequency in the error image\n"
 	  "--maxfreqx         : locate the horizontal component of the most exposed frequency in the error image\n"
 	  "--maxfreqy         : locate the vertical component of the most exposed frequency in the error image\n"
 	  "--maxfreqv         : compute the domination ratio of the most exposed frequency in the error image\n"
 	  "--patternidx       : scan the FFT for suspicious patterns and output the likeliness of errors\n"
-#endif
+	  "--maxfreq-tile n   : the frequency meters following this option average the spectra of\n"
+	  "                     overlapping nxn tiles instead of transforming the complete image.\n"
+	  "                     Frequencies are scaled to the image, n = 0 transforms the complete image\n"
 	  "--toflt dst        : save a floating point version of the source image\n"
 	  "--asflt            : convert to floating point before proceeding (run as filter)\n"
 	  "--tohfl dst        : save a half-float version of the source image\n"
@@ -186,6 +195,11 @@ void Usage(const char *progname)
 	  "--frompq           : convert SMPTE 2084 quantized data to luminances\n"
 	  "--tohlg bits       : convert floating point to Hybrid Log Gamma with HEVC conventions\n"
 	  "--fromhlg          : convert Hybrid Log Gamma to linear luminance, 1000 nits peak\n"
+	  "--fast-math-tf     : --gamma, --togamma, --topq and --tohlg following this option use\n"
+	  "                     approximations of the transfer functions within a relative error of\n"
+	  "                     2e-9 of the exact values, thus integer results differ by at most one\n"
+	  "                     and only for values this close to the boundary between two integers;\n"
+	  "                     the exact functions remain in use on CPUs without AVX2 and FMA\n"
 	  "--invert           : invert the source image before comparing\n"
 	  "--flipx            : flip the source horizontally before comparing\n"
 	  "--flipy            : flip the source vertically before comparing\n"
@@ -290,8 +304,35 @@ void Usage(const char *progname)
 	  "--isreducedrange   : override automatic range detection, source has head/toe region\n"
 	  "--littleendian     : use little endian output if applicable\n"
 	  "--bigendian        : use big endian output if applicable\n"
+	  "--tiffcompress m   : compress TIFF output with method m, which is none, lzw, packbits\n"
+	  "                     or deflate. Append +pred to lzw or deflate to compress the\n"
+	  "                     horizontal differences of integer samples, e.g. lzw+pred\n"
+	  "--tiffrows n       : write TIFF output in strips of n rows, compressed in parallel\n"
+	  "                     with --threads. The default are strips of about 64K\n"
+	  "--bigtiff          : write TIFF output as BigTIFF with 64 bit file offsets. This is\n"
+	  "                     the default for images that could exceed 4GB otherwise\n"
 	  "--toabsradiance    : multiply floating point samples by recorded radiance scale to convert to absolute radiance\n"
 	  "--brief            : use a brief (only numeric) output format\n"
+	  "--json             : print all results along with the options requesting them, their\n"
+	  "                     values for the individual components, the layout of the images\n"
+	  "                     and the seconds spent on loading and on each result as JSON object\n"
+	  "--csv              : print the same as --json as CSV table with one value per row\n"
+	  "--threads n        : use n threads for the measurements and for decoding the strips and\n"
+	  "                     tiles of TIFF images, 0 for one per processor\n"
+	  "--profile          : print the time, the samples touched, the throughput and the growth\n"
+	  "                     of the peak memory use of loading, copying and saving images and\n"
+	  "                     of each filter and metric to stderr. Images mapped into memory\n"
+	  "                     are then read completely while loading\n"
+	  "--frames f:n       : measure n frames of two raw sequences starting at frame f, 0 for all,\n"
+	  "                     print the results per frame and their mean, minimum and MSE average\n"
+	  "--stream rows      : run filters and metrics on bands of about the given number of rows\n"
+	  "                     if all of them allow it, which bounds the memory required for filtering.\n"
+	  "                     'cache' selects bands fitting into the cache, such that a chain of\n"
+	  "                     filters passes each band on while it is still in the cache\n"
+	  "--batch listfile   : measure all pairs listed in the file, one 'original distorted [label]'\n"
+	  "                     per line, and print one row of results per pair. With --threads,\n"
+	  "                     several pairs are measured concurrently. Options writing images or\n"
+	  "                     files such as --diff, --convert, --fft or --hist are not available\n"
 	  ">,>=,==,!=,<=,< t  : last result must be larger, larger or equal, equal, not equal,\n"
 	  "                     smaller or equal or smaller than given threshold t.\n"
 	  "                     Attention: Quoting required when used from the shell.\n"
@@ -303,7 +344,7 @@ void Usage(const char *progname)
 	  "--help             : print this page\n"
 	  "--rawhelp          : print help on raw image formatting. First time users: PLEASE READ THIS.\n"
 	  "\n",
-	  progname
+	  progname,progname
 	  );
 }
 ///
@@ -611,9 +652,9 @@ class Meter *ParseProperties(int &argc,char **&argv)
 ///
 
 /// ParseFFT
-// Parse FFT related features that require the GSL
-#ifdef USE_GSL
-class Meter *ParseFFT(int &argc,char **&argv)
+// Parse FFT related features. The frequency meters average the
+// spectra of tiles of the given size unless it is zero.
+class Meter *ParseFFT(int &argc,char **&argv,ULONG tile)
 {
   class Meter *m = NULL;
   const char *arg = argv[1];
@@ -671,22 +712,21 @@ class Meter *ParseFFT(int &argc,char **&argv)
     argc -= 4;
     argv += 4;
   } else if (!strcmp(arg,"--maxfreqr")) {
-    m = new class MaxFreq(MaxFreq::MaxR);
+    m = new class MaxFreq(MaxFreq::MaxR,tile);
   } else if (!strcmp(arg,"--maxfreqx")) {
-    m = new class MaxFreq(MaxFreq::MaxH);
+    m = new class MaxFreq(MaxFreq::MaxH,tile);
   } else if (!strcmp(arg,"--maxfreqy")) {
-    m = new class MaxFreq(MaxFreq::MaxV);
+    m = new class MaxFreq(MaxFreq::MaxV,tile);
   } else if (!strcmp(arg,"--maxfreqv")) {
-    m = new class MaxFreq(MaxFreq::Var);
+    m = new class MaxFreq(MaxFreq::Var,tile);
   } else if (!strcmp(arg,"--maxfreqv")) {
-    m = new class MaxFreq(MaxFreq::Var);
+    m = new class MaxFreq(MaxFreq::Var,tile);
   } else if (!strcmp(arg,"--patternidx")) {
-    m = new class MaxFreq(MaxFreq::Pattern);
+    m = new class MaxFreq(MaxFreq::Pattern,tile);
   }
 
   return m;
 }
-#endif
 ///
 
 /// ParseColor
@@ -1095,7 +1135,7 @@ class Meter *ParseConversions(int &argc,char **&argv,struct ImgSpecs &specout)
 
 /// ParseTransferFunctions
 // Parse various transfer function related methods.
-class Meter *ParseTransferFunctions(int &argc,char **&argv,struct ImgSpecs &specout)
+class Meter *ParseTransferFunctions(int &argc,char **&argv,struct ImgSpecs &specout,bool fastmath)
 {
   class Meter *m = NULL;
   const char *arg = argv[1];
@@ -1107,7 +1147,7 @@ class Meter *ParseTransferFunctions(int &argc,char **&argv,struct ImgSpecs &spec
       throw "--gamma requires three arguments, a bit depth, a gamma value and a file name";
     bpp   = ParseLong(argv[2]);
     gamma = ParseDouble(argv[3]);
-    m     = new class Mapping(argv[4],Mapping::Gamma,gamma,false,bpp,false,specout);
+    m     = new class Mapping(argv[4],Mapping::Gamma,gamma,false,bpp,false,specout,0.0,fastmath);
     argc -= 3;
     argv += 3;
   } else if (!strcmp(arg,"--toegamma")) {
@@ -1155,7 +1195,7 @@ class Meter *ParseTransferFunctions(int &argc,char **&argv,struct ImgSpecs &spec
       throw "--togamma requires two arguments, a bit depth and a gamma value";
     bpp   = ParseLong(argv[2]);
     gamma = ParseDouble(argv[3]);
-    m     = new class Mapping(NULL,Mapping::Gamma,gamma,false,bpp,true,specout);
+    m     = new class Mapping(NULL,Mapping::Gamma,gamma,false,bpp,true,specout,0.0,fastmath);
     argc -= 2;
     argv += 2;
   } else if (!strcmp(arg,"--totoegamma")) {
@@ -1207,7 +1247,7 @@ class Meter *ParseTransferFunctions(int &argc,char **&argv,struct ImgSpecs &spec
     bits  = ParseLong(argv[2]);
     if (bits < 8 || bits > 32)
       throw "--topq requires a bit depth between 8 and 32 bits";
-    m     = new class Mapping(NULL,Mapping::PQ,1.0,false,bits,true,specout);
+    m     = new class Mapping(NULL,Mapping::PQ,1.0,false,bits,true,specout,0.0,fastmath);
     argc -= 1;
     argv += 1;
   } else if (!strcmp(arg,"--frompq")) {
@@ -1219,7 +1259,7 @@ class Meter *ParseTransferFunctions(int &argc,char **&argv,struct ImgSpecs &spec
     bits  = ParseLong(argv[2]);
     if (bits < 8 || bits > 32)
       throw "--tohlg requires a bit depth between 8 and 32 bits";
-    m     = new class Mapping(NULL,Mapping::HLG,1.0,false,bits,true,specout);
+    m     = new class Mapping(NULL,Mapping::HLG,1.0,false,bits,true,specout,0.0,fastmath);
     argc -= 1;
     argv += 1;
   } else if (!strcmp(arg,"--fromhlg")) {
@@ -1549,20 +1589,70 @@ class Meter *ParseTotal(int &argc,char **&argv)
 }
 ///
 
-/// main
-int main(int argc,char **argv)
+/// struct Options
+// Settings from the command line that are not meters.
+struct Options {
+  //
+  // Specifications for the two input images and the output images.
+  struct ImgSpecs spec1,spec2,specout;
+  //
+  // Print only the numeric results.
+  bool  brief;
+  //
+  // Format of the output, text unless a machine readable report is
+  // requested.
+  Report::Format format;
+  //
+  // Set if only help was requested.
+  bool  help;
+  //
+  // Number of threads, zero for one per processor.
+  LONG  threads;
+  //
+  // First frame and number of frames in sequence mode, first is
+  // negative if not in sequence mode, count is zero for all frames.
+  LONG  first;
+  LONG  count;
+  //
+  // Number of rows of the bands in streaming mode, zero if the images
+  // are processed as a whole, negative for bands fitting into the
+  // cache.
+  LONG  stream;
+  //
+  // The file listing the image pairs in batch mode, NULL otherwise.
+  const char *batch;
+  //
+  // Size of the tiles the frequency meters following on the command
+  // line average their spectra over, zero for the complete image.
+  ULONG maxfreqtile;
+  //
+  // Set if the transfer functions following on the command line may
+  // use approximations.
+  bool  fastmath;
+  //
+  // Print the time and memory taken by the stages of the run.
+  bool  profile;
+  //
+  // Set if the agenda restores the images, whose samples must then
+  // stay intact.
+  bool  restore;
+  //
+  Options(void)
+    : brief(false), format(Report::Text), help(false), threads(1), first(-1), count(0), stream(0), batch(NULL),
+      maxfreqtile(0), fastmath(false), profile(false), restore(false)
+  { }
+};
+///
+
+/// ParseAgenda
+// Parse all options in front of the two image names, create the agenda
+// of meters from them and collect the remaining options. Returns the
+// agenda, with argc and argv pointing to the image names.
+class Meter *ParseAgenda(int &argc,char **&argv,struct Options &opts,
+			 class ImageLayout *&orgcpy,class ImageLayout *&dstcpy)
 {
   class Meter *agenda = NULL,*last = NULL,*m;
-  const char *org = NULL;
-  const char *dst = NULL;
   const char *name = argv[0];
-  class ImageLayout *orgimg = NULL;
-  class ImageLayout *dstimg = NULL;
-  class ImageLayout *orgcpy = NULL;
-  class ImageLayout *dstcpy = NULL;
-  struct ImgSpecs spec1,spec2,specout;
-  bool  brief = false;
-  int   rc    = 0;
 
   try {
     while(argc > 1) {
@@ -1573,10 +1663,12 @@ int main(int argc,char **argv)
       if (arg[0] == '-' && arg[1] != '/') {
 	if (!strcmp(arg,"--help")) {
 	  Usage(argv[0]);
-	  return 0;
+	  opts.help = true;
+	  break;
 	} else if (!strcmp(arg,"--rawhelp")) {
 	  RawHelp();
-	  return 0;
+	  opts.help = true;
+	  break;
 	} else if ((m = ParseMetrics(argc,argv))) {
 	  // Done with it.
 	} else if (!strcmp(arg,"--stripe")) {
@@ -1586,25 +1678,25 @@ int main(int argc,char **argv)
 	} else if (!strcmp(arg,"--diff") || !strcmp(arg,"-i")) {
 	  if (argc < 3)
 	    throw "--diff requires the target file name as argument";
-	  m = new class DiffImg(argv[2],specout,true);
+	  m = new class DiffImg(argv[2],opts.specout,true);
 	  argc--;
 	  argv++;
 	} else if (!strcmp(arg,"--rawdiff") || !strcmp(arg,"-i")) {
 	  if (argc < 3)
 	    throw "--rawdiff requires the target file name as argument";
-	  m = new class DiffImg(argv[2],specout,false);
+	  m = new class DiffImg(argv[2],opts.specout,false);
 	  argc--;
 	  argv++;
 	} else if (!strcmp(arg,"--sdiff")) {
 	  if (argc < 4)
 	    throw "--sdiff requires a scale and the target file name as argument";
-	  m = new class DiffImg(argv[3],specout,false,ParseDouble(argv[2]));
+	  m = new class DiffImg(argv[3],opts.specout,false,ParseDouble(argv[2]));
 	  argc -= 2;
 	  argv += 2;
 	} else if (!strcmp(arg,"--butterfly")) {
 	  if (argc < 3)
 	    throw "--butterfly requires the target file name as argument";
-	  m = new class Butterfly(argv[2],specout);
+	  m = new class Butterfly(argv[2],opts.specout);
 	  argc--;
 	  argv++;
 	} else if (!strcmp(arg,"--topfield")) {
@@ -1638,19 +1730,17 @@ int main(int argc,char **argv)
 	} else if (!strcmp(arg,"--convert")) {
 	  if (argc < 3)
 	    throw "--convert requires the target file name as argument";
-	  m = new class ConvertImg(argv[2],specout);
+	  m = new class ConvertImg(argv[2],opts.specout);
 	  argc--;
 	  argv++;
 	} else if (!strcmp(arg,"--merge")) {
 	  if (argc < 3)
 	    throw "--merge requires the target file name as argument";
-	  m = new class AddImg(argv[2],specout);
+	  m = new class AddImg(argv[2],opts.specout);
 	  argc--;
 	  argv++;
-#ifdef USE_GSL
-	} else if ((m = ParseFFT(argc,argv))) {
+	} else if ((m = ParseFFT(argc,argv,opts.maxfreqtile))) {
 	  // done with it.
-#endif
 	} else if (!strcmp(arg,"--hist")) {
 	  if (argc < 3)
 	    throw "--hist requires a file name as argument";
@@ -1677,17 +1767,17 @@ int main(int argc,char **argv)
 	  m = new class ColorHistogram(1.0 / b);
 	  argc--;
 	  argv++;
-	} else if ((m = ParseColor(argc,argv,specout))) {
+	} else if ((m = ParseColor(argc,argv,opts.specout))) {
 	  // done with it.
 	} else if ((m = ParseBayer(argc,argv))) {
 	  // done with it.
-	} else if ((m = ParseConversions(argc,argv,specout))) {
+	} else if ((m = ParseConversions(argc,argv,opts.specout))) {
 	  // done with it.
-	} else if ((m = ParseTransferFunctions(argc,argv,specout))) {
+	} else if ((m = ParseTransferFunctions(argc,argv,opts.specout,opts.fastmath))) {
 	  // done with it.
 	} else if ((m = ParseTotal(argc,argv))) {
 	  // done with it.
-	} else if ((m = ParseGeometric(argc,argv,spec1,spec2))) {
+	} else if ((m = ParseGeometric(argc,argv,opts.spec1,opts.spec2))) {
 	  // done with it.
 	} else if ((m = ParseSubsampling(argc,argv))) {
 	  // Done with it.
@@ -1695,35 +1785,129 @@ int main(int argc,char **argv)
 	  // done with it.
 	} else if (!strcmp(arg,"--restore")) {
 	  m = new class Restore(orgcpy,dstcpy);
+	  opts.restore = true;
 	} else if (!strcmp(arg,"--raw")) {
-	  specout.ASCII = ImgSpecs::No;
+	  opts.specout.ASCII = ImgSpecs::No;
 	} else if (!strcmp(arg,"--ascii")) {
-	  specout.ASCII = ImgSpecs::Yes;
+	  opts.specout.ASCII = ImgSpecs::Yes;
 	} else if (!strcmp(arg,"--interleaved")) {
-	  specout.Interleaved = ImgSpecs::Yes;
+	  opts.specout.Interleaved = ImgSpecs::Yes;
 	} else if (!strcmp(arg,"--separate")) {
-	  specout.Interleaved = ImgSpecs::No;
+	  opts.specout.Interleaved = ImgSpecs::No;
 	} else if (!strcmp(arg,"--littleendian")) {
-	  specout.LittleEndian = ImgSpecs::Yes;
+	  opts.specout.LittleEndian = ImgSpecs::Yes;
 	} else if (!strcmp(arg,"--bigendian")) {
-	  specout.LittleEndian = ImgSpecs::No;
+	  opts.specout.LittleEndian = ImgSpecs::No;
+	} else if (!strcmp(arg,"--tiffcompress")) {
+	  const char *method;
+	  if (argc < 3)
+	    throw "--tiffcompress requires the compression method as argument";
+	  method = argv[2];
+	  opts.specout.Prediction = ImgSpecs::No;
+	  if (!strcmp(method,"none")) {
+	    opts.specout.Compression = ImgSpecs::Uncompressed;
+	  } else if (!strcmp(method,"lzw")) {
+	    opts.specout.Compression = ImgSpecs::LZW;
+	  } else if (!strcmp(method,"lzw+pred")) {
+	    opts.specout.Compression = ImgSpecs::LZW;
+	    opts.specout.Prediction  = ImgSpecs::Yes;
+	  } else if (!strcmp(method,"packbits")) {
+	    opts.specout.Compression = ImgSpecs::PackBits;
+	  } else if (!strcmp(method,"deflate")) {
+	    opts.specout.Compression = ImgSpecs::Deflate;
+	  } else if (!strcmp(method,"deflate+pred")) {
+	    opts.specout.Compression = ImgSpecs::Deflate;
+	    opts.specout.Prediction  = ImgSpecs::Yes;
+	  } else {
+	    throw "--tiffcompress requires none, lzw, lzw+pred, packbits, deflate or deflate+pred as argument";
+	  }
+	  argc--;
+	  argv++;
+	} else if (!strcmp(arg,"--tiffrows")) {
+	  long rows;
+	  if (argc < 3)
+	    throw "--tiffrows requires the number of rows per strip as argument";
+	  rows = ParseLong(argv[2]);
+	  if (rows <= 0)
+	    throw "--tiffrows requires a positive argument";
+	  opts.specout.RowsPerStrip = rows;
+	  argc--;
+	  argv++;
+	} else if (!strcmp(arg,"--bigtiff")) {
+	  opts.specout.BigTIFF = ImgSpecs::Yes;
 	} else if (!strcmp(arg,"--toabsradiance")) {
-	  spec1.AbsoluteRadiance = ImgSpecs::Yes;
-	  spec2.AbsoluteRadiance = ImgSpecs::Yes;
+	  opts.spec1.AbsoluteRadiance = ImgSpecs::Yes;
+	  opts.spec2.AbsoluteRadiance = ImgSpecs::Yes;
 	} else if (!strcmp(arg,"--isyuv")) {
-	  spec1.YUVEncoded = ImgSpecs::Yes;
-	  spec2.YUVEncoded = ImgSpecs::Yes;
+	  opts.spec1.YUVEncoded = ImgSpecs::Yes;
+	  opts.spec2.YUVEncoded = ImgSpecs::Yes;
 	} else if (!strcmp(arg,"--isrgb")) {
-	  spec1.YUVEncoded = ImgSpecs::No;
-	  spec2.YUVEncoded = ImgSpecs::No;
+	  opts.spec1.YUVEncoded = ImgSpecs::No;
+	  opts.spec2.YUVEncoded = ImgSpecs::No;
 	} else if (!strcmp(arg,"--isfullrange")) {
-	  spec1.FullRange  = ImgSpecs::Yes;
-	  spec2.FullRange  = ImgSpecs::Yes;
+	  opts.spec1.FullRange  = ImgSpecs::Yes;
+	  opts.spec2.FullRange  = ImgSpecs::Yes;
 	} else if (!strcmp(arg,"--isreducedrange")) {
-	  spec1.FullRange  = ImgSpecs::No;
-	  spec2.FullRange  = ImgSpecs::No;
+	  opts.spec1.FullRange  = ImgSpecs::No;
+	  opts.spec2.FullRange  = ImgSpecs::No;
 	} else if (!strcmp(arg,"--brief")) {
-	  brief = true;
+	  opts.brief = true;
+	} else if (!strcmp(arg,"--json")) {
+	  opts.format = Report::JSON;
+	} else if (!strcmp(arg,"--csv")) {
+	  opts.format = Report::CSV;
+	} else if (!strcmp(arg,"--profile")) {
+	  opts.profile = true;
+	} else if (!strcmp(arg,"--maxfreq-tile")) {
+	  LONG tile;
+	  if (argc < 3)
+	    throw "--maxfreq-tile requires the tile size as argument";
+	  tile = ParseLong(argv[2]);
+	  if (tile != 0 && tile < 8)
+	    throw "--maxfreq-tile requires a tile size of at least 8, or 0";
+	  opts.maxfreqtile = tile;
+	  argc--;
+	  argv++;
+	} else if (!strcmp(arg,"--fast-math-tf")) {
+	  opts.fastmath = true;
+	} else if (!strcmp(arg,"--threads")) {
+	  if (argc < 3)
+	    throw "--threads requires the number of threads as argument";
+	  opts.threads = ParseLong(argv[2]);
+	  if (opts.threads < 0)
+	    throw "--threads requires a non-negative argument";
+	  argc--;
+	  argv++;
+	} else if (!strcmp(arg,"--frames")) {
+	  char *end;
+	  if (argc < 3)
+	    throw "--frames requires the first frame and the frame count as argument";
+	  opts.first = strtol(argv[2],&end,0);
+	  if (*end != ':' || opts.first < 0)
+	    throw "--frames requires an argument of the form first:count";
+	  opts.count = strtol(end + 1,&end,0);
+	  if (*end || opts.count < 0)
+	    throw "--frames requires an argument of the form first:count";
+	  argc--;
+	  argv++;
+	} else if (!strcmp(arg,"--stream")) {
+	  if (argc < 3)
+	    throw "--stream requires the number of rows per band as argument";
+	  if (!strcmp(argv[2],"cache")) {
+	    opts.stream = -1;
+	  } else {
+	    opts.stream = ParseLong(argv[2]);
+	    if (opts.stream < 0)
+	      throw "--stream requires a non-negative argument";
+	  }
+	  argc--;
+	  argv++;
+	} else if (!strcmp(arg,"--batch")) {
+	  if (argc < 3)
+	    throw "--batch requires the name of the file listing the image pairs as argument";
+	  opts.batch = argv[2];
+	  argc--;
+	  argv++;
 	} else {
 	  Usage(name);
 	  throw "unknown command line option";
@@ -1758,6 +1942,7 @@ int main(int argc,char **argv)
       //
       // Created a new meter to be attached?
       if (m) {
+	m->OptionOf() = arg;
 	if (agenda == NULL) {
 	  agenda = m;
 	  last   = m;
@@ -1768,51 +1953,899 @@ int main(int argc,char **argv)
 	}
       }
     }
-    if (argc == 3) {
-      org = argv[1];
-      dst = argv[2];
-    } else {
-      Usage(name);
-      throw "requires exactly two mandatory arguments, original and distorted image";
-    }
     if (agenda == NULL) {
       // Default: PSNR
       agenda = new class PSNR(PSNR::Mean);
+      agenda->OptionOf() = "--psnr";
+    }
+  } catch(...) {
+    while((m = agenda)) {
+      agenda = m->NextOf();
+      delete m;
+    }
+    throw;
+  }
+
+  return agenda;
+}
+///
+
+/// LabelOf
+// Return a name for the meter in profiles, the name of its result if
+// it has one, or the option that created it.
+const char *LabelOf(const class Meter *m)
+{
+  if (m->NameOf())
+    return m->NameOf();
+  if (m->OptionOf())
+    return m->OptionOf();
+  return "filter";
+}
+///
+
+/// CountResults
+// Return the number of meters on the agenda that deliver a result.
+ULONG CountResults(class Meter *agenda)
+{
+  ULONG count = 0;
+
+  for(;agenda;agenda = agenda->NextOf()) {
+    if (agenda->NameOf())
+      count++;
+  }
+
+  return count;
+}
+///
+
+/// MeasureImages
+// Run the agenda on the two images and print the results unless print
+// is false. If results is non-NULL, the results of all meters that
+// deliver one are also stored there in agenda order. If frame is
+// non-negative, it is printed along with the results. If report is
+// non-NULL, the results are also recorded there along with the time
+// spent since the previous result, which includes the filters in
+// between. If buffers is non-NULL, the filters take their sample
+// buffers from this pool, and buffers the images no longer refer to
+// are returned to it after each filter.
+void MeasureImages(class Meter *agenda,class ImageLayout *orgimg,class ImageLayout *dstimg,
+		   class Statistics *stats,class BufferPool *buffers,bool brief,bool print,
+		   LONG frame,double *results,class Report *report)
+{
+  class Meter *m;
+  class Timer timer;
+  class Spectra spectra(stats->PoolOf());
+  double val = 0.0;
+  
+  for(m = agenda;m;m = m->NextOf()) {
+    const char *name = m->NameOf();
+    class Profile::Probe probe;
+
+    if (name) {
+      // A real measurement. Compare the image dimensions.
+      // Compare the images, at least the dimensions and the precisions must be
+      // equal.
+      orgimg->TestIfCompatible(dstimg);
+    }
+      
+    if (m->StatisticsOf()) {
+      // A metric that works on statistics. Collect the statistics of
+      // all consecutive metrics in one go unless this is already done.
+      if (!stats->isValid(m->StatisticsOf())) {
+	class Meter *n;
+	ULONG mask = 0;
+	for(n = m;n && n->StatisticsOf();n = n->NextOf()) {
+	  mask |= n->StatisticsOf();
+	}
+	stats->Collect(orgimg,dstimg,mask);
+      }
+      val = m->Evaluate(orgimg,*stats,val);
+    } else {
+      // Anything else may modify the images, unless it only reads
+      // their spectra. It may use the threads the statistics are
+      // collected with.
+      if (!m->isSpectral()) {
+	stats->Invalidate();
+	spectra.Invalidate();
+      }
+      m->UsePool(stats->PoolOf());
+      m->UseSpectra(&spectra);
+      m->UseBuffers(buffers);
+      val = m->Measure(orgimg,dstimg,val);
+      m->UseSpectra(NULL);
+      if (buffers)
+	buffers->Recycle(orgimg,dstimg);
     }
-    assert(org && dst);
-    orgimg = ImageLayout::LoadImage(org,spec1);
-    if (!strcmp(dst,"-")) { 
+    probe.Record(LabelOf(m),NULL,orgimg->SamplesOf() + dstimg->SamplesOf(),
+		 orgimg->SampleBytesOf() + dstimg->SampleBytesOf());
+    if (name && print) {
+      if (brief) {
+	printf("%g\n",val);
+      } else if (frame >= 0) {
+	printf("%s[%ld]:\t%g\n",name,long(frame),val);
+      } else {
+	printf("%s:\t%g\n",name,val);
+      }
+    }
+    if (name && results) {
+      *results++ = val;
+    }
+    if (name && report) {
+      report->AddResult(m,val,timer.ElapsedOf());
+      timer.Start();
+    }
+  }
+  // The images are modified or gone after this.
+  stats->Invalidate();
+}
+///
+
+/// MeasureSequence
+// Run the agenda on all frames of two raw image sequences and print
+// the results of each frame, followed by their mean and minimum over
+// all frames, and for results in dB also the value computed from the
+// averaged MSE. The file formats are only parsed once, and all frames
+// are read into the same buffers. The agenda is rebuilt from the
+// options for each frame as meters may keep state of the images they
+// were run on.
+void MeasureSequence(int argc,char **argv,const char *org,const char *dst,
+		     struct Options &opts,class Statistics *stats)
+{
+  class SimpleRaw orgseq,dstseq;
+  class BufferPool buffers;
+  class ImageLayout *orgcpy = NULL;
+  class ImageLayout *dstcpy = NULL;
+  class Meter *agenda       = NULL,*m;
+  const char **names        = NULL;
+  bool   *decibel           = NULL;
+  double *results           = NULL;
+  double *sum               = NULL;
+  double *min               = NULL;
+  double *mse               = NULL;
+  ULONG  i,count            = 0;
+  ULONG  frames             = 0;
+  LONG   frame;
+
+  orgseq.OpenSequence(org,opts.spec1);
+  dstseq.OpenSequence(dst,opts.spec2);
+
+  try {
+    for(frame = opts.first;opts.count == 0 || frame < opts.first + opts.count;frame++) {
+      int    fargc = argc;
+      char **fargv = argv;
+      struct Options fopts;
+      //
+      if (!orgseq.LoadFrame(frame) || !dstseq.LoadFrame(frame)) {
+	if (opts.count)
+	  throw "the image sequences end before the last requested frame";
+	break;
+      }
+      //
+      // Work on copies of the layouts such that the frame buffers
+      // remain available for the next frame.
+      class ImageLayout orgimg(orgseq);
+      class ImageLayout dstimg(dstseq);
+      orgcpy = new class ImageLayout(orgseq);
+      dstcpy = new class ImageLayout(dstseq);
+      agenda = ParseAgenda(fargc,fargv,fopts,orgcpy,dstcpy);
+      fopts.specout.MergeSpecs(opts.spec1,opts.spec2);
+      if (fopts.restore)
+	buffers.Protect(orgcpy,dstcpy);
+      //
+      if (names == NULL) {
+	count   = CountResults(agenda);
+	names   = new const char *[count];
+	decibel = new bool[count];
+	results = new double[count];
+	sum     = new double[count];
+	min     = new double[count];
+	mse     = new double[count];
+	for(m = agenda,i = 0;m;m = m->NextOf()) {
+	  if (m->NameOf()) {
+	    names[i]   = m->NameOf();
+	    decibel[i] = m->isDecibel();
+	    sum[i]     = 0.0;
+	    min[i]     = HUGE_VAL;
+	    mse[i]     = 0.0;
+	    i++;
+	  }
+	}
+      }
+      //
+      MeasureImages(agenda,&orgimg,&dstimg,stats,&buffers,opts.brief,true,frame,results,NULL);
+      //
+      for(i = 0;i < count;i++) {
+	sum[i] += results[i];
+	if (results[i] < min[i])
+	  min[i] = results[i];
+	if (decibel[i])
+	  mse[i] += pow(10.0,-results[i] / 10.0);
+      }
+      frames++;
+      //
+      while((m = agenda)) {
+	agenda = m->NextOf();
+	delete m;
+      }
+      buffers.Protect(NULL,NULL);
+      delete orgcpy;
+      orgcpy = NULL;
+      delete dstcpy;
+      dstcpy = NULL;
+      //
+      // The buffers of this frame can be reused for the next.
+      buffers.Recycle(NULL,NULL);
+    }
+    //
+    if (frames == 0)
+      throw "the image sequences do not contain the requested frames";
+    //
+    for(i = 0;i < count;i++) {
+      if (opts.brief) {
+	printf("%g\n%g\n",sum[i] / frames,min[i]);
+	if (decibel[i])
+	  printf("%g\n",-10.0 * log10(mse[i] / frames));
+      } else {
+	printf("mean %s:\t%g\n",names[i],sum[i] / frames);
+	printf("min %s:\t%g\n",names[i],min[i]);
+	if (decibel[i])
+	  printf("MSE averaged %s:\t%g\n",names[i],-10.0 * log10(mse[i] / frames));
+      }
+    }
+  } catch(...) {
+    while((m = agenda)) {
+      agenda = m->NextOf();
+      delete m;
+    }
+    delete orgcpy;
+    delete dstcpy;
+    delete[] names;
+    delete[] decibel;
+    delete[] results;
+    delete[] sum;
+    delete[] min;
+    delete[] mse;
+    throw;
+  }
+  
+  delete[] names;
+  delete[] decibel;
+  delete[] results;
+  delete[] sum;
+  delete[] min;
+  delete[] mse;
+}
+///
+
+/// isStreamable
+// Check whether the agenda can be run on horizontal bands of the two
+// images, i.e. whether it only consists of point-wise filters, metrics
+// working on statistics and checks of their results, and whether the
+// images have the same layout.
+bool isStreamable(class Meter *agenda,const class ImageLayout *orgimg,const class ImageLayout *dstimg)
+{
+  UWORD comp;
+
+  for(;agenda;agenda = agenda->NextOf()) {
+    if (agenda->StatisticsOf() == 0 && !agenda->isPointWise() && !agenda->isResultOnly())
+      return false;
+  }
+
+  if (orgimg->WidthOf() != dstimg->WidthOf() || orgimg->HeightOf() != dstimg->HeightOf() ||
+      orgimg->DepthOf() != dstimg->DepthOf() || orgimg->HeightOf() == 0)
+    return false;
+
+  for(comp = 0;comp < orgimg->DepthOf();comp++) {
+    if (orgimg->SubYOf(comp) != dstimg->SubYOf(comp) ||
+	orgimg->HeightOf(comp) != dstimg->HeightOf(comp))
+      return false;
+  }
+
+  return true;
+}
+///
+
+/// CacheRowsOf
+// Return the number of rows of bands of two images of the layout of
+// img that fit into the cache once converted to floating point, such
+// that a chain of filters works on samples still in the cache.
+ULONG CacheRowsOf(const class ImageLayout *img)
+{
+  const UQUAD cache = 1 << 20;
+  UQUAD bytes       = 0;
+  UWORD comp;
+
+  for(comp = 0;comp < img->DepthOf();comp++) {
+    bytes += 2 * sizeof(FLOAT) * UQUAD(img->WidthOf(comp));
+  }
+
+  if (bytes == 0 || bytes >= cache)
+    return 1;
+
+  return ULONG(cache / bytes);
+}
+///
+
+/// StreamRowsOf
+// Return the height of the bands the images are run on in streaming
+// mode. It is rounded up such that the statistics are identical to
+// those of the complete images.
+ULONG StreamRowsOf(const struct Options &opts,class ImageLayout *orgimg)
+{
+  ULONG unit = Statistics::RowsOf(orgimg);
+  ULONG rows = (opts.stream > 0)?(ULONG(opts.stream)):(CacheRowsOf(orgimg));
+
+  return ((rows + unit - 1) / unit) * unit;
+}
+///
+
+/// isStreamed
+// Check whether the agenda is run on bands of the images, which is
+// only done if requested. Filters then pass each band on to the next
+// filter, and the metrics at the end collect their statistics from
+// it. The full-size intermediate images are never created.
+bool isStreamed(const struct Options &opts,class Meter *agenda,
+		class ImageLayout *orgimg,const class ImageLayout *dstimg)
+{
+  return opts.stream != 0 && isStreamable(agenda,orgimg,dstimg);
+}
+///
+
+/// MeasureStream
+// Run the agenda on horizontal bands of the two images and print the
+// results unless print is false. If results is non-NULL, the results
+// are also stored there in agenda order, and if report is non-NULL,
+// they are recorded there along with the time spent on them over all
+// bands. Filters then only allocate memory for a band rather than for
+// the complete images, and the metrics accumulate their statistics band
+// by band. The band height is rounded up such that the statistics are
+// identical to those of the complete images. The meters are restarted
+// before each band to release what they kept of the previous one. If
+// buffers is non-NULL, the filters take their band buffers from this
+// pool such that all bands share the same memory. Unless the band
+// height is given, bands fit into the cache.
+void MeasureStream(class Meter *agenda,class ImageLayout *orgimg,class ImageLayout *dstimg,
+		   struct Options &opts,class ThreadPool *pool,class BufferPool *buffers,
+		   bool print,double *results,class Report *report)
+{
+  ULONG rows   = StreamRowsOf(opts,orgimg);
+  ULONG height = orgimg->HeightOf();
+  ULONG count  = CountResults(agenda);
+  class BandLayout orgband(*orgimg,rows);
+  class BandLayout dstband(*dstimg,rows);
+  class BandLayout shape(*orgimg,0);
+  class Statistics **stats   = NULL;
+  class Meter *m;
+  double *seconds            = NULL;
+  ULONG groups               = 0;
+  bool group                 = false;
+  ULONG g,i,y;
+
+  //
+  // One set of statistics for each group of consecutive metrics.
+  for(m = agenda;m;m = m->NextOf()) {
+    if (m->StatisticsOf() && !group)
+      groups++;
+    group = (m->StatisticsOf() != 0);
+  }
+
+  try {
+    stats = new class Statistics *[groups];
+    for(g = 0;g < groups;g++)
+      stats[g] = NULL;
+    for(g = 0;g < groups;g++)
+      stats[g] = new class Statistics(pool);
+    //
+    seconds = new double[count];
+    for(i = 0;i < count;i++)
+      seconds[i] = 0.0;
+    //
+    for(y = 0;y < height;y += rows) {
+      bool   last   = (height - y <= rows);
+      double val    = 0.0;
+      class Timer timer;
+      //
+      orgband.Fill(y);
+      dstband.Fill(y);
+      for(m = agenda;m;m = m->NextOf())
+	m->Restart();
+      if (buffers)
+	buffers->Recycle(&orgband,&dstband);
+      //
+      group = false;
+      for(m = agenda,g = 0,i = 0;m;m = m->NextOf()) {
+	const char *name = m->NameOf();
+	class Profile::Probe probe;
+	//
+	if (name)
+	  orgband.TestIfCompatible(&dstband);
+	//
+	if (m->StatisticsOf()) {
+	  if (!group) {
+	    // Collect the statistics of all consecutive metrics in one go.
+	    class Statistics *st = stats[g++];
+	    class Meter *n;
+	    ULONG mask = 0;
+	    for(n = m;n && n->StatisticsOf();n = n->NextOf()) {
+	      mask |= n->StatisticsOf();
+	    }
+	    if (y == 0) {
+	      shape.Describe(orgband);
+	      st->Start(&shape,mask);
+	    }
+	    st->Accumulate(&orgband,&dstband,y);
+	    if (last)
+	      st->Finish();
+	    group = true;
+	  }
+	  if (last) {
+	    shape.Describe(orgband);
+	    val = m->Evaluate(&shape,*stats[g - 1],val);
+	  }
+	} else {
+	  group = false;
+	  // Checks of the results only run once all results are available.
+	  if (last || !m->isResultOnly()) {
+	    m->UseBuffers(buffers);
+	    val = m->Measure(&orgband,&dstband,val);
+	    if (buffers)
+	      buffers->Recycle(&orgband,&dstband);
+	  }
+	}
+	probe.Record(LabelOf(m),NULL,orgband.SamplesOf() + dstband.SamplesOf(),
+		     orgband.SampleBytesOf() + dstband.SampleBytesOf());
+	if (name && last && print) {
+	  if (opts.brief) {
+	    printf("%g\n",val);
+	  } else {
+	    printf("%s:\t%g\n",name,val);
+	  }
+	}
+	if (name && last && results) {
+	  *results++ = val;
+	}
+	if (name) {
+	  seconds[i] += timer.ElapsedOf();
+	  timer.Start();
+	  if (last && report)
+	    report->AddResult(m,val,seconds[i]);
+	  i++;
+	}
+      }
+    }
+  } catch(...) {
+    if (stats) {
+      for(g = 0;g < groups;g++)
+	delete stats[g];
+      delete[] stats;
+    }
+    delete[] seconds;
+    throw;
+  }
+
+  for(g = 0;g < groups;g++)
+    delete stats[g];
+  delete[] stats;
+  delete[] seconds;
+}
+///
+
+/// MeasurePair
+// Load two images, run a fresh agenda built from the options on them
+// and store the results in agenda order without printing them. This is
+// the work unit of batch mode, it does not share any state with pairs
+// measured at the same time on other threads.
+void MeasurePair(int argc,char **argv,const char *org,const char *dst,double *results)
+{
+  class Meter *agenda       = NULL,*m;
+  class ImageLayout *orgimg = NULL;
+  class ImageLayout *dstimg = NULL;
+  class ImageLayout *orgcpy = NULL;
+  class ImageLayout *dstcpy = NULL;
+  class Statistics stats;
+  class BufferPool buffers;
+  struct Options opts;
+  int    fargc = argc;
+  char **fargv = argv;
+
+  try {
+    agenda = ParseAgenda(fargc,fargv,opts,orgcpy,dstcpy);
+    orgimg = ImageLayout::LoadImage(org,opts.spec1);
+    if (!strcmp(dst,"-")) {
       dstimg = ImageLayout::CloneLayout(orgimg);
     } else {
-      dstimg = ImageLayout::LoadImage(dst,spec2);
+      dstimg = ImageLayout::LoadImage(dst,opts.spec2);
     }
-    // Make copies of the images.
-    orgcpy   = new ImageLayout(*orgimg);
-    dstcpy   = new ImageLayout(*dstimg);
+    orgcpy = new ImageLayout(*orgimg);
+    dstcpy = new ImageLayout(*dstimg);
+    if (opts.restore)
+      buffers.Protect(orgcpy,dstcpy);
     //
-    specout.MergeSpecs(spec1,spec2);
+    opts.specout.MergeSpecs(opts.spec1,opts.spec2);
     //
+    if (isStreamed(opts,agenda,orgimg,dstimg)) {
+      MeasureStream(agenda,orgimg,dstimg,opts,NULL,&buffers,false,results,NULL);
+    } else {
+      MeasureImages(agenda,orgimg,dstimg,&stats,&buffers,opts.brief,false,-1,results,NULL);
+    }
+  } catch(...) {
+    while((m = agenda)) {
+      agenda = m->NextOf();
+      delete m;
+    }
+    delete orgcpy;
+    delete dstcpy;
+    delete orgimg;
+    delete dstimg;
+    throw;
+  }
+
+  while((m = agenda)) {
+    agenda = m->NextOf();
+    delete m;
+  }
+  delete orgcpy;
+  delete dstcpy;
+  delete orgimg;
+  delete dstimg;
+}
+///
 
+/// class BatchJob
+// Measures a chunk of the pairs of a batch, one pair per work item,
+// and keeps the results and errors for printing them in order.
+class BatchJob : public ThreadPool::Job {
+  //
+  // The complete command line, the agenda is rebuilt from it for
+  // each pair.
+  int          m_iArgc;
+  char       **m_ppcArgv;
+  //
+  // The original and distorted image names of all pairs.
+  const char **m_ppcOrg;
+  const char **m_ppcDst;
+  //
+  // The first pair of the current chunk.
+  ULONG        m_ulFirst;
+  //
+  // The number of results per pair.
+  ULONG        m_ulCount;
+  //
+  // The results of the pairs of the chunk, m_ulCount per pair.
+  double      *m_pdResults;
+  //
+  // The error messages of the pairs of the chunk, empty if the
+  // pair was measured successfully.
+  char        *m_pcErrors;
+  //
+public:
+  enum {
+    ErrorSize = 256
+  };
+  //
+  BatchJob(int argc,char **argv,const char **org,const char **dst,ULONG count,ULONG chunk)
+    : m_iArgc(argc), m_ppcArgv(argv), m_ppcOrg(org), m_ppcDst(dst),
+      m_ulFirst(0), m_ulCount(count), m_pdResults(NULL), m_pcErrors(NULL)
+  {
+    m_pdResults = new double[chunk * (count + 1)];
+    try {
+      m_pcErrors = new char[chunk * ErrorSize];
+    } catch(...) {
+      delete[] m_pdResults;
+      throw;
+    }
+  }
+  //
+  virtual ~BatchJob(void)
+  {
+    delete[] m_pdResults;
+    delete[] m_pcErrors;
+  }
+  //
+  // Start a new chunk at the given pair.
+  void Start(ULONG first)
+  {
+    m_ulFirst = first;
+  }
+  //
+  // Measure a pair of the current chunk.
+  virtual void Run(ULONG item)
+  {
+    char *error = m_pcErrors + item * ErrorSize;
     //
-    // Now perform the measurements on all images.
-    double val = 0.0;
-    for(m = agenda;m;m = m->NextOf()) {
-      const char *name = m->NameOf();
-
-      if (name) {
-	// A real measurement. Compare the image dimensions.
-	// Compare the images, at least the dimensions and the precisions must be
-	// equal.
-	orgimg->TestIfCompatible(dstimg);
+    error[0] = '\0';
+    try {
+      MeasurePair(m_iArgc,m_ppcArgv,m_ppcOrg[m_ulFirst + item],m_ppcDst[m_ulFirst + item],
+		  m_pdResults + item * m_ulCount);
+    } catch(const char *msg) {
+      strncpy(error,msg,ErrorSize - 1);
+      error[ErrorSize - 1] = '\0';
+    } catch(const std::bad_alloc &) {
+      strcpy(error,"out of memory");
+    } catch(...) {
+      strcpy(error,"caught unknown exception");
+    }
+  }
+  //
+  // Return the results of a pair of the current chunk.
+  const double *ResultsOf(ULONG item) const
+  {
+    return m_pdResults + item * m_ulCount;
+  }
+  //
+  // Return the error message of a pair of the current chunk, or
+  // NULL if it was measured successfully.
+  const char *ErrorOf(ULONG item) const
+  {
+    const char *error = m_pcErrors + item * ErrorSize;
+
+    return (*error)?(error):(NULL);
+  }
+};
+///
+
+/// MeasureBatch
+// Measure all image pairs listed in the batch file, one pair of the
+// form "original distorted [label]" per line, and print one row of
+// results per pair in the order of the list. Empty lines and lines
+// starting with '#' are ignored. Pairs are measured concurrently on
+// the threads of the pool, if there is one, in chunks such that the
+// rows can be printed as they become available. Returns the number of
+// pairs that failed.
+ULONG MeasureBatch(int argc,char **argv,class Meter *agenda,struct Options &opts,class ThreadPool *pool)
+{
+  FILE *list               = fopen(opts.batch,"r");
+  char *text               = NULL;
+  const char **org         = NULL;
+  const char **dst         = NULL;
+  const char **label       = NULL;
+  class BatchJob *job      = NULL;
+  class Meter *m;
+  ULONG size               = 0;
+  ULONG pairs              = 0;
+  ULONG count              = CountResults(agenda);
+  ULONG chunk              = (pool)?(pool->ThreadsOf() * 4):(1);
+  ULONG failed             = 0;
+  ULONG i,j,first;
+
+  if (list == NULL)
+    throw "cannot open the batch list file";
+
+  try {
+    char *line,*next;
+    size_t len;
+    //
+    // Read the complete list, then split it into lines and fields in place.
+    for(;;) {
+      char *grow = new char[size + 4096 + 1];
+      if (text) {
+	memcpy(grow,text,size);
+	delete[] text;
       }
-      
-      val = m->Measure(orgimg,dstimg,val);
-      if (name) {
-	if (brief) {
-	  printf("%g\n",val);
-	} else {
-	  printf("%s:\t%g\n",name,val);
+      text = grow;
+      len  = fread(text + size,1,4096,list);
+      size += len;
+      if (len < 4096)
+	break;
+    }
+    text[size] = '\0';
+    fclose(list);
+    list = NULL;
+    //
+    for(line = text;*line;line = next) {
+      next = line + strcspn(line,"\n");
+      if (*next)
+	next++;
+      pairs++;
+    }
+    org   = new const char *[pairs + 1];
+    dst   = new const char *[pairs + 1];
+    label = new const char *[pairs + 1];
+    //
+    for(line = text,pairs = 0;*line;line = next) {
+      const char *field[3];
+      char *p = line;
+      ULONG fields = 0;
+      //
+      next = line + strcspn(line,"\n");
+      if (*next)
+	*next++ = '\0';
+      while(*p) {
+	p += strspn(p," \t\r");
+	if (*p == '\0' || (*p == '#' && fields == 0))
+	  break;
+	if (fields >= 3)
+	  throw "lines of the batch list file must be of the form: original distorted [label]";
+	field[fields++] = p;
+	p += strcspn(p," \t\r");
+	if (*p)
+	  *p++ = '\0';
+      }
+      if (fields == 0)
+	continue;
+      if (fields < 2)
+	throw "lines of the batch list file must be of the form: original distorted [label]";
+      org[pairs]   = field[0];
+      dst[pairs]   = field[1];
+      label[pairs] = (fields > 2)?(field[2]):(field[1]);
+      pairs++;
+    }
+    //
+    if (!opts.brief) {
+      printf("label");
+      for(m = agenda;m;m = m->NextOf()) {
+	if (m->NameOf())
+	  printf("\t%s",m->NameOf());
+      }
+      printf("\n");
+    }
+    //
+    job = new class BatchJob(argc,argv,org,dst,count,chunk);
+    for(first = 0;first < pairs;first += chunk) {
+      ULONG items = (pairs - first < chunk)?(pairs - first):(chunk);
+      //
+      job->Start(first);
+      if (pool) {
+	pool->Dispatch(job,items);
+      } else {
+	for(i = 0;i < items;i++)
+	  job->Run(i);
+      }
+      //
+      for(i = 0;i < items;i++) {
+	const char *error = job->ErrorOf(i);
+	if (!opts.brief)
+	  printf("%s",label[first + i]);
+	for(j = 0;j < count;j++) {
+	  const char *sep = (j > 0 || !opts.brief)?("\t"):("");
+	  if (error) {
+	    printf("%snan",sep);
+	  } else {
+	    printf("%s%g",sep,job->ResultsOf(i)[j]);
+	  }
 	}
+	printf("\n");
+	if (error) {
+	  fprintf(stderr,"*** Program failed on %s %s : %s ***\n",org[first + i],dst[first + i],error);
+	  failed++;
+	}
+      }
+      fflush(stdout);
+    }
+  } catch(...) {
+    if (list)
+      fclose(list);
+    delete job;
+    delete[] org;
+    delete[] dst;
+    delete[] label;
+    delete[] text;
+    throw;
+  }
+
+  delete job;
+  delete[] org;
+  delete[] dst;
+  delete[] label;
+  delete[] text;
+
+  return failed;
+}
+///
+
+/// main
+int main(int argc,char **argv)
+{
+  class Meter *agenda = NULL,*m;
+  const char *org = NULL;
+  const char *dst = NULL;
+  const char *name = argv[0];
+  class ImageLayout *orgimg = NULL;
+  class ImageLayout *dstimg = NULL;
+  class ImageLayout *orgcpy = NULL;
+  class ImageLayout *dstcpy = NULL;
+  class ThreadPool *pool  = NULL;
+  class Statistics *stats = NULL;
+  class BufferPool *buffers = NULL;
+  class Report *report    = NULL;
+  class Profile *profile  = NULL;
+  struct Options opts;
+  int   rc    = 0;
+
+  try {
+    int    aargc = argc;
+    char **aargv = argv;
+    //
+    agenda = ParseAgenda(argc,argv,opts,orgcpy,dstcpy);
+    if (opts.help) {
+      while((m = agenda)) {
+	agenda = m->NextOf();
+	delete m;
+      }
+      return 0;
+    }
+    if (opts.batch) {
+      if (argc != 1) {
+	Usage(name);
+	throw "the image pairs are taken from the batch list file, no images on the command line allowed";
+      }
+      if (opts.first >= 0)
+	throw "--batch cannot be combined with --frames";
+      if (opts.format != Report::Text)
+	throw "--json and --csv are not available in batch mode";
+      if (opts.profile)
+	throw "--profile is not available in batch mode";
+      // All pairs would write to the same file.
+      for(m = agenda;m;m = m->NextOf()) {
+	if (m->TargetOf())
+	  throw "options writing images or files are not available in batch mode";
+      }
+    } else if (argc == 3) {
+      org = argv[1];
+      dst = argv[2];
+    } else {
+      Usage(name);
+      throw "requires exactly two mandatory arguments, original and distorted image";
+    }
+    if (opts.first >= 0 && opts.format != Report::Text)
+      throw "--json and --csv are not available in sequence mode";
+    if (opts.threads != 1)
+      pool = new class ThreadPool(opts.threads);
+    stats  = new class Statistics(pool);
+    buffers = new class BufferPool;
+    if (opts.format != Report::Text)
+      report = new class Report;
+    if (opts.profile)
+      profile = new class Profile;
+    if (opts.batch) {
+      // Batch mode. The agenda is rebuilt for each pair.
+      if (MeasureBatch(aargc,aargv,agenda,opts,pool))
+	rc = 10;
+    } else if (opts.first >= 0) {
+      // Sequence mode. The agenda is rebuilt for each frame.
+      while((m = agenda)) {
+	agenda = m->NextOf();
+	delete m;
+      }
+      MeasureSequence(aargc,aargv,org,dst,opts,stats);
+    } else {
+      class Timer timer;
+      //
+      orgimg = ImageLayout::LoadImage(org,opts.spec1,pool);
+      if (!strcmp(dst,"-")) { 
+	dstimg = ImageLayout::CloneLayout(orgimg);
+      } else {
+	dstimg = ImageLayout::LoadImage(dst,opts.spec2,pool);
+      }
+      if (report) {
+	report->AddStage("load",timer.ElapsedOf());
+	report->AddImage("original",org,orgimg);
+	report->AddImage("distorted",dst,dstimg);
+      }
+      // Make copies of the images. These only copy the layout, the
+      // samples are shared.
+      class Profile::Probe copy;
+      orgcpy   = new ImageLayout(*orgimg);
+      dstcpy   = new ImageLayout(*dstimg);
+      copy.Record("copy",NULL,0,0);
+      //
+      // Filters working in place must leave the copies alone.
+      if (opts.restore)
+	buffers->Protect(orgcpy,dstcpy);
+      //
+      opts.specout.MergeSpecs(opts.spec1,opts.spec2);
+      //
+      // Now perform the measurements on all images, or on bands of
+      // them if requested and possible.
+      timer.Start();
+      if (isStreamed(opts,agenda,orgimg,dstimg)) {
+	MeasureStream(agenda,orgimg,dstimg,opts,pool,buffers,report == NULL,NULL,report);
+      } else {
+	MeasureImages(agenda,orgimg,dstimg,stats,buffers,opts.brief,report == NULL,-1,NULL,report);
+      }
+      if (report) {
+	report->AddStage("measure",timer.ElapsedOf());
+	report->Print(opts.format);
       }
     }
   } catch(const char *error) {
@@ -1829,6 +2862,12 @@ int main(int argc,char **argv)
     rc = 20;
   }
 
+  if (profile) {
+    // Keep the results in front of the profile.
+    fflush(stdout);
+    profile->Print(stderr);
+    delete profile;
+  }
   if (orgcpy)
     delete orgcpy;
   if (dstcpy)
@@ -1837,11 +2876,21 @@ int main(int argc,char **argv)
     delete orgimg;
   if (dstimg)
     delete dstimg;
+  if (stats)
+    delete stats;
+  if (report)
+    delete report;
+  if (pool)
+    delete pool;
 
   while((m = agenda)) {
     agenda = m->NextOf();
     delete m;
   }
+  //
+  // Released last, the images may refer to its buffers up to here.
+  if (buffers)
+    delete buffers;
 
   return rc;
 }
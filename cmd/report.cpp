@@ -0,0 +1,331 @@
+/*************************************************************************
+** Written by Thomas Richter (THOR Software) for Accusoft	        **
+** All Rights Reserved							**
+**************************************************************************
+
+This source file is part of difftest_ng, a universal image measuring
+and conversion framework.
+
+    difftest_ng is free software: you can redistribute it and/or modify
+    it under the terms of the GNU General Public License as published by
+    the Free Software Foundation, either version 3 of the License, or
+    (at your option) any later version.
+
+    difftest_ng is distributed in the hope that it will be useful,
+    but WITHOUT ANY WARRANTY; without even the implied warranty of
+    MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+    GNU General Public License for more details.
+
+    You should have received a copy of the GNU General Public License
+    along with difftest_ng.  If not, see <http://www.gnu.org/licenses/>.
+
+*************************************************************************/
+/*
+ * Machine readable report
+ * 
+ * $Id$
+ *
+ * This class collects the results of all meters, their breakdown into
+ * components, the layout of the images and the time spent in the
+ * stages of the run, and prints them as JSON or CSV.
+ */
+
+/// Includes
+#include "cmd/report.hpp"
+#include "diff/meter.hpp"
+#include "img/imglayout.hpp"
+#include "std/stdio.hpp"
+#include "std/string.hpp"
+///
+
+/// Report::~Report
+Report::~Report(void)
+{
+  struct Image *img;
+  struct Result *res;
+  struct Stage *stage;
+
+  while((img = m_pImages)) {
+    m_pImages = img->m_pNext;
+    delete img;
+  }
+  while((res = m_pResults)) {
+    m_pResults = res->m_pNext;
+    delete res;
+  }
+  while((stage = m_pStages)) {
+    m_pStages = stage->m_pNext;
+    delete stage;
+  }
+}
+///
+
+/// Report::AddImage
+// Record the layout of an image. The role and file name must remain
+// valid while the report exists.
+void Report::AddImage(const char *role,const char *file,const class ImageLayout *layout)
+{
+  struct Image *img = new struct Image;
+  UWORD comp,d      = layout->DepthOf();
+
+  // Link in first such that the image is released along with the report.
+  *m_ppLastImage = img;
+  m_ppLastImage  = &img->m_pNext;
+  //
+  img->m_pcRole    = role;
+  img->m_pcFile    = file;
+  img->m_ulWidth   = layout->WidthOf();
+  img->m_ulHeight  = layout->HeightOf();
+  img->m_usDepth   = d;
+  img->m_pulWidth  = new ULONG[d];
+  img->m_pulHeight = new ULONG[d];
+  img->m_pucBits   = new UBYTE[d];
+  img->m_pbSigned  = new bool[d];
+  img->m_pbFloat   = new bool[d];
+  //
+  for(comp = 0;comp < d;comp++) {
+    img->m_pulWidth[comp]  = layout->WidthOf(comp);
+    img->m_pulHeight[comp] = layout->HeightOf(comp);
+    img->m_pucBits[comp]   = layout->BitsOf(comp);
+    img->m_pbSigned[comp]  = layout->isSigned(comp);
+    img->m_pbFloat[comp]   = layout->isFloat(comp);
+  }
+}
+///
+
+/// Report::AddResult
+// Record the result of a meter along with its breakdown into
+// components and the seconds it took.
+void Report::AddResult(const class Meter *meter,double value,double seconds)
+{
+  struct Result *res = new struct Result;
+  const char *name   = meter->NameOf();
+  const char *option = meter->OptionOf();
+  UWORD comp,d       = meter->ComponentsOf();
+
+  *m_ppLastResult = res;
+  m_ppLastResult  = &res->m_pNext;
+  //
+  res->m_pcName   = new char[strlen(name) + 1];
+  strcpy(res->m_pcName,name);
+  if (option) {
+    res->m_pcOption = new char[strlen(option) + 1];
+    strcpy(res->m_pcOption,option);
+  }
+  res->m_dValue   = value;
+  res->m_dSeconds = seconds;
+  //
+  if (d) {
+    res->m_pdComponents = new double[d];
+    res->m_usComponents = d;
+    for(comp = 0;comp < d;comp++)
+      res->m_pdComponents[comp] = meter->ComponentOf(comp);
+  }
+}
+///
+
+/// Report::AddStage
+// Record the seconds a stage of the run took. The name must remain
+// valid while the report exists.
+void Report::AddStage(const char *name,double seconds)
+{
+  struct Stage *stage = new struct Stage;
+
+  *m_ppLastStage = stage;
+  m_ppLastStage  = &stage->m_pNext;
+  //
+  stage->m_pcName   = name;
+  stage->m_dSeconds = seconds;
+}
+///
+
+/// Report::PrintJSONString
+// Print a string as JSON string, including the quotes.
+void Report::PrintJSONString(const char *str)
+{
+  putchar('"');
+  for(;*str;str++) {
+    unsigned char c = *str;
+    if (c == '"' || c == '\\') {
+      printf("\\%c",c);
+    } else if (c < 0x20) {
+      printf("\\u%04x",c);
+    } else {
+      putchar(c);
+    }
+  }
+  putchar('"');
+}
+///
+
+/// Report::PrintCSVString
+// Print a string as CSV field, quoted with embedded quotes doubled.
+void Report::PrintCSVString(const char *str)
+{
+  putchar('"');
+  for(;*str;str++) {
+    if (*str == '"')
+      putchar('"');
+    putchar(*str);
+  }
+  putchar('"');
+}
+///
+
+/// Report::PrintCSVResult
+// Print the section, name and option fields of a result row as CSV.
+void Report::PrintCSVResult(const struct Result *res)
+{
+  printf("result,");
+  PrintCSVString(res->m_pcName);
+  putchar(',');
+  if (res->m_pcOption)
+    PrintCSVString(res->m_pcOption);
+}
+///
+
+/// Report::PrintJSONNumber
+// Print a number as JSON, which has no representation for
+// infinities and NANs. These become null. The exponent is checked
+// directly as the program is compiled with finite math.
+void Report::PrintJSONNumber(double val)
+{
+  UQUAD bits;
+
+  memcpy(&bits,&val,sizeof(bits));
+  if (((bits >> 52) & 0x7ff) == 0x7ff) {
+    printf("null");
+  } else {
+    printf("%.10g",val);
+  }
+}
+///
+
+/// Report::PrintJSON
+// Print the collected data as a single JSON object.
+void Report::PrintJSON(void) const
+{
+  const struct Image *img;
+  const struct Result *res;
+  const struct Stage *stage;
+  UWORD comp;
+
+  printf("{\n  \"images\": [");
+  for(img = m_pImages;img;img = img->m_pNext) {
+    printf("%s\n    {\"role\": ",(img == m_pImages)?(""):(","));
+    PrintJSONString(img->m_pcRole);
+    printf(", \"file\": ");
+    PrintJSONString(img->m_pcFile);
+    printf(", \"width\": %lu, \"height\": %lu, \"depth\": %u, \"components\": [",
+	   (unsigned long)img->m_ulWidth,(unsigned long)img->m_ulHeight,
+	   (unsigned int)img->m_usDepth);
+    for(comp = 0;comp < img->m_usDepth;comp++) {
+      printf("%s\n      {\"width\": %lu, \"height\": %lu, \"bits\": %u, "
+	     "\"signed\": %s, \"float\": %s}",(comp)?(","):(""),
+	     (unsigned long)img->m_pulWidth[comp],(unsigned long)img->m_pulHeight[comp],
+	     (unsigned int)img->m_pucBits[comp],
+	     (img->m_pbSigned[comp])?("true"):("false"),
+	     (img->m_pbFloat[comp])?("true"):("false"));
+    }
+    printf("]}");
+  }
+  printf("\n  ],\n  \"results\": [");
+  for(res = m_pResults;res;res = res->m_pNext) {
+    printf("%s\n    {\"name\": ",(res == m_pResults)?(""):(","));
+    PrintJSONString(res->m_pcName);
+    printf(", \"option\": ");
+    if (res->m_pcOption) {
+      PrintJSONString(res->m_pcOption);
+    } else {
+      printf("null");
+    }
+    printf(", \"value\": ");
+    PrintJSONNumber(res->m_dValue);
+    printf(", \"seconds\": ");
+    PrintJSONNumber(res->m_dSeconds);
+    if (res->m_usComponents) {
+      printf(", \"components\": [");
+      for(comp = 0;comp < res->m_usComponents;comp++) {
+	if (comp)
+	  printf(", ");
+	PrintJSONNumber(res->m_pdComponents[comp]);
+      }
+      printf("]");
+    }
+    printf("}");
+  }
+  printf("\n  ],\n  \"stages\": [");
+  for(stage = m_pStages;stage;stage = stage->m_pNext) {
+    printf("%s\n    {\"name\": ",(stage == m_pStages)?(""):(","));
+    PrintJSONString(stage->m_pcName);
+    printf(", \"seconds\": ");
+    PrintJSONNumber(stage->m_dSeconds);
+    printf("}");
+  }
+  printf("\n  ]\n}\n");
+}
+///
+
+/// Report::PrintCSV
+// Print the collected data as CSV table with one value per row. The
+// option column is only filled in for results, the component column
+// is empty for values of the complete image.
+void Report::PrintCSV(void) const
+{
+  const struct Image *img;
+  const struct Result *res;
+  const struct Stage *stage;
+  UWORD comp;
+
+  printf("section,name,option,component,key,value\n");
+  for(img = m_pImages;img;img = img->m_pNext) {
+    printf("image,%s,,,file,",img->m_pcRole);
+    PrintCSVString(img->m_pcFile);
+    printf("\nimage,%s,,,width,%lu\n",img->m_pcRole,(unsigned long)img->m_ulWidth);
+    printf("image,%s,,,height,%lu\n",img->m_pcRole,(unsigned long)img->m_ulHeight);
+    printf("image,%s,,,depth,%u\n",img->m_pcRole,(unsigned int)img->m_usDepth);
+    for(comp = 0;comp < img->m_usDepth;comp++) {
+      printf("image,%s,,%u,width,%lu\n",img->m_pcRole,(unsigned int)comp,
+	     (unsigned long)img->m_pulWidth[comp]);
+      printf("image,%s,,%u,height,%lu\n",img->m_pcRole,(unsigned int)comp,
+	     (unsigned long)img->m_pulHeight[comp]);
+      printf("image,%s,,%u,bits,%u\n",img->m_pcRole,(unsigned int)comp,
+	     (unsigned int)img->m_pucBits[comp]);
+      printf("image,%s,,%u,signed,%d\n",img->m_pcRole,(unsigned int)comp,
+	     (img->m_pbSigned[comp])?(1):(0));
+      printf("image,%s,,%u,float,%d\n",img->m_pcRole,(unsigned int)comp,
+	     (img->m_pbFloat[comp])?(1):(0));
+    }
+  }
+  for(res = m_pResults;res;res = res->m_pNext) {
+    PrintCSVResult(res);
+    printf(",,value,%.10g\n",res->m_dValue);
+    PrintCSVResult(res);
+    printf(",,seconds,%.10g\n",res->m_dSeconds);
+    for(comp = 0;comp < res->m_usComponents;comp++) {
+      PrintCSVResult(res);
+      printf(",%u,value,%.10g\n",(unsigned int)comp,res->m_pdComponents[comp]);
+    }
+  }
+  for(stage = m_pStages;stage;stage = stage->m_pNext) {
+    printf("stage,%s,,,seconds,%.10g\n",stage->m_pcName,stage->m_dSeconds);
+  }
+}
+///
+
+/// Report::Print
+// Print everything collected in the given format to stdout.
+void Report::Print(Format format) const
+{
+  switch(format) {
+  case JSON:
+    PrintJSON();
+    break;
+  case CSV:
+    PrintCSV();
+    break;
+  case Text:
+    break;
+  }
+}
+///
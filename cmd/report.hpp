@@ -0,0 +1,176 @@
+/*************************************************************************
+** Written by Thomas Richter (THOR Software) for Accusoft	        **
+** All Rights Reserved							**
+**************************************************************************
+
+This source file is part of difftest_ng, a universal image measuring
+and conversion framework.
+
+    difftest_ng is free software: you can redistribute it and/or modify
+    it under the terms of the GNU General Public License as published by
+    the Free Software Foundation, either version 3 of the License, or
+    (at your option) any later version.
+
+    difftest_ng is distributed in the hope that it will be useful,
+    but WITHOUT ANY WARRANTY; without even the implied warranty of
+    MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+    GNU General Public License for more details.
+
+    You should have received a copy of the GNU General Public License
+    along with difftest_ng.  If not, see <http://www.gnu.org/licenses/>.
+
+*************************************************************************/
+/*
+ * Machine readable report
+ * 
+ * $Id$
+ *
+ * This class collects the results of all meters, their breakdown into
+ * components, the layout of the images and the time spent in the
+ * stages of the run, and prints them as JSON or CSV.
+ */
+
+#ifndef CMD_REPORT_HPP
+#define CMD_REPORT_HPP
+
+/// Includes
+#include "interface/types.hpp"
+///
+
+/// Forwards
+class ImageLayout;
+class Meter;
+///
+
+/// class Report
+class Report {
+  //
+  // Layout of an image as loaded, before any filter modified it.
+  struct Image {
+    struct Image *m_pNext;
+    //
+    // What the image is used as, and where it came from.
+    const char   *m_pcRole;
+    const char   *m_pcFile;
+    //
+    // Dimensions of the image.
+    ULONG         m_ulWidth;
+    ULONG         m_ulHeight;
+    UWORD         m_usDepth;
+    //
+    // Dimensions and sample types of the components.
+    ULONG        *m_pulWidth;
+    ULONG        *m_pulHeight;
+    UBYTE        *m_pucBits;
+    bool         *m_pbSigned;
+    bool         *m_pbFloat;
+    //
+    Image(void)
+      : m_pNext(NULL), m_pulWidth(NULL), m_pulHeight(NULL),
+	m_pucBits(NULL), m_pbSigned(NULL), m_pbFloat(NULL)
+    { }
+    //
+    ~Image(void)
+    {
+      delete[] m_pulWidth;
+      delete[] m_pulHeight;
+      delete[] m_pucBits;
+      delete[] m_pbSigned;
+      delete[] m_pbFloat;
+    }
+  }             *m_pImages,**m_ppLastImage;
+  //
+  // Result of a single meter.
+  struct Result {
+    struct Result *m_pNext;
+    //
+    // Name of the meter, copied as the meter goes away before the
+    // report is printed.
+    char          *m_pcName;
+    //
+    // The command line option that created the meter, which tells
+    // meters of the same name apart. Copied for the same reason.
+    char          *m_pcOption;
+    //
+    // The result and the seconds it took to compute it.
+    double         m_dValue;
+    double         m_dSeconds;
+    //
+    // Results for the individual components, if any.
+    UWORD          m_usComponents;
+    double        *m_pdComponents;
+    //
+    Result(void)
+      : m_pNext(NULL), m_pcName(NULL), m_pcOption(NULL), m_usComponents(0), m_pdComponents(NULL)
+    { }
+    //
+    ~Result(void)
+    {
+      delete[] m_pcName;
+      delete[] m_pcOption;
+      delete[] m_pdComponents;
+    }
+  }             *m_pResults,**m_ppLastResult;
+  //
+  // A stage of the run and the seconds it took.
+  struct Stage {
+    struct Stage *m_pNext;
+    const char   *m_pcName;
+    double        m_dSeconds;
+    //
+    Stage(void)
+      : m_pNext(NULL)
+    { }
+  }             *m_pStages,**m_ppLastStage;
+  //
+  // Print a string as JSON or CSV string, including the quotes.
+  static void PrintJSONString(const char *str);
+  static void PrintCSVString(const char *str);
+  //
+  // Print the section, name and option fields of a result row as CSV.
+  static void PrintCSVResult(const struct Result *res);
+  //
+  // Print a number as JSON, which has no representation for
+  // infinities and NANs.
+  static void PrintJSONNumber(double val);
+  //
+  // Print the collected data in the two formats.
+  void PrintJSON(void) const;
+  void PrintCSV(void) const;
+  //
+public:
+  //
+  // Output formats.
+  enum Format {
+    Text,
+    JSON,
+    CSV
+  };
+  //
+  Report(void)
+    : m_pImages(NULL), m_ppLastImage(&m_pImages),
+      m_pResults(NULL), m_ppLastResult(&m_pResults),
+      m_pStages(NULL), m_ppLastStage(&m_pStages)
+  { }
+  //
+  ~Report(void);
+  //
+  // Record the layout of an image. The role and file name must remain
+  // valid while the report exists.
+  void AddImage(const char *role,const char *file,const class ImageLayout *img);
+  //
+  // Record the result of a meter along with its breakdown into
+  // components and the seconds it took.
+  void AddResult(const class Meter *meter,double value,double seconds);
+  //
+  // Record the seconds a stage of the run took. The name must remain
+  // valid while the report exists.
+  void AddStage(const char *name,double seconds);
+  //
+  // Print everything collected in the given format to stdout.
+  void Print(Format format) const;
+};
+///
+
+///
+#endif
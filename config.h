@@ -42,14 +42,15 @@ and conversion framework.
 #ifdef USE_AUTOCONF
 #include "autoconfig.h"
 //
-#if defined(HAVE_GSL_FFT_COMPLEX_BACKWARD) && defined(HAVE_GSL_FFT_COMPLEX_FORWARD) && defined(HAVE_GSL_FFT_COMPLEX_WORKSPACE_ALLOC) && defined(HAVE_GSL_FFT_COMPLEX_WORKSPACE_FREE) && defined(HAVE_GSL_GSL_FFT_COMPLEX_H)
-# define USE_GSL
-#endif
-//
 #if defined(HAVE_PNG_H)
 # define USE_PNG
 #endif
 //
+// zlib is linked in along with libpng.
+#if defined(HAVE_ZLIB_H) && defined(USE_PNG)
+# define USE_ZLIB
+#endif
+//
 #if defined(HAVE_IMATHBOX_H) && defined(HAVE_IMFINPUTFILE_H) && defined(HAVE_IMFRGBAFILE_H) && defined(HAVE_HALF_H)
 # define USE_EXR
 #endif
@@ -369,7 +370,6 @@ and conversion framework.
 # ifndef J2K_HIDDEN
 #  define J2K_HIDDEN
 # endif
-# define USE_GSL
 #endif
 ///
 
@@ -70,7 +70,7 @@ double AddImg::Measure(class ImageLayout *src,class ImageLayout *sr2,double in)
     m_pComponent[i+d1].m_pPtr            = const_cast<APTR>(sr2->DataOf(i));
   }
 
-  SaveImage(m_pcTargetFile,m_TargetSpecs);
+  SaveImage(m_pcTargetFile,m_TargetSpecs,PoolOf());
   
   return in;
 }
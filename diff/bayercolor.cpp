@@ -42,8 +42,8 @@ and conversion framework.
 /// BayerColor::~BayerColor
 BayerColor::~BayerColor(void)
 {
-  delete[] m_pucSrcImage;
-  delete[] m_pucDstImage;
+  ReleaseBuffer(m_pucSrcImage);
+  ReleaseBuffer(m_pucDstImage);
 }
 ///
 
@@ -526,7 +526,7 @@ void BayerColor::CreateImage(UBYTE *&target,class ImageLayout *src,bool extendsr
   //
   // Compute the number of bits per sample. 
   bps    = ImageLayout::SuggestBPP(targetbits,false);
-  target = new UBYTE[m_ulWidth * m_ulHeight * bps];
+  target = AllocateBuffer(m_ulWidth * m_ulHeight * bps);
   m_pComponent[0].m_ulBytesPerPixel = bps;
   m_pComponent[0].m_ulBytesPerRow   = bps * m_ulWidth;
   m_pComponent[0].m_pPtr            = target;
@@ -538,7 +538,7 @@ void BayerColor::CreateImage(UBYTE *&target,class ImageLayout *src,bool extendsr
 // single component image given as source.
 void BayerColor::Decorrelate(UBYTE *&target,class ImageLayout *src)
 {
-  delete[] target;
+  ReleaseBuffer(target);
   target = NULL;
   delete[] m_pComponent;
   m_pComponent = NULL;
@@ -602,7 +602,7 @@ void BayerColor::Decorrelate(UBYTE *&target,class ImageLayout *src)
 // the single component image given as source
 void BayerColor::InverseDecorrelate(UBYTE *&target,class ImageLayout *src)
 {
-  delete[] target;
+  ReleaseBuffer(target);
   target = NULL;
   delete[] m_pComponent;
   m_pComponent = NULL;
@@ -75,7 +75,7 @@ Butterfly::~Butterfly(void)
   if (m_ppucImage) {
     for(i = 0;i < m_usDepth;i++) {
       if (m_ppucImage[i])
-	delete[] m_ppucImage[i];
+	ReleaseBuffer(m_ppucImage[i]);
     }
     delete[] m_ppucImage;
   }
@@ -97,7 +97,7 @@ double Butterfly::Measure(class ImageLayout *src,class ImageLayout *dst,double i
     ULONG  w     = src->WidthOf(comp);
     ULONG  h     = src->HeightOf(comp);
     UBYTE  bytes = ImageLayout::SuggestBPP(src->BitsOf(comp),src->isFloat(comp));
-    UBYTE *mem   = new UBYTE[w * h * bytes];
+    UBYTE *mem   = AllocateBuffer(w * h * bytes);
     //
     m_ppucImage[comp]                    = mem;
     m_pComponent[comp].m_ucBits          = src->BitsOf(comp);
@@ -160,7 +160,7 @@ double Butterfly::Measure(class ImageLayout *src,class ImageLayout *dst,double i
     }
   }
 
-  SaveImage(m_pTargetFile,m_TargetSpecs);
+  SaveImage(m_pTargetFile,m_TargetSpecs,PoolOf());
 
   return in;
 }
@@ -74,6 +74,12 @@ public:
   {
     return NULL;
   }
+  //
+  // Only checks the result.
+  virtual bool isResultOnly(void) const
+  {
+    return true;
+  }
 };
 ///
 
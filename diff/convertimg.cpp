@@ -36,7 +36,7 @@ and conversion framework.
 /// ConvertImg::Measure
 double ConvertImg::Measure(class ImageLayout *src,class ImageLayout *,double in)
 {
-  src->SaveImage(m_pcTargetFile,m_TargetSpecs);
+  src->SaveImage(m_pcTargetFile,m_TargetSpecs,PoolOf());
   
   return in;
 }
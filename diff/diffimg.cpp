@@ -101,7 +101,7 @@ DiffImg::~DiffImg(void)
   if (m_ppucImage) {
     for(i = 0;i < m_usDepth;i++) {
       if (m_ppucImage[i])
-	delete[] m_ppucImage[i];
+	ReleaseBuffer(m_ppucImage[i]);
     }
     delete[] m_ppucImage;
   }
@@ -127,7 +127,7 @@ double DiffImg::Measure(class ImageLayout *src,class ImageLayout *dst,double in)
     ULONG  w     = src->WidthOf(comp);
     ULONG  h     = src->HeightOf(comp);
     UBYTE  bytes = (m_bScale)?1:ImageLayout::SuggestBPP(src->BitsOf(comp),src->isFloat(comp));
-    UBYTE *mem   = new UBYTE[w * h * bytes];
+    UBYTE *mem   = AllocateBuffer(w * h * bytes);
     //
     // Shift is the required shift to generate unsigned data from a
     // differential signal, before scaling to the target bitdepth.
@@ -288,7 +288,7 @@ double DiffImg::Measure(class ImageLayout *src,class ImageLayout *dst,double in)
     }
   }
 
-  SaveImage(m_pTargetFile,m_TargetSpecs);
+  SaveImage(m_pTargetFile,m_TargetSpecs,PoolOf());
 
   return in;
 }
@@ -85,6 +85,12 @@ public:
   {
     return NULL;
   }
+  //
+  // Return the file the output is written to, NULL if none.
+  virtual const char *TargetOf(void) const
+  {
+    return m_pTargetFile;
+  }
 };
 ///
 
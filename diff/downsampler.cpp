@@ -175,7 +175,7 @@ void Downsampler::ReleaseComponents(UBYTE **p)
   if (p) {
     for(i = 0;i < m_usAllocated;i++) {
       if (p[i])
-        delete[] p[i];
+        ReleaseBuffer(p[i]);
     }
     delete[] p;
     p = NULL;
@@ -233,7 +233,7 @@ void Downsampler::Downsample(UBYTE **&data,class ImageLayout *src)
   for(i = 0;i < m_usDepth;i++) {
     UBYTE bps = ImageLayout::SuggestBPP(m_pComponent[i].m_ucBits,m_pComponent[i].m_bFloat);
     //
-    data[i]                           = new UBYTE[m_pComponent[i].m_ulWidth * m_pComponent[i].m_ulHeight * bps];
+    data[i]                           = AllocateBuffer(m_pComponent[i].m_ulWidth * m_pComponent[i].m_ulHeight * bps);
     m_pComponent[i].m_ulBytesPerPixel = bps;
     m_pComponent[i].m_ulBytesPerRow   = bps * m_pComponent[i].m_ulWidth;
     m_pComponent[i].m_pPtr            = data[i];
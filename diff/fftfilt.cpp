@@ -34,7 +34,6 @@ and conversion framework.
 #include "tools/fft.hpp"
 #include "std/math.hpp"
 #include "std/string.hpp"
-#ifdef USE_GSL
 #include "img/imglayout.hpp"
 ///
 
@@ -51,12 +50,11 @@ void FFTFilt::CopyToFFT(T *org,ULONG obytesperpixel,ULONG obytesperrow,
     T *dstrow      = dst;
     double *trgrow = target + y * stride;
     for(x = 0;x < w;x++) {
-      trgrow[0]   = *orgrow - *dstrow; // real part
-      trgrow[1]   = 0.0; // imaginary part.
+      *trgrow     = *orgrow - *dstrow;
       //
       orgrow      = (T *)((const UBYTE *)(orgrow) + obytesperpixel);
       dstrow      = (T *)((const UBYTE *)(dstrow) + dbytesperpixel);
-      trgrow     += 2;
+      trgrow++;
     }
     org = (T *)((const UBYTE *)(org) + obytesperrow);
     dst = (T *)((const UBYTE *)(dst) + dbytesperrow);
@@ -76,7 +74,7 @@ void FFTFilt::CopyFromFFT(double *src,ULONG stride,ULONG w,ULONG h,
     T *dstrow      = dst;
     double *srcrow = src;
     for(x = 0;x < w;x++) {
-      double v = srcrow[0] * scale + shift; // The imaginary part should be zero. Or close to zero...
+      double v = *srcrow * scale + shift;
       if (v < min) {
 	*dstrow = min;
       } else if (v > max) {
@@ -85,7 +83,7 @@ void FFTFilt::CopyFromFFT(double *src,ULONG stride,ULONG w,ULONG h,
 	*dstrow = T(v);
       }
       dstrow      = (T *)((UBYTE *)(dstrow) + dbytesperpixel);
-      srcrow     += 2;
+      srcrow++;
     }
     dst = (T *)((UBYTE *)(dst) + dbytesperrow);
     src += stride;
@@ -101,7 +99,7 @@ FFTFilt::~FFTFilt(void)
   if (m_ppucImage) {
     for(i = 0;i < m_usDepth;i++) {
       if (m_ppucImage[i])
-        delete[] m_ppucImage[i];
+        ReleaseBuffer(m_ppucImage[i]);
     }
     delete[] m_ppucImage;
   }
@@ -180,7 +178,7 @@ void FFTFilt::FindMinMax(double *fft,ULONG stride,ULONG w,ULONG h,double &min,do
 
   for(y = 0;y < h;y++) {
     for(x = 0;x < w;x++) {
-      double v = fft[y * stride + (x << 1) + 0]; // only the real part.
+      double v = fft[y * stride + x];
       if (v < min)
 	min = v;
       if (v > max)
@@ -215,7 +213,7 @@ double FFTFilt::Measure(class ImageLayout *src,class ImageLayout *dst,double in)
     UBYTE sbpp  = ImageLayout::SuggestBPP(src->BitsOf(comp),src->isFloat(comp));
     ULONG x,y;
     //
-    m_ppucImage[comp]                    = mem = new UBYTE[w * h * sbpp];
+    m_ppucImage[comp]                    = mem = AllocateBuffer(w * h * sbpp);
     m_pComponent[comp].m_ucBits          = src->BitsOf(comp);
     m_pComponent[comp].m_bSigned         = src->isSigned(comp);
     m_pComponent[comp].m_bFloat          = src->isFloat(comp);
@@ -224,7 +222,7 @@ double FFTFilt::Measure(class ImageLayout *src,class ImageLayout *dst,double in)
     m_pComponent[comp].m_ulBytesPerPixel = sbpp;
     m_pComponent[comp].m_ulBytesPerRow   = w * sbpp;
     m_pComponent[comp].m_pPtr            = mem;
-    m_ppFFT[comp] = fft                  = new class FFT(w,h,false);
+    m_ppFFT[comp] = fft                  = new class FFT(w,h,false,PoolOf());
     //
     if (src->isSigned(comp)) {
       if (src->BitsOf(comp) <= 8) {
@@ -302,11 +300,17 @@ double FFTFilt::Measure(class ImageLayout *src,class ImageLayout *dst,double in)
     //
     //NormalizeFilter(m_pdFilter,w,w,h);
     //
-    // Now apply the filter.
+    // Now apply the filter. Only the coefficients of the non-negative
+    // frequencies are available, and the output is the real part of
+    // the filtered image. The filter is therefore made symmetric by
+    // averaging it with its mirror image.
     for(y = 0;y < h;y++) {
-      for(x = 0;x < w;x++) {
-	fft->DataOf()[y * fft->ModuloOf() + (x << 1) + 0] *= m_pdFilter[y * w + x];
-	fft->DataOf()[y * fft->ModuloOf() + (x << 1) + 1] *= m_pdFilter[y * w + x];
+      ULONG ym = (y)?(h - y):(0);
+      for(x = 0;x < fft->SpectrumWidthOf();x++) {
+	ULONG  xm = (x)?(w - x):(0);
+	double f  = 0.5 * (m_pdFilter[y * w + x] + m_pdFilter[ym * w + xm]);
+	fft->DataOf()[y * fft->ModuloOf() + (x << 1) + 0] *= f;
+	fft->DataOf()[y * fft->ModuloOf() + (x << 1) + 1] *= f;
       }
     }
     //
@@ -393,5 +397,3 @@ double FFTFilt::Measure(class ImageLayout *src,class ImageLayout *dst,double in)
   return in;
 }
 ///
-
-#endif
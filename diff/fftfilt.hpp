@@ -35,7 +35,6 @@ and conversion framework.
 /// Includes
 #include "diff/meter.hpp"
 #include "img/imglayout.hpp"
-#ifdef USE_GSL
 ///
 
 /// Forwards
@@ -107,9 +106,14 @@ public:
   {
     return NULL;
   }
+  //
+  // Return the file the output is written to, NULL if none.
+  virtual const char *TargetOf(void) const
+  {
+    return m_pTargetFile;
+  }
 };
 ///
 
 ///
 #endif
-#endif
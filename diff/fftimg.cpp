@@ -31,36 +31,10 @@ and conversion framework.
 
 /// Includes
 #include "diff/fftimg.hpp"
+#include "diff/spectra.hpp"
 #include "tools/fft.hpp"
 #include "std/math.hpp"
 #include "std/string.hpp"
-#ifdef USE_GSL
-///
-
-/// FFTImg::CopyToFFT
-template<typename T>
-void FFTImg::CopyToFFT(T *org,ULONG obytesperpixel,ULONG obytesperrow,
-		       T *dst,ULONG dbytesperpixel,ULONG dbytesperrow,
-		       double *target,ULONG stride,ULONG w,ULONG h)
-{
-  ULONG x,y;
-
-  for(y = 0;y < h;y++) {
-    T *orgrow      = org;
-    T *dstrow      = dst;
-    double *trgrow = target + y * stride;
-    for(x = 0;x < w;x++) {
-      trgrow[0]   = *orgrow - *dstrow; // real part
-      trgrow[1]   = 0.0; // imaginary part.
-      //
-      orgrow      = (T *)((const UBYTE *)(orgrow) + obytesperpixel);
-      dstrow      = (T *)((const UBYTE *)(dstrow) + dbytesperpixel);
-      trgrow     += 2;
-    }
-    org = (T *)((const UBYTE *)(org) + obytesperrow);
-    dst = (T *)((const UBYTE *)(dst) + dbytesperrow);
-  }
-}
 ///
 
 /// FFTImg::~FFTImg
@@ -71,18 +45,13 @@ FFTImg::~FFTImg(void)
   if (m_ppucImage) {
     for(i = 0;i < m_usDepth;i++) {
       if (m_ppucImage[i])
-        delete[] m_ppucImage[i];
+        ReleaseBuffer(m_ppucImage[i]);
     }
     delete[] m_ppucImage;
   }
 
-  if (m_ppFFT) {
-    for(i = 0;i < m_usDepth;i++) {
-      if (m_ppFFT[i])
-        delete m_ppFFT[i];
-    }
-    delete[] m_ppFFT;
-  }
+  // The spectra belong to the Spectra class.
+  delete[] m_ppFFT;
 
 }
 ///
@@ -92,6 +61,12 @@ double FFTImg::Measure(class ImageLayout *src,class ImageLayout *dst,double in)
 { 
   UWORD comp;
   double max = 0.0;
+  class Spectra own(PoolOf());
+  class Spectra *spectra = SpectraOf();
+  //
+  // Transform the images here unless the spectra are shared.
+  if (spectra == NULL)
+    spectra = &own;
 
   CreateComponents(*src);
   m_ppucImage = new UBYTE *[src->DepthOf()];
@@ -102,7 +77,7 @@ double FFTImg::Measure(class ImageLayout *src,class ImageLayout *dst,double in)
   for(comp = 0;comp < src->DepthOf();comp++) {
     ULONG  w    = src->WidthOf(comp);
     ULONG  h    = src->HeightOf(comp);
-    UBYTE *mem  = new UBYTE[w * h];
+    UBYTE *mem  = AllocateBuffer(w * h);
     class FFT *fft;
     ULONG  x,y;
     //
@@ -114,65 +89,12 @@ double FFTImg::Measure(class ImageLayout *src,class ImageLayout *dst,double in)
     m_pComponent[comp].m_ulBytesPerPixel = 1;
     m_pComponent[comp].m_ulBytesPerRow   = w;
     m_pComponent[comp].m_pPtr            = mem;
-    m_ppFFT[comp] = fft                  = new class FFT(w,h,m_bWindow);
-    //
-    if (src->isSigned(comp)) {
-      if (src->BitsOf(comp) <= 8) {
-	CopyToFFT<const BYTE>((const BYTE *)src->DataOf(comp),src->BytesPerPixel(comp),src->BytesPerRow(comp),
-			      (const BYTE *)dst->DataOf(comp),dst->BytesPerPixel(comp),dst->BytesPerRow(comp),
-			      fft->DataOf(),fft->ModuloOf(),w,h);
-      } else if (!src->isFloat(comp) && src->BitsOf(comp) <= 16) {
-	CopyToFFT<const WORD>((const WORD *)src->DataOf(comp),src->BytesPerPixel(comp),src->BytesPerRow(comp),
-			      (const WORD *)dst->DataOf(comp),dst->BytesPerPixel(comp),dst->BytesPerRow(comp),
-			      fft->DataOf(),fft->ModuloOf(),w,h);
-      } else if (!src->isFloat(comp) && src->BitsOf(comp) <= 32) {
-	CopyToFFT<const LONG>((const LONG *)src->DataOf(comp),src->BytesPerPixel(comp),src->BytesPerRow(comp),
-			      (const LONG *)dst->DataOf(comp),dst->BytesPerPixel(comp),dst->BytesPerRow(comp),
-			      fft->DataOf(),fft->ModuloOf(),w,h);
-      } else if (src->BitsOf(comp) <= 32 && src->isFloat(comp)) {
-	CopyToFFT<const FLOAT>((const FLOAT *)src->DataOf(comp),src->BytesPerPixel(comp),src->BytesPerRow(comp),
-			       (const FLOAT *)dst->DataOf(comp),dst->BytesPerPixel(comp),dst->BytesPerRow(comp),
-			       fft->DataOf(),fft->ModuloOf(),w,h);
-      } else if (src->BitsOf(comp) == 64 && src->isFloat(comp)) {
-	CopyToFFT<const DOUBLE>((const DOUBLE *)src->DataOf(comp),src->BytesPerPixel(comp),src->BytesPerRow(comp),
-				(const DOUBLE *)dst->DataOf(comp),dst->BytesPerPixel(comp),dst->BytesPerRow(comp),
-				fft->DataOf(),fft->ModuloOf(),w,h);
-      } else {
-	throw "unsupported data type";
-      }
-    } else {
-      if (src->BitsOf(comp) <= 8) {
-	CopyToFFT<const UBYTE>((const UBYTE *)src->DataOf(comp),src->BytesPerPixel(comp),src->BytesPerRow(comp),
-			       (const UBYTE *)dst->DataOf(comp),dst->BytesPerPixel(comp),dst->BytesPerRow(comp),
-			       fft->DataOf(),fft->ModuloOf(),w,h);
-      } else if (!src->isFloat(comp) && src->BitsOf(comp) <= 16) {
-	CopyToFFT<const UWORD>((const UWORD *)src->DataOf(comp),src->BytesPerPixel(comp),src->BytesPerRow(comp),
-			       (const UWORD *)dst->DataOf(comp),dst->BytesPerPixel(comp),dst->BytesPerRow(comp),
-			       fft->DataOf(),fft->ModuloOf(),w,h);
-      } else if (!src->isFloat(comp) && src->BitsOf(comp) <= 32) {
-	CopyToFFT<const ULONG>((const ULONG *)src->DataOf(comp),src->BytesPerPixel(comp),src->BytesPerRow(comp),
-			       (const ULONG *)dst->DataOf(comp),dst->BytesPerPixel(comp),dst->BytesPerRow(comp),
-			       fft->DataOf(),fft->ModuloOf(),w,h);
-      } else if (src->BitsOf(comp) <= 32 && src->isFloat(comp)) {
-	CopyToFFT<const FLOAT>((const FLOAT *)src->DataOf(comp),src->BytesPerPixel(comp),src->BytesPerRow(comp),
-			       (const FLOAT *)dst->DataOf(comp),dst->BytesPerPixel(comp),dst->BytesPerRow(comp),
-			       fft->DataOf(),fft->ModuloOf(),w,h);
-      } else if (src->BitsOf(comp) == 64 && src->isFloat(comp)) {
-	CopyToFFT<const DOUBLE>((const DOUBLE *)src->DataOf(comp),src->BytesPerPixel(comp),src->BytesPerRow(comp),
-				(const DOUBLE *)dst->DataOf(comp),dst->BytesPerPixel(comp),dst->BytesPerRow(comp),
-				fft->DataOf(),fft->ModuloOf(),w,h);
-      } else {
-	throw "unsupported data type";
-      }
-    }
-    // Run the transformation.
-    fft->ForwardsFFT();
+    m_ppFFT[comp] = fft                  = spectra->SpectrumOf(src,dst,comp,m_bWindow);
     //
     // Normalize the components.
     for(y = 0;y < h;y++) {
-      const double *data = fft->DataOf() + y * fft->ModuloOf();
-      for(x = 0;x < w;x++,data += 2) {
-	double v = sqrt(data[0] * data[0] + data[1] * data[1]);
+      for(x = 0;x < w;x++) {
+	double v = sqrt(fft->SquareMagnitudeOf(x,y));
 	if (v > max && x != 0 && y != 0)
 	  max = v;
       }
@@ -192,11 +114,11 @@ double FFTImg::Measure(class ImageLayout *src,class ImageLayout *dst,double in)
     //
     // Now fill in the target 
     for(y = 0;y < h;y++) {
-      const double *data = fft->DataOf() + y * fft->ModuloOf();
-      UBYTE *out         = mem + ((y < (h >> 1))?(y + (h >> 1)):(y - (h >> 1))) * w;
+      // Move the zero frequency to the center, also for odd sizes.
+      UBYTE *out         = mem + ((y + (h >> 1)) % h) * w;
       out               += w >> 1;
-      for(x = 0;x < w;x++,data += 2) {
-	double v = sqrt(data[0] * data[0] + data[1] * data[1]) * 255 / max;
+      for(x = 0;x < w;x++) {
+	double v = sqrt(fft->SquareMagnitudeOf(x,y)) * 255 / max;
 	UBYTE dt;
 	if (v < 0.0) {
 	  dt = 0;
@@ -205,7 +127,7 @@ double FFTImg::Measure(class ImageLayout *src,class ImageLayout *dst,double in)
 	} else {
 	  dt = UBYTE(v);
 	}
-	if (x == (w >> 1))
+	if (x == w - (w >> 1))
 	  out -= w;
 	*out++ = dt;
       }
@@ -217,5 +139,3 @@ double FFTImg::Measure(class ImageLayout *src,class ImageLayout *dst,double in)
   return in;
 }
 ///
-
-#endif
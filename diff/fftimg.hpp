@@ -35,7 +35,6 @@ and conversion framework.
 /// Includes
 #include "diff/meter.hpp"
 #include "img/imglayout.hpp"
-#ifdef USE_GSL
 ///
 
 /// Forwards
@@ -53,17 +52,12 @@ class FFTImg : public Meter, private ImageLayout {
   // The component memory itself.
   UBYTE     **m_ppucImage;
   //
-  // The FFTs used here.
+  // The spectra used here, owned by the Spectra class.
   class FFT **m_ppFFT;
   //
   // The window-flag for the FFT.
   bool        m_bWindow;
   //
-  template<typename T>
-  void CopyToFFT(T *org       ,ULONG obytesperpixel,ULONG obytesperrow,
-		 T *dst       ,ULONG dbytesperpixel,ULONG dbytesperrow,
-		 double *trg  ,ULONG stide,ULONG w,ULONG h);
-  //
 public:
   //
   // Construct the difference image. Takes a file name.
@@ -76,13 +70,24 @@ public:
   //
   virtual double Measure(class ImageLayout *src,class ImageLayout *dst,double in);
   //
+  // Only the spectra of the images are used.
+  virtual bool isSpectral(void) const
+  {
+    return true;
+  }
+  //
   virtual const char *NameOf(void) const
   {
     return NULL;
   }
+  //
+  // Return the file the output is written to, NULL if none.
+  virtual const char *TargetOf(void) const
+  {
+    return m_pTargetFile;
+  }
 };
 ///
 
 ///
 #endif
-#endif
@@ -103,7 +103,7 @@ FlipExtend::~FlipExtend(void)
   if (m_ppucImage) {
     for(i = 0;i < m_usDepth;i++) {
       if (m_ppucImage[i])
-        delete[] m_ppucImage[i];
+        ReleaseBuffer(m_ppucImage[i]);
     }
     delete[] m_ppucImage;
   }
@@ -143,12 +143,12 @@ void FlipExtend::ApplyExtension(class ImageLayout *src)
     dbpp = ImageLayout::SuggestBPP(src->BitsOf(comp),src->isFloat(comp));
     switch(m_Dir) {
     case FlipX:
-      mem  = new UBYTE[(w << 1) * h * dbpp];
+      mem  = AllocateBuffer((w << 1) * h * dbpp);
       m_pComponent[comp].m_ulWidth         = w << 1;
       m_pComponent[comp].m_ulHeight        = h;
       break;
     case FlipY:
-      mem  = new UBYTE[w * (h << 1) * dbpp];
+      mem  = AllocateBuffer(w * (h << 1) * dbpp);
       m_pComponent[comp].m_ulWidth         = w;
       m_pComponent[comp].m_ulHeight        = h << 1;
       break;
@@ -290,6 +290,7 @@ double FlipExtend::Measure(class ImageLayout *src,class ImageLayout *dst,double
   // Create a destination image.
   assert(m_pDest == NULL);
   m_pDest = new class FlipExtend(m_Dir);
+  m_pDest->UseBuffers(BuffersOf());
   //
   // Also map the destination image.
   m_pDest->ApplyExtension(dst);
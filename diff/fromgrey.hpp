@@ -63,6 +63,12 @@ public:
   {
     return NULL;
   }
+  //
+  // Works on each sample by itself.
+  virtual bool isPointWise(void) const
+  {
+    return true;
+  }
 };
 ///
 
@@ -32,6 +32,7 @@ and conversion framework.
 /// Includes
 #include "diff/histogram.hpp"
 #include "img/imglayout.hpp"
+#include "tools/memorymap.hpp"
 #include "std/assert.hpp"
 #include "std/errno.hpp"
 #include "std/string.hpp"
@@ -153,6 +154,7 @@ double Histogram::Measure(class ImageLayout *src,class ImageLayout *dst,double i
     FILE *out = NULL;
     
     if (strcmp(m_pcTargetFile,"-")) {
+      MemoryMap::DetachFile(m_pcTargetFile);
       out = fopen(m_pcTargetFile,"w");
       if (out == NULL) {
 	ImageLayout::PostError("unable to open the histogram output file %s: %s\n",m_pcTargetFile,strerror(errno));
@@ -33,8 +33,237 @@ and conversion framework.
 #include "diff/mapping.hpp"
 #include "std/string.hpp"
 #include "std/math.hpp"
+#include "tools/bufferpool.hpp"
+#include "tools/fastmath.hpp"
+#include "tools/simddiff.hpp"
+#if defined(__GNUC__) && (__GNUC__ >= 5 || defined(__clang__)) && (defined(__x86_64__) || defined(__i386__))
+#define USE_X86_SIMD
+#endif
 ///
 
+/// EntriesOf
+// Return the number of values of the sample type S, if it can be
+// tabulated.
+template<typename S>
+static ULONG EntriesOf(void)
+{
+  return ULONG(UQUAD(1) << (sizeof(S) << 3));
+}
+///
+
+/// Mapping::LookupTable
+// Return the table of the transfer function for all values of the
+// integer sample type S, or NULL if the samples are too large to
+// tabulate. Tables are kept by the buffer pool for the complete run.
+// Without a pool, the filter keeps the last table, but only builds
+// one if the component has more samples than the table. If ramp is
+// set on return, the caller has to compute the table by running the
+// function over the ramp of all sample values behind the table.
+template<typename S,typename T>
+T *Mapping::LookupTable(ULONG w,ULONG h,double parameter,const S *&ramp)
+{
+  const ULONG entries = EntriesOf<S>();
+  const size_t size   = entries * (sizeof(T) + sizeof(S));
+  struct TableKey key;
+  UBYTE *table;
+  bool fresh;
+  ULONG i;
+
+  ramp = NULL;
+  if (sizeof(S) > sizeof(UWORD) || m_bTabulating)
+    return NULL;
+  //
+  // Clear the padding such that keys can be compared bytewise.
+  memset(&key,0,sizeof(key));
+  key.m_Type          = m_Type;
+  key.m_bInverse      = m_bInverse;
+  key.m_ucTargetDepth = m_ucTargetDepth;
+  key.m_ucSampleSize  = sizeof(S);
+  key.m_dGamma        = m_dGamma;
+  key.m_dToeSlope     = m_dToeSlope;
+  key.m_dParameter    = parameter;
+  //
+  if (BuffersOf()) {
+    table = BuffersOf()->TableOf(&key,sizeof(key),size,fresh);
+  } else if (UQUAD(w) * h > entries) {
+    fresh = (m_pucTable == NULL || memcmp(&key,&m_TableKey,sizeof(key)) != 0);
+    if (fresh) {
+      delete[] m_pucTable;
+      m_pucTable = NULL;
+      m_pucTable = new UBYTE[size];
+      m_TableKey = key;
+    }
+    table = m_pucTable;
+  } else {
+    return NULL;
+  }
+  //
+  if (fresh) {
+    S *values = (S *)(table + entries * sizeof(T));
+    for(i = 0;i < entries;i++)
+      values[i] = S(i);
+    ramp = values;
+  }
+
+  return (T *)table;
+}
+///
+
+/// Mapping::ApplyTable
+// Run the samples through the lookup table.
+template<typename S,typename T>
+void Mapping::ApplyTable(const S *src,ULONG obytesperpixel,ULONG obytesperrow,
+			 T *dst      ,ULONG dbytesperpixel,ULONG dbytesperrow,
+			 ULONG w, ULONG h, const T *table)
+{
+  ULONG x,y;
+
+  for(y = 0;y < h;y++) {
+    const S *orgrow = src;
+    T *dstrow       = dst;
+    for(x = 0;x < w;x++) {
+      *dstrow = table[ULONG(*orgrow)];
+      orgrow  = (const S *)((const UBYTE *)(orgrow) + obytesperpixel);
+      dstrow  = (T       *)((UBYTE *)(dstrow) + dbytesperpixel);
+    }
+    src = (const S *)((const UBYTE *)(src) + obytesperrow);
+    dst = (T       *)((UBYTE *)(dst)       + dbytesperrow);
+  }
+}
+///
+
+
+#ifdef USE_X86_SIMD
+/// Fast kernels
+// The approximations of the transfer functions for n values in a
+// contiguous array, in place. They are vectorized by the compiler,
+// but only pay off for vectors of four or more doubles, hence they are
+// compiled for AVX2 and AVX-512 only. The gamma map is rounded by an
+// offset of one half. Negative values and NaNs become a tiny positive
+// number whose power is zero, which also maps to the PQ value of zero.
+// For HLG, both branches are computed and one is selected.
+#define FAST_KERNELS(suffix,isa)					\
+__attribute__((target(isa)))						\
+static void FastGamma##suffix(double *v,ULONG n,double scale,double limF,double gamma) \
+{									\
+  double invgamma = 1.0 / gamma;					\
+  double invlimf  = 1.0 / limF;						\
+  ULONG i;								\
+									\
+  for(i = 0;i < n;i++) {						\
+    double x = v[i] * invlimf;						\
+    x        = (x > 1e-300)?(x):(1e-300);				\
+    x        = scale * FastPow(x,invgamma);				\
+    v[i]     = ((x < scale)?(x):(scale)) + 0.5;				\
+  }									\
+}									\
+									\
+__attribute__((target(isa)))						\
+static void FastPQ##suffix(double *v,ULONG n,double scale,double lmax)	\
+{									\
+  const double m1 = 2610.0 / 4096.0 * 0.25;				\
+  const double m2 = 2523.0 / 4096.0 * 128.0;				\
+  const double c1 = 3424.0 / 4096.0;					\
+  const double c2 = 2413.0 / 4096.0 * 32.0;				\
+  const double c3 = 2392.0 / 4096.0 * 32.0;				\
+  double invlmax  = 1.0 / lmax;						\
+  ULONG i;								\
+									\
+  for(i = 0;i < n;i++) {						\
+    double l = v[i] * invlmax;						\
+    double p,q;								\
+    l        = (l > 1e-300)?(l):(1e-300);				\
+    p        = FastPow(l,m1);						\
+    q        = FastPow((c2 * p + c1) / (c3 * p + 1.0),m2);		\
+    v[i]     = ((q < 1.0)?(q):(1.0)) * scale;				\
+  }									\
+}									\
+									\
+__attribute__((target(isa)))						\
+static void FastHLG##suffix(double *v,ULONG n,double scale,double lmax)	\
+{									\
+  const double a = 0.17883277, b = 0.28466892, c = 0.55991073;		\
+  const double r = sqrt(3.0);						\
+  const double t = 1.0 / 12.0;						\
+  double invlmax = 1.0 / lmax;						\
+  ULONG i;								\
+									\
+  for(i = 0;i < n;i++) {						\
+    double l = v[i] * invlmax;						\
+    double q,p;								\
+    l        = (l > 0.0)?(l):(0.0);					\
+    q        = 12.0 * l - b;						\
+    q        = (q > 1e-300)?(q):(1e-300);				\
+    p        = (l < t)?(r * sqrt(l)):(a * FastLog(q) + c);		\
+    v[i]     = ((p < 1.0)?(p):(1.0)) * scale;				\
+  }									\
+}
+//
+FAST_KERNELS(AVX2,"avx2,fma")
+FAST_KERNELS(AVX512,"avx512f,avx512dq,avx512vl,fma")
+///
+#endif
+
+/// Mapping::FastKernelsOf
+// Return the kernels approximating the transfer functions for the
+// vector units of this machine, or NULL if the exact functions are
+// faster.
+const struct Mapping::FastKernels *Mapping::FastKernelsOf(void)
+{
+#ifdef USE_X86_SIMD
+  static const struct Mapping::FastKernels avx2   = {FastGammaAVX2,FastPQAVX2,FastHLGAVX2};
+  static const struct Mapping::FastKernels avx512 = {FastGammaAVX512,FastPQAVX512,FastHLGAVX512};
+  //
+  if (SIMDDiff::LevelOf() >= SIMDDiff::AVX2 && __builtin_cpu_supports("fma"))
+    return (SIMDDiff::LevelOf() == SIMDDiff::AVX512)?(&avx512):(&avx2);
+#endif
+  return NULL;
+}
+///
+
+/// Mapping::FastTransfer
+// Apply the transfer function with the approximations of
+// tools/fastmath.hpp. Each row is collected into a contiguous array
+// such that the kernels can work on vectors, then converted to the
+// target type. The parameters are those of ToGamma, or the peak
+// luminance in place of limF for PQ and HLG.
+template<typename S,typename T>
+void Mapping::FastTransfer(const S *org ,ULONG obytesperpixel,ULONG obytesperrow,
+			   T *dst       ,ULONG dbytesperpixel,ULONG dbytesperrow,
+			   ULONG w, ULONG h, double scale, double limF, double gamma)
+{
+  double *row = new double[w];
+  ULONG x,y;
+
+  for(y = 0;y < h;y++) {
+    const S *orgrow = org;
+    T *dstrow       = dst;
+    for(x = 0;x < w;x++) {
+      row[x] = *orgrow;
+      orgrow = (const S *)((const UBYTE *)(orgrow) + obytesperpixel);
+    }
+    switch(m_Type) {
+    case PQ:
+      m_pFastKernels->PQ(row,w,scale,limF);
+      break;
+    case HLG:
+      m_pFastKernels->HLG(row,w,scale,limF);
+      break;
+    default:
+      m_pFastKernels->Gamma(row,w,scale,limF,gamma);
+      break;
+    }
+    for(x = 0;x < w;x++) {
+      *dstrow = T(row[x]);
+      dstrow  = (T *)((UBYTE *)(dstrow) + dbytesperpixel);
+    }
+    org = (const S *)((const UBYTE *)(org) + obytesperrow);
+    dst = (T *)((UBYTE *)(dst) + dbytesperrow);
+  }
+
+  delete[] row;
+}
+///
 
 /// Mapping::ToGamma
 // Convert to int using a gamma mapping.
@@ -45,6 +274,11 @@ void Mapping::ToGamma(const S *org ,ULONG obytesperpixel,ULONG obytesperrow,
 {
   ULONG x,y;
   double invgamma = 1.0 / gamma;
+
+  if (m_pFastKernels) {
+    FastTransfer<S,T>(org,obytesperpixel,obytesperrow,dst,dbytesperpixel,dbytesperrow,w,h,scale,limF,gamma);
+    return;
+  }
   
   for(y = 0;y < h;y++) {
     const S *orgrow = org;
@@ -79,6 +313,18 @@ void Mapping::InvGamma(const S *src  ,ULONG obytesperpixel,ULONG obytesperrow,
 { 
   ULONG x,y;
   double invscale = 1.0 / scale;
+  const S *ramp;
+  T *table        = LookupTable<S,T>(w,h,scale,ramp);
+
+  if (table) {
+    if (ramp) {
+      m_bTabulating = true;
+      InvGamma<S,T>(ramp,sizeof(S),0,table,sizeof(T),0,EntriesOf<S>(),1,scale,outscale,gamma);
+      m_bTabulating = false;
+    }
+    ApplyTable<S,T>(src,obytesperpixel,obytesperrow,dst,dbytesperpixel,dbytesperrow,w,h,table);
+    return;
+  }
   
   for(y = 0;y < h;y++) {
     const S *orgrow = src;
@@ -156,6 +402,19 @@ void Mapping::InvToeGamma(const S *org  ,ULONG obytesperpixel,ULONG obytesperrow
   double s     = 1.0 / (scale * max);
   double o     = offset * max;
   double isl   = 1.0 / slope;
+  const S *ramp;
+  T *table     = LookupTable<S,T>(w,h,max,ramp);
+
+  if (table) {
+    if (ramp) {
+      m_bTabulating = true;
+      InvToeGamma<S,T>(ramp,sizeof(S),0,table,sizeof(T),0,EntriesOf<S>(),1,
+		       scale,offset,slope,threshold,gamma,min,max);
+      m_bTabulating = false;
+    }
+    ApplyTable<S,T>(org,obytesperpixel,obytesperrow,dst,dbytesperpixel,dbytesperrow,w,h,table);
+    return;
+  }
 
   for(y = 0;y < h;y++) {
     const S *orgrow = org;
@@ -328,6 +587,18 @@ void Mapping::ToHalfExp(const UWORD *org ,ULONG obytesperpixel,ULONG obytesperro
 			ULONG w, ULONG h)
 {
   ULONG x,y;
+  const UWORD *ramp;
+  FLOAT *table = LookupTable<UWORD,FLOAT>(w,h,0.0,ramp);
+
+  if (table) {
+    if (ramp) {
+      m_bTabulating = true;
+      ToHalfExp(ramp,sizeof(UWORD),0,table,sizeof(FLOAT),0,EntriesOf<UWORD>(),1);
+      m_bTabulating = false;
+    }
+    ApplyTable<UWORD,FLOAT>(org,obytesperpixel,obytesperrow,dst,dbytesperpixel,dbytesperrow,w,h,table);
+    return;
+  }
   
   for(y = 0;y < h;y++) {
     const UWORD *orgrow = org;
@@ -372,6 +643,18 @@ void Mapping::FromPQ(const T *org ,ULONG obytesperpixel,ULONG obytesperrow,
   const double c2 = 2413.0 / 4096.0 * 32.0;
   const double c3 = 2392.0 / 4096.0 * 32.0;
   const double lmax = 10000;
+  const T *ramp;
+  FLOAT *table    = LookupTable<T,FLOAT>(w,h,scale,ramp);
+
+  if (table) {
+    if (ramp) {
+      m_bTabulating = true;
+      FromPQ<T>(ramp,sizeof(T),0,table,sizeof(FLOAT),0,EntriesOf<T>(),1,scale);
+      m_bTabulating = false;
+    }
+    ApplyTable<T,FLOAT>(org,obytesperpixel,obytesperrow,dst,dbytesperpixel,dbytesperrow,w,h,table);
+    return;
+  }
   
   for(y = 0;y < h;y++) {
     const T *orgrow = org;
@@ -407,6 +690,11 @@ void Mapping::ToPQ(const FLOAT *org ,ULONG obytesperpixel,ULONG obytesperrow,
   const double c2 = 2413.0 / 4096.0 * 32.0;
   const double c3 = 2392.0 / 4096.0 * 32.0;
   const double lmax = 10000; // peak luminance
+
+  if (m_pFastKernels) {
+    FastTransfer<FLOAT,T>(org,obytesperpixel,obytesperrow,dst,dbytesperpixel,dbytesperrow,w,h,scale,lmax,1.0);
+    return;
+  }
   
   for(y = 0;y < h;y++) {
     const FLOAT *orgrow = org;
@@ -435,6 +723,18 @@ void Mapping::FromHLG(const T *org ,ULONG obytesperpixel,ULONG obytesperrow,
   ULONG x,y;
   const double lmax = 1000.0; /* This is the peak luminance HEVC uses for it */
   const double a = 0.17883277, b = 0.28466892, c = 0.55991073;
+  const T *ramp;
+  FLOAT *table      = LookupTable<T,FLOAT>(w,h,scale,ramp);
+
+  if (table) {
+    if (ramp) {
+      m_bTabulating = true;
+      FromHLG<T>(ramp,sizeof(T),0,table,sizeof(FLOAT),0,EntriesOf<T>(),1,scale);
+      m_bTabulating = false;
+    }
+    ApplyTable<T,FLOAT>(org,obytesperpixel,obytesperrow,dst,dbytesperpixel,dbytesperrow,w,h,table);
+    return;
+  }
   
   for(y = 0;y < h;y++) {
     const T *orgrow = org;
@@ -468,6 +768,11 @@ void Mapping::ToHLG(const FLOAT *org ,ULONG obytesperpixel,ULONG obytesperrow,
   const double r = sqrt(3.0);
   const double t = 1.0 / 12.0;
   const double lmax = 1000; // peak luminance
+
+  if (m_pFastKernels) {
+    FastTransfer<FLOAT,T>(org,obytesperpixel,obytesperrow,dst,dbytesperpixel,dbytesperrow,w,h,scale,lmax,1.0);
+    return;
+  }
   
   for(y = 0;y < h;y++) {
     const FLOAT *orgrow = org;
@@ -493,19 +798,32 @@ void Mapping::ToHLG(const FLOAT *org ,ULONG obytesperpixel,ULONG obytesperrow,
 ///
 /// Mapping::~Mapping
 Mapping::~Mapping(void)
+{
+  Restart();
+
+  delete m_pDest;
+  delete[] m_PU_Lut;
+  delete[] m_pucTable;
+}
+///
+
+/// Mapping::Restart
+// Release the result of the last band, but keep the tables.
+void Mapping::Restart(void)
 {
   int i;
 
   if (m_ppucImage) {
     for(i = 0;i < m_usDepth;i++) {
       if (m_ppucImage[i])
-        delete[] m_ppucImage[i];
+        ReleaseBuffer(m_ppucImage[i]);
     }
     delete[] m_ppucImage;
+    m_ppucImage = NULL;
   }
 
-  delete m_pDest;
-  delete[] m_PU_Lut;
+  if (m_pDest)
+    m_pDest->Restart();
 }
 ///
 
@@ -732,7 +1050,7 @@ void Mapping::ApplyMap(class ImageLayout *src,class ImageLayout *dst)
   //
   assert(src->DepthOf() == dst->DepthOf());
   //
-  if (m_Type == PU2)
+  if (m_Type == PU2 && m_PU_Lut == NULL)
     CreatePUMap();
   //
   // Compute or approximate the threshold and offset/scale for the gamma plus toe region
@@ -819,11 +1137,11 @@ void Mapping::ApplyMap(class ImageLayout *src,class ImageLayout *dst)
 	  InvToeGamma<UBYTE,UBYTE>((const UBYTE *)src->DataOf(comp),src->BytesPerPixel(comp),src->BytesPerRow(comp),
 				   (UBYTE *)dst->DataOf(comp),dst->BytesPerPixel(comp),dst->BytesPerRow(comp),
 				   w,h,1.0 + offset,offset,ts,thres,m_dGamma,0.0,(1UL << src->BitsOf(comp)) - 1);
-	} else if (src->BitsOf(comp) <= 8) {
+	} else if (src->BitsOf(comp) <= 16) {
 	  InvToeGamma<UWORD,UWORD>((const UWORD *)src->DataOf(comp),src->BytesPerPixel(comp),src->BytesPerRow(comp),
 				   (UWORD *)dst->DataOf(comp),dst->BytesPerPixel(comp),dst->BytesPerRow(comp),
 				   w,h,1.0 + offset,offset,ts,thres,m_dGamma,0.0,(1UL << src->BitsOf(comp)) - 1);
-	} else if (src->BitsOf(comp) <= 16) {
+	} else if (src->BitsOf(comp) <= 32) {
 	  InvToeGamma<ULONG,ULONG>((const ULONG *)src->DataOf(comp),src->BytesPerPixel(comp),src->BytesPerRow(comp),
 				   (ULONG *)dst->DataOf(comp),dst->BytesPerPixel(comp),dst->BytesPerRow(comp),
 				   w,h,1.0 + offset,offset,ts,thres,m_dGamma,0.0,(1UL << src->BitsOf(comp)) - 1);
@@ -833,11 +1151,11 @@ void Mapping::ApplyMap(class ImageLayout *src,class ImageLayout *dst)
 	  ToToeGamma<UBYTE,UBYTE>((const UBYTE *)src->DataOf(comp),src->BytesPerPixel(comp),src->BytesPerRow(comp),
 				   (UBYTE *)dst->DataOf(comp),dst->BytesPerPixel(comp),dst->BytesPerRow(comp),
 				   w,h,1.0 + offset,offset,ts,thres,m_dGamma,0.0,(1UL << src->BitsOf(comp)) - 1);
-	} else if (src->BitsOf(comp) <= 8) {
+	} else if (src->BitsOf(comp) <= 16) {
 	  ToToeGamma<UWORD,UWORD>((const UWORD *)src->DataOf(comp),src->BytesPerPixel(comp),src->BytesPerRow(comp),
 				   (UWORD *)dst->DataOf(comp),dst->BytesPerPixel(comp),dst->BytesPerRow(comp),
 				   w,h,1.0 + offset,offset,ts,thres,m_dGamma,0.0,(1UL << src->BitsOf(comp)) - 1);
-	} else if (src->BitsOf(comp) <= 16) {
+	} else if (src->BitsOf(comp) <= 32) {
 	  ToToeGamma<ULONG,ULONG>((const ULONG *)src->DataOf(comp),src->BytesPerPixel(comp),src->BytesPerRow(comp),
 				  (ULONG *)dst->DataOf(comp),dst->BytesPerPixel(comp),dst->BytesPerRow(comp),
 				  w,h,1.0 + offset,offset,ts,thres,m_dGamma,0.0,(1UL << src->BitsOf(comp)) - 1);
@@ -1046,7 +1364,7 @@ void Mapping::CreateTargetBuffer(class ImageLayout *src)
       //
       if (m_Type == GammaToe) {
 	UBYTE bps  = ImageLayout::SuggestBPP(src->BitsOf(comp),false);
-	UBYTE *mem = new UBYTE[w * h * bps];
+	UBYTE *mem = AllocateBuffer(w * h * bps);
 	m_ppucImage[comp] = mem;
 	//
 	m_pComponent[comp].m_ucBits          = src->BitsOf(comp);
@@ -1058,7 +1376,7 @@ void Mapping::CreateTargetBuffer(class ImageLayout *src)
 	m_pComponent[comp].m_ulBytesPerRow   = w * bps;
 	m_pComponent[comp].m_pPtr            = mem;
       } else {
-	FLOAT *mem = new FLOAT[w * h];
+	FLOAT *mem = (FLOAT *)AllocateBuffer(w * h * sizeof(FLOAT));
 	m_ppucImage[comp] = (UBYTE *)mem;
 	//
 	m_pComponent[comp].m_ucBits          = 32;
@@ -1085,7 +1403,7 @@ void Mapping::CreateTargetBuffer(class ImageLayout *src)
       }
       //
       if (m_Type == Log || m_Type == PU2) {
-	FLOAT *mem = new FLOAT[w * h];
+	FLOAT *mem = (FLOAT *)AllocateBuffer(w * h * sizeof(FLOAT));
 	m_ppucImage[comp] = (UBYTE *)mem;
 	//
 	m_pComponent[comp].m_ucBits          = m_ucTargetDepth;
@@ -1098,7 +1416,7 @@ void Mapping::CreateTargetBuffer(class ImageLayout *src)
 	m_pComponent[comp].m_pPtr            = mem;
       } else {
 	UBYTE bps  = ImageLayout::SuggestBPP((m_Type == GammaToe)?src->BitsOf(comp):m_ucTargetDepth,false);
-	UBYTE *mem = new UBYTE[w * h * bps];
+	UBYTE *mem = AllocateBuffer(w * h * bps);
 	m_ppucImage[comp] = mem;
 	//
 	m_pComponent[comp].m_ucBits          = (m_Type == GammaToe)?src->BitsOf(comp):m_ucTargetDepth;
@@ -1124,8 +1442,11 @@ double Mapping::Measure(class ImageLayout *src,class ImageLayout *dst,double in)
     // Now apply the conversion.
     ApplyMap(src,this);
     //
-    assert(m_pDest == NULL);
-    m_pDest = new class Mapping(NULL,m_Type,m_dGamma,m_bInverse,m_ucTargetDepth,true,m_TargetSpecs,m_dToeSlope);
+    // The destination mapping is kept over bands for its tables.
+    if (m_pDest == NULL)
+      m_pDest = new class Mapping(NULL,m_Type,m_dGamma,m_bInverse,m_ucTargetDepth,true,m_TargetSpecs,m_dToeSlope,
+				  m_bFastMath);
+    m_pDest->UseBuffers(BuffersOf());
     //
     m_pDest->CreateTargetBuffer(dst);
     m_pDest->ApplyMap(dst,m_pDest);
@@ -1139,7 +1460,7 @@ double Mapping::Measure(class ImageLayout *src,class ImageLayout *dst,double in)
     // Now apply the conversion.
     ApplyMap(src,this);
     
-    SaveImage(m_pTargetFile,m_TargetSpecs);
+    SaveImage(m_pTargetFile,m_TargetSpecs,PoolOf());
   }
 
   return in;
@@ -88,12 +88,72 @@ private:
   // Apply as a filter, do not save an output image.
   bool           m_bFilter;
   //
+  // Use the approximations of tools/fastmath.hpp for the transfer
+  // functions of samples that are not looked up in a table.
+  bool           m_bFastMath;
+  //
+  // The kernels computing the approximations on rows of samples. NULL
+  // if approximations are not requested, or not faster than the exact
+  // functions on this machine.
+  struct FastKernels {
+    void (*Gamma)(double *v,ULONG n,double scale,double limF,double gamma);
+    void (*PQ)(double *v,ULONG n,double scale,double lmax);
+    void (*HLG)(double *v,ULONG n,double scale,double lmax);
+  };
+  const struct FastKernels *m_pFastKernels;
+  //
+  // Set while a lookup table is computed, which happens by running
+  // the transfer function over all possible sample values.
+  bool           m_bTabulating;
+  //
   // Output specifications of the destination file.
   const struct ImgSpecs &m_TargetSpecs;
   //
+  // Identifies a lookup table of the transfer function for a sample
+  // size and the parameter of the function that depends on the bit
+  // depth of the samples.
+  struct TableKey {
+    MappingType m_Type;
+    bool        m_bInverse;
+    UBYTE       m_ucTargetDepth;
+    UBYTE       m_ucSampleSize;
+    double      m_dGamma;
+    double      m_dToeSlope;
+    double      m_dParameter;
+  };
+  //
+  // The lookup table if the filter does not take its buffers from a
+  // pool, and its key.
+  UBYTE         *m_pucTable;
+  struct TableKey m_TableKey;
+  //
+  // Return the table of the transfer function for all values of the
+  // integer sample type S, or NULL if the samples are too large to
+  // tabulate. If ramp is set on return, the caller has to compute the
+  // table by running the function over the ramp of all sample values.
+  template<typename S,typename T>
+  T *LookupTable(ULONG w,ULONG h,double parameter,const S *&ramp);
+  //
+  // Run the samples through the lookup table.
+  template<typename S,typename T>
+  void ApplyTable(const S *src,ULONG obytesperpixel,ULONG obytesperrow,
+		  T *dst      ,ULONG dbytesperpixel,ULONG dbytesperrow,
+		  ULONG w, ULONG h, const T *table);
+  //
   // Create the PU-Lookup table.
   void CreatePUMap(void);
   //
+  // Return the kernels approximating the transfer functions on this
+  // machine, or NULL.
+  static const struct FastKernels *FastKernelsOf(void);
+  //
+  // Apply the gamma, PQ or HLG map with approximations instead of the
+  // exact functions.
+  template<typename S,typename T>
+  void FastTransfer(const S *org ,ULONG obytesperpixel,ULONG obytesperrow,
+		    T *dst       ,ULONG dbytesperpixel,ULONG dbytesperrow,
+		    ULONG w, ULONG h, double scale, double limF, double gamma);
+  //
   // Convert to int using a gamma mapping.
   template<typename S,typename T>
   void ToGamma(const S *org ,ULONG obytesperpixel,ULONG obytesperrow,
@@ -189,10 +249,12 @@ public:
   //
   // Scale the difference image. Takes a file name.
   Mapping(const char *filename,MappingType type,double gamma,bool inverse,UBYTE targetdepth,
-	  bool filter,const struct ImgSpecs &specs,double slope = 0.0)
+	  bool filter,const struct ImgSpecs &specs,double slope = 0.0,bool fastmath = false)
     : m_pTargetFile(filename), m_ppucImage(NULL), m_pDest(NULL), m_PU_Lut(NULL),
       m_Type(type), m_dGamma(gamma), m_dToeSlope(slope), m_ucTargetDepth(targetdepth), 
-      m_bInverse(inverse), m_bFilter(filter), m_TargetSpecs(specs)
+      m_bInverse(inverse), m_bFilter(filter), m_bFastMath(fastmath),
+      m_pFastKernels((fastmath)?(FastKernelsOf()):(NULL)), m_bTabulating(false),
+      m_TargetSpecs(specs), m_pucTable(NULL)
   {
   }
   //
@@ -204,6 +266,23 @@ public:
   {
     return NULL;
   }
+  //
+  // Return the file the output is written to, NULL if none.
+  virtual const char *TargetOf(void) const
+  {
+    return m_pTargetFile;
+  }
+  //
+  // Works on each sample by itself, but only as a filter. Saving
+  // the image requires all of it, and so does the forward gamma
+  // mapping which scales by a percentile of the complete image.
+  virtual bool isPointWise(void) const
+  {
+    return m_bFilter && !(m_Type == Gamma && !m_bInverse);
+  }
+  //
+  // Release the result of the last band, but keep the tables.
+  virtual void Restart(void);
 };
 ///
 
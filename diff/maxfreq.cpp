@@ -31,138 +31,51 @@ and conversion framework.
 
 /// Includes
 #include "diff/maxfreq.hpp"
+#include "diff/spectra.hpp"
 #include "tools/fft.hpp"
 #include "std/math.hpp"
 #include "std/string.hpp"
-#ifdef USE_GSL
-///
-
-/// MaxFreq::CopyToFFT
-template<typename T>
-void MaxFreq::CopyToFFT(T *org,ULONG obytesperpixel,ULONG obytesperrow,
-			T *dst,ULONG dbytesperpixel,ULONG dbytesperrow,
-			double *target,ULONG stride,ULONG w,ULONG h)
-{
-  ULONG x,y;
-
-  for(y = 0;y < h;y++) {
-    T *orgrow      = org;
-    T *dstrow      = dst;
-    double *trgrow = target + y * stride;
-    for(x = 0;x < w;x++) {
-      trgrow[0]   = *orgrow - *dstrow; // real part
-      trgrow[1]   = 0.0; // imaginary part.
-      //
-      orgrow      = (T *)((const UBYTE *)(orgrow) + obytesperpixel);
-      dstrow      = (T *)((const UBYTE *)(dstrow) + dbytesperpixel);
-      trgrow     += 2;
-    }
-    org = (T *)((const UBYTE *)(org) + obytesperrow);
-    dst = (T *)((const UBYTE *)(dst) + dbytesperrow);
-  }
-}
 ///
 
 /// MaxFreq::~MaxFreq
 MaxFreq::~MaxFreq(void)
 {
-  int i;
-
   delete[] m_pdAbs;
   
-  if (m_ppFFT) {
-    for(i = 0;i < m_usDepth;i++) {
-      if (m_ppFFT[i])
-        delete m_ppFFT[i];
-    }
-    delete[] m_ppFFT;
-  }
+  // The spectra belong to the Spectra class.
+  delete[] m_ppFFT;
 
 }
 ///
 
-/// MaxFreq::Measure
-double MaxFreq::Measure(class ImageLayout *src,class ImageLayout *dst,double)
-{ 
+/// MaxFreq::FullSpectrum
+// Compute the power spectrum of the complete image, return the
+// dimensions of the part of interest.
+void MaxFreq::FullSpectrum(class ImageLayout *src,class ImageLayout *dst,ULONG &maxw,ULONG &maxh)
+{
   ULONG x,y;
-  ULONG maxw = 0,maxh = 0;
   ULONG mod;
   UWORD comp;
-  double fmax[16];
-  ULONG  xm[16];
-  ULONG  ym[16];
+  class Spectra own(PoolOf());
+  class Spectra *spectra = SpectraOf();
+  //
+  // Transform the images here unless the spectra are shared.
+  if (spectra == NULL)
+    spectra = &own;
 
-  m_usDepth  = src->DepthOf();
   m_ppFFT    = new FFT *[m_usDepth];
   memset(m_ppFFT,0,sizeof(class FFT *) * m_usDepth);
 
-  memset(fmax,0,sizeof(fmax));
-  memset(xm,0,sizeof(xm));
-  memset(ym,0,sizeof(xm));
-
   for(comp = 0;comp < m_usDepth;comp++) {
     ULONG  w    = src->WidthOf(comp);
     ULONG  h    = src->HeightOf(comp);
-    class FFT *fft;
     //
-    m_ppFFT[comp] = fft = new class FFT(w,h,true);
+    m_ppFFT[comp] = spectra->SpectrumOf(src,dst,comp,true);
     //
     if (w > maxw)
       maxw = w;
     if (h > maxh)
       maxh = h;
-    //
-    if (src->isSigned(comp)) {
-      if (src->BitsOf(comp) <= 8) {
-	CopyToFFT<const BYTE>((const BYTE *)src->DataOf(comp),src->BytesPerPixel(comp),src->BytesPerRow(comp),
-			      (const BYTE *)dst->DataOf(comp),dst->BytesPerPixel(comp),dst->BytesPerRow(comp),
-			      fft->DataOf(),fft->ModuloOf(),w,h);
-      } else if (!src->isFloat(comp) && src->BitsOf(comp) <= 16) {
-	CopyToFFT<const WORD>((const WORD *)src->DataOf(comp),src->BytesPerPixel(comp),src->BytesPerRow(comp),
-			      (const WORD *)dst->DataOf(comp),dst->BytesPerPixel(comp),dst->BytesPerRow(comp),
-			      fft->DataOf(),fft->ModuloOf(),w,h);
-      } else if (!src->isFloat(comp) && src->BitsOf(comp) <= 32) {
-	CopyToFFT<const LONG>((const LONG *)src->DataOf(comp),src->BytesPerPixel(comp),src->BytesPerRow(comp),
-			      (const LONG *)dst->DataOf(comp),dst->BytesPerPixel(comp),dst->BytesPerRow(comp),
-			      fft->DataOf(),fft->ModuloOf(),w,h);
-      } else if (src->BitsOf(comp) <= 32 && src->isFloat(comp)) {
-	CopyToFFT<const FLOAT>((const FLOAT *)src->DataOf(comp),src->BytesPerPixel(comp),src->BytesPerRow(comp),
-			       (const FLOAT *)dst->DataOf(comp),dst->BytesPerPixel(comp),dst->BytesPerRow(comp),
-			       fft->DataOf(),fft->ModuloOf(),w,h);
-      } else if (src->BitsOf(comp) == 64 && src->isFloat(comp)) {
-	CopyToFFT<const DOUBLE>((const DOUBLE *)src->DataOf(comp),src->BytesPerPixel(comp),src->BytesPerRow(comp),
-			       (const DOUBLE *)dst->DataOf(comp),dst->BytesPerPixel(comp),dst->BytesPerRow(comp),
-				fft->DataOf(),fft->ModuloOf(),w,h);
-      } else {
-	throw "unsupported data type";
-      }
-    } else {
-      if (src->BitsOf(comp) <= 8) {
-	CopyToFFT<const UBYTE>((const UBYTE *)src->DataOf(comp),src->BytesPerPixel(comp),src->BytesPerRow(comp),
-			       (const UBYTE *)dst->DataOf(comp),dst->BytesPerPixel(comp),dst->BytesPerRow(comp),
-			       fft->DataOf(),fft->ModuloOf(),w,h);
-      } else if (!src->isFloat(comp) && src->BitsOf(comp) <= 16) {
-	CopyToFFT<const UWORD>((const UWORD *)src->DataOf(comp),src->BytesPerPixel(comp),src->BytesPerRow(comp),
-			       (const UWORD *)dst->DataOf(comp),dst->BytesPerPixel(comp),dst->BytesPerRow(comp),
-			       fft->DataOf(),fft->ModuloOf(),w,h);
-      } else if (!src->isFloat(comp) && src->BitsOf(comp) <= 32) {
-	CopyToFFT<const ULONG>((const ULONG *)src->DataOf(comp),src->BytesPerPixel(comp),src->BytesPerRow(comp),
-			       (const ULONG *)dst->DataOf(comp),dst->BytesPerPixel(comp),dst->BytesPerRow(comp),
-			       fft->DataOf(),fft->ModuloOf(),w,h);
-      } else if (src->BitsOf(comp) <= 32 && src->isFloat(comp)) {
-	CopyToFFT<const FLOAT>((const FLOAT *)src->DataOf(comp),src->BytesPerPixel(comp),src->BytesPerRow(comp),
-			       (const FLOAT *)dst->DataOf(comp),dst->BytesPerPixel(comp),dst->BytesPerRow(comp),
-			       fft->DataOf(),fft->ModuloOf(),w,h);
-      } else if (src->BitsOf(comp) == 64 && src->isFloat(comp)) {
-	CopyToFFT<const DOUBLE>((const DOUBLE *)src->DataOf(comp),src->BytesPerPixel(comp),src->BytesPerRow(comp),
-				(const DOUBLE *)dst->DataOf(comp),dst->BytesPerPixel(comp),dst->BytesPerRow(comp),
-				fft->DataOf(),fft->ModuloOf(),w,h);
-      } else {
-	throw "unsupported data type";
-      }
-    }
-    // Run the transformation.
-    fft->ForwardsFFT();
   }
 
   // Due to symmetry, only 1/4 needs to be investiaged.
@@ -185,6 +98,83 @@ double MaxFreq::Measure(class ImageLayout *src,class ImageLayout *dst,double)
       m_pdAbs[y * mod + x] = f;
     }
   }
+}
+///
+
+/// MaxFreq::TiledSpectrum
+// Compute the averaged power spectrum of the tiles, return the
+// dimensions of the part of interest.
+void MaxFreq::TiledSpectrum(class ImageLayout *src,class ImageLayout *dst,ULONG &maxw,ULONG &maxh)
+{
+  ULONG x,y;
+  ULONG tw,th;
+  UWORD comp;
+  class Spectra own(PoolOf());
+  class Spectra *spectra = SpectraOf();
+  //
+  // Average the tiles here unless the spectra are shared.
+  if (spectra == NULL)
+    spectra = &own;
+
+  for(comp = 0;comp < m_usDepth;comp++) {
+    spectra->TiledPowerOf(src,dst,comp,m_ulTile,tw,th);
+    if ((tw >> 1) > maxw)
+      maxw = tw >> 1;
+    if ((th >> 1) > maxh)
+      maxh = th >> 1;
+  }
+
+  m_pdAbs = new double[maxw * maxh];
+  memset(m_pdAbs,0,sizeof(double) * maxw * maxh);
+
+  // The power spectra are kept, this only looks them up again.
+  for(comp = 0;comp < m_usDepth;comp++) {
+    const double *power = spectra->TiledPowerOf(src,dst,comp,m_ulTile,tw,th);
+    for(y = 0;y < (th >> 1);y++) {
+      for(x = 0;x < (tw >> 1);x++) {
+	m_pdAbs[y * maxw + x] += power[y * (tw >> 1) + x];
+      }
+    }
+  }
+}
+///
+
+/// MaxFreq::Measure
+double MaxFreq::Measure(class ImageLayout *src,class ImageLayout *dst,double)
+{ 
+  ULONG x,y;
+  ULONG maxw = 0,maxh = 0;
+  ULONG mod;
+  UWORD comp;
+  double fmax[16];
+  ULONG  xm[16];
+  ULONG  ym[16];
+  double sx = 1.0,sy = 1.0;
+
+  m_usDepth  = src->DepthOf();
+
+  memset(fmax,0,sizeof(fmax));
+  memset(xm,0,sizeof(xm));
+  memset(ym,0,sizeof(xm));
+
+  if (m_ulTile) {
+    ULONG w = 0,h = 0;
+    //
+    TiledSpectrum(src,dst,maxw,maxh);
+    //
+    // Scale the frequencies of the tiles to those of the image.
+    for(comp = 0;comp < m_usDepth;comp++) {
+      if (src->WidthOf(comp) > w)
+	w = src->WidthOf(comp);
+      if (src->HeightOf(comp) > h)
+	h = src->HeightOf(comp);
+    }
+    sx = double(w) / ((w > m_ulTile)?(m_ulTile):(w));
+    sy = double(h) / ((h > m_ulTile)?(m_ulTile):(h));
+  } else {
+    FullSpectrum(src,dst,maxw,maxh);
+  }
+  mod = maxw;
 
   for(y = 0;y < maxh;y++) {
     for(x = 0;x < maxw;x++) {
@@ -224,11 +214,11 @@ double MaxFreq::Measure(class ImageLayout *src,class ImageLayout *dst,double)
 
   switch(m_Type) {
   case MaxH:
-    return xm[0];
+    return xm[0] * sx;
   case MaxV:
-    return ym[0];
+    return ym[0] * sy;
   case MaxR:
-    return sqrt(double(xm[0]) * xm[0] + double(ym[0]) * ym[0]);
+    return sqrt(xm[0] * sx * xm[0] * sx + ym[0] * sy * ym[0] * sy);
   case Var:
     return fmax[0];
   case Pattern:
@@ -265,5 +255,3 @@ double MaxFreq::Measure(class ImageLayout *src,class ImageLayout *dst,double)
   return 0.0;
 }
 ///
-
-#endif
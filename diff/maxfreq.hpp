@@ -35,7 +35,6 @@ and conversion framework.
 /// Includes
 #include "diff/meter.hpp"
 #include "img/imglayout.hpp"
-#ifdef USE_GSL
 ///
 
 /// Forwards
@@ -45,9 +44,12 @@ class FFT;
 /// class MaxFreq
 // This class saves the FFT of the difference image as a normalized 8bpp image
 // with the same number of components as the original.
+// If a tile size is given, the power spectra of overlapping windowed
+// tiles are averaged instead of transforming the complete image, and
+// frequencies are scaled to the frequency grid of the complete image.
 class MaxFreq : public Meter {
   //
-  // The FFTs used here.
+  // The spectra used here, owned by the Spectra class.
   class FFT **m_ppFFT;
   //
   // Number of FFT components.
@@ -59,10 +61,16 @@ class MaxFreq : public Meter {
   // The type of measurement.
   int         m_Type;
   //
-  template<typename T>
-  void CopyToFFT(T *org       ,ULONG obytesperpixel,ULONG obytesperrow,
-		 T *dst       ,ULONG dbytesperpixel,ULONG dbytesperrow,
-		 double *trg  ,ULONG stide,ULONG w,ULONG h);
+  // Edge size of the tiles, zero if the complete image is transformed.
+  ULONG       m_ulTile;
+  //
+  // Compute the power spectrum of the complete image, return the
+  // dimensions of the part of interest.
+  void FullSpectrum(class ImageLayout *src,class ImageLayout *dst,ULONG &maxw,ULONG &maxh);
+  //
+  // Compute the averaged power spectrum of the tiles, return the
+  // dimensions of the part of interest.
+  void TiledSpectrum(class ImageLayout *src,class ImageLayout *dst,ULONG &maxw,ULONG &maxh);
   //
 public:
   //
@@ -75,9 +83,10 @@ public:
     Pattern // Pattern index
   };
   //
-  // Construct the difference image. Takes a file name.
-  MaxFreq(Type t)
-    : m_ppFFT(NULL), m_usDepth(0), m_pdAbs(NULL), m_Type(t)
+  // Construct the meter. If the tile size is non-zero, the spectrum
+  // is averaged over tiles of this size.
+  MaxFreq(Type t,ULONG tile = 0)
+    : m_ppFFT(NULL), m_usDepth(0), m_pdAbs(NULL), m_Type(t), m_ulTile(tile)
   {
   }
   //
@@ -85,6 +94,13 @@ public:
   //
   virtual double Measure(class ImageLayout *src,class ImageLayout *dst,double in);
   //
+  // Only the spectra of the images are used, or the images are
+  // read tile by tile.
+  virtual bool isSpectral(void) const
+  {
+    return true;
+  }
+  //
   virtual const char *NameOf(void) const
   {
     switch(m_Type) {
@@ -106,4 +122,3 @@ public:
 
 ///
 #endif
-#endif
@@ -45,10 +45,11 @@ MergeFields::~MergeFields(void)
     UBYTE **mem = m_ppucMemory;
     UWORD  i    = m_usDepth;
     while(i) {
-      delete *mem;
+      ReleaseBuffer(*mem);
       mem++;
       i--;
     }
+    delete[] m_ppucMemory;
   }
 }
 ///
@@ -123,7 +124,7 @@ double MergeFields::Measure(class ImageLayout *src,class ImageLayout *dst,double
     m_pComponent[i].m_ulHeight        = src->HeightOf(i) + dst->HeightOf(i);
     m_pComponent[i].m_ulBytesPerPixel = SuggestBPP(src->BitsOf(i),src->isFloat(i));
     m_pComponent[i].m_ulBytesPerRow   = m_pComponent[i].m_ulWidth * m_pComponent[i].m_ulBytesPerPixel;
-    m_ppucMemory[i]                   = new UBYTE[m_pComponent[i].m_ulBytesPerRow * m_pComponent[i].m_ulHeight];
+    m_ppucMemory[i]                   = AllocateBuffer(m_pComponent[i].m_ulBytesPerRow * m_pComponent[i].m_ulHeight);
     m_pComponent[i].m_pPtr            = m_ppucMemory[i];
     if (src->BitsOf(i) <= 8) {
       InterleaveData<UBYTE>((UBYTE *)m_ppucMemory[i],m_pComponent[i].m_ulBytesPerPixel,m_pComponent[i].m_ulBytesPerRow,
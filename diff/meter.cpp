@@ -30,4 +30,46 @@ and conversion framework.
 
 /// Includes
 #include "diff/meter.hpp"
+#include "tools/bufferpool.hpp"
+///
+
+/// Meter::ComponentResults
+// Return room for the results of the given number of components,
+// to be filled in by the measurement.
+double *Meter::ComponentResults(UWORD depth)
+{
+  if (depth != m_usComponents) {
+    delete[] m_pdComponents;
+    m_pdComponents = NULL;
+    m_usComponents = 0;
+    m_pdComponents = new double[depth];
+    m_usComponents = depth;
+  }
+  
+  return m_pdComponents;
+}
+///
+
+/// Meter::AllocateBuffer
+// Return a sample buffer of the given size, from the pool if there
+// is one.
+UBYTE *Meter::AllocateBuffer(size_t size)
+{
+  if (m_pBuffers)
+    return m_pBuffers->Allocate(size);
+
+  return new UBYTE[size];
+}
+///
+
+/// Meter::isWritable
+// Check whether the samples of the image may be overwritten instead of
+// writing the result into a new buffer.
+bool Meter::isWritable(const class ImageLayout *img) const
+{
+  if (m_pBuffers)
+    return m_pBuffers->isWritable(img);
+
+  return false;
+}
 ///
@@ -33,10 +33,15 @@ and conversion framework.
 
 /// Includes
 #include "interface/types.hpp"
+#include "std/stddef.hpp"
 ///
 
 /// Forwards
 class ImageLayout;
+class Statistics;
+class ThreadPool;
+class Spectra;
+class BufferPool;
 ///
 
 /// class Meter
@@ -47,14 +52,78 @@ class Meter {
   // Pointer to the next meter on the agenda.
   class Meter *m_pNext;
   //
+  // The command line option the meter was created from, if any.
+  const char  *m_pcOption;
+  //
+  // Results of the last measurement for the individual components,
+  // if the meter breaks its result down. NULL otherwise.
+  double      *m_pdComponents;
+  UWORD        m_usComponents;
+  //
+  // The threads the meter may use for its measurement, NULL if it
+  // runs on the calling thread only.
+  class ThreadPool *m_pPool;
+  //
+  // The spectra of the images shared with the other meters on the
+  // agenda, NULL if every meter transforms the images itself.
+  class Spectra    *m_pSpectra;
+  //
+  // The pool the sample buffers of filters are taken from, NULL if
+  // the filters allocate and release them themselves.
+  class BufferPool *m_pBuffers;
+  //
+protected:
+  //
+  // Return room for the results of the given number of components,
+  // to be filled in by the measurement.
+  double *ComponentResults(UWORD depth);
+  //
+  // Return the threads the meter may use, or NULL.
+  class ThreadPool *PoolOf(void) const
+  {
+    return m_pPool;
+  }
+  //
+  // Return the spectra shared on the agenda, or NULL.
+  class Spectra *SpectraOf(void) const
+  {
+    return m_pSpectra;
+  }
+  //
+  // Return the buffer pool, or NULL.
+  class BufferPool *BuffersOf(void) const
+  {
+    return m_pBuffers;
+  }
+  //
+  // Return a sample buffer of the given size, from the pool if there
+  // is one. Release it with ReleaseBuffer.
+  UBYTE *AllocateBuffer(size_t size);
+  //
+  // Release a buffer obtained from AllocateBuffer. Buffers of the
+  // pool remain with the pool, which hands them out again once the
+  // images no longer refer to them.
+  void ReleaseBuffer(UBYTE *mem)
+  {
+    if (m_pBuffers == NULL)
+      delete[] mem;
+  }
+  //
+  // Check whether the samples of the image may be overwritten instead
+  // of writing the result into a new buffer. This is only known if
+  // the meter takes its buffers from a pool, false otherwise.
+  bool isWritable(const class ImageLayout *img) const;
+  //
 public:
   Meter(void)
-    : m_pNext(NULL)
+    : m_pNext(NULL), m_pcOption(NULL), m_pdComponents(NULL), m_usComponents(0), m_pPool(NULL),
+      m_pSpectra(NULL), m_pBuffers(NULL)
   {
   }
   //
   virtual ~Meter(void)
   {
+    delete[] m_pdComponents;
   }
   //
   //
@@ -68,12 +137,116 @@ public:
     return m_pNext;
   }
   //
+  // Return the command line option the meter was created from, or NULL.
+  const char *OptionOf(void) const
+  {
+    return m_pcOption;
+  }
+  //
+  const char *&OptionOf(void)
+  {
+    return m_pcOption;
+  }
+  //
+  // Offer the threads of the given pool for the measurement.
+  void UsePool(class ThreadPool *pool)
+  {
+    m_pPool = pool;
+  }
+  //
+  // Offer spectra of the images shared with the other meters.
+  void UseSpectra(class Spectra *spectra)
+  {
+    m_pSpectra = spectra;
+  }
+  //
+  // Take the sample buffers of filters from the given pool. The pool
+  // must outlive the meter and the images it is run on.
+  void UseBuffers(class BufferPool *buffers)
+  {
+    m_pBuffers = buffers;
+  }
+  //
   // Perform the measurement, return the result.
   virtual double Measure(class ImageLayout *org,class ImageLayout *dist,double in) = 0;
   //
+  // Return the accumulators (see Statistics) this meter derives its
+  // result from. Zero if the meter does not work on statistics.
+  virtual ULONG StatisticsOf(void) const
+  {
+    return 0;
+  }
+  //
+  // Compute the result from statistics collected on the images.
+  // Only called if StatisticsOf() is non-zero. Consecutive meters
+  // working on statistics thus share a single pass over the images.
+  virtual double Evaluate(class ImageLayout *,const class Statistics &,double in)
+  {
+    return in;
+  }
+  //
+  // Return whether this meter is a filter that computes each output
+  // row from the same row of the input only and does not deliver a
+  // result. Such filters can be run on horizontal bands of the
+  // images instead of the complete images.
+  virtual bool isPointWise(void) const
+  {
+    return false;
+  }
+  //
+  // Forget the images the meter was run on such that it can run on
+  // the next band of the images. Point-wise filters keeping the
+  // buffers of their result must release them here.
+  virtual void Restart(void)
+  {
+  }
+  //
+  // Return whether this meter only checks the result of the previous
+  // meter and never looks at the images.
+  virtual bool isResultOnly(void) const
+  {
+    return false;
+  }
+  //
+  // Return whether this meter only reads the spectra of the images
+  // and leaves the images alone, such that spectra computed before
+  // remain valid.
+  virtual bool isSpectral(void) const
+  {
+    return false;
+  }
+  //
+  // Return the number of components the last result is broken down
+  // into, zero if the meter only delivers a single result.
+  UWORD ComponentsOf(void) const
+  {
+    return m_usComponents;
+  }
+  //
+  // Return the result of the last measurement for the given component.
+  double ComponentOf(UWORD comp) const
+  {
+    return m_pdComponents[comp];
+  }
+  //
+  // Return whether the result is in dB, i.e. a logarithm of an
+  // error. Averages over several images are then formed over the
+  // error rather than over the logarithm.
+  virtual bool isDecibel(void) const
+  {
+    return false;
+  }
+  //
   // Return the name of this class.
   virtual const char *NameOf(void) const = 0;
   //
+  // Return the file the meter writes its output to, NULL if it does
+  // not write a file.
+  virtual const char *TargetOf(void) const
+  {
+    return NULL;
+  }
+  //
 };
 ///
 
@@ -31,48 +31,29 @@ and conversion framework.
 
 /// Includes
 #include "diff/mrse.hpp"
+#include "diff/statistics.hpp"
 #include "img/imglayout.hpp"
 #include "std/math.hpp"
 ///
 
-/// MRSE::Compute
-template<typename T>
-double MRSE::Compute(T *org,ULONG obytesperpixel,ULONG obytesperrow,
-		     T *dst,ULONG dbytesperpixel,ULONG dbytesperrow,
-		     ULONG w,ULONG h)
+/// MRSE::Measure
+double MRSE::Measure(class ImageLayout *src,class ImageLayout *dst,double in)
 {
-  double error = 0.0;
-  ULONG x,y;
+  class Statistics stats;
 
-  for(y = 0;y < h;y++) {
-    T *orgrow = org;
-    T *dstrow = dst;
-    for(x = 0;x < w;x++) {
-      double vorg = *orgrow;
-      double vdst = *dstrow;
-      double diff = vorg - vdst;
-      double norm = vorg * vorg + vdst * vdst;
-      if (norm > 0.0) {
-	error    += (diff * diff) / norm;
-      }
-      //
-      orgrow      = (T *)((const UBYTE *)(orgrow) + obytesperpixel);
-      dstrow      = (T *)((const UBYTE *)(dstrow) + dbytesperpixel);
-    }
-    org = (T *)((const UBYTE *)(org) + obytesperrow);
-    dst = (T *)((const UBYTE *)(dst) + dbytesperrow);
-  }
+  stats.Collect(src,dst,StatisticsOf());
 
-  return error;
+  return Evaluate(src,stats,in);
 }
 ///
 
-/// MRSE::Measure
-double MRSE::Measure(class ImageLayout *src,class ImageLayout *dst,double)
+/// MRSE::Evaluate
+double MRSE::Evaluate(class ImageLayout *src,const class Statistics &stats,double)
 {
   double error = 0.0;
   UWORD comp,d = src->DepthOf();
   int type = m_Type;
+  double *cres = ComponentResults(d);
 
   if (d != 3 && type != Min && type != Mean) {
     fprintf(stderr,"the selected MRSE measurement is only available for three component images, reverting to minmrse\n");
@@ -80,63 +61,16 @@ double MRSE::Measure(class ImageLayout *src,class ImageLayout *dst,double)
   }
 
   for(comp = 0;comp < d;comp++) {
-    double mse = 0.0;
+    double mse = stats.ComponentOf(comp).m_dRelativeError;
     ULONG  w   = src->WidthOf(comp);
     ULONG  h   = src->HeightOf(comp);
     double prc = (src->isFloat(comp))?(1.0):(double(UQUAD(1) << src->BitsOf(comp)) - 1.0);
     //
-    if (src->isSigned(comp)) {
-      if (src->BitsOf(comp) <= 8) {
-	mse = Compute<const BYTE>((const BYTE *)src->DataOf(comp),src->BytesPerPixel(comp),src->BytesPerRow(comp),
-				  (const BYTE *)dst->DataOf(comp),dst->BytesPerPixel(comp),dst->BytesPerRow(comp),
-				  w,h);
-      } else if (!src->isFloat(comp) && src->BitsOf(comp) <= 16) {
-	mse = Compute<const WORD>((const WORD *)src->DataOf(comp),src->BytesPerPixel(comp),src->BytesPerRow(comp),
-				  (const WORD *)dst->DataOf(comp),dst->BytesPerPixel(comp),dst->BytesPerRow(comp),
-				  w,h);
-      } else if (!src->isFloat(comp) && src->BitsOf(comp) <= 32) {
-	mse = Compute<const LONG>((const LONG *)src->DataOf(comp),src->BytesPerPixel(comp),src->BytesPerRow(comp),
-				  (const LONG *)dst->DataOf(comp),dst->BytesPerPixel(comp),dst->BytesPerRow(comp),
-				  w,h);
-      } else if (src->BitsOf(comp) <= 32 && src->isFloat(comp)) {
-	mse = Compute<const FLOAT>((const FLOAT *)src->DataOf(comp),src->BytesPerPixel(comp),src->BytesPerRow(comp),
-				   (const FLOAT *)dst->DataOf(comp),dst->BytesPerPixel(comp),dst->BytesPerRow(comp),
-				   w,h);
-      } else if (src->BitsOf(comp) == 64 && src->isFloat(comp)) {
-	mse = Compute<const DOUBLE>((const DOUBLE *)src->DataOf(comp),src->BytesPerPixel(comp),src->BytesPerRow(comp),
-				    (const DOUBLE *)dst->DataOf(comp),dst->BytesPerPixel(comp),dst->BytesPerRow(comp),
-				    w,h);
-      } else {
-	throw "unsupported data type";
-      }
-    } else {
-      if (src->BitsOf(comp) <= 8) {
-	mse = Compute<const UBYTE>((const UBYTE *)src->DataOf(comp),src->BytesPerPixel(comp),src->BytesPerRow(comp),
-				   (const UBYTE *)dst->DataOf(comp),dst->BytesPerPixel(comp),dst->BytesPerRow(comp),
-				   w,h);
-      } else if (!src->isFloat(comp) && src->BitsOf(comp) <= 16) {
-	mse = Compute<const UWORD>((const UWORD *)src->DataOf(comp),src->BytesPerPixel(comp),src->BytesPerRow(comp),
-				   (const UWORD *)dst->DataOf(comp),dst->BytesPerPixel(comp),dst->BytesPerRow(comp),
-				   w,h);
-      } else if (!src->isFloat(comp) && src->BitsOf(comp) <= 32) {
-	mse = Compute<const ULONG>((const ULONG *)src->DataOf(comp),src->BytesPerPixel(comp),src->BytesPerRow(comp),
-				   (const ULONG *)dst->DataOf(comp),dst->BytesPerPixel(comp),dst->BytesPerRow(comp),
-				   w,h);
-      } else if (src->BitsOf(comp) <= 32 && src->isFloat(comp)) {
-	mse = Compute<const FLOAT>((const FLOAT *)src->DataOf(comp),src->BytesPerPixel(comp),src->BytesPerRow(comp),
-				   (const FLOAT *)dst->DataOf(comp),dst->BytesPerPixel(comp),dst->BytesPerRow(comp),
-				   w,h);
-      } else if (src->BitsOf(comp) == 64 && src->isFloat(comp)) {
-	mse = Compute<const DOUBLE>((const DOUBLE *)src->DataOf(comp),src->BytesPerPixel(comp),src->BytesPerRow(comp),
-				    (const DOUBLE *)dst->DataOf(comp),dst->BytesPerPixel(comp),dst->BytesPerRow(comp),
-				    w,h);
-      } else {
-	throw "unsupported data type";
-      }
-    }
-    //
     mse /= (w * h) * prc * prc;
     //
+    // The result of this component alone.
+    cres[comp] = -10.0 * log(mse) / log(10.0);
+    //
     switch(m_Type) {
     case Mean:
       error += mse / src->DepthOf();
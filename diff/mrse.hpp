@@ -34,6 +34,7 @@ and conversion framework.
 
 /// Includes
 #include "diff/meter.hpp"
+#include "diff/statistics.hpp"
 ///
 
 /// Forwards
@@ -46,11 +47,6 @@ class MRSE : public Meter {
   // PSNR measurement type
   int m_Type;
   //
-  // Templated implementations
-  template<typename T>
-  double Compute(T *org,ULONG obytesperpixel,ULONG obytesperrow,
-		 T *dst,ULONG dbytesperpixel,ULONG dbytesperrow,
-		 ULONG w,ULONG h);
 public:
   //
   // Several options: Mean MRSE, minimum MRSE, and with YCbCr weights (yuck!)
@@ -68,6 +64,21 @@ public:
   //
   virtual double Measure(class ImageLayout *src,class ImageLayout *dst,double in);
   //
+  // The statistics the MRSE is computed from.
+  virtual ULONG StatisticsOf(void) const
+  {
+    return Statistics::RelativeError;
+  }
+  //
+  // Compute the MRSE from the collected statistics.
+  virtual double Evaluate(class ImageLayout *src,const class Statistics &stats,double in);
+  //
+  // The MRSE is always in dB.
+  virtual bool isDecibel(void) const
+  {
+    return true;
+  }
+  //
   virtual const char *NameOf(void) const
   {
     return "MRSE";
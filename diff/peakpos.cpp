@@ -30,112 +30,36 @@ and conversion framework.
 
 /// Includes
 #include "diff/peakpos.hpp"
+#include "diff/statistics.hpp"
 #include "img/imglayout.hpp"
 #include "std/math.hpp"
 ///
 
-/// PeakPos::PeakError
-template<typename T>
-PeakPos::Pixel PeakPos::PeakError(T *org,ULONG obytesperpixel,ULONG obytesperrow,
-				  T *dst,ULONG dbytesperpixel,ULONG dbytesperrow,
-				  ULONG w,ULONG h)
+/// PeakPos::Measure
+double PeakPos::Measure(class ImageLayout *src,class ImageLayout *dst,double in)
 {
-  double error = 0.0;
-  ULONG x,y;
-  ULONG px = 0;
-  ULONG py = 0;
+  class Statistics stats;
 
-  for(y = 0;y < h;y++) {
-    T *orgrow = org;
-    T *dstrow = dst;
-    for(x = 0;x < w;x++) {
-      double diff = *orgrow - *dstrow;
-      diff        = fabs(diff);
-      if (diff > error) {
-	error     = diff;
-	px        = x;
-	py        = y;
-      }
-      //
-      orgrow      = (T *)((const UBYTE *)(orgrow) + obytesperpixel);
-      dstrow      = (T *)((const UBYTE *)(dstrow) + dbytesperpixel);
-    }
-    org = (T *)((const UBYTE *)(org) + obytesperrow);
-    dst = (T *)((const UBYTE *)(dst) + dbytesperrow);
-  }
+  stats.Collect(src,dst,StatisticsOf());
 
-  {
-    struct Pixel pix;
-    pix.error = error;
-    pix.x     = px;
-    pix.y     = py;
-    
-    return pix;
-  }
+  return Evaluate(src,stats,in);
 }
 ///
 
-/// PeakPos::Measure
-double PeakPos::Measure(class ImageLayout *src,class ImageLayout *dst,double)
+/// PeakPos::Evaluate
+double PeakPos::Evaluate(class ImageLayout *src,const class Statistics &stats,double)
 {
-  struct Pixel px,pxmax = {0,0,0.0};
+  struct Pixel px = {0,0,0.0},pxmax = {0,0,0.0};
   double error = 0.0;
   UWORD comp;
 
   for(comp = 0;comp < src->DepthOf();comp++) {
-    ULONG  w    = src->WidthOf(comp);
-    ULONG  h    = src->HeightOf(comp);
+    const struct Statistics::Component &c = stats.ComponentOf(comp);
     double prc  = src->isFloat(comp)?(1.0):(double(UQUAD(1) << src->BitsOf(comp)) - 1.0);
     //
-    if (src->isSigned(comp)) {
-      if (src->BitsOf(comp) <= 8) {
-	px = PeakError<const BYTE>((const BYTE *)src->DataOf(comp),src->BytesPerPixel(comp),src->BytesPerRow(comp),
-				     (const BYTE *)dst->DataOf(comp),dst->BytesPerPixel(comp),dst->BytesPerRow(comp),
-				     w,h);
-      } else if (!src->isFloat(comp) && src->BitsOf(comp) <= 16) {
-	px = PeakError<const WORD>((const WORD *)src->DataOf(comp),src->BytesPerPixel(comp),src->BytesPerRow(comp),
-				     (const WORD *)dst->DataOf(comp),dst->BytesPerPixel(comp),dst->BytesPerRow(comp),
-				     w,h);
-       } else if (!src->isFloat(comp) && src->BitsOf(comp) <= 32) {
-	px = PeakError<const LONG>((const LONG *)src->DataOf(comp),src->BytesPerPixel(comp),src->BytesPerRow(comp),
-				     (const LONG *)dst->DataOf(comp),dst->BytesPerPixel(comp),dst->BytesPerRow(comp),
-				     w,h);
-      } else if (src->BitsOf(comp) <= 32 && src->isFloat(comp)) {
-	px = PeakError<const FLOAT>((const FLOAT *)src->DataOf(comp),src->BytesPerPixel(comp),src->BytesPerRow(comp),
-				      (const FLOAT *)dst->DataOf(comp),dst->BytesPerPixel(comp),dst->BytesPerRow(comp),
-				      w,h);
-      } else if (src->BitsOf(comp) == 64 && src->isFloat(comp)) {
-	px = PeakError<const DOUBLE>((const DOUBLE *)src->DataOf(comp),src->BytesPerPixel(comp),src->BytesPerRow(comp),
-				       (const DOUBLE *)dst->DataOf(comp),dst->BytesPerPixel(comp),dst->BytesPerRow(comp),
-				       w,h);
-      } else {
-	throw "unsupported data type";
-      }
-    } else {
-      if (src->BitsOf(comp) <= 8) {
-	px = PeakError<const UBYTE>((const UBYTE *)src->DataOf(comp),src->BytesPerPixel(comp),src->BytesPerRow(comp),
-				      (const UBYTE *)dst->DataOf(comp),dst->BytesPerPixel(comp),dst->BytesPerRow(comp),
-				      w,h);
-      } else if (!src->isFloat(comp) && src->BitsOf(comp) <= 16) {
-	px = PeakError<const UWORD>((const UWORD *)src->DataOf(comp),src->BytesPerPixel(comp),src->BytesPerRow(comp),
-				      (const UWORD *)dst->DataOf(comp),dst->BytesPerPixel(comp),dst->BytesPerRow(comp),
-				      w,h);
-      } else if (!src->isFloat(comp) && src->BitsOf(comp) <= 32) {
-	px = PeakError<const ULONG>((const ULONG *)src->DataOf(comp),src->BytesPerPixel(comp),src->BytesPerRow(comp),
-				      (const ULONG *)dst->DataOf(comp),dst->BytesPerPixel(comp),dst->BytesPerRow(comp),
-				      w,h);
-      } else if (src->BitsOf(comp) <= 32 && src->isFloat(comp)) {
-	px = PeakError<const FLOAT>((const FLOAT *)src->DataOf(comp),src->BytesPerPixel(comp),src->BytesPerRow(comp),
-				      (const FLOAT *)dst->DataOf(comp),dst->BytesPerPixel(comp),dst->BytesPerRow(comp),
-				      w,h);
-      } else if (src->BitsOf(comp) == 64 && src->isFloat(comp)) {
-	px = PeakError<const DOUBLE>((const DOUBLE *)src->DataOf(comp),src->BytesPerPixel(comp),src->BytesPerRow(comp),
-				       (const DOUBLE *)dst->DataOf(comp),dst->BytesPerPixel(comp),dst->BytesPerRow(comp),
-				       w,h);
-      } else {
-	throw "unsupported data type";
-      }
-    }
+    px.error = c.m_dPeakError;
+    px.x     = c.m_ulPeakX;
+    px.y     = c.m_ulPeakY;
     //
     px.error /= prc;
     //
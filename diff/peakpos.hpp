@@ -33,6 +33,7 @@ and conversion framework.
 
 /// Includes
 #include "diff/meter.hpp"
+#include "diff/statistics.hpp"
 ///
 
 /// Forwards
@@ -51,11 +52,6 @@ class PeakPos : public Meter {
   // PRE measurement type
   int m_Type;
   //
-  // Templated implementations
-  template<typename T>
-  Pixel PeakError(T *org,ULONG obytesperpixel,ULONG obytesperrow,
-		  T *dst,ULONG dbytesperpixel,ULONG dbytesperrow,
-		  ULONG w,ULONG h);
 public:
   //
   // Several options: X and Y position.
@@ -70,6 +66,15 @@ public:
   //
   virtual double Measure(class ImageLayout *src,class ImageLayout *dst,double in);
   //
+  // The statistics the peak position is computed from.
+  virtual ULONG StatisticsOf(void) const
+  {
+    return Statistics::PeakError;
+  }
+  //
+  // Compute the peak position from the collected statistics.
+  virtual double Evaluate(class ImageLayout *src,const class Statistics &stats,double in);
+  //
   virtual const char *NameOf(void) const
   {
     return "PeakPosition";
@@ -33,6 +33,7 @@ and conversion framework.
 
 /// Includes
 #include "diff/meter.hpp"
+#include "diff/statistics.hpp"
 ///
 
 /// Forwards
@@ -45,11 +46,6 @@ class PRE : public Meter {
   // PRE measurement type
   int m_Type;
   //
-  // Templated implementations
-  template<typename T>
-  double PeakError(T *org,ULONG obytesperpixel,ULONG obytesperrow,
-		   T *dst,ULONG dbytesperpixel,ULONG dbytesperrow,
-		   ULONG w,ULONG h);
 public:
   //
   // Several options: Mean PRE, minimum PRE
@@ -64,6 +60,15 @@ public:
   //
   virtual double Measure(class ImageLayout *src,class ImageLayout *dst,double in);
   //
+  // The statistics the peak relative error is computed from.
+  virtual ULONG StatisticsOf(void) const
+  {
+    return Statistics::PeakError;
+  }
+  //
+  // Compute the peak relative error from the collected statistics.
+  virtual double Evaluate(class ImageLayout *src,const class Statistics &stats,double in);
+  //
   virtual const char *NameOf(void) const
   {
     return "PeakRelativeError";
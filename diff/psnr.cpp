@@ -31,51 +31,31 @@ and conversion framework.
 
 /// Includes
 #include "diff/psnr.hpp"
+#include "diff/statistics.hpp"
 #include "img/imglayout.hpp"
 #include "std/math.hpp"
 ///
 
-/// PSNR::MSE
-template<typename T>
-double PSNR::MSE(T *org,ULONG obytesperpixel,ULONG obytesperrow,
-		 T *dst,ULONG dbytesperpixel,ULONG dbytesperrow,
-		 ULONG w,ULONG h,double &max,double &energy)
+/// PSNR::Measure
+double PSNR::Measure(class ImageLayout *src,class ImageLayout *dst,double in)
 {
-  double error = 0.0;
-  ULONG x,y;
+  class Statistics stats;
 
-  for(y = 0;y < h;y++) {
-    T *orgrow = org;
-    T *dstrow = dst;
-    for(x = 0;x < w;x++) {
-      double diff = *orgrow - *dstrow;
-      double orq  = *orgrow * *orgrow;
-      //double dsq  = *dstrow * *dstrow;
-      error      += diff * diff;
-      //energy     += (orq + dsq) * 0.5;
-      energy     += orq;
-      if (orq > max) max = orq;
-      // if (dsq > max) max = dsq;
-      //
-      orgrow      = (T *)((const UBYTE *)(orgrow) + obytesperpixel);
-      dstrow      = (T *)((const UBYTE *)(dstrow) + dbytesperpixel);
-    }
-    org = (T *)((const UBYTE *)(org) + obytesperrow);
-    dst = (T *)((const UBYTE *)(dst) + dbytesperrow);
-  }
+  stats.Collect(src,dst,StatisticsOf());
 
-  return error;
+  return Evaluate(src,stats,in);
 }
 ///
 
-/// PSNR::Measure
-double PSNR::Measure(class ImageLayout *src,class ImageLayout *dst,double)
+/// PSNR::Evaluate
+double PSNR::Evaluate(class ImageLayout *src,const class Statistics &stats,double)
 {
   double error  = 0.0;
   double max    = 0.0;
   double energy = 0.0;
   UWORD comp,d  = src->DepthOf();
   int type      = m_Type;
+  double *cres  = ComponentResults(d);
 
   if (d != 3 && type != Min && type != Mean && type != RootMean) {
     fprintf(stderr,"the selected PSNR measurement is only available for three component images, reverting to minpsnr\n");
@@ -83,61 +63,15 @@ double PSNR::Measure(class ImageLayout *src,class ImageLayout *dst,double)
   }
 
   for(comp = 0;comp < d;comp++) {
-    double mse = 0.0;
-    double erg = 0.0;
+    const struct Statistics::Component &c = stats.ComponentOf(comp);
+    double mse = c.m_dSquareError;
+    double erg = c.m_dEnergy;
     ULONG  w   = src->WidthOf(comp);
     ULONG  h   = src->HeightOf(comp);
     double prc = (src->isFloat(comp))?(1.0):(double(UQUAD(1) << src->BitsOf(comp)) - 1.0);
     //
-    if (src->isSigned(comp)) {
-      if (src->BitsOf(comp) <= 8) {
-	mse = MSE<const BYTE>((const BYTE *)src->DataOf(comp),src->BytesPerPixel(comp),src->BytesPerRow(comp),
-			      (const BYTE *)dst->DataOf(comp),dst->BytesPerPixel(comp),dst->BytesPerRow(comp),
-			      w,h,max,erg);
-      } else if (!src->isFloat(comp) && src->BitsOf(comp) <= 16) {
-	mse = MSE<const WORD>((const WORD *)src->DataOf(comp),src->BytesPerPixel(comp),src->BytesPerRow(comp),
-			      (const WORD *)dst->DataOf(comp),dst->BytesPerPixel(comp),dst->BytesPerRow(comp),
-			      w,h,max,erg);
-      } else if (!src->isFloat(comp) && src->BitsOf(comp) <= 32) {
-	mse = MSE<const LONG>((const LONG *)src->DataOf(comp),src->BytesPerPixel(comp),src->BytesPerRow(comp),
-			      (const LONG *)dst->DataOf(comp),dst->BytesPerPixel(comp),dst->BytesPerRow(comp),
-			      w,h,max,erg);
-      } else if (src->BitsOf(comp) <= 32 && src->isFloat(comp)) {
-	mse = MSE<const FLOAT>((const FLOAT *)src->DataOf(comp),src->BytesPerPixel(comp),src->BytesPerRow(comp),
-			       (const FLOAT *)dst->DataOf(comp),dst->BytesPerPixel(comp),dst->BytesPerRow(comp),
-			       w,h,max,erg);
-      } else if (src->BitsOf(comp) == 64 && src->isFloat(comp)) {
-	mse = MSE<const DOUBLE>((const DOUBLE *)src->DataOf(comp),src->BytesPerPixel(comp),src->BytesPerRow(comp),
-				(const DOUBLE *)dst->DataOf(comp),dst->BytesPerPixel(comp),dst->BytesPerRow(comp),
-				w,h,max,erg);
-      } else {
-	throw "unsupported data type";
-      }
-    } else {
-      if (src->BitsOf(comp) <= 8) {
-	mse = MSE<const UBYTE>((const UBYTE *)src->DataOf(comp),src->BytesPerPixel(comp),src->BytesPerRow(comp),
-			       (const UBYTE *)dst->DataOf(comp),dst->BytesPerPixel(comp),dst->BytesPerRow(comp),
-			       w,h,max,erg);
-      } else if (!src->isFloat(comp) && src->BitsOf(comp) <= 16) {
-	mse = MSE<const UWORD>((const UWORD *)src->DataOf(comp),src->BytesPerPixel(comp),src->BytesPerRow(comp),
-			       (const UWORD *)dst->DataOf(comp),dst->BytesPerPixel(comp),dst->BytesPerRow(comp),
-			       w,h,max,erg);
-      } else if (!src->isFloat(comp) && src->BitsOf(comp) <= 32) {
-	mse = MSE<const ULONG>((const ULONG *)src->DataOf(comp),src->BytesPerPixel(comp),src->BytesPerRow(comp),
-			       (const ULONG *)dst->DataOf(comp),dst->BytesPerPixel(comp),dst->BytesPerRow(comp),
-			       w,h,max,erg);
-      } else if (src->BitsOf(comp) <= 32 && src->isFloat(comp)) {
-	mse = MSE<const FLOAT>((const FLOAT *)src->DataOf(comp),src->BytesPerPixel(comp),src->BytesPerRow(comp),
-			       (const FLOAT *)dst->DataOf(comp),dst->BytesPerPixel(comp),dst->BytesPerRow(comp),
-			       w,h,max,erg);
-      } else if (src->BitsOf(comp) == 64 && src->isFloat(comp)) {
-	mse = MSE<const DOUBLE>((const DOUBLE *)src->DataOf(comp),src->BytesPerPixel(comp),src->BytesPerRow(comp),
-				(const DOUBLE *)dst->DataOf(comp),dst->BytesPerPixel(comp),dst->BytesPerRow(comp),
-				w,h,max,erg);
-      } else {
-	throw "unsupported data type";
-      }
-    }
+    if (c.m_dPeakSquare > max)
+      max = c.m_dPeakSquare;
     //
     if (m_bSNR || m_bLinear) {
       mse /= (w * h);
@@ -147,6 +81,9 @@ double PSNR::Measure(class ImageLayout *src,class ImageLayout *dst,double)
       erg /= (w * h) * prc * prc;
     }
     //
+    // The result of this component alone.
+    cres[comp] = Scale(mse,erg,c.m_dPeakSquare);
+    //
     switch(type) {
     case Mean:
     case RootMean:
@@ -206,6 +143,15 @@ double PSNR::Measure(class ImageLayout *src,class ImageLayout *dst,double)
     }
   }
 
+  return Scale(error,energy,max);
+}
+///
+
+/// PSNR::Scale
+// Convert a normalized mean square error into the result, given the
+// energy and the peak of the source the error is relative to.
+double PSNR::Scale(double error,double energy,double max) const
+{
   if (m_bSNR) {
     if (m_bScaleToEnergy) {
       if (energy > 0.0) {
@@ -219,7 +165,7 @@ double PSNR::Measure(class ImageLayout *src,class ImageLayout *dst,double)
   }
   
   if (m_bLinear) {
-    if (type == RootMean)
+    if (m_Type == RootMean)
       return sqrt(error);
     return error;
   } else {
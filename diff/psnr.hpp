@@ -34,6 +34,7 @@ and conversion framework.
 
 /// Includes
 #include "diff/meter.hpp"
+#include "diff/statistics.hpp"
 ///
 
 /// Forwards
@@ -55,11 +56,10 @@ class PSNR : public Meter {
   // Instead of taking the max in the SNR computation, compute the energy of the source.
   bool m_bScaleToEnergy;
   //
-  // Templated implementations
-  template<typename T>
-  double MSE(T *org,ULONG obytesperpixel,ULONG obytesperrow,
-	     T *dst,ULONG dbytesperpixel,ULONG dbytesperrow,
-	     ULONG w,ULONG h,double &max,double &energy);
+  // Convert a normalized mean square error into the result, given the
+  // energy and the peak of the source the error is relative to.
+  double Scale(double error,double energy,double max) const;
+  //
 public:
   //
   // Several options: Mean PSNR, minimum PSNR, and with YCbCr weights (yuck!)
@@ -78,6 +78,23 @@ public:
   //
   virtual double Measure(class ImageLayout *src,class ImageLayout *dst,double in);
   //
+  // The statistics the PSNR is computed from.
+  virtual ULONG StatisticsOf(void) const
+  {
+    if (m_bSNR)
+      return Statistics::SquareError | Statistics::SourceEnergy;
+    return Statistics::SquareError;
+  }
+  //
+  // Compute the PSNR from the collected statistics.
+  virtual double Evaluate(class ImageLayout *src,const class Statistics &stats,double in);
+  //
+  // The PSNR and SNR values are in dB unless linear.
+  virtual bool isDecibel(void) const
+  {
+    return !m_bLinear;
+  }
+  //
   virtual const char *NameOf(void) const
   {
     if (m_bLinear) {
@@ -66,18 +66,28 @@ void Scale::Convert(const S *org ,ULONG obytesperpixel,ULONG obytesperrow,
 
 /// Scale::~Scale
 Scale::~Scale(void)
+{
+  Restart();
+}
+///
+
+/// Scale::Restart
+// Release the result of the last band.
+void Scale::Restart(void)
 {
   int i;
 
   if (m_ppucImage) {
     for(i = 0;i < m_usDepth;i++) {
       if (m_ppucImage[i])
-        delete[] m_ppucImage[i];
+        ReleaseBuffer(m_ppucImage[i]);
     }
     delete[] m_ppucImage;
+    m_ppucImage = NULL;
   }
 
   delete m_pDest;
+  m_pDest = NULL;
 }
 ///
 
@@ -86,6 +96,8 @@ Scale::~Scale(void)
 void Scale::ApplyScaling(class ImageLayout *src)
 {
   UWORD comp;
+  // As a filter, the result may replace the source samples.
+  bool writable = (m_pTargetFile == NULL) && isWritable(src);
 
   CreateComponents(*src);
   m_ppucImage = new UBYTE *[src->DepthOf()];
@@ -146,15 +158,26 @@ void Scale::ApplyScaling(class ImageLayout *src)
     //
     // Now install the parameters.
     dbpp = ImageLayout::SuggestBPP(bps,tofloat);
-    mem  = new UBYTE[w * h * dbpp];
-    m_ppucImage[comp]                    = mem;
+    if (writable && dbpp == ImageLayout::SuggestBPP(sbps,src->isFloat(comp)) &&
+	src->BytesPerPixel(comp) == dbpp && src->BytesPerRow(comp) == w * dbpp) {
+      // Samples keep their size and are packed as in a new buffer, so
+      // convert them where they are. Each sample is read before it is
+      // overwritten. Interleaved samples go into a new buffer as
+      // before, since the filters behind may round them differently.
+      mem  = (UBYTE *)src->DataOf(comp);
+      dbpr = w * dbpp;
+    } else {
+      mem  = AllocateBuffer(w * h * dbpp);
+      dbpr = w * dbpp;
+      m_ppucImage[comp] = mem;
+    }
     m_pComponent[comp].m_ucBits          = bps;
     m_pComponent[comp].m_bSigned         = tosigned;
     m_pComponent[comp].m_bFloat          = tofloat;
     m_pComponent[comp].m_ulWidth         = w;
     m_pComponent[comp].m_ulHeight        = h;
     m_pComponent[comp].m_ulBytesPerPixel = dbpp;
-    m_pComponent[comp].m_ulBytesPerRow   = dbpr = w * dbpp;
+    m_pComponent[comp].m_ulBytesPerRow   = dbpr;
     m_pComponent[comp].m_pPtr            = mem;
     //
     if (tofloat) {
@@ -211,6 +234,11 @@ void Scale::ApplyScaling(class ImageLayout *src)
     if (m_bPad)
       scale = 1.0;
     //
+    // Floating point samples converted in place to the same type
+    // remain as they are.
+    if (mem == src->DataOf(comp) && tofloat && src->isFloat(comp) && scale == 1.0 && shift == 0.0)
+      continue;
+    //
     //
     if (tofloat) {
       if (bps == 32 || bps == 16) {
@@ -578,6 +606,7 @@ double Scale::Measure(class ImageLayout *src,class ImageLayout *dst,double in)
     assert(m_pDest == NULL);
     m_pDest = new class Scale(m_pTargetFile,m_bMakeInt,m_bMakeFloat,m_bMakeUnsigned,m_bMakeSigned,
 			      m_ucTargetDepth,m_bPad,m_TargetSpecs);
+    m_pDest->UseBuffers(BuffersOf());
     //
     // Also map the destination image.
     m_pDest->ApplyScaling(dst);
@@ -588,7 +617,7 @@ double Scale::Measure(class ImageLayout *src,class ImageLayout *dst,double in)
   } else {
     ApplyScaling(src);
     
-    SaveImage(m_pTargetFile,m_TargetSpecs);
+    SaveImage(m_pTargetFile,m_TargetSpecs,PoolOf());
   }
   return in;
 }
@@ -108,6 +108,22 @@ public:
   {
     return NULL;
   }
+  //
+  // Return the file the output is written to, NULL if none.
+  virtual const char *TargetOf(void) const
+  {
+    return m_pTargetFile;
+  }
+  //
+  // Works on each sample by itself, but only as a filter. Saving
+  // the image requires all of it.
+  virtual bool isPointWise(void) const
+  {
+    return m_pTargetFile == NULL;
+  }
+  //
+  // Release the result of the last band.
+  virtual void Restart(void);
 };
 ///
 
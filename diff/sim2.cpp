@@ -39,8 +39,8 @@ and conversion framework.
 // Destroy the class, release all memory
 Sim2::~Sim2(void)
 {
-  delete[] m_pucSrc;
-  delete[] m_pucDst;
+  ReleaseBuffer(m_pucSrc);
+  ReleaseBuffer(m_pucDst);
 }
 ///
 
@@ -223,10 +223,10 @@ void Sim2::Convert(class ImageLayout *img,bool dst)
   CreateComponents(w,h,3);
   if (dst) {
     assert(m_pucDst == NULL);
-    buf = m_pucDst = new UBYTE[w * h * 3];
+    buf = m_pucDst = AllocateBuffer(w * h * 3);
   } else {
     assert(m_pucSrc == NULL);
-    buf = m_pucSrc = new UBYTE[w * h * 3];
+    buf = m_pucSrc = AllocateBuffer(w * h * 3);
   }
   assert(buf);
   for(i = 0;i < 3;i++) {
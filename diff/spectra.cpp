@@ -0,0 +1,344 @@
+/*************************************************************************
+** Written by Thomas Richter (THOR Software) for Accusoft	        **
+** All Rights Reserved							**
+**************************************************************************
+
+This source file is part of difftest_ng, a universal image measuring
+and conversion framework.
+
+    difftest_ng is free software: you can redistribute it and/or modify
+    it under the terms of the GNU General Public License as published by
+    the Free Software Foundation, either version 3 of the License, or
+    (at your option) any later version.
+
+    difftest_ng is distributed in the hope that it will be useful,
+    but WITHOUT ANY WARRANTY; without even the implied warranty of
+    MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+    GNU General Public License for more details.
+
+    You should have received a copy of the GNU General Public License
+    along with difftest_ng.  If not, see <http://www.gnu.org/licenses/>.
+
+*************************************************************************/
+/*
+**
+** $Id$
+**
+** This class keeps the spectra of the difference of two images such
+** that several FFT based meters in a row (MaxFreq, FFTImg) transform
+** the difference only once. The spectra are dropped as soon as the
+** images are modified or replaced.
+*/
+
+/// Includes
+#include "diff/spectra.hpp"
+#include "img/imglayout.hpp"
+#include "tools/fft.hpp"
+#include "std/string.hpp"
+///
+
+/// Spectra::CopyToFFT
+// Fill the difference of the two components into the transformation.
+template<typename T>
+void Spectra::CopyToFFT(T *org,ULONG obytesperpixel,ULONG obytesperrow,
+			T *dst,ULONG dbytesperpixel,ULONG dbytesperrow,
+			double *target,ULONG stride,ULONG w,ULONG h)
+{
+  ULONG x,y;
+
+  for(y = 0;y < h;y++) {
+    T *orgrow      = org;
+    T *dstrow      = dst;
+    double *trgrow = target + y * stride;
+    for(x = 0;x < w;x++) {
+      *trgrow     = *orgrow - *dstrow;
+      //
+      orgrow      = (T *)((const UBYTE *)(orgrow) + obytesperpixel);
+      dstrow      = (T *)((const UBYTE *)(dstrow) + dbytesperpixel);
+      trgrow++;
+    }
+    org = (T *)((const UBYTE *)(org) + obytesperrow);
+    dst = (T *)((const UBYTE *)(dst) + dbytesperrow);
+  }
+}
+///
+
+/// Spectra::DifferenceOf
+// Fill the difference org - dst of the w x h rectangle at x,y of the
+// given component into the target with the given stride in doubles.
+void Spectra::DifferenceOf(const class ImageLayout *org,const class ImageLayout *dst,UWORD comp,
+			   ULONG x,ULONG y,ULONG w,ULONG h,double *target,ULONG stride)
+{
+  const UBYTE *orgdata = (const UBYTE *)org->DataOf(comp) +
+    y * org->BytesPerRow(comp) + x * org->BytesPerPixel(comp);
+  const UBYTE *dstdata = (const UBYTE *)dst->DataOf(comp) +
+    y * dst->BytesPerRow(comp) + x * dst->BytesPerPixel(comp);
+
+  if (org->isSigned(comp)) {
+    if (org->BitsOf(comp) <= 8) {
+      CopyToFFT<const BYTE>((const BYTE *)orgdata,org->BytesPerPixel(comp),org->BytesPerRow(comp),
+			    (const BYTE *)dstdata,dst->BytesPerPixel(comp),dst->BytesPerRow(comp),
+			    target,stride,w,h);
+    } else if (!org->isFloat(comp) && org->BitsOf(comp) <= 16) {
+      CopyToFFT<const WORD>((const WORD *)orgdata,org->BytesPerPixel(comp),org->BytesPerRow(comp),
+			    (const WORD *)dstdata,dst->BytesPerPixel(comp),dst->BytesPerRow(comp),
+			    target,stride,w,h);
+    } else if (!org->isFloat(comp) && org->BitsOf(comp) <= 32) {
+      CopyToFFT<const LONG>((const LONG *)orgdata,org->BytesPerPixel(comp),org->BytesPerRow(comp),
+			    (const LONG *)dstdata,dst->BytesPerPixel(comp),dst->BytesPerRow(comp),
+			    target,stride,w,h);
+    } else if (org->BitsOf(comp) <= 32 && org->isFloat(comp)) {
+      CopyToFFT<const FLOAT>((const FLOAT *)orgdata,org->BytesPerPixel(comp),org->BytesPerRow(comp),
+			     (const FLOAT *)dstdata,dst->BytesPerPixel(comp),dst->BytesPerRow(comp),
+			     target,stride,w,h);
+    } else if (org->BitsOf(comp) == 64 && org->isFloat(comp)) {
+      CopyToFFT<const DOUBLE>((const DOUBLE *)orgdata,org->BytesPerPixel(comp),org->BytesPerRow(comp),
+			      (const DOUBLE *)dstdata,dst->BytesPerPixel(comp),dst->BytesPerRow(comp),
+			      target,stride,w,h);
+    } else {
+      throw "unsupported data type";
+    }
+  } else {
+    if (org->BitsOf(comp) <= 8) {
+      CopyToFFT<const UBYTE>((const UBYTE *)orgdata,org->BytesPerPixel(comp),org->BytesPerRow(comp),
+			     (const UBYTE *)dstdata,dst->BytesPerPixel(comp),dst->BytesPerRow(comp),
+			     target,stride,w,h);
+    } else if (!org->isFloat(comp) && org->BitsOf(comp) <= 16) {
+      CopyToFFT<const UWORD>((const UWORD *)orgdata,org->BytesPerPixel(comp),org->BytesPerRow(comp),
+			     (const UWORD *)dstdata,dst->BytesPerPixel(comp),dst->BytesPerRow(comp),
+			     target,stride,w,h);
+    } else if (!org->isFloat(comp) && org->BitsOf(comp) <= 32) {
+      CopyToFFT<const ULONG>((const ULONG *)orgdata,org->BytesPerPixel(comp),org->BytesPerRow(comp),
+			     (const ULONG *)dstdata,dst->BytesPerPixel(comp),dst->BytesPerRow(comp),
+			     target,stride,w,h);
+    } else if (org->BitsOf(comp) <= 32 && org->isFloat(comp)) {
+      CopyToFFT<const FLOAT>((const FLOAT *)orgdata,org->BytesPerPixel(comp),org->BytesPerRow(comp),
+			     (const FLOAT *)dstdata,dst->BytesPerPixel(comp),dst->BytesPerRow(comp),
+			     target,stride,w,h);
+    } else if (org->BitsOf(comp) == 64 && org->isFloat(comp)) {
+      CopyToFFT<const DOUBLE>((const DOUBLE *)orgdata,org->BytesPerPixel(comp),org->BytesPerRow(comp),
+			      (const DOUBLE *)dstdata,dst->BytesPerPixel(comp),dst->BytesPerRow(comp),
+			      target,stride,w,h);
+    } else {
+      throw "unsupported data type";
+    }
+  }
+}
+///
+
+/// Spectra::Invalidate
+// Drop all spectra, to be called whenever the images are modified.
+void Spectra::Invalidate(void)
+{
+  struct Spectrum *s;
+
+  while((s = m_pSpectra)) {
+    m_pSpectra = s->m_pNext;
+    delete s->m_pFFT;
+    delete[] s->m_pdPower;
+    delete s;
+  }
+  m_pOrg = NULL;
+  m_pDst = NULL;
+}
+///
+
+/// Spectra::FindSpectrum
+// Return the spectrum of the given component, window and tile
+// size if it is already there, NULL otherwise.
+struct Spectra::Spectrum *Spectra::FindSpectrum(class ImageLayout *org,class ImageLayout *dst,
+						UWORD comp,bool window,ULONG tile)
+{
+  struct Spectrum *s;
+  //
+  // Spectra of other images are of no use.
+  if (org != m_pOrg || dst != m_pDst) {
+    Invalidate();
+    m_pOrg = org;
+    m_pDst = dst;
+  }
+  //
+  for(s = m_pSpectra;s;s = s->m_pNext) {
+    if (s->m_usComp == comp && s->m_bWindow == window && s->m_ulTile == tile)
+      return s;
+  }
+  //
+  return NULL;
+}
+///
+
+/// Spectra::SpectrumOf
+// Return the spectrum of the difference org - dst of the given
+// component, windowed or not. The result remains owned by this
+// class and is valid until the next invalidation.
+class FFT *Spectra::SpectrumOf(class ImageLayout *org,class ImageLayout *dst,UWORD comp,bool window)
+{
+  struct Spectrum *s = FindSpectrum(org,dst,comp,window,0);
+  class FFT *fft;
+  ULONG w,h;
+  //
+  if (s)
+    return s->m_pFFT;
+  //
+  w   = org->WidthOf(comp);
+  h   = org->HeightOf(comp);
+  fft = new class FFT(w,h,window,m_pPool);
+  //
+  try {
+    DifferenceOf(org,dst,comp,0,0,w,h,fft->DataOf(),fft->ModuloOf());
+    //
+    // Run the transformation.
+    fft->ForwardsFFT();
+  } catch(...) {
+    delete fft;
+    throw;
+  }
+  //
+  s            = new struct Spectrum;
+  s->m_pNext   = m_pSpectra;
+  s->m_pFFT    = fft;
+  s->m_pdPower = NULL;
+  s->m_usComp  = comp;
+  s->m_bWindow = window;
+  s->m_ulTile  = 0;
+  s->m_ulWidth = w;
+  s->m_ulHeight= h;
+  m_pSpectra   = s;
+  //
+  return fft;
+}
+///
+
+/// Spectra::TilesOf
+// Return the number of tiles of the given size that cover the
+// given extent with an overlap of half a tile.
+ULONG Spectra::TilesOf(ULONG size,ULONG extent)
+{
+  ULONG step = size >> 1;
+
+  if (extent <= size)
+    return 1;
+
+  return (extent - size + step - 1) / step + 1;
+}
+///
+
+/// Spectra::TileOffsetOf
+// Return the position of the given tile. The last tile is aligned to
+// the end of the extent.
+ULONG Spectra::TileOffsetOf(ULONG tile,ULONG size,ULONG extent)
+{
+  ULONG pos = tile * (size >> 1);
+
+  if (pos + size > extent)
+    pos = extent - size;
+
+  return pos;
+}
+///
+
+/// Spectra::Run
+// Sum the power spectra of a row of tiles.
+void Spectra::Run(ULONG item)
+{
+  ULONG tw       = m_ulTileWidth;
+  ULONG th       = m_ulTileHeight;
+  ULONG qw       = tw >> 1;
+  ULONG qh       = th >> 1;
+  ULONG y0       = TileOffsetOf(item,th,m_pOrg->HeightOf(m_usComp));
+  double *sum    = m_pdPartial + item * qw * qh;
+  class FFT fft(tw,th,true);
+  ULONG i,x,y;
+
+  memset(sum,0,sizeof(double) * qw * qh);
+
+  for(i = 0;i < m_ulTilesX;i++) {
+    ULONG x0 = TileOffsetOf(i,tw,m_pOrg->WidthOf(m_usComp));
+    //
+    DifferenceOf(m_pOrg,m_pDst,m_usComp,x0,y0,tw,th,fft.DataOf(),fft.ModuloOf());
+    fft.ForwardsFFT();
+    //
+    for(y = 0;y < qh;y++) {
+      const double *row = fft.DataOf() + y * fft.ModuloOf();
+      double *out       = sum + y * qw;
+      for(x = 0;x < qw;x++) {
+	out[x] += row[(x << 1) + 0] * row[(x << 1) + 0] + row[(x << 1) + 1] * row[(x << 1) + 1];
+      }
+    }
+  }
+}
+///
+
+/// Spectra::TiledPowerOf
+// Return the power spectrum of the difference org - dst of the
+// given component averaged over windowed tiles of the given size
+// that overlap by half a tile.
+const double *Spectra::TiledPowerOf(class ImageLayout *org,class ImageLayout *dst,UWORD comp,ULONG tile,
+				    ULONG &tw,ULONG &th)
+{
+  struct Spectrum *s = FindSpectrum(org,dst,comp,true,tile);
+  ULONG w  = org->WidthOf(comp);
+  ULONG h  = org->HeightOf(comp);
+  ULONG qw,qh,x,y,i;
+  double *power;
+  double norm;
+  //
+  if (s) {
+    tw = s->m_ulWidth;
+    th = s->m_ulHeight;
+    return s->m_pdPower;
+  }
+  //
+  tw = (w > tile)?(tile):(w);
+  th = (h > tile)?(tile):(h);
+  qw = tw >> 1;
+  qh = th >> 1;
+  //
+  m_usComp       = comp;
+  m_ulTileWidth  = tw;
+  m_ulTileHeight = th;
+  m_ulTilesX     = TilesOf(tw,w);
+  m_ulTilesY     = TilesOf(th,h);
+  //
+  delete[] m_pdPartial;
+  m_pdPartial = NULL;
+  m_pdPartial = new double[m_ulTilesY * qw * qh];
+  //
+  if (m_pPool && m_pPool->ThreadsOf() > 1 && m_ulTilesY > 1) {
+    m_pPool->Dispatch(this,m_ulTilesY);
+  } else {
+    for(i = 0;i < m_ulTilesY;i++)
+      Run(i);
+  }
+  //
+  // Combine the rows in order such that the result does not depend
+  // on the number of threads, and average over the tiles.
+  power = new double[qw * qh];
+  norm  = 1.0 / (double(m_ulTilesX) * m_ulTilesY);
+  for(y = 0;y < qh;y++) {
+    for(x = 0;x < qw;x++) {
+      double f = 0.0;
+      for(i = 0;i < m_ulTilesY;i++) {
+	f += m_pdPartial[(i * qh + y) * qw + x];
+      }
+      power[y * qw + x] = f * norm;
+    }
+  }
+  //
+  delete[] m_pdPartial;
+  m_pdPartial = NULL;
+  //
+  s            = new struct Spectrum;
+  s->m_pNext   = m_pSpectra;
+  s->m_pFFT    = NULL;
+  s->m_pdPower = power;
+  s->m_usComp  = comp;
+  s->m_bWindow = true;
+  s->m_ulTile  = tile;
+  s->m_ulWidth = tw;
+  s->m_ulHeight= th;
+  m_pSpectra   = s;
+  //
+  return power;
+}
+///
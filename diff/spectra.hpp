@@ -0,0 +1,163 @@
+/*************************************************************************
+** Written by Thomas Richter (THOR Software) for Accusoft	        **
+** All Rights Reserved							**
+**************************************************************************
+
+This source file is part of difftest_ng, a universal image measuring
+and conversion framework.
+
+    difftest_ng is free software: you can redistribute it and/or modify
+    it under the terms of the GNU General Public License as published by
+    the Free Software Foundation, either version 3 of the License, or
+    (at your option) any later version.
+
+    difftest_ng is distributed in the hope that it will be useful,
+    but WITHOUT ANY WARRANTY; without even the implied warranty of
+    MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+    GNU General Public License for more details.
+
+    You should have received a copy of the GNU General Public License
+    along with difftest_ng.  If not, see <http://www.gnu.org/licenses/>.
+
+*************************************************************************/
+/*
+**
+** $Id$
+**
+** This class keeps the spectra of the difference of two images such
+** that several FFT based meters in a row (MaxFreq, FFTImg) transform
+** the difference only once. The spectra are dropped as soon as the
+** images are modified or replaced.
+** Instead of the spectrum of the complete image, the power spectrum
+** averaged over overlapping windowed tiles can be requested. This
+** needs memory for a few tiles only, and its cost is linear in the
+** image size.
+*/
+
+#ifndef DIFF_SPECTRA_HPP
+#define DIFF_SPECTRA_HPP
+
+/// Includes
+#include "interface/types.hpp"
+#include "tools/threadpool.hpp"
+///
+
+/// Forwards
+class ImageLayout;
+class FFT;
+class ThreadPool;
+///
+
+/// class Spectra
+// This class keeps the spectra of the difference of two images, one per
+// component and window setting or tile size, computed on first request.
+class Spectra : private ThreadPool::Job {
+  //
+  // A spectrum of a single component.
+  struct Spectrum {
+    //
+    // Next spectrum in the list.
+    struct Spectrum *m_pNext;
+    //
+    // The transformation including its data, NULL for tiles.
+    class FFT       *m_pFFT;
+    //
+    // The averaged power spectrum of the tiles, NULL for the complete
+    // image.
+    double          *m_pdPower;
+    //
+    // The component the spectrum belongs to.
+    UWORD            m_usComp;
+    //
+    // Whether the difference was windowed before the transformation.
+    bool             m_bWindow;
+    //
+    // The requested tile size, zero for the complete image, and the
+    // dimensions of the tiles of this component.
+    ULONG            m_ulTile;
+    ULONG            m_ulWidth;
+    ULONG            m_ulHeight;
+  };
+  //
+  // The spectra computed so far.
+  struct Spectrum   *m_pSpectra;
+  //
+  // The images the spectra belong to.
+  const class ImageLayout *m_pOrg;
+  const class ImageLayout *m_pDst;
+  //
+  // The threads the transformations may use, or NULL.
+  class ThreadPool  *m_pPool;
+  //
+  // The tiles currently worked on: component, dimensions and number of
+  // tiles horizontally and vertically.
+  UWORD              m_usComp;
+  ULONG              m_ulTileWidth;
+  ULONG              m_ulTileHeight;
+  ULONG              m_ulTilesX;
+  ULONG              m_ulTilesY;
+  //
+  // The power spectra summed over each row of tiles, each covering
+  // the non-negative frequencies of a tile.
+  double            *m_pdPartial;
+  //
+  // Return the number of tiles of the given size that cover the
+  // given extent with an overlap of half a tile.
+  static ULONG TilesOf(ULONG size,ULONG extent);
+  //
+  // Return the position of the given tile.
+  static ULONG TileOffsetOf(ULONG tile,ULONG size,ULONG extent);
+  //
+  // Sum the power spectra of a row of tiles.
+  virtual void Run(ULONG item);
+  //
+  // Return the spectrum of the given component, window and tile
+  // size if it is already there, NULL otherwise.
+  struct Spectrum *FindSpectrum(class ImageLayout *org,class ImageLayout *dst,
+				UWORD comp,bool window,ULONG tile);
+  //
+  // Fill the difference of the two components into the transformation.
+  template<typename T>
+  static void CopyToFFT(T *org       ,ULONG obytesperpixel,ULONG obytesperrow,
+			T *dst       ,ULONG dbytesperpixel,ULONG dbytesperrow,
+			double *trg  ,ULONG stride,ULONG w,ULONG h);
+  //
+public:
+  Spectra(class ThreadPool *pool = NULL)
+    : m_pSpectra(NULL), m_pOrg(NULL), m_pDst(NULL), m_pPool(pool), m_usComp(0),
+      m_ulTileWidth(0), m_ulTileHeight(0), m_ulTilesX(0), m_ulTilesY(0), m_pdPartial(NULL)
+  {
+  }
+  //
+  ~Spectra(void)
+  {
+    Invalidate();
+    delete[] m_pdPartial;
+  }
+  //
+  // Drop all spectra, to be called whenever the images are modified.
+  void Invalidate(void);
+  //
+  // Fill the difference org - dst of the w x h rectangle at x,y of the
+  // given component into the target with the given stride in doubles.
+  static void DifferenceOf(const class ImageLayout *org,const class ImageLayout *dst,UWORD comp,
+			   ULONG x,ULONG y,ULONG w,ULONG h,double *target,ULONG stride);
+  //
+  // Return the spectrum of the difference org - dst of the given
+  // component, windowed or not. The result remains owned by this
+  // class and is valid until the next invalidation.
+  class FFT *SpectrumOf(class ImageLayout *org,class ImageLayout *dst,UWORD comp,bool window);
+  //
+  // Return the power spectrum of the difference org - dst of the
+  // given component averaged over windowed tiles of the given size
+  // that overlap by half a tile. Tiles are clipped to the component.
+  // The result covers the non-negative frequencies of a tile, i.e.
+  // (w >> 1) x (h >> 1) values for tiles of w x h samples, whose
+  // dimensions are also returned. It remains owned by this class.
+  const double *TiledPowerOf(class ImageLayout *org,class ImageLayout *dst,UWORD comp,ULONG tile,
+			     ULONG &w,ULONG &h);
+};
+///
+
+///
+#endif
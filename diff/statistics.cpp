@@ -0,0 +1,595 @@
+/*************************************************************************
+** Written by Thomas Richter (THOR Software) for Accusoft	        **
+** All Rights Reserved							**
+**************************************************************************
+
+This source file is part of difftest_ng, a universal image measuring
+and conversion framework.
+
+    difftest_ng is free software: you can redistribute it and/or modify
+    it under the terms of the GNU General Public License as published by
+    the Free Software Foundation, either version 3 of the License, or
+    (at your option) any later version.
+
+    difftest_ng is distributed in the hope that it will be useful,
+    but WITHOUT ANY WARRANTY; without even the implied warranty of
+    MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+    GNU General Public License for more details.
+
+    You should have received a copy of the GNU General Public License
+    along with difftest_ng.  If not, see <http://www.gnu.org/licenses/>.
+
+*************************************************************************/
+
+/*
+**
+** $Id$
+**
+** This class collects all the sample statistics the metric meters
+** (PSNR, MRSE, PRE, Thres, PeakPos, Stripe) derive their results from.
+** All of them are collected in a single pass over the two images, so
+** several metrics in a row only have to read the images once.
+*/
+
+/// Includes
+#include "diff/statistics.hpp"
+#include "img/imglayout.hpp"
+#include "tools/simddiff.hpp"
+#include "std/math.hpp"
+#include "std/string.hpp"
+///
+
+/// Statistics::Statistics
+Statistics::Statistics(class ThreadPool *pool)
+  : m_pPool(pool), m_pComponent(NULL), m_usDepth(0), m_ulMask(0),
+    m_pBand(NULL), m_ulBands(0), m_pdColumn(NULL), m_ulColumns(0),
+    m_pulBandRows(NULL), m_pulWidth(NULL), m_pdTotal(NULL), m_ulTotal(0), m_pKernel(NULL)
+{
+}
+///
+
+/// Statistics::~Statistics
+Statistics::~Statistics(void)
+{
+  delete[] m_pComponent;
+  delete[] m_pBand;
+  delete[] m_pdColumn;
+  delete[] m_pulBandRows;
+  delete[] m_pulWidth;
+  delete[] m_pdTotal;
+}
+///
+
+/// Statistics::Reset
+// Reset the accumulators of a component.
+void Statistics::Reset(struct Component &c)
+{
+  c.m_dSquareError   = 0.0;
+  c.m_dEnergy        = 0.0;
+  c.m_dPeakSquare    = 0.0;
+  c.m_dRelativeError = 0.0;
+  c.m_dMinDiff       = HUGE_VAL;
+  c.m_dMaxDiff       = -HUGE_VAL;
+  c.m_dDrift         = 0.0;
+  c.m_dAbsoluteError = 0.0;
+  c.m_dPeakError     = 0.0;
+  c.m_ulPeakX        = 0;
+  c.m_ulPeakY        = 0;
+  c.m_dToe           = HUGE_VAL;
+  c.m_dHead          = -HUGE_VAL;
+  c.m_dRowError      = 0.0;
+  c.m_dColumnError   = 0.0;
+}
+///
+
+/// Statistics::CollectBand
+// Collect the statistics of a single band of rows of the current
+// component. Note that the differences are computed in the data type
+// of the samples, as all the metrics did when they still walked the
+// images themselves.
+template<typename T>
+void Statistics::CollectBand(ULONG band)
+{
+  struct Component &c = m_pBand[band];
+  const ULONG mask    = m_ulCollect;
+  const bool square   = (mask & SquareError)    != 0;
+  const bool energy   = (mask & SourceEnergy)   != 0;
+  const bool relative = (mask & RelativeError)  != 0;
+  const bool range    = (mask & DiffRange)      != 0;
+  const bool drift    = (mask & Drift)          != 0;
+  const bool absolute = (mask & AbsoluteError)  != 0;
+  const bool peak     = (mask & PeakError)      != 0;
+  const bool source   = (mask & SourceRange)    != 0;
+  const bool rowcol   = (mask & RowColumnError) != 0;
+  ULONG obytesperpixel = m_ulOrgBytesPerPixel;
+  ULONG dbytesperpixel = m_ulDstBytesPerPixel;
+  ULONG w              = m_ulWidth;
+  ULONG y0             = band * m_ulBandRows;
+  ULONG y1             = y0 + m_ulBandRows;
+  double *column       = (rowcol)?(m_pdColumn + band * w):(NULL);
+  T *org               = (T *)(m_pucOrg + y0 * m_ulOrgBytesPerRow);
+  T *dst               = (T *)(m_pucDst + y0 * m_ulDstBytesPerRow);
+  ULONG x,y;
+
+  if (y1 > m_ulHeight)
+    y1 = m_ulHeight;
+
+  Reset(c);
+  if (rowcol) {
+    memset(column,0,w * sizeof(double));
+  }
+
+  for(y = y0;y < y1;y++) {
+    double rowerr = 0.0;
+    T *orgrow     = org;
+    T *dstrow     = dst;
+    for(x = 0;x < w;x++) {
+      double diff = *orgrow - *dstrow;
+      if (square) {
+	c.m_dSquareError += diff * diff;
+      }
+      if (energy) {
+	double orq        = *orgrow * *orgrow;
+	c.m_dEnergy      += orq;
+	if (orq > c.m_dPeakSquare)
+	  c.m_dPeakSquare = orq;
+      }
+      if (relative) {
+	double vorg = *orgrow;
+	double vdst = *dstrow;
+	double rdif = vorg - vdst;
+	double norm = vorg * vorg + vdst * vdst;
+	if (norm > 0.0)
+	  c.m_dRelativeError += (rdif * rdif) / norm;
+      }
+      if (range) {
+	if (diff < c.m_dMinDiff)
+	  c.m_dMinDiff = diff;
+	if (diff > c.m_dMaxDiff)
+	  c.m_dMaxDiff = diff;
+      }
+      if (drift) {
+	c.m_dDrift += diff;
+      }
+      if (absolute) {
+	c.m_dAbsoluteError += fabs(diff);
+      }
+      if (peak) {
+	double adiff = fabs(diff);
+	if (adiff > c.m_dPeakError) {
+	  c.m_dPeakError = adiff;
+	  c.m_ulPeakX    = x;
+	  c.m_ulPeakY    = y;
+	}
+      }
+      if (source) {
+	if (*orgrow < c.m_dToe)
+	  c.m_dToe  = *orgrow;
+	if (*orgrow > c.m_dHead)
+	  c.m_dHead = *orgrow;
+      }
+      if (rowcol) {
+	rowerr    += diff * diff;
+	column[x] += diff * diff;
+      }
+      //
+      orgrow      = (T *)((const UBYTE *)(orgrow) + obytesperpixel);
+      dstrow      = (T *)((const UBYTE *)(dstrow) + dbytesperpixel);
+    }
+    if (rowcol && rowerr > c.m_dRowError)
+      c.m_dRowError = rowerr;
+    org = (T *)((const UBYTE *)(org) + m_ulOrgBytesPerRow);
+    dst = (T *)((const UBYTE *)(dst) + m_ulDstBytesPerRow);
+  }
+}
+///
+
+/// Statistics::DifferenceBand
+// Collect the squared and absolute differences of a single band of rows
+// of contiguous 8 or 16 bit samples. The sums are exact integers, and
+// the same the generic kernel computes.
+template<typename T>
+void Statistics::DifferenceBand(ULONG band)
+{
+  struct Component &c = m_pBand[band];
+  ULONG y0            = band * m_ulBandRows;
+  ULONG y1            = y0 + m_ulBandRows;
+  const UBYTE *org    = m_pucOrg + y0 * m_ulOrgBytesPerRow;
+  const UBYTE *dst    = m_pucDst + y0 * m_ulDstBytesPerRow;
+  UQUAD square        = 0;
+  UQUAD absolute      = 0;
+  ULONG y;
+
+  if (y1 > m_ulHeight)
+    y1 = m_ulHeight;
+
+  Reset(c);
+
+  for(y = y0;y < y1;y++) {
+    SIMDDiff::Accumulate((T *)org,(T *)dst,m_ulWidth,square,absolute);
+    org += m_ulOrgBytesPerRow;
+    dst += m_ulDstBytesPerRow;
+  }
+
+  c.m_dSquareError   = double(square);
+  c.m_dAbsoluteError = double(absolute);
+}
+///
+
+/// Statistics::RowColumnBand
+// Collect the squared and absolute differences and the per-row and
+// per-column squared errors of a single band of rows of 8 or 16 bit
+// integer samples. All of them are exact integers, hence the same the
+// generic kernel computes, but the sweep runs without any per-sample
+// decisions and the column sums are updated along the rows.
+template<typename T>
+void Statistics::RowColumnBand(ULONG band)
+{
+  struct Component &c  = m_pBand[band];
+  ULONG obytesperpixel = m_ulOrgBytesPerPixel;
+  ULONG dbytesperpixel = m_ulDstBytesPerPixel;
+  ULONG w              = m_ulWidth;
+  ULONG y0             = band * m_ulBandRows;
+  ULONG y1             = y0 + m_ulBandRows;
+  double *column       = m_pdColumn + band * w;
+  const UBYTE *org     = m_pucOrg + y0 * m_ulOrgBytesPerRow;
+  const UBYTE *dst     = m_pucDst + y0 * m_ulDstBytesPerRow;
+  UQUAD square         = 0;
+  UQUAD absolute       = 0;
+  UQUAD rowmax         = 0;
+  ULONG x,y;
+
+  if (y1 > m_ulHeight)
+    y1 = m_ulHeight;
+
+  Reset(c);
+  memset(column,0,w * sizeof(double));
+
+  for(y = y0;y < y1;y++) {
+    UQUAD rowerr = 0;
+    UQUAD rowabs = 0;
+    if (obytesperpixel == sizeof(T) && dbytesperpixel == sizeof(T)) {
+      const T *orgrow = (const T *)org;
+      const T *dstrow = (const T *)dst;
+      for(x = 0;x < w;x++) {
+	LONG  diff = LONG(orgrow[x]) - LONG(dstrow[x]);
+	ULONG ad   = ULONG((diff < 0)?(-diff):(diff));
+	ULONG sq   = ad * ad;
+	rowerr    += sq;
+	rowabs    += ad;
+	column[x] += sq;
+      }
+    } else {
+      const UBYTE *orgrow = org;
+      const UBYTE *dstrow = dst;
+      for(x = 0;x < w;x++) {
+	LONG  diff = LONG(*(const T *)orgrow) - LONG(*(const T *)dstrow);
+	ULONG ad   = ULONG((diff < 0)?(-diff):(diff));
+	ULONG sq   = ad * ad;
+	rowerr    += sq;
+	rowabs    += ad;
+	column[x] += sq;
+	orgrow    += obytesperpixel;
+	dstrow    += dbytesperpixel;
+      }
+    }
+    square   += rowerr;
+    absolute += rowabs;
+    if (rowerr > rowmax)
+      rowmax = rowerr;
+    org += m_ulOrgBytesPerRow;
+    dst += m_ulDstBytesPerRow;
+  }
+
+  c.m_dSquareError   = double(square);
+  c.m_dAbsoluteError = double(absolute);
+  c.m_dRowError      = double(rowmax);
+}
+///
+
+/// Statistics::Merge
+// Add the band statistics of the current component to the component
+// statistics. This always runs in band order, hence the result is
+// independent of the order in which the bands were collected.
+void Statistics::Merge(ULONG bands,struct Component &c,ULONG y,double *total)
+{
+  ULONG b,x;
+
+  for(b = 0;b < bands;b++) {
+    const struct Component &p = m_pBand[b];
+    c.m_dSquareError   += p.m_dSquareError;
+    c.m_dEnergy        += p.m_dEnergy;
+    c.m_dRelativeError += p.m_dRelativeError;
+    c.m_dDrift         += p.m_dDrift;
+    c.m_dAbsoluteError += p.m_dAbsoluteError;
+    if (p.m_dPeakSquare > c.m_dPeakSquare)
+      c.m_dPeakSquare = p.m_dPeakSquare;
+    if (p.m_dMinDiff < c.m_dMinDiff)
+      c.m_dMinDiff = p.m_dMinDiff;
+    if (p.m_dMaxDiff > c.m_dMaxDiff)
+      c.m_dMaxDiff = p.m_dMaxDiff;
+    // Strictly larger keeps the first position in scan order.
+    if (p.m_dPeakError > c.m_dPeakError) {
+      c.m_dPeakError = p.m_dPeakError;
+      c.m_ulPeakX    = p.m_ulPeakX;
+      c.m_ulPeakY    = p.m_ulPeakY + y;
+    }
+    if (p.m_dToe < c.m_dToe)
+      c.m_dToe = p.m_dToe;
+    if (p.m_dHead > c.m_dHead)
+      c.m_dHead = p.m_dHead;
+    if (p.m_dRowError > c.m_dRowError)
+      c.m_dRowError = p.m_dRowError;
+  }
+
+  if (m_ulCollect & RowColumnError) {
+    // Accumulate the columns of all bands.
+    for(b = 0;b < bands;b++) {
+      const double *partial = m_pdColumn + b * m_ulWidth;
+      for(x = 0;x < m_ulWidth;x++) {
+	total[x] += partial[x];
+      }
+    }
+  }
+}
+///
+
+/// Statistics::SelectKernel
+// Select the kernel for the given component of the image.
+void Statistics::SelectKernel(class ImageLayout *src,UWORD comp,ULONG mask)
+{
+  //
+  // Squared and absolute differences of contiguous small integer
+  // samples are collected with vector instructions.
+  bool simd = (mask & ~(SquareError | AbsoluteError)) == 0 && !src->isFloat(comp) &&
+    src->BitsOf(comp) <= 16 && m_ulOrgBytesPerPixel == m_ulDstBytesPerPixel &&
+    m_ulOrgBytesPerPixel == ((src->BitsOf(comp) <= 8)?(sizeof(UBYTE)):(sizeof(UWORD)));
+  //
+  // The same plus the row and column errors of the stripe detector
+  // are collected in a dedicated row-major sweep.
+  bool rowcol = (mask & RowColumnError) != 0 && !src->isFloat(comp) && src->BitsOf(comp) <= 16 &&
+    (mask & ~(SquareError | AbsoluteError | RowColumnError)) == 0;
+  //
+  if (rowcol) {
+    if (src->isSigned(comp)) {
+      if (src->BitsOf(comp) <= 8) {
+	m_pKernel = &Statistics::RowColumnBand<BYTE>;
+      } else {
+	m_pKernel = &Statistics::RowColumnBand<WORD>;
+      }
+    } else {
+      if (src->BitsOf(comp) <= 8) {
+	m_pKernel = &Statistics::RowColumnBand<UBYTE>;
+      } else {
+	m_pKernel = &Statistics::RowColumnBand<UWORD>;
+      }
+    }
+  } else if (simd) {
+    if (src->isSigned(comp)) {
+      if (src->BitsOf(comp) <= 8) {
+	m_pKernel = &Statistics::DifferenceBand<const BYTE>;
+      } else {
+	m_pKernel = &Statistics::DifferenceBand<const WORD>;
+      }
+    } else {
+      if (src->BitsOf(comp) <= 8) {
+	m_pKernel = &Statistics::DifferenceBand<const UBYTE>;
+      } else {
+	m_pKernel = &Statistics::DifferenceBand<const UWORD>;
+      }
+    }
+  } else if (src->isSigned(comp)) {
+    if (src->BitsOf(comp) <= 8) {
+      m_pKernel = &Statistics::CollectBand<const BYTE>;
+    } else if (!src->isFloat(comp) && src->BitsOf(comp) <= 16) {
+      m_pKernel = &Statistics::CollectBand<const WORD>;
+    } else if (!src->isFloat(comp) && src->BitsOf(comp) <= 32) {
+      m_pKernel = &Statistics::CollectBand<const LONG>;
+    } else if (src->BitsOf(comp) <= 32 && src->isFloat(comp)) {
+      m_pKernel = &Statistics::CollectBand<const FLOAT>;
+    } else if (src->BitsOf(comp) == 64 && src->isFloat(comp)) {
+      m_pKernel = &Statistics::CollectBand<const DOUBLE>;
+    } else {
+      throw "unsupported data type";
+    }
+  } else {
+    if (src->BitsOf(comp) <= 8) {
+      m_pKernel = &Statistics::CollectBand<const UBYTE>;
+    } else if (!src->isFloat(comp) && src->BitsOf(comp) <= 16) {
+      m_pKernel = &Statistics::CollectBand<const UWORD>;
+    } else if (!src->isFloat(comp) && src->BitsOf(comp) <= 32) {
+      m_pKernel = &Statistics::CollectBand<const ULONG>;
+    } else if (src->BitsOf(comp) <= 32 && src->isFloat(comp)) {
+      m_pKernel = &Statistics::CollectBand<const FLOAT>;
+    } else if (src->BitsOf(comp) == 64 && src->isFloat(comp)) {
+      m_pKernel = &Statistics::CollectBand<const DOUBLE>;
+    } else {
+      throw "unsupported data type";
+    }
+  }
+}
+///
+
+/// Statistics::BandRowsOf
+// Return the number of rows of a band of a component of the given
+// height. The band height only depends on the component height, never
+// on the number of threads, to make the result reproducible.
+ULONG Statistics::BandRowsOf(ULONG height)
+{
+  ULONG rows = (height + MaxBands - 1) / MaxBands;
+
+  if (rows < MinBandRows)
+    rows = MinBandRows;
+
+  return rows;
+}
+///
+
+/// Statistics::RowsOf
+// Return the number of rows of the full resolution image a piece
+// must be a multiple of for collecting src piecewise, namely the
+// least common multiple of the band heights of all components.
+ULONG Statistics::RowsOf(class ImageLayout *src)
+{
+  UWORD comp,d = src->DepthOf();
+  ULONG rows   = 1;
+
+  for(comp = 0;comp < d;comp++) {
+    ULONG r = BandRowsOf(src->HeightOf(comp)) * src->SubYOf(comp);
+    ULONG a = rows,b = r;
+    while(b) {
+      ULONG t = a % b;
+      a = b;
+      b = t;
+    }
+    rows = rows / a * r;
+  }
+
+  return rows;
+}
+///
+
+/// Statistics::Start
+// Reset the accumulators for collecting an image of the dimensions of
+// src piece by piece.
+void Statistics::Start(class ImageLayout *src,ULONG mask)
+{
+  UWORD comp,d = src->DepthOf();
+  ULONG total  = 0;
+
+  if (d != m_usDepth || m_pComponent == NULL) {
+    delete[] m_pComponent;
+    m_pComponent  = NULL;
+    delete[] m_pulBandRows;
+    m_pulBandRows = NULL;
+    delete[] m_pulWidth;
+    m_pulWidth    = NULL;
+    m_usDepth     = 0;
+    m_pComponent  = new struct Component[d];
+    m_pulBandRows = new ULONG[d];
+    m_pulWidth    = new ULONG[d];
+    m_usDepth     = d;
+  }
+  m_ulMask    = 0;
+  m_ulCollect = mask;
+
+  for(comp = 0;comp < d;comp++) {
+    Reset(m_pComponent[comp]);
+    m_pulBandRows[comp] = BandRowsOf(src->HeightOf(comp));
+    m_pulWidth[comp]    = src->WidthOf(comp);
+    total              += src->WidthOf(comp);
+  }
+
+  if (mask & RowColumnError) {
+    if (total > m_ulTotal || m_pdTotal == NULL) {
+      delete[] m_pdTotal;
+      m_pdTotal = NULL;
+      m_ulTotal = 0;
+      m_pdTotal = new double[total];
+      m_ulTotal = total;
+    }
+    memset(m_pdTotal,0,total * sizeof(double));
+  }
+}
+///
+
+/// Statistics::Accumulate
+// Add the statistics of a piece of the images starting at row y of the
+// full resolution image. Pieces must be added top to bottom.
+void Statistics::Accumulate(class ImageLayout *src,class ImageLayout *dst,ULONG y)
+{
+  UWORD comp,d = src->DepthOf();
+  double *total = m_pdTotal;
+  ULONG mask    = m_ulCollect;
+
+  if (d != m_usDepth)
+    throw "the number of components changed while collecting statistics";
+
+  for(comp = 0;comp < d;comp++) {
+    struct Component &c = m_pComponent[comp];
+    ULONG  w   = src->WidthOf(comp);
+    ULONG  h   = src->HeightOf(comp);
+    ULONG  bands;
+    //
+    if (w != m_pulWidth[comp])
+      throw "the component dimensions changed while collecting statistics";
+    //
+    m_ulBandRows = m_pulBandRows[comp];
+    bands        = (h + m_ulBandRows - 1) / m_ulBandRows;
+    //
+    if (bands == 0) {
+      total += w;
+      continue;
+    }
+    //
+    if (bands > m_ulBands || m_pBand == NULL) {
+      delete[] m_pBand;
+      m_pBand   = NULL;
+      m_ulBands = 0;
+      m_pBand   = new struct Component[bands];
+      m_ulBands = bands;
+    }
+    if ((mask & RowColumnError) && (bands * w > m_ulColumns || m_pdColumn == NULL)) {
+      delete[] m_pdColumn;
+      m_pdColumn  = NULL;
+      m_ulColumns = 0;
+      m_pdColumn  = new double[bands * w];
+      m_ulColumns = bands * w;
+    }
+    //
+    m_pucOrg             = (const UBYTE *)src->DataOf(comp);
+    m_pucDst             = (const UBYTE *)dst->DataOf(comp);
+    m_ulOrgBytesPerPixel = src->BytesPerPixel(comp);
+    m_ulOrgBytesPerRow   = src->BytesPerRow(comp);
+    m_ulDstBytesPerPixel = dst->BytesPerPixel(comp);
+    m_ulDstBytesPerRow   = dst->BytesPerRow(comp);
+    m_ulWidth            = w;
+    m_ulHeight           = h;
+    //
+    SelectKernel(src,comp,mask);
+    //
+    if (m_pPool) {
+      m_pPool->Dispatch(this,bands);
+    } else {
+      ULONG b;
+      for(b = 0;b < bands;b++) {
+	(this->*m_pKernel)(b);
+      }
+    }
+    Merge(bands,c,y / src->SubYOf(comp),total);
+    total += w;
+  }
+}
+///
+
+/// Statistics::Finish
+// Complete the statistics once all pieces have been added.
+void Statistics::Finish(void)
+{
+  UWORD comp;
+
+  if (m_ulCollect & RowColumnError) {
+    const double *total = m_pdTotal;
+    for(comp = 0;comp < m_usDepth;comp++) {
+      struct Component &c = m_pComponent[comp];
+      ULONG x,w = m_pulWidth[comp];
+      for(x = 0;x < w;x++) {
+	if (total[x] > c.m_dColumnError)
+	  c.m_dColumnError = total[x];
+      }
+      total += w;
+    }
+  }
+  m_ulMask = m_ulCollect;
+}
+///
+
+/// Statistics::Collect
+// Collect the accumulators in the given mask for the two images.
+void Statistics::Collect(class ImageLayout *src,class ImageLayout *dst,ULONG mask)
+{
+  Start(src,mask);
+  Accumulate(src,dst,0);
+  Finish();
+}
+///
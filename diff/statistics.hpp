@@ -0,0 +1,276 @@
+/*************************************************************************
+** Written by Thomas Richter (THOR Software) for Accusoft	        **
+** All Rights Reserved							**
+**************************************************************************
+
+This source file is part of difftest_ng, a universal image measuring
+and conversion framework.
+
+    difftest_ng is free software: you can redistribute it and/or modify
+    it under the terms of the GNU General Public License as published by
+    the Free Software Foundation, either version 3 of the License, or
+    (at your option) any later version.
+
+    difftest_ng is distributed in the hope that it will be useful,
+    but WITHOUT ANY WARRANTY; without even the implied warranty of
+    MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+    GNU General Public License for more details.
+
+    You should have received a copy of the GNU General Public License
+    along with difftest_ng.  If not, see <http://www.gnu.org/licenses/>.
+
+*************************************************************************/
+
+/*
+**
+** $Id$
+**
+** This class collects all the sample statistics the metric meters
+** (PSNR, MRSE, PRE, Thres, PeakPos, Stripe) derive their results from.
+** All of them are collected in a single pass over the two images, so
+** several metrics in a row only have to read the images once.
+*/
+
+#ifndef DIFF_STATISTICS_HPP
+#define DIFF_STATISTICS_HPP
+
+/// Includes
+#include "interface/types.hpp"
+#include "std/assert.hpp"
+#include "tools/threadpool.hpp"
+///
+
+/// Forwards
+class ImageLayout;
+///
+
+/// class Statistics
+// This class collects all the sample statistics the metric meters
+// derive their results from in a single pass over the two images.
+// Components are split into bands of rows whose partial results are
+// combined in band order, so the result does not depend on the number
+// of threads working on the bands.
+class Statistics : private ThreadPool::Job {
+  //
+public:
+  //
+  // Accumulators that can be requested. Meters combine the
+  // accumulators they need into a bitmask.
+  enum Accumulator {
+    SquareError    = 1 << 0, // sum of squared differences
+    RelativeError  = 1 << 1, // sum of squared differences relative to the sample energy
+    DiffRange      = 1 << 2, // minimum and maximum of source - destination
+    Drift          = 1 << 3, // sum of source - destination
+    AbsoluteError  = 1 << 4, // sum of absolute differences
+    PeakError      = 1 << 5, // maximum absolute difference and its position
+    SourceRange    = 1 << 6, // minimum and maximum of the source
+    RowColumnError = 1 << 7, // maximum of the per-row and per-column squared errors
+    SourceEnergy   = 1 << 8  // energy and peak square of the source
+  };
+  //
+  // The statistics of a single component.
+  struct Component {
+    //
+    // Sum of the squared differences.
+    double m_dSquareError;
+    //
+    // Sum of the squared source samples.
+    double m_dEnergy;
+    //
+    // Maximum of the squared source samples.
+    double m_dPeakSquare;
+    //
+    // Sum of the squared differences, each normalized by the sample energy.
+    double m_dRelativeError;
+    //
+    // Minimum and maximum of the difference source - destination.
+    double m_dMinDiff;
+    double m_dMaxDiff;
+    //
+    // Sum of the differences.
+    double m_dDrift;
+    //
+    // Sum of the absolute differences.
+    double m_dAbsoluteError;
+    //
+    // Maximum absolute difference, and the position where it
+    // was found first.
+    double m_dPeakError;
+    ULONG  m_ulPeakX;
+    ULONG  m_ulPeakY;
+    //
+    // Minimum and maximum of the source samples.
+    double m_dToe;
+    double m_dHead;
+    //
+    // Maximum over all rows of the squared error within the row,
+    // and the same over all columns.
+    double m_dRowError;
+    double m_dColumnError;
+  };
+  //
+private:
+  //
+  // Components are split into at most this many bands, each of which
+  // is at least MinBandRows high.
+  enum {
+    MaxBands    = 256,
+    MinBandRows = 16
+  };
+  //
+  // The pool running the bands, or NULL to run them on the
+  // calling thread.
+  class ThreadPool *m_pPool;
+  //
+  // The per-component statistics, one entry per component.
+  struct Component *m_pComponent;
+  //
+  // Number of components collected.
+  UWORD             m_usDepth;
+  //
+  // Accumulators collected for the current images.
+  ULONG             m_ulMask;
+  //
+  // The partial statistics of the bands of the current component.
+  struct Component *m_pBand;
+  //
+  // Size of the above in entries.
+  ULONG             m_ulBands;
+  //
+  // The per-column accumulators of the squared errors required
+  // for the column error, one row of them per band.
+  double           *m_pdColumn;
+  //
+  // Size of the above in entries.
+  ULONG             m_ulColumns;
+  //
+  // The number of rows in a band, for each component. This only
+  // depends on the height of the complete component, such that
+  // images collected in several pieces give the same result.
+  ULONG            *m_pulBandRows;
+  //
+  // The width of each component.
+  ULONG            *m_pulWidth;
+  //
+  // The per-column sums of the squared errors of all rows collected
+  // so far, the columns of all components in a row.
+  double           *m_pdTotal;
+  //
+  // Size of the above in entries.
+  ULONG             m_ulTotal;
+  //
+  // The component currently worked on, as seen by the bands.
+  const UBYTE      *m_pucOrg;
+  const UBYTE      *m_pucDst;
+  ULONG             m_ulOrgBytesPerPixel;
+  ULONG             m_ulOrgBytesPerRow;
+  ULONG             m_ulDstBytesPerPixel;
+  ULONG             m_ulDstBytesPerRow;
+  ULONG             m_ulWidth;
+  ULONG             m_ulHeight;
+  ULONG             m_ulBandRows;
+  //
+  // The accumulators requested for the current component.
+  ULONG             m_ulCollect;
+  //
+  // The kernel collecting a band, instantiated for the sample type
+  // of the current component.
+  void (Statistics::*m_pKernel)(ULONG band);
+  //
+  // Reset the accumulators of a component.
+  static void Reset(struct Component &c);
+  //
+  // Collect the statistics of a single band of rows.
+  template<typename T>
+  void CollectBand(ULONG band);
+  //
+  // Collect the squared and absolute differences of a single band of
+  // rows of contiguous 8 or 16 bit samples with vector instructions.
+  template<typename T>
+  void DifferenceBand(ULONG band);
+  //
+  // Collect the squared and absolute differences along with the
+  // per-row and per-column squared errors of a single band of rows
+  // of 8 or 16 bit integer samples in one row-major sweep.
+  template<typename T>
+  void RowColumnBand(ULONG band);
+  //
+  // Run a band on behalf of the thread pool.
+  virtual void Run(ULONG band)
+  {
+    (this->*m_pKernel)(band);
+  }
+  //
+  // Return the number of rows of a band of a component of the given
+  // height.
+  static ULONG BandRowsOf(ULONG height);
+  //
+  // Select the kernel for the given component of the image.
+  void SelectKernel(class ImageLayout *src,UWORD comp,ULONG mask);
+  //
+  // Add the band statistics of the current component in band order to
+  // the component statistics. The bands start at row y of the component,
+  // the column sums of the component are in total.
+  void Merge(ULONG bands,struct Component &c,ULONG y,double *total);
+  //
+public:
+  // Collect statistics, potentially using the threads of the given pool.
+  Statistics(class ThreadPool *pool = NULL);
+  //
+  ~Statistics(void);
+  //
+  // Return the pool the statistics are collected with, or NULL.
+  class ThreadPool *PoolOf(void) const
+  {
+    return m_pPool;
+  }
+  //
+  // Collect the accumulators in the given mask for the two images.
+  void Collect(class ImageLayout *src,class ImageLayout *dst,ULONG mask);
+  //
+  // Collect the images in horizontal pieces instead: Start resets the
+  // accumulators for an image of the dimensions of src, Accumulate adds
+  // the statistics of a piece of it starting at row y, and Finish
+  // completes the statistics once all rows have been added. The pieces
+  // must be added top to bottom. If their heights are multiples of
+  // RowsOf(), the result is identical to that of Collect on the
+  // complete images.
+  void Start(class ImageLayout *src,ULONG mask);
+  void Accumulate(class ImageLayout *src,class ImageLayout *dst,ULONG y);
+  void Finish(void);
+  //
+  // Return the number of rows of the full resolution image a piece
+  // must be a multiple of for collecting src piecewise.
+  static ULONG RowsOf(class ImageLayout *src);
+  //
+  // Forget about the collected statistics, e.g. because the images
+  // changed.
+  void Invalidate(void)
+  {
+    m_ulMask = 0;
+  }
+  //
+  // Check whether all accumulators in the mask have been collected.
+  bool isValid(ULONG mask) const
+  {
+    return mask && (m_ulMask & mask) == mask;
+  }
+  //
+  // Return the number of components collected.
+  UWORD DepthOf(void) const
+  {
+    return m_usDepth;
+  }
+  //
+  // Return the statistics of the given component.
+  const struct Component &ComponentOf(UWORD comp) const
+  {
+    assert(comp < m_usDepth);
+
+    return m_pComponent[comp];
+  }
+};
+///
+
+///
+#endif
@@ -31,223 +31,36 @@ and conversion framework.
 
 /// Includes
 #include "diff/stripe.hpp"
+#include "diff/statistics.hpp"
 #include "img/imglayout.hpp"
 #include "std/math.hpp"
 ///
 
-/// Stripe::MSE
-// Traditional non-directional MSE
-template<typename T>
-double Stripe::MSE(T *org,ULONG obytesperpixel,ULONG obytesperrow,
-		   T *dst,ULONG dbytesperpixel,ULONG dbytesperrow,
-		   ULONG w,ULONG h)
-{
-  double error = 0.0;
-  ULONG x,y;
-
-  for(y = 0;y < h;y++) {
-    T *orgrow = org;
-    T *dstrow = dst;
-    for(x = 0;x < w;x++) {
-      double diff = *orgrow - *dstrow;
-      error      += diff * diff;
-      //
-      orgrow      = (T *)((const UBYTE *)(orgrow) + obytesperpixel);
-      dstrow      = (T *)((const UBYTE *)(dstrow) + dbytesperpixel);
-    }
-    org = (T *)((const UBYTE *)(org) + obytesperrow);
-    dst = (T *)((const UBYTE *)(dst) + dbytesperrow);
-  }
-
-  return error;
-}
-///
-
-/// Stripe::MSE_Hor
-// l^2 in Horizontal direction, l^infinity in vertical direction
-template<typename T>
-double Stripe::MSE_Hor(T *org,ULONG obytesperpixel,ULONG obytesperrow,
-		       T *dst,ULONG dbytesperpixel,ULONG dbytesperrow,
-		       ULONG w,ULONG h)
-{
-  double error = 0.0;
-  ULONG x,y;
-
-  for(y = 0;y < h;y++) {
-    double err = 0.0;
-    T *orgrow = org;
-    T *dstrow = dst;
-    for(x = 0;x < w;x++) {
-      double diff = *orgrow - *dstrow;
-      err        += diff * diff;
-      //
-      orgrow      = (T *)((const UBYTE *)(orgrow) + obytesperpixel);
-      dstrow      = (T *)((const UBYTE *)(dstrow) + dbytesperpixel);
-    }
-    if (err > error)
-      error = err;
-    org = (T *)((const UBYTE *)(org) + obytesperrow);
-    dst = (T *)((const UBYTE *)(dst) + dbytesperrow);
-  }
-
-  return error * h;
-}
-///
-
-/// Stripe::MSE_Ver
-// l^2 in vertical direction, l^infinity in horizontal direction
-template<typename T>
-double Stripe::MSE_Ver(T *org,ULONG obytesperpixel,ULONG obytesperrow,
-		       T *dst,ULONG dbytesperpixel,ULONG dbytesperrow,
-		       ULONG w,ULONG h)
+/// Stripe::Measure
+double Stripe::Measure(class ImageLayout *src,class ImageLayout *dst,double in)
 {
-  double error = 0.0;
-  ULONG x,y;
+  class Statistics stats;
 
-  for(x = 0;x < w;x++) {
-    double err = 0.0;
-    T *orgrow = org;
-    T *dstrow = dst;
-    for(y = 0;y < h;y++) {
-      double diff = *orgrow - *dstrow;
-      err        += diff * diff;
-      //
-      orgrow      = (T *)((const UBYTE *)(orgrow) + obytesperrow);
-      dstrow      = (T *)((const UBYTE *)(dstrow) + dbytesperrow);
-    }
-    if (err > error)
-      error = err;
-    org = (T *)((const UBYTE *)(org) + obytesperpixel);
-    dst = (T *)((const UBYTE *)(dst) + dbytesperpixel);
-  }
+  stats.Collect(src,dst,StatisticsOf());
 
-  return error * w;
+  return Evaluate(src,stats,in);
 }
 ///
 
-/// Stripe::Measure
-double Stripe::Measure(class ImageLayout *src,class ImageLayout *dst,double)
+/// Stripe::Evaluate
+double Stripe::Evaluate(class ImageLayout *src,const class Statistics &stats,double)
 {
   double max   = 0.0;
   UWORD comp;
 
   for(comp = 0;comp < src->DepthOf();comp++) {
-    double mseh = 0.0;
-    double msev = 0.0;
-    double mse  = 0.0;
-    ULONG  w   = src->WidthOf(comp);
-    ULONG  h   = src->HeightOf(comp);
-    double prc = (src->isFloat(comp))?(1.0):(double(UQUAD(1) << src->BitsOf(comp)) - 1.0);
-    //
-    if (src->isSigned(comp)) {
-      if (src->BitsOf(comp) <= 8) {
-	mseh = MSE_Hor<const BYTE>((const BYTE *)src->DataOf(comp),src->BytesPerPixel(comp),src->BytesPerRow(comp),
-				   (const BYTE *)dst->DataOf(comp),dst->BytesPerPixel(comp),dst->BytesPerRow(comp),
-				   w,h);
-	msev = MSE_Ver<const BYTE>((const BYTE *)src->DataOf(comp),src->BytesPerPixel(comp),src->BytesPerRow(comp),
-				   (const BYTE *)dst->DataOf(comp),dst->BytesPerPixel(comp),dst->BytesPerRow(comp),
-				   w,h);
- 	mse  = MSE<const BYTE>((const BYTE *)src->DataOf(comp),src->BytesPerPixel(comp),src->BytesPerRow(comp),
-			       (const BYTE *)dst->DataOf(comp),dst->BytesPerPixel(comp),dst->BytesPerRow(comp),
-			       w,h);
-     } else if (!src->isFloat(comp) && src->BitsOf(comp) <= 16) {
-	mseh = MSE_Hor<const WORD>((const WORD *)src->DataOf(comp),src->BytesPerPixel(comp),src->BytesPerRow(comp),
-				   (const WORD *)dst->DataOf(comp),dst->BytesPerPixel(comp),dst->BytesPerRow(comp),
-				   w,h);
-	msev = MSE_Ver<const WORD>((const WORD *)src->DataOf(comp),src->BytesPerPixel(comp),src->BytesPerRow(comp),
-				   (const WORD *)dst->DataOf(comp),dst->BytesPerPixel(comp),dst->BytesPerRow(comp),
-				   w,h);
-	mse  = MSE<const WORD>((const WORD *)src->DataOf(comp),src->BytesPerPixel(comp),src->BytesPerRow(comp),
-			       (const WORD *)dst->DataOf(comp),dst->BytesPerPixel(comp),dst->BytesPerRow(comp),
-			       w,h);
-       } else if (!src->isFloat(comp) && src->BitsOf(comp) <= 32) {
-	mseh = MSE_Hor<const LONG>((const LONG *)src->DataOf(comp),src->BytesPerPixel(comp),src->BytesPerRow(comp),
-				   (const LONG *)dst->DataOf(comp),dst->BytesPerPixel(comp),dst->BytesPerRow(comp),
-				   w,h);
-	msev = MSE_Ver<const LONG>((const LONG *)src->DataOf(comp),src->BytesPerPixel(comp),src->BytesPerRow(comp),
-				   (const LONG *)dst->DataOf(comp),dst->BytesPerPixel(comp),dst->BytesPerRow(comp),
-				   w,h);
-	mse  = MSE<const LONG>((const LONG *)src->DataOf(comp),src->BytesPerPixel(comp),src->BytesPerRow(comp),
-			       (const LONG *)dst->DataOf(comp),dst->BytesPerPixel(comp),dst->BytesPerRow(comp),
-			       w,h);
-      } else if (src->BitsOf(comp) <= 32 && src->isFloat(comp)) {
-	mseh = MSE_Hor<const FLOAT>((const FLOAT *)src->DataOf(comp),src->BytesPerPixel(comp),src->BytesPerRow(comp),
-				    (const FLOAT *)dst->DataOf(comp),dst->BytesPerPixel(comp),dst->BytesPerRow(comp),
-				    w,h);
-	msev = MSE_Ver<const FLOAT>((const FLOAT *)src->DataOf(comp),src->BytesPerPixel(comp),src->BytesPerRow(comp),
-				    (const FLOAT *)dst->DataOf(comp),dst->BytesPerPixel(comp),dst->BytesPerRow(comp),
-				    w,h);
-	mse  = MSE<const FLOAT>((const FLOAT *)src->DataOf(comp),src->BytesPerPixel(comp),src->BytesPerRow(comp),
-				(const FLOAT *)dst->DataOf(comp),dst->BytesPerPixel(comp),dst->BytesPerRow(comp),
-				w,h);
-      } else if (src->BitsOf(comp) == 64 && src->isFloat(comp)) {
-	mseh = MSE_Hor<const DOUBLE>((const DOUBLE *)src->DataOf(comp),src->BytesPerPixel(comp),src->BytesPerRow(comp),
-				     (const DOUBLE *)dst->DataOf(comp),dst->BytesPerPixel(comp),dst->BytesPerRow(comp),
-				     w,h);
-	msev = MSE_Ver<const DOUBLE>((const DOUBLE *)src->DataOf(comp),src->BytesPerPixel(comp),src->BytesPerRow(comp),
-				     (const DOUBLE *)dst->DataOf(comp),dst->BytesPerPixel(comp),dst->BytesPerRow(comp),
-				     w,h);
-	mse  = MSE<const DOUBLE>((const DOUBLE *)src->DataOf(comp),src->BytesPerPixel(comp),src->BytesPerRow(comp),
-				 (const DOUBLE *)dst->DataOf(comp),dst->BytesPerPixel(comp),dst->BytesPerRow(comp),
-				 w,h);
-      } else {
-	throw "unsupported data type";
-      }
-    } else {
-      if (src->BitsOf(comp) <= 8) {
-	mseh = MSE_Hor<const UBYTE>((const UBYTE *)src->DataOf(comp),src->BytesPerPixel(comp),src->BytesPerRow(comp),
-				    (const UBYTE *)dst->DataOf(comp),dst->BytesPerPixel(comp),dst->BytesPerRow(comp),
-				    w,h);
-	msev = MSE_Ver<const UBYTE>((const UBYTE *)src->DataOf(comp),src->BytesPerPixel(comp),src->BytesPerRow(comp),
-				    (const UBYTE *)dst->DataOf(comp),dst->BytesPerPixel(comp),dst->BytesPerRow(comp),
-				    w,h);
-	mse  = MSE<const UBYTE>((const UBYTE *)src->DataOf(comp),src->BytesPerPixel(comp),src->BytesPerRow(comp),
-				(const UBYTE *)dst->DataOf(comp),dst->BytesPerPixel(comp),dst->BytesPerRow(comp),
-				w,h);
-      } else if (!src->isFloat(comp) && src->BitsOf(comp) <= 16) {
-	mseh = MSE_Hor<const UWORD>((const UWORD *)src->DataOf(comp),src->BytesPerPixel(comp),src->BytesPerRow(comp),
-				    (const UWORD *)dst->DataOf(comp),dst->BytesPerPixel(comp),dst->BytesPerRow(comp),
-				    w,h);
-	msev = MSE_Ver<const UWORD>((const UWORD *)src->DataOf(comp),src->BytesPerPixel(comp),src->BytesPerRow(comp),
-				    (const UWORD *)dst->DataOf(comp),dst->BytesPerPixel(comp),dst->BytesPerRow(comp),
-				    w,h);
-	mse  = MSE<const UWORD>((const UWORD *)src->DataOf(comp),src->BytesPerPixel(comp),src->BytesPerRow(comp),
-				(const UWORD *)dst->DataOf(comp),dst->BytesPerPixel(comp),dst->BytesPerRow(comp),
-				w,h);
-      } else if (!src->isFloat(comp) && src->BitsOf(comp) <= 32) {
-	mseh = MSE_Hor<const ULONG>((const ULONG *)src->DataOf(comp),src->BytesPerPixel(comp),src->BytesPerRow(comp),
-				    (const ULONG *)dst->DataOf(comp),dst->BytesPerPixel(comp),dst->BytesPerRow(comp),
-				    w,h);
-	msev = MSE_Ver<const ULONG>((const ULONG *)src->DataOf(comp),src->BytesPerPixel(comp),src->BytesPerRow(comp),
-				    (const ULONG *)dst->DataOf(comp),dst->BytesPerPixel(comp),dst->BytesPerRow(comp),
-				    w,h);
-	mse  = MSE<const ULONG>((const ULONG *)src->DataOf(comp),src->BytesPerPixel(comp),src->BytesPerRow(comp),
-				(const ULONG *)dst->DataOf(comp),dst->BytesPerPixel(comp),dst->BytesPerRow(comp),
-				w,h);
-      } else if (src->BitsOf(comp) <= 32 && src->isFloat(comp)) {
-	mseh = MSE_Hor<const FLOAT>((const FLOAT *)src->DataOf(comp),src->BytesPerPixel(comp),src->BytesPerRow(comp),
-				    (const FLOAT *)dst->DataOf(comp),dst->BytesPerPixel(comp),dst->BytesPerRow(comp),
-				    w,h);
-	msev = MSE_Ver<const FLOAT>((const FLOAT *)src->DataOf(comp),src->BytesPerPixel(comp),src->BytesPerRow(comp),
-				    (const FLOAT *)dst->DataOf(comp),dst->BytesPerPixel(comp),dst->BytesPerRow(comp),
-				    w,h);
-	mse  = MSE<const FLOAT>((const FLOAT *)src->DataOf(comp),src->BytesPerPixel(comp),src->BytesPerRow(comp),
-				(const FLOAT *)dst->DataOf(comp),dst->BytesPerPixel(comp),dst->BytesPerRow(comp),
-				w,h);
-      } else if (src->BitsOf(comp) == 64 && src->isFloat(comp)) {
-	mseh = MSE_Hor<const DOUBLE>((const DOUBLE *)src->DataOf(comp),src->BytesPerPixel(comp),src->BytesPerRow(comp),
-				     (const DOUBLE *)dst->DataOf(comp),dst->BytesPerPixel(comp),dst->BytesPerRow(comp),
-				     w,h);
-	msev = MSE_Ver<const DOUBLE>((const DOUBLE *)src->DataOf(comp),src->BytesPerPixel(comp),src->BytesPerRow(comp),
-				     (const DOUBLE *)dst->DataOf(comp),dst->BytesPerPixel(comp),dst->BytesPerRow(comp),
-				     w,h);
-	mse  = MSE<const DOUBLE>((const DOUBLE *)src->DataOf(comp),src->BytesPerPixel(comp),src->BytesPerRow(comp),
-				 (const DOUBLE *)dst->DataOf(comp),dst->BytesPerPixel(comp),dst->BytesPerRow(comp),
-				 w,h);
-      } else {
-	throw "unsupported data type";
-      }
-    }
+    const struct Statistics::Component &c = stats.ComponentOf(comp);
+    ULONG  w    = src->WidthOf(comp);
+    ULONG  h    = src->HeightOf(comp);
+    double mseh = c.m_dRowError    * h; // l^2 in horizontal direction, l^infinity in vertical direction
+    double msev = c.m_dColumnError * w; // l^2 in vertical direction, l^infinity in horizontal direction
+    double mse  = c.m_dSquareError;     // traditional non-directional MSE
+    double prc  = (src->isFloat(comp))?(1.0):(double(UQUAD(1) << src->BitsOf(comp)) - 1.0);
     //
     mseh /= (w * h) * prc * prc;
     msev /= (w * h) * prc * prc;
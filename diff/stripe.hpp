@@ -34,6 +34,7 @@ and conversion framework.
 
 /// Includes
 #include "diff/meter.hpp"
+#include "diff/statistics.hpp"
 ///
 
 /// Forwards
@@ -46,21 +47,6 @@ class Stripe : public Meter {
   // PSNR measurement type
   int m_Type;
   //
-  // Templated implementations
-  template<typename T>
-  double MSE_Hor(T *org,ULONG obytesperpixel,ULONG obytesperrow,
-		 T *dst,ULONG dbytesperpixel,ULONG dbytesperrow,
-		 ULONG w,ULONG h);
-  //
-  template<typename T>
-  double MSE_Ver(T *org,ULONG obytesperpixel,ULONG obytesperrow,
-		 T *dst,ULONG dbytesperpixel,ULONG dbytesperrow,
-		 ULONG w,ULONG h);  
-  //
-  template<typename T>
-  double MSE(T *org,ULONG obytesperpixel,ULONG obytesperrow,
-	     T *dst,ULONG dbytesperpixel,ULONG dbytesperrow,
-	     ULONG w,ULONG h);
 public:
   //
   //
@@ -69,6 +55,15 @@ public:
   //
   virtual double Measure(class ImageLayout *src,class ImageLayout *dst,double in);
   //
+  // The statistics the stripe indicator is computed from.
+  virtual ULONG StatisticsOf(void) const
+  {
+    return Statistics::SquareError | Statistics::RowColumnError;
+  }
+  //
+  // Compute the stripe indicator from the collected statistics.
+  virtual double Evaluate(class ImageLayout *src,const class Statistics &stats,double in);
+  //
   virtual const char *NameOf(void) const
   {
     return "Stripe-Detect";
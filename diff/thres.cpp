@@ -30,87 +30,28 @@ and conversion framework.
 
 /// Includes
 #include "diff/thres.hpp"
+#include "diff/statistics.hpp"
 #include "img/imglayout.hpp"
 #include "std/math.hpp"
 ///
 
-/// Thres::PeakError
-template<typename T>
-double Thres::Error(T *org,ULONG obytesperpixel,ULONG obytesperrow,
-		    T *dst,ULONG dbytesperpixel,ULONG dbytesperrow,
-		    ULONG w,ULONG h)
+/// Thres::Measure
+double Thres::Measure(class ImageLayout *src,class ImageLayout *dst,double in)
 {
-  double error;
-  ULONG x,y;
+  class Statistics stats;
 
-  switch(m_Type) {
-  case Toe:
-  case Min:
-    error = HUGE_VAL;
-    break;
-  case Head:
-  case Max:
-    error = -HUGE_VAL;
-    break;
-  default:
-    error = 0;
-    break;
-  }
-  
-  for(y = 0;y < h;y++) {
-    T *orgrow = org;
-    T *dstrow = dst;
-    for(x = 0;x < w;x++) {
-      double diff = *orgrow - *dstrow;
-      switch(m_Type) {
-      case Min:
-	if (diff < error)
-	  error = diff;
-	break;
-      case Max:
-	if (diff > error)
-	  error = diff;
-	break;
-      case Drift:
-	error += diff;
-	break;
-      case Avg:
-	error += fabs(diff);
-	break;
-      case Peak:
-	diff = fabs(diff);
-	if (diff > error)
-	  error = diff;
-	break;
-      case Toe:
-	if (*orgrow < error)
-	  error = *orgrow;
-	break;
-      case Head:
-	if (*orgrow > error)
-	  error = *orgrow;
-	break;
-      }
-      //
-      orgrow      = (T *)((const UBYTE *)(orgrow) + obytesperpixel);
-      dstrow      = (T *)((const UBYTE *)(dstrow) + dbytesperpixel);
-    }
-    org = (T *)((const UBYTE *)(org) + obytesperrow);
-    dst = (T *)((const UBYTE *)(dst) + dbytesperrow);
-  }
+  stats.Collect(src,dst,StatisticsOf());
 
-  if (m_Type == Avg || m_Type == Drift)
-    error /= w * h;
-  
-  return error;
+  return Evaluate(src,stats,in);
 }
 ///
 
-/// Thres::Measure
-double Thres::Measure(class ImageLayout *src,class ImageLayout *dst,double)
+/// Thres::Evaluate
+double Thres::Evaluate(class ImageLayout *src,const class Statistics &stats,double)
 {
   double error;
   UWORD comp;
+  double *cres = ComponentResults(src->DepthOf());
   
   switch(m_Type) {
   case Toe:
@@ -127,60 +68,38 @@ double Thres::Measure(class ImageLayout *src,class ImageLayout *dst,double)
   }
   
   for(comp = 0;comp < src->DepthOf();comp++) {
+    const struct Statistics::Component &c = stats.ComponentOf(comp);
     double peak = 0.0;
     ULONG  w    = src->WidthOf(comp);
     ULONG  h    = src->HeightOf(comp);
     //
-    if (src->isSigned(comp)) {
-      if (src->BitsOf(comp) <= 8) {
-	peak = Error<const BYTE>((const BYTE *)src->DataOf(comp),src->BytesPerPixel(comp),src->BytesPerRow(comp),
-				 (const BYTE *)dst->DataOf(comp),dst->BytesPerPixel(comp),dst->BytesPerRow(comp),
-				 w,h);
-      } else if (!src->isFloat(comp) && src->BitsOf(comp) <= 16) {
-	peak = Error<const WORD>((const WORD *)src->DataOf(comp),src->BytesPerPixel(comp),src->BytesPerRow(comp),
-				 (const WORD *)dst->DataOf(comp),dst->BytesPerPixel(comp),dst->BytesPerRow(comp),
-				 w,h);
-      } else if (!src->isFloat(comp) && src->BitsOf(comp) <= 32) {
-	peak = Error<const LONG>((const LONG *)src->DataOf(comp),src->BytesPerPixel(comp),src->BytesPerRow(comp),
-				 (const LONG *)dst->DataOf(comp),dst->BytesPerPixel(comp),dst->BytesPerRow(comp),
-				 w,h);
-      } else if (src->BitsOf(comp) <= 32 && src->isFloat(comp)) {
-	peak = Error<const FLOAT>((const FLOAT *)src->DataOf(comp),src->BytesPerPixel(comp),src->BytesPerRow(comp),
-				  (const FLOAT *)dst->DataOf(comp),dst->BytesPerPixel(comp),dst->BytesPerRow(comp),
-				  w,h);
-      } else if (src->BitsOf(comp) == 64 && src->isFloat(comp)) {
-	peak = Error<const DOUBLE>((const DOUBLE *)src->DataOf(comp),src->BytesPerPixel(comp),src->BytesPerRow(comp),
-				   (const DOUBLE *)dst->DataOf(comp),dst->BytesPerPixel(comp),dst->BytesPerRow(comp),
-				   w,h);
-      } else {
-	throw "unsupported data type";
-      }
-    } else {
-      if (src->BitsOf(comp) <= 8) {
-	peak = Error<const UBYTE>((const UBYTE *)src->DataOf(comp),src->BytesPerPixel(comp),src->BytesPerRow(comp),
-				  (const UBYTE *)dst->DataOf(comp),dst->BytesPerPixel(comp),dst->BytesPerRow(comp),
-				  w,h);
-      } else if (!src->isFloat(comp) && src->BitsOf(comp) <= 16) {
-	peak = Error<const UWORD>((const UWORD *)src->DataOf(comp),src->BytesPerPixel(comp),src->BytesPerRow(comp),
-				  (const UWORD *)dst->DataOf(comp),dst->BytesPerPixel(comp),dst->BytesPerRow(comp),
-				  w,h);
-      } else if (!src->isFloat(comp) && src->BitsOf(comp) <= 32) {
-	peak = Error<const ULONG>((const ULONG *)src->DataOf(comp),src->BytesPerPixel(comp),src->BytesPerRow(comp),
-				  (const ULONG *)dst->DataOf(comp),dst->BytesPerPixel(comp),dst->BytesPerRow(comp),
-				  w,h);
-      } else if (src->BitsOf(comp) <= 32 && src->isFloat(comp)) {
-	peak = Error<const FLOAT>((const FLOAT *)src->DataOf(comp),src->BytesPerPixel(comp),src->BytesPerRow(comp),
-				  (const FLOAT *)dst->DataOf(comp),dst->BytesPerPixel(comp),dst->BytesPerRow(comp),
-				  w,h);
-      } else if (src->BitsOf(comp) == 64 && src->isFloat(comp)) {
-	peak = Error<const DOUBLE>((const DOUBLE *)src->DataOf(comp),src->BytesPerPixel(comp),src->BytesPerRow(comp),
-				   (const DOUBLE *)dst->DataOf(comp),dst->BytesPerPixel(comp),dst->BytesPerRow(comp),
-				   w,h);
-      } else {
-	throw "unsupported data type";
-      }
+    switch(m_Type) {
+    case Min:
+      peak = c.m_dMinDiff;
+      break;
+    case Max:
+      peak = c.m_dMaxDiff;
+      break;
+    case Drift:
+      peak = c.m_dDrift / (w * h);
+      break;
+    case Avg:
+      peak = c.m_dAbsoluteError / (w * h);
+      break;
+    case Peak:
+      peak = c.m_dPeakError;
+      break;
+    case Toe:
+      peak = c.m_dToe;
+      break;
+    case Head:
+      peak = c.m_dHead;
+      break;
     }
     //
+    // The result of this component alone.
+    cres[comp] = peak;
+    //
     switch(m_Type) {
     case Min:
     case Toe:
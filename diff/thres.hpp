@@ -33,6 +33,7 @@ and conversion framework.
 
 /// Includes
 #include "diff/meter.hpp"
+#include "diff/statistics.hpp"
 ///
 
 /// Forwards
@@ -45,11 +46,6 @@ class Thres : public Meter {
   // Threshold measurement type
   int m_Type;
   //
-  // Templated implementations
-  template<typename T>
-  double Error(T *org,ULONG obytesperpixel,ULONG obytesperrow,
-	       T *dst,ULONG dbytesperpixel,ULONG dbytesperrow,
-	       ULONG w,ULONG h);
 public:
   //
   enum Type {
@@ -68,6 +64,29 @@ public:
   //
   virtual double Measure(class ImageLayout *src,class ImageLayout *dst,double in);
   //
+  // The statistics the threshold measure is computed from.
+  virtual ULONG StatisticsOf(void) const
+  {
+    switch(m_Type) {
+    case Min:
+    case Max:
+      return Statistics::DiffRange;
+    case Avg:
+      return Statistics::AbsoluteError;
+    case Drift:
+      return Statistics::Drift;
+    case Peak:
+      return Statistics::PeakError;
+    case Toe:
+    case Head:
+      return Statistics::SourceRange;
+    }
+    return 0;
+  }
+  //
+  // Compute the threshold measure from the collected statistics.
+  virtual double Evaluate(class ImageLayout *src,const class Statistics &stats,double in);
+  //
   virtual const char *NameOf(void) const
   {
     switch(m_Type) {
@@ -49,7 +49,7 @@ ToBayer::~ToBayer(void)
 // that have been allocated.
 void ToBayer::ReleaseComponents(UBYTE *&p)
 {
-  delete[] p;
+  ReleaseBuffer(p);
 }
 ///
 
@@ -135,7 +135,7 @@ void ToBayer::CreateImageData(UBYTE *&data,class ImageLayout *src)
   // Fill up the component data pointers.
   UBYTE bps = ImageLayout::SuggestBPP(m_pComponent[0].m_ucBits,m_pComponent[0].m_bFloat);
   //
-  data      = new UBYTE[m_pComponent[0].m_ulWidth * m_pComponent[0].m_ulHeight * bps];
+  data      = AllocateBuffer(m_pComponent[0].m_ulWidth * m_pComponent[0].m_ulHeight * bps);
   m_pComponent[0].m_ulBytesPerPixel = bps;
   m_pComponent[0].m_ulBytesPerRow   = bps * m_pComponent[0].m_ulWidth;
   m_pComponent[0].m_pPtr            = data;
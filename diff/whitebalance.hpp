@@ -90,6 +90,12 @@ public:
   {
     return NULL;
   }
+  //
+  // Works on each sample by itself.
+  virtual bool isPointWise(void) const
+  {
+    return true;
+  }
 };
 ///
 
@@ -38,12 +38,22 @@ and conversion framework.
 /// YCbCr::~YCbCr
 // Destructor, also gets rid of the image memory
 YCbCr::~YCbCr(void)
+{
+  Restart();
+}
+///
+
+/// YCbCr::Restart
+// Release the result of the last band.
+void YCbCr::Restart(void)
 {
   int i;
   
   for(i = 0;i < 4;i++) {
-    delete[] m_ppucSrcImage[i];
-    delete[] m_ppucDstImage[i];
+    ReleaseBuffer(m_ppucSrcImage[i]);
+    ReleaseBuffer(m_ppucDstImage[i]);
+    m_ppucSrcImage[i] = NULL;
+    m_ppucDstImage[i] = NULL;
   }
 }
 ///
@@ -1241,7 +1251,7 @@ void YCbCr::ToRCT(class ImageLayout *img,UBYTE *(&membuf)[4])
 	  obits++;
       }
       bpc = ImageLayout::SuggestBPP(obits,false);
-      mem = new UBYTE[w * h * bpc];
+      mem = AllocateBuffer(w * h * bpc);
       //
       // Store the pointer to be able to release it later.
       membuf[comp]                         = mem;
@@ -1580,7 +1590,7 @@ void YCbCr::FromRCT(class ImageLayout *img,UBYTE *(&membuf)[4])
       }
       //
       bpc = ImageLayout::SuggestBPP(ybits,false);
-      mem = new UBYTE[w * h * bpc];
+      mem = AllocateBuffer(w * h * bpc);
       //
       // Store the pointer to be able to release it later.
       membuf[comp]                         = mem;
@@ -1707,7 +1717,7 @@ void YCbCr::To422RCT(class ImageLayout *img,UBYTE *(&membuf)[4])
       // would not be reversible.
       obits++;
       bpc = ImageLayout::SuggestBPP(obits,false);
-      mem = new UBYTE[w * h * bpc];
+      mem = AllocateBuffer(w * h * bpc);
       //
       // Store the pointer to be able to release it later.
       membuf[comp]                         = mem;
@@ -1849,7 +1859,7 @@ void YCbCr::From422RCT(class ImageLayout *img,UBYTE *(&membuf)[4])
 	throw "The 422RCT requires that all chroma components have the same signedness";
       //
       bpc = ImageLayout::SuggestBPP(ybits - 1,false);
-      mem = new UBYTE[w * h * bpc];
+      mem = AllocateBuffer(w * h * bpc);
       //
       // Store the pointer to be able to release it later.
       membuf[comp]                         = mem;
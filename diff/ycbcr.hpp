@@ -316,6 +316,15 @@ public:
   {
     return NULL;
   }
+  //
+  // Works on each pixel, or pairs of horizontally adjacent pixels, by itself.
+  virtual bool isPointWise(void) const
+  {
+    return true;
+  }
+  //
+  // Release the result of the last band.
+  virtual void Restart(void);
 };
 ///
 
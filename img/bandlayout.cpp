@@ -0,0 +1,229 @@
+/*************************************************************************
+** Written by Thomas Richter (THOR Software) for Accusoft	        **
+** All Rights Reserved							**
+**************************************************************************
+
+This source file is part of difftest_ng, a universal image measuring
+and conversion framework.
+
+    difftest_ng is free software: you can redistribute it and/or modify
+    it under the terms of the GNU General Public License as published by
+    the Free Software Foundation, either version 3 of the License, or
+    (at your option) any later version.
+
+    difftest_ng is distributed in the hope that it will be useful,
+    but WITHOUT ANY WARRANTY; without even the implied warranty of
+    MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+    GNU General Public License for more details.
+
+    You should have received a copy of the GNU General Public License
+    along with difftest_ng.  If not, see <http://www.gnu.org/licenses/>.
+
+*************************************************************************/
+
+
+/*
+**
+** $Id$
+**
+** This image class holds a horizontal band of rows of another image.
+**
+*/
+
+/// Includes
+#include "imglayout.hpp"
+#include "std/string.hpp"
+#include "img/bandlayout.hpp"
+///
+
+/// BandLayout::BytesPerPixelOf
+// Return the number of bytes from one sample of a component of the
+// band to the next. This is the distance in the source image such
+// that filters see the samples in the same arrangement, unless the
+// source packs them tighter than a component of its own would.
+ULONG BandLayout::BytesPerPixelOf(const class ImageLayout &source,UWORD comp)
+{
+  ULONG bpp = SuggestBPP(source.BitsOf(comp),source.isFloat(comp));
+
+  if (source.BytesPerPixel(comp) > bpp)
+    bpp = source.BytesPerPixel(comp);
+
+  return bpp;
+}
+///
+
+/// BandLayout::LeadOf
+// Return the component of the source whose pixels hold the samples of
+// the given component along with its own, and the offset of the
+// samples of comp within them. This is the interleaved component whose
+// samples come first, or comp itself. The band keeps interleaved
+// components interleaved as the source does, since filters may take a
+// different path on components in separate areas and round
+// differently.
+UWORD BandLayout::LeadOf(const class ImageLayout &source,UWORD comp,ULONG &offset)
+{
+  const UBYTE *c    = (const UBYTE *)source.DataOf(comp);
+  const UBYTE *lead = c;
+  ULONG bpp         = source.BytesPerPixel(comp);
+  ULONG size        = SuggestBPP(source.BitsOf(comp),source.isFloat(comp));
+  UWORD l,best      = comp;
+
+  if (c != NULL && bpp == BytesPerPixelOf(source,comp)) {
+    for(l = 0;l < source.DepthOf();l++) {
+      const UBYTE *p = (const UBYTE *)source.DataOf(l);
+      //
+      if (p != NULL && p < lead && c + size <= p + bpp &&
+	  source.BytesPerPixel(l) == bpp && source.BytesPerRow(l) == source.BytesPerRow(comp) &&
+	  source.WidthOf(l) == source.WidthOf(comp) && source.HeightOf(l) == source.HeightOf(comp) &&
+	  source.SubYOf(l) == source.SubYOf(comp)) {
+	lead = p;
+	best = l;
+      }
+    }
+  }
+
+  offset = ULONG(c - lead);
+  return best;
+}
+///
+
+/// BandLayout::BandLayout
+// Create a band of the given number of rows of the full resolution image.
+BandLayout::BandLayout(const class ImageLayout &source,ULONG rows)
+  : ImageLayout(source), m_pSource(&source), m_ulRows(rows), m_pucImage(NULL)
+{
+  UWORD comp;
+  size_t size = 0;
+
+  for(comp = 0;comp < source.DepthOf();comp++) {
+    if (rows % source.SubYOf(comp))
+      throw "the band height must be divisible by the vertical subsampling factors";
+    size += size_t(source.WidthOf(comp)) * (rows / source.SubYOf(comp)) * BytesPerPixelOf(source,comp);
+  }
+
+  if (size > 0)
+    m_pucImage = new UBYTE[size];
+}
+///
+
+/// BandLayout::~BandLayout
+BandLayout::~BandLayout(void)
+{
+  delete[] m_pucImage;
+}
+///
+
+/// BandLayout::Fill
+// Copy the band starting at row y of the full resolution image and
+// make this layout describe it.
+void BandLayout::Fill(ULONG y)
+{
+  const class ImageLayout *src = m_pSource;
+  UBYTE *mem = m_pucImage;
+  UWORD comp,c;
+  ULONG offset;
+
+  assert(y < src->HeightOf());
+  //
+  // Filters may have replaced the components by their own.
+  CreateComponents(*src);
+  m_ulHeight = src->HeightOf() - y;
+  if (m_ulHeight > m_ulRows)
+    m_ulHeight = m_ulRows;
+
+  for(comp = 0;comp < m_usDepth;comp++) {
+    struct ComponentLayout *cl = m_pComponent + comp;
+    ULONG w         = src->WidthOf(comp);
+    ULONG y0        = y / src->SubYOf(comp);
+    ULONG y1        = y0 + m_ulRows / src->SubYOf(comp);
+    ULONG size      = SuggestBPP(src->BitsOf(comp),src->isFloat(comp));
+    ULONG bpp       = BytesPerPixelOf(*src,comp);
+    ULONG sbpp      = src->BytesPerPixel(comp);
+    ULONG sbpr      = src->BytesPerRow(comp);
+    const UBYTE *in = (const UBYTE *)src->DataOf(comp);
+    ULONG x,yc;
+    //
+    if (y1 > src->HeightOf(comp))
+      y1 = src->HeightOf(comp);
+    if (y0 > y1)
+      y0 = y1;
+    //
+    cl->m_ulWidth         = w;
+    cl->m_ulHeight        = y1 - y0;
+    cl->m_ulBytesPerPixel = bpp;
+    cl->m_ulBytesPerRow   = bpp * w;
+    //
+    // Components within the pixels of another one are copied along
+    // with it, see below.
+    if (LeadOf(*src,comp,offset) != comp)
+      continue;
+    //
+    // Copy the samples of the other components within its pixels
+    // along.
+    for(c = 0;c < m_usDepth;c++) {
+      if (c != comp && LeadOf(*src,c,offset) == comp) {
+	ULONG end = offset + SuggestBPP(src->BitsOf(c),src->isFloat(c));
+	if (end > size)
+	  size = end;
+      }
+    }
+    //
+    cl->m_pPtr            = mem;
+    //
+    in += size_t(y0) * sbpr;
+    for(yc = y0;yc < y1 && w > 0;yc++) {
+      if (sbpp == bpp) {
+	// Samples of interleaved components are copied along with the
+	// gaps between them, but not beyond the last sample.
+	memcpy(mem,in,size_t(w - 1) * bpp + size);
+      } else {
+	UBYTE *d       = mem;
+	const UBYTE *s = in;
+	for(x = 0;x < w;x++) {
+	  memcpy(d,s,size);
+	  d += bpp;
+	  s += sbpp;
+	}
+      }
+      mem += size_t(w) * bpp;
+      in  += sbpr;
+    }
+  }
+  //
+  // The components within the pixels of another one keep their offset
+  // from it.
+  for(comp = 0;comp < m_usDepth;comp++) {
+    c = LeadOf(*src,comp,offset);
+    if (c != comp)
+      m_pComponent[comp].m_pPtr = (UBYTE *)m_pComponent[c].m_pPtr + offset;
+  }
+}
+///
+
+/// BandLayout::Describe
+// Make this layout describe the complete source image in the sample
+// format and depth the given band has now.
+void BandLayout::Describe(const class ImageLayout &band)
+{
+  const class ImageLayout *src = m_pSource;
+  UWORD comp;
+
+  CreateComponents(band);
+  m_ulHeight = src->HeightOf();
+
+  for(comp = 0;comp < m_usDepth;comp++) {
+    struct ComponentLayout *cl = m_pComponent + comp;
+    //
+    // If a filter created new components, derive their heights
+    // from the image height.
+    if (m_usDepth == src->DepthOf()) {
+      cl->m_ulHeight = src->HeightOf(comp);
+    } else {
+      cl->m_ulHeight = (m_ulHeight + cl->m_ucSubY - 1) / cl->m_ucSubY;
+    }
+    cl->m_ulBytesPerPixel = 0;
+    cl->m_ulBytesPerRow   = 0;
+    cl->m_pPtr            = NULL;
+  }
+}
+///
@@ -0,0 +1,90 @@
+/*************************************************************************
+** Written by Thomas Richter (THOR Software) for Accusoft	        **
+** All Rights Reserved							**
+**************************************************************************
+
+This source file is part of difftest_ng, a universal image measuring
+and conversion framework.
+
+    difftest_ng is free software: you can redistribute it and/or modify
+    it under the terms of the GNU General Public License as published by
+    the Free Software Foundation, either version 3 of the License, or
+    (at your option) any later version.
+
+    difftest_ng is distributed in the hope that it will be useful,
+    but WITHOUT ANY WARRANTY; without even the implied warranty of
+    MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+    GNU General Public License for more details.
+
+    You should have received a copy of the GNU General Public License
+    along with difftest_ng.  If not, see <http://www.gnu.org/licenses/>.
+
+*************************************************************************/
+
+
+/*
+**
+** $Id$
+**
+** This image class holds a horizontal band of rows of another image.
+** Filters that work on each row by itself and the statistics of the
+** metrics can then run on one band after another, such that the
+** memory required for the intermediate images is bounded by the
+** size of the band rather than by the size of the image.
+**
+*/
+
+#ifndef BANDLAYOUT_HPP
+#define BANDLAYOUT_HPP
+
+/// Includes
+#include "imglayout.hpp"
+#include "std/stdio.hpp"
+///
+
+/// BandLayout
+// This image class holds a copy of a horizontal band of rows of
+// another image.
+class BandLayout : public ImageLayout {
+  //
+  // The complete image the bands are taken from.
+  const class ImageLayout *m_pSource;
+  //
+  // The number of rows of the full resolution image in a band.
+  ULONG                    m_ulRows;
+  //
+  // The samples of all components of a band.
+  UBYTE                   *m_pucImage;
+  //
+  // Return the number of bytes from one sample of a component of the
+  // band to the next.
+  static ULONG BytesPerPixelOf(const class ImageLayout &source,UWORD comp);
+  //
+  // Return the component of the source whose pixels hold the samples
+  // of the given component along with its own, and the offset of the
+  // samples of comp within them. This is comp itself unless the
+  // components are interleaved.
+  static UWORD LeadOf(const class ImageLayout &source,UWORD comp,ULONG &offset);
+  //
+public:
+  // Create a band of the given number of rows of the full resolution
+  // image. This must be a multiple of the vertical subsampling factors
+  // of all components.
+  BandLayout(const class ImageLayout &source,ULONG rows);
+  //
+  ~BandLayout(void);
+  //
+  // Copy the band starting at row y of the full resolution image
+  // and make this layout describe it. The layout is rebuilt
+  // from the source, whatever filters did to it before.
+  void Fill(ULONG y);
+  //
+  // Make this layout describe the complete source image in the sample
+  // format and depth the given band has now, e.g. after filtering. This
+  // describes the dimensions only, there is no data behind it.
+  void Describe(const class ImageLayout &band);
+};
+///
+
+///
+#endif
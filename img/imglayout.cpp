@@ -49,6 +49,8 @@ and conversion framework.
 #include "img/simpleraw.hpp"
 #include "img/simpledpx.hpp"
 #include "img/blankimg.hpp"
+#include "tools/profile.hpp"
+#include "tools/memorymap.hpp"
 ///
 
 /// ImageLayout::ImageLayout
@@ -296,11 +298,14 @@ void ImageLayout::ExtractField(bool oddfield)
 
 /// ImageLayout::LoadImage
 // Load an image from the specified filespec using the appropriate file type,
-// derived from the extension. Returns the proper loader.
-class ImageLayout *ImageLayout::LoadImage(const char *filename,struct ImgSpecs &specs)
+// derived from the extension. Returns the proper loader. If a pool is given,
+// loaders may use its threads to decode the image.
+class ImageLayout *ImageLayout::LoadImage(const char *filename,struct ImgSpecs &specs,
+					  class ThreadPool *pool)
 {  
   class ImageLayout *img = NULL;
   const char *ext        = strrchr(filename,'.');
+  class Profile::Probe probe;
   //
   if (ext == NULL) {
     if (filename[0] == '-' && filename[1] == '/') {
@@ -317,6 +322,7 @@ class ImageLayout *ImageLayout::LoadImage(const char *filename,struct ImgSpecs &
 	      class BlankImg *blank = new BlankImg(width,height,depth);
 	      blank->CreateComponents(width,height,depth);
 	      blank->BlankSeparate();
+	      probe.Record("create",filename,blank->SamplesOf(),blank->SampleBytesOf());
 	      return blank;
 	    } else throw "image dimensions of newly created image must be all positive";
 	  }
@@ -350,6 +356,7 @@ class ImageLayout *ImageLayout::LoadImage(const char *filename,struct ImgSpecs &
       // TIFF family
       class SimpleTiff *tif = new SimpleTiff;
       img = tif;
+      tif->UsePool(pool);
       tif->LoadImage(filename,specs);
     } else if (!strcmp(ext,".png")) {
       // PNG
@@ -393,21 +400,29 @@ class ImageLayout *ImageLayout::LoadImage(const char *filename,struct ImgSpecs &
     throw;
   }
   //
+  probe.Record("load",filename,img->SamplesOf(),img->SampleBytesOf());
+  //
   return img;
 }
 ///
 
 /// ImageLayout::SaveImage
 // Save an image back to a file
-void ImageLayout::SaveImage(const char *filename,const struct ImgSpecs &specs)
+void ImageLayout::SaveImage(const char *filename,const struct ImgSpecs &specs,
+			    class ThreadPool *pool)
 {
   const char *ext        = strrchr(filename,'.');
+  class Profile::Probe probe;
   //
   // Now get the stream extender.
   if (ext == NULL) {
     throw "no file format extender, unknown format - can't save image";
   }
   //
+  // The target may be one of the images mapped into memory, which
+  // must keep its samples when the saver truncates the file.
+  MemoryMap::DetachFile(filename);
+  //
   if (!strcmp(ext,".ppm") || !strcmp(ext,".pgm") || !strcmp(ext,".pbm") || 
       !strcmp(ext,".pfm") || !strcmp(ext,".pnm")) {
     // PPM family
@@ -428,6 +443,7 @@ void ImageLayout::SaveImage(const char *filename,const struct ImgSpecs &specs)
   } else if (!strcmp(ext,".tif") || !strcmp(ext,".tiff")) {
     // TIFF
     class SimpleTiff tif(*this);
+    tif.UsePool(pool);
     tif.SaveImage(filename,specs);
   } else if (!strcmp(ext,".png")) {
 #ifdef USE_PNG
@@ -458,7 +474,10 @@ void ImageLayout::SaveImage(const char *filename,const struct ImgSpecs &specs)
     raw.SaveImage(filename,specs);
   } else {
     fprintf(stderr,"unknown target image file format\n");
+    return;
   }
+  //
+  probe.Record("save",filename,SamplesOf(),SampleBytesOf());
 }
 ///
 
@@ -484,6 +503,37 @@ class ImageLayout *ImageLayout::CloneLayout(const class ImageLayout *org)
 }
 ///
 
+/// ImageLayout::SamplesOf
+// Return the number of samples of all components.
+UQUAD ImageLayout::SamplesOf(void) const
+{
+  UQUAD samples = 0;
+  UWORD comp;
+
+  for(comp = 0;comp < DepthOf();comp++) {
+    samples += UQUAD(WidthOf(comp)) * HeightOf(comp);
+  }
+
+  return samples;
+}
+///
+
+/// ImageLayout::SampleBytesOf
+// Return the number of bytes the samples of all components take at
+// the precision of the components.
+UQUAD ImageLayout::SampleBytesOf(void) const
+{
+  UQUAD bytes = 0;
+  UWORD comp;
+
+  for(comp = 0;comp < DepthOf();comp++) {
+    bytes += UQUAD(WidthOf(comp)) * HeightOf(comp) * ((BitsOf(comp) + 7) >> 3);
+  }
+
+  return bytes;
+}
+///
+
 /// ImageLayout::TestIfCompatible
 // Check whether the two images are compatible in dimension and depth
 // to allow a comparison. Throw if not.
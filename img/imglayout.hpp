@@ -42,6 +42,7 @@ and conversion framework.
 
 /// Forwards
 struct ImgSpecs;
+class ThreadPool;
 ///
 
 /// Class ImageLayout
@@ -120,11 +121,6 @@ protected:
   // original.
   void CreateComponents(const class ImageLayout &img);
   //
-  // Compute a suitable bits per pixel value from a bitdepth. Note that
-  // this is not the bpp value for this specific implementation, but
-  // a helper function that returns a usable size for a given bitdepth
-  static UBYTE SuggestBPP(UBYTE bits,bool isfloat);
-  //
 public:
   // This can be called by subclasses to indicate an
   // error
@@ -270,6 +266,11 @@ public:
   // Limit to the given field of all components.
   void ExtractField(bool oddfield);
   //
+  // Compute a suitable bits per pixel value from a bitdepth. Note that
+  // this is not the bpp value for this specific implementation, but
+  // a helper function that returns a usable size for a given bitdepth
+  static UBYTE SuggestBPP(UBYTE bits,bool isfloat);
+  //
   // Return or link the next image in here.
   class ImageLayout *&NextOf(void)
   {
@@ -283,15 +284,19 @@ public:
   }
   //
   // Load an image from the specified filespec using the appropriate file type,
-  // derived from the extension. Returns the proper loader.
-  static class ImageLayout *LoadImage(const char *filename,struct ImgSpecs &specs);
+  // derived from the extension. Returns the proper loader. If a pool is given,
+  // loaders may use its threads to decode the image.
+  static class ImageLayout *LoadImage(const char *filename,struct ImgSpecs &specs,
+				      class ThreadPool *pool = NULL);
   //
   // Clone the layout of an image and create an image of the same dimensions just
   // with no data.
   static class ImageLayout *CloneLayout(const class ImageLayout *org);
   //
-  // Save an image back to a file
-  void SaveImage(const char *filename,const struct ImgSpecs &specs);
+  // Save an image back to a file. If a pool is given, savers may use
+  // its threads to encode the image.
+  void SaveImage(const char *filename,const struct ImgSpecs &specs,
+		 class ThreadPool *pool = NULL);
   //
   // Save an image with default specifications.
   void SaveImage(const char *filename);
@@ -299,6 +304,11 @@ public:
   // Check whether the two images are compatible in dimension and depth
   // to allow a comparison. Throw if not.
   void TestIfCompatible(const class ImageLayout *dst) const;
+  //
+  // Return the number of samples of all components, and the number of
+  // bytes they take at the precision of the components.
+  UQUAD SamplesOf(void) const;
+  UQUAD SampleBytesOf(void) const;
 
 };
 ///
@@ -47,6 +47,14 @@ struct ImgSpecs {
     Unspecified
   };
   //
+  // Compression of the image data, if the format offers a choice.
+  enum CompressionType {
+    Uncompressed,
+    LZW,
+    PackBits,
+    Deflate
+  };
+  //
   // Is this image encoded in raw (binary) or ascii format?
   BinaryFeature ASCII;
   //
@@ -70,10 +78,24 @@ struct ImgSpecs {
   //
   BinaryFeature FullRange;
   //
+  // How the image data is compressed, and whether horizontal
+  // differences are compressed instead of the samples.
+  CompressionType Compression;
+  BinaryFeature   Prediction;
+  //
+  // Number of rows written at once and compressed independently
+  // (TIFF strips), zero for a default.
+  ULONG         RowsPerStrip;
+  //
+  // Shall the image be written with 64-bit file offsets (BigTIFF)?
+  // If unspecified, only if the image could exceed 4GB otherwise.
+  BinaryFeature BigTIFF;
+  //
   ImgSpecs(void)
     : ASCII(Unspecified), Interleaved(Unspecified), YUVEncoded(Unspecified), 
       Palettized(Unspecified), LittleEndian(Unspecified), AbsoluteRadiance(Unspecified),
-      RadianceScale(1.0), FullRange(Unspecified)
+      RadianceScale(1.0), FullRange(Unspecified), Compression(Uncompressed),
+      Prediction(Unspecified), RowsPerStrip(0), BigTIFF(Unspecified)
   { }
   //
   // MergeSpecs: Merge this, and two other specs together. This one overrides all,
@@ -33,12 +33,14 @@ and conversion framework.
 #include "img/imgspecs.hpp"
 #include "std/stdio.hpp"
 #include "tools/file.hpp"
+#include "tools/memorymap.hpp"
 ///
 
 /// SimpleDPX::SimpleDPX
 // default constructor
 SimpleDPX::SimpleDPX(void)
-  : m_bLittleEndian(true), m_bLeftToRightScan(false), m_bFlipX(false), m_bFlipY(false), m_bFlipXY(false)
+  : m_bLittleEndian(true), m_bLeftToRightScan(false), m_bFlipX(false), m_bFlipY(false), m_bFlipXY(false),
+    m_pMap(NULL)
 {
 }
 ///
@@ -46,7 +48,8 @@ SimpleDPX::SimpleDPX(void)
 /// SimpleDPX::SimpleDPX
 // Copy the image from another source for later saving.
 SimpleDPX::SimpleDPX(const class ImageLayout &layout)
-  : ImageLayout(layout), m_bLittleEndian(true), m_bLeftToRightScan(false), m_bFlipX(false), m_bFlipY(false), m_bFlipXY(false)
+  : ImageLayout(layout), m_bLittleEndian(true), m_bLeftToRightScan(false), m_bFlipX(false), m_bFlipY(false), m_bFlipXY(false),
+    m_pMap(NULL)
 {
 }
 ///
@@ -56,6 +59,7 @@ SimpleDPX::SimpleDPX(const class ImageLayout &layout)
 SimpleDPX::~SimpleDPX(void)
 {
   // Elements are destroyed as members of this class.
+  delete m_pMap;
 }
 ///
 
@@ -467,6 +471,9 @@ void SimpleDPX::ParseHeader(FILE *file,struct ImgSpecs &specs)
   for(i = 0;i < m_usElements;i++) {
     struct ImageElement *el = m_Elements + i;
     struct ScanElement  *sl = el->m_pScanPattern;
+    ULONG bytesperrow       = 0;
+    UBYTE *mapped           = MapElement(file,el,bytesperrow);
+    UWORD idx               = 0;
     while(sl) {
       struct ComponentLayout *cll; 
       UBYTE bytesperpixel      = ImageLayout::SuggestBPP(el->m_ucBitDepth,false);
@@ -504,7 +511,13 @@ void SimpleDPX::ParseHeader(FILE *file,struct ImgSpecs &specs)
       // Check whether we have already data for this channel. If not, allocate now.
       // As a channel may appear multiple times in one scan pattern, make sure to
       // allocate only once.
-      if (el->m_pData[k] == NULL) {
+      if (mapped) {
+	// Samples of the element are interleaved in the mapping.
+	cll->m_ulBytesPerPixel = (el->m_ucDepth + el->m_ucAlphaDepth) * bytesperpixel;
+	cll->m_ulBytesPerRow   = bytesperrow;
+	cll->m_pPtr            = mapped + idx * bytesperpixel;
+	sl->m_bFirst           = true;
+      } else if (el->m_pData[k] == NULL) {
 	el->m_pData[k] = new UBYTE[cll->m_ulWidth * bytesperpixel * cll->m_ulHeight];
 	cll->m_pPtr    = el->m_pData[k];
 	sl->m_bFirst   = true;
@@ -512,6 +525,7 @@ void SimpleDPX::ParseHeader(FILE *file,struct ImgSpecs &specs)
       sl->m_pData      = cll->m_pPtr;
       sl->m_pComponent = cll;
       sl = sl->m_pNext;
+      idx++;
     }
     // Adjust the components.
     cl += el->m_ucDepth + el->m_ucAlphaDepth;
@@ -519,6 +533,58 @@ void SimpleDPX::ParseHeader(FILE *file,struct ImgSpecs &specs)
 }
 ///
 
+/// SimpleDPX::MapElement
+// Check whether the element holds unpacked 8 or 16 bit samples in the
+// byte order of the host, without subsampling, compression or flipping.
+// If so, return the start of the
+// element data in the mapped file and its row size in bytes, or NULL
+// otherwise.
+UBYTE *SimpleDPX::MapElement(FILE *file,struct ImageElement *el,ULONG &bytesperrow)
+{
+  ULONG bytes   = el->m_ucBitDepth >> 3;
+  ULONG samples = el->m_ucDepth + el->m_ucAlphaDepth;
+  UBYTE *data;
+  //
+  if (el->m_ucBitDepth != 8 && el->m_ucBitDepth != 16)
+    return NULL;
+  if (el->m_bRLE || el->m_bFloat || el->m_ucSubX != 1 || el->m_ucSubY != 1)
+    return NULL;
+  if (el->m_ucLSBPaddingBits || el->m_ucMSBPaddingBits || el->m_ulEndOfLinePadding > ULONG(MAX_LONG))
+    return NULL;
+  if (m_bFlipX || m_bFlipY || m_bFlipXY)
+    return NULL;
+  //
+  // Little endian files scanned from the LSB and big endian files
+  // scanned from the MSB keep bytes in order, words are then in order
+  // if the host shares the byte order of the file.
+  if (m_bLeftToRightScan == m_bLittleEndian)
+    return NULL;
+  if (bytes > 1 && m_bLittleEndian != MemoryMap::isLittleEndian())
+    return NULL;
+  //
+  // Rows start at 32-bit boundaries.
+  bytesperrow = ((m_ulWidth * samples * bytes + 3) & ~3UL) + el->m_ulEndOfLinePadding;
+  if (bytesperrow % bytes)
+    return NULL;
+  //
+  if (m_pMap == NULL) {
+    m_pMap = new class MemoryMap;
+    if (!m_pMap->Map(file)) {
+      delete m_pMap;
+      m_pMap = NULL;
+      return NULL;
+    }
+  }
+  //
+  // The padding of the last row need not be present.
+  data = m_pMap->RangeOf(el->m_ulOffset,UQUAD(bytesperrow) * m_ulHeight - el->m_ulEndOfLinePadding,bytes);
+  if (data)
+    el->m_bMapped = true;
+  //
+  return data;
+}
+///
+
 /// SimpleDPX::ReadData
 // Read a single pixel from the specified file.
 UQUAD SimpleDPX::ReadData(FILE *in,const struct ImageElement *el,bool issigned)
@@ -741,7 +807,8 @@ void SimpleDPX::LoadImage(const char *name,struct ImgSpecs &specs)
 
   ParseHeader(input,specs);
   for(i = 0;i < m_usElements;i++) {
-    ParseElement(input,m_Elements + i);
+    if (!m_Elements[i].m_bMapped)
+      ParseElement(input,m_Elements + i);
   }
 }
 ///
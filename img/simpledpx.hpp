@@ -36,6 +36,10 @@ and conversion framework.
 #include "std/string.hpp"
 ///
 
+/// Forwards
+class MemoryMap;
+///
+
 /// class SimpleDPX
 // This class saves and loads images in the dpx format. DPX is a SMTPE specification
 // for mostly uncompressed frames.
@@ -196,6 +200,9 @@ class SimpleDPX : public ImageLayout {
     // Set in case Runlength-coding is used.
     bool  m_bRLE;
     //
+    // Set in case the samples are used in place from the file.
+    bool  m_bMapped;
+    //
     // End of line padding. This is the number of bytes added to the end of
     // each line to pad to a given multiple of bytes.
     ULONG m_ulEndOfLinePadding;
@@ -221,7 +228,7 @@ class SimpleDPX : public ImageLayout {
       m_ucSubX(1), m_ucSubY(1),
       m_ucBitDepth(0), m_ucLSBPaddingBits(0), m_ucMSBPaddingBits(0),
       m_ucPackElements(1),
-      m_bSigned(false), m_bFloat(false), m_bRLE(false),
+      m_bSigned(false), m_bFloat(false), m_bRLE(false), m_bMapped(false),
       m_ulEndOfLinePadding(0), m_ulEndOfFramePadding(0), m_ulOffset(0)
     { 
       memset(m_pData,0,sizeof(m_pData));
@@ -266,6 +273,9 @@ class SimpleDPX : public ImageLayout {
     //
   }   m_Elements[8];
   //
+  // If elements are used in place, the mapping of the file.
+  class MemoryMap *m_pMap;
+  //
   //
   // A little helper to make IDs readable.
   static ULONG MakeID(UBYTE c1,UBYTE c2,UBYTE c3,UBYTE c4)
@@ -397,6 +407,11 @@ class SimpleDPX : public ImageLayout {
   // data container.
   void ParseElement(FILE *file,struct ImageElement *el);
   //
+  // Check whether the element holds unpacked 8 or 16 bit samples in the
+  // byte order of the host. If so, return the start of the element in
+  // the mapped file and its row size in bytes, or NULL otherwise.
+  UBYTE *MapElement(FILE *file,struct ImageElement *el,ULONG &bytesperrow);
+  //
   // Write out the target data to the components.
   void WriteElement(FILE *out,struct ImageElement *el);
   //
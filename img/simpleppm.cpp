@@ -29,6 +29,7 @@ and conversion framework.
 /// Includes
 #include "std/stdlib.hpp"
 #include "tools/file.hpp"
+#include "tools/memorymap.hpp"
 #include "simpleppm.hpp"
 #include "imgspecs.hpp"
 ///
@@ -36,7 +37,7 @@ and conversion framework.
 /// SimplePpm::SimplePpm
 // Default constructor.
 SimplePpm::SimplePpm(void)
-  : m_pucImage(NULL), m_pusImage(NULL), m_pfImage(NULL)
+  : m_pucImage(NULL), m_pusImage(NULL), m_pfImage(NULL), m_pMap(NULL)
 {
 }
 ///
@@ -44,7 +45,7 @@ SimplePpm::SimplePpm(void)
 /// SimplePpm::SimplePpm
 // Copy constructor, reference a PPM image.
 SimplePpm::SimplePpm(const class ImageLayout &org)
-  : ImageLayout(org), m_pucImage(NULL), m_pusImage(NULL), m_pfImage(NULL)
+  : ImageLayout(org), m_pucImage(NULL), m_pusImage(NULL), m_pfImage(NULL), m_pMap(NULL)
 {
 }
 ///
@@ -56,6 +57,7 @@ SimplePpm::~SimplePpm(void)
   delete[] m_pucImage;
   delete[] m_pusImage;
   delete[] m_pfImage;
+  delete m_pMap;
 }
 ///
 
@@ -191,6 +193,7 @@ void SimplePpm::LoadImage(const char *basename,struct ImgSpecs &specs)
   bool flt = false; // pfm or ppm?
   bool pfs = false; // pfs or pfm?
   bool bigendian = true; // default is bigendian.
+  UBYTE *mapped = NULL; // samples used in place.
   File file(basename,"rb");
   //
   //
@@ -348,6 +351,32 @@ void SimplePpm::LoadImage(const char *basename,struct ImgSpecs &specs)
     }
   }
   //
+  if (!pfs) {
+    // Skip a single whitespace character.
+    data = Get();
+    // Check for MS-Dos line separator \r\n
+    if (data == '\r') {
+      data = Get();
+      if (data != '\n') {
+	// no MS-Dos separator, MacOs separator! Iek!
+	LastUnDo();
+	data = '\r';
+      }
+    }
+    //
+    // A new line must be found here.
+    if (data != ' ' && data != '\n' && data != '\r' && data != '\t') {
+      PostError("Malformed PPM stream.\n");
+    }
+  }
+  //
+  // Check what to do about the scale.
+  if (flt && specs.AbsoluteRadiance != ImgSpecs::Yes) {
+    // Here keep the scale in the specs, write it out later.
+    specs.RadianceScale = scale;
+    scale = 1.0;
+  }
+  //
   // Now build the component array.
   CreateComponents(m_ulWidth,m_ulHeight,m_usDepth);
   //
@@ -367,9 +396,24 @@ void SimplePpm::LoadImage(const char *basename,struct ImgSpecs &specs)
     }
   }
   //
+  // Raw samples that are stored just as the components describe them
+  // are used in place from a mapping of the file. Words and floats
+  // must be in the byte order of the host for that.
+  if (raw && bits > 1 && scale == 1.0 && (bits <= 8 || bigendian != MemoryMap::isLittleEndian())) {
+    ULONG bytes = (bits <= 8)?(sizeof(UBYTE)):((bits <= 16)?(sizeof(UWORD)):(sizeof(FLOAT)));
+    //
+    m_pMap = new class MemoryMap;
+    if (m_pMap->Map(m_pFile))
+      mapped = m_pMap->RangeOf(UQUAD(ftell(m_pFile)),UQUAD(bytes) * m_ulWidth * m_ulHeight * m_usDepth,bytes);
+    if (mapped == NULL) {
+      delete m_pMap;
+      m_pMap = NULL;
+    }
+  }
+  //
   // The next step depends on whether we are UBYTE or UWORD.
   if (bits == 32) {
-    m_pfImage  = new FLOAT[m_ulWidth * m_ulHeight * m_usDepth];
+    FLOAT *image = (mapped)?((FLOAT *)mapped):(m_pfImage = new FLOAT[m_ulWidth * m_ulHeight * m_usDepth]);
     //
     // Ok, now fill out the components. PFM is interleaved, PFS is separate.
     if (pfs) { 
@@ -377,7 +421,7 @@ void SimplePpm::LoadImage(const char *basename,struct ImgSpecs &specs)
 	m_pComponent[i].m_ucBits          = bits;
 	m_pComponent[i].m_ulBytesPerPixel = 4; 
 	m_pComponent[i].m_ulBytesPerRow   = 4 * m_ulWidth;
-	m_pComponent[i].m_pPtr            = m_pfImage + m_ulWidth * m_ulHeight * i;
+	m_pComponent[i].m_pPtr            = image + m_ulWidth * m_ulHeight * i;
 	m_pComponent[i].m_bFloat          = true;
 	m_pComponent[i].m_bSigned         = true;
       }
@@ -386,61 +430,37 @@ void SimplePpm::LoadImage(const char *basename,struct ImgSpecs &specs)
 	m_pComponent[i].m_ucBits          = bits;
 	m_pComponent[i].m_ulBytesPerPixel = m_usDepth * 4; // Notice the "per byte" indicator!
 	m_pComponent[i].m_ulBytesPerRow   = m_usDepth * 4 * m_ulWidth;
-	m_pComponent[i].m_pPtr            = m_pfImage + i;
+	m_pComponent[i].m_pPtr            = image + i;
 	m_pComponent[i].m_bFloat          = true;
 	m_pComponent[i].m_bSigned         = true;
       }
     }
   } else if (bits > 8) {
-    m_pusImage = new UWORD[m_ulWidth * m_ulHeight * m_usDepth];
+    UWORD *image = (mapped)?((UWORD *)mapped):(m_pusImage = new UWORD[m_ulWidth * m_ulHeight * m_usDepth]);
     //
     // Ok, now fill out the components.
     for(i = 0; i < m_usDepth; i++) {
       m_pComponent[i].m_ucBits          = bits;
       m_pComponent[i].m_ulBytesPerPixel = m_usDepth * 2; // Notice the "per byte" indicator!
       m_pComponent[i].m_ulBytesPerRow   = m_usDepth * 2 * m_ulWidth;
-      m_pComponent[i].m_pPtr            = m_pusImage + i;
+      m_pComponent[i].m_pPtr            = image + i;
     }
   } else {
-    m_pucImage = new UBYTE[m_ulWidth * m_ulHeight * m_usDepth];
+    UBYTE *image = (mapped)?(mapped):(m_pucImage = new UBYTE[m_ulWidth * m_ulHeight * m_usDepth]);
     //
     // Ok, now fill out the components.
     for(i = 0; i < m_usDepth; i++) {
       m_pComponent[i].m_ucBits          = bits;
       m_pComponent[i].m_ulBytesPerPixel = m_usDepth;
       m_pComponent[i].m_ulBytesPerRow   = m_usDepth * m_ulWidth;
-      m_pComponent[i].m_pPtr            = m_pucImage + i;
-    }
-  }
-  //
-  if (!pfs) {
-    // Skip a single whitespace character.
-    data = Get();
-    // Check for MS-Dos line separator \r\n
-    if (data == '\r') {
-      data = Get();
-      if (data != '\n') {
-	// no MS-Dos separator, MacOs separator! Iek!
-	LastUnDo();
-	data = '\r';
-      }
-    }
-    //
-    // A new line must be found here.
-    if (data != ' ' && data != '\n' && data != '\r' && data != '\t') {
-      PostError("Malformed PPM stream.\n");
+      m_pComponent[i].m_pPtr            = image + i;
     }
   }
   //
   // Now read the data, component wise interleaved. Depends on the representation.
-  if (flt) {
-    //
-    // Check what to do about the scale.
-    if (specs.AbsoluteRadiance != ImgSpecs::Yes) {
-      // Here keep the scale in the specs, write it out later.
-      specs.RadianceScale = scale;
-      scale = 1.0;
-    }
+  if (mapped) {
+    // Nothing to read, the samples are used in place.
+  } else if (flt) {
     //
     FLOAT *buffer = m_pfImage; // assumes that the FPU endianness is equal to the integer endianness
     for(y=0;y<m_ulHeight;y++) {
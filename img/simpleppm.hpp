@@ -36,6 +36,7 @@ and conversion framework.
 
 /// Forwards
 struct ImgSpecs;
+class MemoryMap;
 ///
 
 /// SimplePpm
@@ -49,6 +50,10 @@ class SimplePpm : public ImageLayout {
   // This pointer is for floating point images.
   FLOAT *m_pfImage;
   //
+  // If the samples are used in place, the mapping of the file
+  // they are in. The image pointers above are then NULL.
+  class MemoryMap *m_pMap;
+  //
   // For shortcutting: The file we read from/write to.
   FILE  *m_pFile;
   //
@@ -32,6 +32,7 @@ and conversion framework.
 #include "std/stdlib.hpp"
 #include "tools/halffloat.hpp"
 #include "tools/file.hpp"
+#include "tools/memorymap.hpp"
 #include "img/imglayout.hpp"
 #include "img/imgspecs.hpp"
 #include "img/simpleraw.hpp"
@@ -43,7 +44,9 @@ SimpleRaw::SimpleRaw(void)
   : m_pcFilename(NULL), m_pRawList(NULL), 
     m_ulNominalWidth(0), m_ulNominalHeight(0), m_usNominalDepth(0), 
     m_usFields(0), m_bSeparate(false), m_ucBit(0), m_uqBitBuffer(0),
-    m_ulAlignment(0)
+    m_ulAlignment(0), m_pSequence(NULL), m_lFrameSize(0), m_lFileSize(0),
+    m_pMap(NULL), m_pRowFields(NULL), m_ulPixelBytes(0), m_ulPixels(0),
+    m_pucRow(NULL), m_ulRowSize(0)
   
 {
 }
@@ -55,7 +58,9 @@ SimpleRaw::SimpleRaw(const class ImageLayout &org)
   : ImageLayout(org), m_pcFilename(NULL), m_pRawList(NULL), 
     m_ulNominalWidth(0), m_ulNominalHeight(0), m_usNominalDepth(0), 
     m_usFields(0), m_bSeparate(false), m_ucBit(0), m_uqBitBuffer(0),
-    m_ulAlignment(0)
+    m_ulAlignment(0), m_pSequence(NULL), m_lFrameSize(0), m_lFileSize(0),
+    m_pMap(NULL), m_pRowFields(NULL), m_ulPixelBytes(0), m_ulPixels(0),
+    m_pucRow(NULL), m_ulRowSize(0)
 {
 }
 ///
@@ -68,6 +73,13 @@ SimpleRaw::~SimpleRaw(void)
 
   delete[] m_pcFilename;
 
+  if (m_pSequence)
+    fclose(m_pSequence);
+
+  delete m_pMap;
+  delete[] m_pRowFields;
+  delete[] m_pucRow;
+
   while((rl = m_pRawList)) {
     UBYTE *mem = (UBYTE *)rl->m_pPtr;
     m_pRawList = rl->m_pNext;
@@ -516,14 +528,14 @@ UQUAD SimpleRaw::ReadData(FILE *in,UBYTE bitsize,UBYTE packsize,bool littleendia
 }
 ///
 
-/// SimpleRaw::LoadImage
-// Load an image from a level 1 file descriptor, keep it within
-// the internals of this class. The accessor methods below
-// should be used to find out more about this image.
-void SimpleRaw::LoadImage(const char *nameandspecs,struct ImgSpecs &specs)
+/// SimpleRaw::CreateLayout
+// Parse the format specification off the file name and create the
+// component layout and the buffers for a single frame from it.
+void SimpleRaw::CreateLayout(const char *nameandspecs,struct ImgSpecs &specs)
 {
   struct RawLayout *rl;
   bool yuv = false;
+  UQUAD framesize;
   //
   m_ulNominalWidth  = 0;
   m_ulNominalHeight = 0;
@@ -536,13 +548,23 @@ void SimpleRaw::LoadImage(const char *nameandspecs,struct ImgSpecs &specs)
     PostError("image dimensions must be specified when loading a raw image");
     return;
   }
-  File in       = File(m_pcFilename,"rb");
-  m_ucBit       = 0;
-  m_uqBitBuffer = 0;
   //
   // Setup the component of the master layout.
   CreateComponents(m_ulNominalWidth,m_ulNominalHeight,m_usNominalDepth);
   //
+  // Byte-aligned samples in the byte order of the host are used in
+  // place from a mapping of the file instead of being read.
+  framesize = MapLayout(NULL);
+  if (framesize > 0) {
+    File in(m_pcFilename,"rb");
+    //
+    m_pMap = new class MemoryMap;
+    if (!m_pMap->Map(in) || m_pMap->SizeOf() < framesize) {
+      delete m_pMap;
+      m_pMap = NULL;
+    }
+  }
+  //
   //
   for(rl = m_pRawList;rl;rl = rl->m_pNext) {
     if (!rl->m_bIsPadding) {
@@ -587,7 +609,7 @@ void SimpleRaw::LoadImage(const char *nameandspecs,struct ImgSpecs &specs)
       }
       cl->m_ulBytesPerRow   = ULONG(bpp * cl->m_ulWidth);
       rl->m_ulBytesPerRow   = ULONG(bpp * cl->m_ulWidth);
-      if (cl->m_pPtr == NULL) {
+      if (cl->m_pPtr == NULL && m_pMap == NULL) {
 	cl->m_pPtr          = new UBYTE[bpp * cl->m_ulWidth * cl->m_ulHeight];
 	rl->m_pPtr          = cl->m_pPtr;
       }
@@ -595,11 +617,18 @@ void SimpleRaw::LoadImage(const char *nameandspecs,struct ImgSpecs &specs)
     }
   }
   //
+  if (m_pMap)
+    MapLayout(m_pMap->DataOf());
+  //
   for(UWORD i = 0;i < m_usNominalDepth;i++) {
     if (m_pComponent[i].m_pPtr == NULL)
       PostError("The raw format specification did not include definitions for all channels");
   }
   //
+  // Layouts that are not used in place are read row by row if possible.
+  if (m_pMap == NULL)
+    CompileRows();
+  //
   // Make a best guess whether this is yuv.
   if (m_usNominalDepth >= 3 && 
       (m_pComponent[1].m_ucSubX > m_pComponent[0].m_ucSubX ||
@@ -615,6 +644,23 @@ void SimpleRaw::LoadImage(const char *nameandspecs,struct ImgSpecs &specs)
   // Insert the yuv flag into the specs, unless the user knows any better
   if (specs.YUVEncoded == ImgSpecs::Unspecified)
     specs.YUVEncoded  = yuv?(ImgSpecs::Yes):(ImgSpecs::No);
+}
+///
+
+/// SimpleRaw::ReadFrame
+// Read the samples of a single frame from the current file position
+// into the buffers allocated by CreateLayout.
+void SimpleRaw::ReadFrame(FILE *in)
+{
+  struct RawLayout *rl;
+  //
+  if (m_pRowFields) {
+    ReadRows(in);
+    return;
+  }
+  //
+  m_ucBit       = 0;
+  m_uqBitBuffer = 0;
   //
   // Now read the stuff.
   if (m_bSeparate) {
@@ -755,6 +801,420 @@ void SimpleRaw::LoadImage(const char *nameandspecs,struct ImgSpecs &specs)
 }
 ///
 
+/// SimpleRaw::MapLayout
+// Return the size of a frame in bytes if the file layout can be
+// described by the components directly, i.e. all fields are unpacked
+// 8, 16 or 32 bit samples in the byte order of the host, each channel
+// is present exactly once and all samples are naturally aligned.
+// Returns zero otherwise. If a frame is given, the components are
+// pointed into it.
+UQUAD SimpleRaw::MapLayout(UBYTE *frame)
+{
+  struct RawLayout *rl;
+  UQUAD offset = 0;
+  ULONG align  = 1;
+  UWORD fields = 0;
+  //
+  for(rl = m_pRawList;rl;rl = rl->m_pNext) {
+    ULONG size = rl->m_ucBits >> 3;
+    //
+    if (rl->m_ucBitsPacked || rl->m_bStartPacking)
+      return 0;
+    if (rl->m_ucBits != 8 && rl->m_ucBits != 16 && rl->m_ucBits != 32)
+      return 0;
+    if (rl->m_bFloat && rl->m_ucBits == 16)
+      return 0; // half-floats are converted on reading.
+    //
+    // Separate planes assemble their samples in bit-order, which
+    // is little endian for left-aligned fields.
+    if (size > 1) {
+      bool little = (m_bSeparate)?(rl->m_bLefty):(rl->m_bLittleEndian);
+      if (little != MemoryMap::isLittleEndian())
+	return 0;
+    }
+    if (offset % size)
+      return 0;
+    if (size > align)
+      align = size;
+    if (!rl->m_bIsPadding)
+      fields++;
+    //
+    if (m_bSeparate) {
+      ULONG width  = (rl->m_ulWidth  + rl->m_ucSubX - 1) / (rl->m_ucSubX);
+      ULONG height = (rl->m_ulHeight + rl->m_ucSubY - 1) / (rl->m_ucSubY);
+      ULONG row    = width * size;
+      //
+      if (m_ulAlignment)
+	row = (row + m_ulAlignment - 1) / m_ulAlignment * m_ulAlignment;
+      if (row % size)
+	return 0;
+      if (frame && !rl->m_bIsPadding) {
+	struct ComponentLayout *cl = m_pComponent + rl->m_usTargetChannel;
+	cl->m_pPtr            = frame + offset;
+	cl->m_ulBytesPerPixel = size;
+	cl->m_ulBytesPerRow   = row;
+      }
+      offset += UQUAD(row) * height;
+    } else {
+      if (frame && !rl->m_bIsPadding)
+	m_pComponent[rl->m_usTargetChannel].m_pPtr = frame + offset;
+      offset += size;
+    }
+  }
+  //
+  // Channels that appear more than once are not mappable.
+  if (fields != m_usNominalDepth)
+    return 0;
+  //
+  if (!m_bSeparate) {
+    ULONG pixel = ULONG(offset);
+    ULONG row   = pixel * m_ulNominalWidth;
+    //
+    if (m_ulAlignment)
+      row = (row + m_ulAlignment - 1) / m_ulAlignment * m_ulAlignment;
+    if (pixel % align || row % align)
+      return 0;
+    if (frame) {
+      for(rl = m_pRawList;rl;rl = rl->m_pNext) {
+	if (!rl->m_bIsPadding) {
+	  struct ComponentLayout *cl = m_pComponent + rl->m_usTargetChannel;
+	  cl->m_ulBytesPerPixel = pixel;
+	  cl->m_ulBytesPerRow   = row;
+	}
+      }
+    }
+    offset = UQUAD(row) * m_ulNominalHeight;
+  }
+  //
+  // Frames must keep the alignment in sequences.
+  if (offset % align)
+    return 0;
+  //
+  return offset;
+}
+///
+
+/// SimpleRaw::CompileRows
+// Compile the fields for reading complete rows. This covers all layouts
+// whose fields are either whole bytes or packed into units of up to 32
+// bits, e.g. 8 and 16 bit samples in either byte order, planar 4:2:0
+// and 4:2:2, or v210. Returns false if the layout requires reading bit
+// by bit.
+bool SimpleRaw::CompileRows(void)
+{
+  struct RawLayout *rl;
+  struct RowField *rf,*end;
+  ULONG offset  = 0;
+  ULONG rowsize = 0;
+  UBYTE used    = 0;
+  //
+  assert(m_pRowFields == NULL);
+  m_pRowFields = rf = new struct RowField[m_usFields];
+  end          = m_pRowFields + m_usFields;
+  //
+  for(rl = m_pRawList;rl;rl = rl->m_pNext,rf++) {
+    bool first = (rl->m_ucBitsPacked == 0 || rl->m_bStartPacking);
+    //
+    // Half-floats are converted, larger fields do not fit into units.
+    if ((rl->m_bFloat && rl->m_ucBits != 32) || rl->m_ucBits > 32)
+      break;
+    //
+    rf->m_pComponent = (rl->m_bIsPadding)?(NULL):(m_pComponent + rl->m_usTargetChannel);
+    rf->m_bFirst     = first;
+    rf->m_ucBits     = rl->m_ucBits;
+    rf->m_usRepeat   = 1;
+    rf->m_usIndex    = 0;
+    rf->m_ulWidth    = (rl->m_ulWidth  + rl->m_ucSubX - 1) / (rl->m_ucSubX);
+    rf->m_ulHeight   = (rl->m_ulHeight + rl->m_ucSubY - 1) / (rl->m_ucSubY);
+    //
+    if (rl->m_ucBitsPacked) {
+      // Packed fields are cut from a unit read in the given byte
+      // order, starting at the MSB, or at the LSB for left-aligned
+      // fields.
+      if (rl->m_ucBitsPacked > 32)
+	break;
+      if (first)
+	used = 0;
+      rf->m_ucUnit        = rl->m_ucBitsPacked >> 3;
+      rf->m_bLittleEndian = rl->m_bLittleEndian;
+      rf->m_bSigned       = rl->m_bSigned;
+      rf->m_ucShift       = (rl->m_bLefty)?(used):(rl->m_ucBitsPacked - used - rl->m_ucBits);
+      used               += rl->m_ucBits;
+    } else {
+      // Unpacked fields must cover whole bytes. Separate planes
+      // assemble them bit by bit, which is little endian for
+      // left-aligned fields, and sign-extend them.
+      if (rl->m_ucBits & 7)
+	break;
+      rf->m_ucUnit        = rl->m_ucBits >> 3;
+      rf->m_bLittleEndian = (m_bSeparate)?(rl->m_bLefty):(rl->m_bLittleEndian);
+      rf->m_bSigned       = (m_bSeparate)?(rl->m_bSigned):(false);
+      rf->m_ucShift       = 0;
+    }
+    //
+    if (m_bSeparate) {
+      rf->m_ulOffset = 0;
+      if (rf->m_ulWidth * rf->m_ucUnit > rowsize)
+	rowsize = rf->m_ulWidth * rf->m_ucUnit;
+    } else if (first) {
+      rf->m_ulOffset = offset;
+      offset        += rf->m_ucUnit;
+    } else {
+      rf->m_ulOffset = rf[-1].m_ulOffset;
+    }
+  }
+  //
+  if (rl) {
+    delete[] m_pRowFields;
+    m_pRowFields = NULL;
+    return false;
+  }
+  //
+  if (!m_bSeparate) {
+    // Channels may appear several times in a pixel, e.g. luma in v210.
+    // Rows extend until all channels are complete.
+    m_ulPixelBytes = offset;
+    m_ulPixels     = 0;
+    for(rf = m_pRowFields;rf < end;rf++) {
+      if (rf->m_pComponent) {
+	const struct RowField *rg;
+	ULONG pixels;
+	rf->m_usRepeat = 0;
+	for(rg = m_pRowFields;rg < end;rg++) {
+	  if (rg->m_pComponent == rf->m_pComponent) {
+	    if (rg < rf)
+	      rf->m_usIndex++;
+	    rf->m_usRepeat++;
+	  }
+	}
+	pixels = (rf->m_pComponent->m_ulWidth + rf->m_usRepeat - 1) / rf->m_usRepeat;
+	if (pixels > m_ulPixels)
+	  m_ulPixels = pixels;
+      }
+    }
+    rowsize = m_ulPixels * m_ulPixelBytes;
+  }
+  //
+  if (m_ulAlignment)
+    rowsize = (rowsize + m_ulAlignment - 1) / m_ulAlignment * m_ulAlignment;
+  //
+  m_pucRow    = new UBYTE[rowsize];
+  m_ulRowSize = rowsize;
+  //
+  return true;
+}
+///
+
+/// SimpleRaw::ReadRow
+// Read a row of the given size from the file into the row buffer,
+// along with the padding up to the next alignment boundary.
+void SimpleRaw::ReadRow(FILE *in,ULONG bytes)
+{
+  ULONG size = bytes;
+  //
+  if (m_ulAlignment)
+    size = (bytes + m_ulAlignment - 1) / m_ulAlignment * m_ulAlignment;
+  assert(size <= m_ulRowSize);
+  //
+  // The padding of the last row may be missing.
+  if (fread(m_pucRow,sizeof(UBYTE),size,in) < bytes)
+    PostError("unexpected EOF while reading %s",m_pcFilename);
+}
+///
+
+/// SimpleRaw::UnpackField
+// Extract count samples of the given field from units stride bytes
+// apart, and store them as T dststride bytes apart.
+template<typename T>
+void SimpleRaw::UnpackField(const struct RowField *rf,const UBYTE *src,ULONG stride,
+			    UBYTE *dst,ULONG dststride,ULONG count)
+{
+  UBYTE unit = rf->m_ucUnit;
+  ULONG mask = (rf->m_ucBits >= 32)?(MAX_ULONG):((1UL << rf->m_ucBits) - 1);
+  ULONG sign = (rf->m_bSigned)?(1UL << (rf->m_ucBits - 1)):(0);
+  //
+  if (unit == sizeof(T) && rf->m_ucBits == (unit << 3)) {
+    // Whole samples, only the byte order may differ.
+    if (unit == 1 || rf->m_bLittleEndian == MemoryMap::isLittleEndian()) {
+      if (stride == sizeof(T) && dststride == sizeof(T)) {
+	memcpy(dst,src,count * sizeof(T));
+      } else {
+	while(count--) {
+	  memcpy(dst,src,sizeof(T));
+	  src += stride;
+	  dst += dststride;
+	}
+      }
+    } else {
+      // Swap bytes. Only words and longs get here.
+      while(count--) {
+	ULONG v = 0;
+	UBYTE i;
+	if (rf->m_bLittleEndian) {
+	  for(i = sizeof(T);i > 0;i--)
+	    v = (v << 8) | src[i - 1];
+	} else {
+	  for(i = 0;i < sizeof(T);i++)
+	    v = (v << 8) | src[i];
+	}
+	*(T *)dst = T(v);
+	src += stride;
+	dst += dststride;
+      }
+    }
+    return;
+  }
+  //
+  while(count--) {
+    ULONG v = 0;
+    UBYTE i;
+    if (rf->m_bLittleEndian) {
+      for(i = unit;i > 0;i--)
+	v = (v << 8) | src[i - 1];
+    } else {
+      for(i = 0;i < unit;i++)
+	v = (v << 8) | src[i];
+    }
+    v = (v >> rf->m_ucShift) & mask;
+    if (v & sign)
+      v |= ~mask;
+    *(T *)dst = T(v);
+    src += stride;
+    dst += dststride;
+  }
+}
+///
+
+/// SimpleRaw::ReadRows
+// Read the samples of a single frame row by row through the compiled
+// fields.
+void SimpleRaw::ReadRows(FILE *in)
+{
+  const struct RowField *rf,*last;
+  const struct RowField *end = m_pRowFields + m_usFields;
+  ULONG y;
+  //
+  for(rf = m_pRowFields;rf < end;rf = last) {
+    ULONG height = m_ulHeight;
+    ULONG bytes  = m_ulPixels * m_ulPixelBytes;
+    //
+    // Separate planes are read one after another, interleaved rows
+    // hold all fields.
+    if (m_bSeparate) {
+      for(last = rf + 1;last < end && !last->m_bFirst;last++) {
+      }
+      height = rf->m_ulHeight;
+      bytes  = rf->m_ulWidth * rf->m_ucUnit;
+    } else {
+      last   = end;
+    }
+    //
+    for(y = 0;y < height;y++) {
+      const struct RowField *f;
+      ReadRow(in,bytes);
+      for(f = rf;f < last;f++) {
+	struct ComponentLayout *cl = f->m_pComponent;
+	if (cl && f->m_usIndex < cl->m_ulWidth) {
+	  const UBYTE *src = m_pucRow + f->m_ulOffset;
+	  UBYTE *dst       = (UBYTE *)cl->m_pPtr + y * cl->m_ulBytesPerRow + f->m_usIndex * cl->m_ulBytesPerPixel;
+	  ULONG stride     = (m_bSeparate)?(f->m_ucUnit):(m_ulPixelBytes);
+	  ULONG dststride  = f->m_usRepeat * cl->m_ulBytesPerPixel;
+	  ULONG count      = (cl->m_ulWidth - f->m_usIndex + f->m_usRepeat - 1) / f->m_usRepeat;
+	  //
+	  if (f->m_ucBits <= 8) {
+	    UnpackField<UBYTE>(f,src,stride,dst,dststride,count);
+	  } else if (f->m_ucBits <= 16) {
+	    UnpackField<UWORD>(f,src,stride,dst,dststride,count);
+	  } else {
+	    UnpackField<ULONG>(f,src,stride,dst,dststride,count);
+	  }
+	}
+      }
+    }
+  }
+}
+///
+
+/// SimpleRaw::LoadImage
+// Load an image from a level 1 file descriptor, keep it within
+// the internals of this class. The accessor methods below
+// should be used to find out more about this image.
+void SimpleRaw::LoadImage(const char *nameandspecs,struct ImgSpecs &specs)
+{
+  CreateLayout(nameandspecs,specs);
+  //
+  if (m_pMap == NULL) {
+    File in = File(m_pcFilename,"rb");
+    ReadFrame(in);
+  }
+}
+///
+
+/// SimpleRaw::OpenSequence
+// Open a file containing a sequence of frames of identical layout.
+// The format is parsed and the frame buffers are allocated only once
+// here, frames are then read by LoadFrame into the same buffers.
+void SimpleRaw::OpenSequence(const char *nameandspecs,struct ImgSpecs &specs)
+{
+  CreateLayout(nameandspecs,specs);
+  //
+  if (m_pMap) {
+    // All frames are in the mapping already.
+    m_lFrameSize = long(MapLayout(NULL));
+    m_lFileSize  = long(m_pMap->SizeOf());
+    return;
+  }
+  //
+  assert(m_pSequence == NULL);
+  m_pSequence = fopen(m_pcFilename,"rb");
+  if (m_pSequence == NULL)
+    PostError("unable to open %s",m_pcFilename);
+  //
+  if (fseek(m_pSequence,0,SEEK_END) != 0 || (m_lFileSize = ftell(m_pSequence)) < 0)
+    PostError("unable to find the size of %s",m_pcFilename);
+  m_lFrameSize = 0;
+}
+///
+
+/// SimpleRaw::LoadFrame
+// Load the given frame of the sequence opened by OpenSequence.
+// Returns false if the file ends before this frame.
+bool SimpleRaw::LoadFrame(ULONG frame)
+{
+  if (m_pMap) {
+    if (m_lFileSize / m_lFrameSize <= long(frame))
+      return false;
+    MapLayout(m_pMap->DataOf() + UQUAD(frame) * m_lFrameSize);
+    return true;
+  }
+  //
+  assert(m_pSequence);
+  //
+  if (m_lFrameSize == 0) {
+    // The size of a frame is only known after reading one due to
+    // packing and alignment, so read the first frame to find it.
+    if (m_lFileSize == 0)
+      return false;
+    fseek(m_pSequence,0,SEEK_SET);
+    ReadFrame(m_pSequence);
+    m_lFrameSize = ftell(m_pSequence);
+    if (m_lFrameSize <= 0)
+      PostError("invalid frame size in %s",m_pcFilename);
+    if (frame == 0)
+      return true;
+  }
+  //
+  if (m_lFileSize / m_lFrameSize <= long(frame))
+    return false;
+  //
+  if (fseek(m_pSequence,long(frame) * m_lFrameSize,SEEK_SET) != 0)
+    PostError("unable to seek to frame %lu of %s",(unsigned long)frame,m_pcFilename);
+  ReadFrame(m_pSequence);
+  //
+  return true;
+}
+///
+
 /// SimpleRaw::BitAlignOut
 // On writing, flush to the next byte boundary.
 void SimpleRaw::BitAlignOut(FILE *out,UBYTE packsize,bool littleendian,bool lefty)
@@ -875,6 +1335,7 @@ void SimpleRaw::SaveImage(const char *nameandspecs,const struct ImgSpecs &)
     }
   }
   //
+  MemoryMap::DetachFile(m_pcFilename);
   File out      = File(m_pcFilename,"wb");
   m_ucBit       = 0;
   m_uqBitBuffer = 0;
@@ -31,9 +31,14 @@ and conversion framework.
 
 /// Includes
 #include "interface/types.hpp"
+#include "std/stdio.hpp"
 #include "img/imglayout.hpp"
 ///
 
+/// Forwards
+class MemoryMap;
+///
+
 /// class SimpleRaw
 // This class saves and loads images in any format. To specify the format, use the file
 // name. That is:
@@ -147,6 +152,94 @@ class SimpleRaw : public ImageLayout {
   // alignment.
   ULONG m_ulAlignment;
   //
+  // The file frames are read from in sequence mode.
+  FILE *m_pSequence;
+  //
+  // Size of a frame and of the complete file in bytes. The frame size
+  // is zero until the first frame has been read.
+  long  m_lFrameSize;
+  long  m_lFileSize;
+  //
+  // If the samples are used in place, the mapping of the file.
+  // The buffers of the raw layouts are then NULL.
+  class MemoryMap *m_pMap;
+  //
+  // Return the size of a frame in bytes if all fields are byte-aligned
+  // samples in the byte order of the host such that the components can
+  // describe the file layout directly, zero otherwise. If a frame is
+  // given, point the components into it.
+  UQUAD MapLayout(UBYTE *frame);
+  //
+  // A field of the file layout compiled for reading complete rows.
+  // Fields are extracted from units of up to four bytes.
+  struct RowField {
+    //
+    // The target component, or NULL for padding fields.
+    struct ComponentLayout *m_pComponent;
+    //
+    // Offset of the unit within a pixel in bytes, for interleaved
+    // layouts. Separate layouts start a new plane at each unit.
+    ULONG  m_ulOffset;
+    //
+    // Size of the unit in bytes, and its byte order.
+    UBYTE  m_ucUnit;
+    bool   m_bLittleEndian;
+    //
+    // True if this field starts a new unit.
+    bool   m_bFirst;
+    //
+    // Position of the LSB of the field within the unit and its size.
+    UBYTE  m_ucShift;
+    UBYTE  m_ucBits;
+    //
+    // True if the field is sign-extended on reading.
+    bool   m_bSigned;
+    //
+    // For interleaved layouts: the number of times the target channel
+    // appears in a pixel, and the index of this appearance. The field
+    // goes to position pixel * m_usRepeat + m_usIndex of the row.
+    UWORD  m_usRepeat;
+    UWORD  m_usIndex;
+    //
+    // For separate layouts: the dimensions of the plane.
+    ULONG  m_ulWidth;
+    ULONG  m_ulHeight;
+  }    *m_pRowFields;
+  //
+  // For interleaved layouts, the size of a pixel in bytes and the
+  // number of pixels in a row.
+  ULONG  m_ulPixelBytes;
+  ULONG  m_ulPixels;
+  //
+  // Buffer for a row of the file, including the alignment.
+  UBYTE *m_pucRow;
+  ULONG  m_ulRowSize;
+  //
+  // Compile the fields for reading complete rows. Returns false if the
+  // layout requires reading bit by bit.
+  bool CompileRows(void);
+  //
+  // Read a row of the given size and alignment padding from the file
+  // into the row buffer.
+  void ReadRow(FILE *in,ULONG bytes);
+  //
+  // Read the samples of a single frame row by row through the compiled
+  // fields.
+  void ReadRows(FILE *in);
+  //
+  // Extract count samples of the given field from units stride bytes
+  // apart, and store them as T dststride bytes apart.
+  template<typename T>
+  static void UnpackField(const struct RowField *rf,const UBYTE *src,ULONG stride,
+			  UBYTE *dst,ULONG dststride,ULONG count);
+  //
+  // Parse the format specification and create the component layout
+  // and the buffers for a single frame.
+  void CreateLayout(const char *nameandspecs,struct ImgSpecs &specs);
+  //
+  // Read the samples of a single frame from the current file position.
+  void ReadFrame(FILE *in);
+  //
   // Read a single pixel from the specified file.
   UQUAD ReadData(FILE *in,UBYTE bitsize,UBYTE packsize,
 		 bool littleendian,bool issigned,bool lefty,bool chunk);
@@ -182,6 +275,14 @@ public:
   // should be used to find out more about this image.
   void LoadImage(const char *nameandspecs,struct ImgSpecs &specs);
   //
+  // Open a file containing a sequence of frames of the given format.
+  // The format is parsed and the frame buffers are allocated only once.
+  void OpenSequence(const char *nameandspecs,struct ImgSpecs &specs);
+  //
+  // Load the given frame of the sequence into the frame buffers.
+  // Returns false if the file ends before this frame.
+  bool LoadFrame(ULONG frame);
+  //
 };
 ///
 
@@ -34,19 +34,25 @@ and conversion framework.
 #include "std/stdio.hpp"
 #include "tools/file.hpp"
 #include "tools/halffloat.hpp"
+#include "tools/memorymap.hpp"
 #include "tiff/tiffparser.hpp"
 #include "tiff/tiffwriter.hpp"
 #include "tiff/tifftags.hpp"
 #include "tiff/lzwdecoder.hpp"
 #include "tiff/packbitsdecoder.hpp"
+#include "tiff/deflatedecoder.hpp"
 #include "tiff/trivialdecoder.hpp"
+#include "tiff/lzwencoder.hpp"
+#include "tiff/packbitsencoder.hpp"
+#include "tiff/deflateencoder.hpp"
 #include "img/imgspecs.hpp"
 ///
 
 /// SimpleTiff::SimpleTiff
 // default constructor
 SimpleTiff::SimpleTiff(void)
-  : m_ppComponents(NULL), m_usCount(0)
+  : m_ppComponents(NULL), m_usCount(0), m_pMap(NULL), m_pPool(NULL),
+    m_pCoding(NULL), m_pUnits(NULL), m_pWriter(NULL)
 {
 }
 ///
@@ -55,7 +61,8 @@ SimpleTiff::SimpleTiff(void)
 // copy the layout and reference from a
 // different layout.
 SimpleTiff::SimpleTiff(const class ImageLayout &layout)
-  : ImageLayout(layout), m_ppComponents(NULL), m_usCount(0)
+  : ImageLayout(layout), m_ppComponents(NULL), m_usCount(0), m_pMap(NULL), m_pPool(NULL),
+    m_pCoding(NULL), m_pUnits(NULL), m_pWriter(NULL)
 {
 }
 ///
@@ -73,18 +80,22 @@ SimpleTiff::~SimpleTiff(void)
 
     delete[] m_ppComponents;
   }
+
+  delete m_pMap;
 }
 ///
 
 /// SimpleTiff::SaveImage
 // Save an image to a level 1 file descriptor, given its
 // width, height and depth. We only support grey level and
-// RGB here, no palette images.
+// RGB here, no palette images. Strips are compressed in
+// batches, on the threads of the pool if there is one, and
+// written as soon as the batch is complete. As their sizes
+// are only known then, the IFD follows the image data. Images
+// that could exceed 4GB are written as BigTIFF.
 void SimpleTiff::SaveImage(const char *filename,const struct ImgSpecs &specs)
 {
-  UBYTE *buffer = 0;
-  UWORD comp,comq,t;
-  ULONG x,y;
+  UWORD comp;
   ULONG w   = WidthOf();
   ULONG h   = HeightOf();
   UWORD d   = DepthOf();
@@ -95,7 +106,13 @@ void SimpleTiff::SaveImage(const char *filename,const struct ImgSpecs &specs)
   bool  ycc      = false;
   bool  separate = false;
   bool  isfloat  = false;
+  bool  bigtiff  = false;
   ULONG bytesperrow;
+  ULONG rps,spp,count,batch,first,i;
+  UQUAD bound;
+  UWORD planes,p;
+  struct TiffCoding coding;
+  struct TiffUnit *units;
   
   for(comp = 0;comp < d;comp++) {
     if (isFloat(comp))
@@ -134,12 +151,59 @@ void SimpleTiff::SaveImage(const char *filename,const struct ImgSpecs &specs)
     separate = true;
   }
 
-  class TiffWriter writer(filename,(specs.LittleEndian == ImgSpecs::No)?(true):(false));
+  //
+  // Classic TIFF addresses at most 4GB. Unless specified otherwise,
+  // write a BigTIFF if the strips could come close to this limit,
+  // allowing for the expansion of incompressible data by the coders.
+  if (specs.BigTIFF == ImgSpecs::Unspecified) {
+    bound = (UQUAD(bpp) * w / 8 + d) * h;
+    if (specs.Compression != ImgSpecs::Uncompressed)
+      bound += bound >> 1;
+    bigtiff = bound > MAX_ULONG - (1UL << 24);
+  } else {
+    bigtiff = specs.BigTIFF == ImgSpecs::Yes;
+  }
+
+  class TiffWriter writer(filename,(specs.LittleEndian == ImgSpecs::No)?(true):(false),bigtiff);
+
+  switch(specs.Compression) {
+  case ImgSpecs::LZW:
+    coding.m_iCompression = TiffTag::Compression::LZW;
+    break;
+  case ImgSpecs::PackBits:
+    coding.m_iCompression = TiffTag::Compression::PACKBITS;
+    break;
+  case ImgSpecs::Deflate:
+    coding.m_iCompression = TiffTag::Compression::DEFLATE;
+    break;
+  default:
+    coding.m_iCompression = TiffTag::Compression::NONE;
+    break;
+  }
+  //
+  // Horizontal differences are only formed for integer samples of
+  // identical depths, and only for the compressions that define them.
+  coding.m_bPrediction    = specs.Prediction == ImgSpecs::Yes && !isfloat &&
+    (bps == 8 || bps == 16 || bps == 32) &&
+    (coding.m_iCompression == TiffTag::Compression::LZW ||
+     coding.m_iCompression == TiffTag::Compression::DEFLATE);
+  coding.m_bBigEndian     = (specs.LittleEndian == ImgSpecs::No)?(true):(false);
+  coding.m_ulInvert       = 0;
+  coding.m_ucBits         = bps;
+  coding.m_pulBits        = NULL;
+  coding.m_pulFormat      = NULL;
+  coding.m_pulRed         = NULL;
+  coding.m_pulGreen       = NULL;
+  coding.m_pulBlue        = NULL;
+  coding.m_ucSubX         = sx;
+  coding.m_ucSubY         = sy;
+  coding.m_dScale         = 1.0;
 
-  writer.DefineScalarTag(TiffTag::COMPRESSION,TiffTag::Compression::NONE);
+  writer.DefineScalarTag(TiffTag::COMPRESSION,coding.m_iCompression);
+  if (coding.m_bPrediction)
+    writer.DefineScalarTag(TiffTag::PREDICTOR,TiffTag::Predictor::HDIFF);
   writer.DefineScalarTag(TiffTag::IMAGEWIDTH,w);
   writer.DefineScalarTag(TiffTag::IMAGELENGTH,h);
-  writer.DefineScalarTag(TiffTag::ROWSPERSTRIP,h); // one strip is enough.
   writer.DefineScalarTag(TiffTag::SAMPLESPERPIXEL,d);
 
   if (isfloat && specs.RadianceScale != 1.0) {
@@ -188,7 +252,6 @@ void SimpleTiff::SaveImage(const char *filename,const struct ImgSpecs &specs)
   
   void *bpt = writer.DefineTag(TiffTag::BITSPERSAMPLE,3,d);
   void *fmt = writer.DefineTag(TiffTag::SAMPLEFORMAT,3,d);
-  void *ofs = writer.DefineTag(TiffTag::STRIPOFFSETS,4,(separate)?(d):(1));
 
   for(comp = 0;comp < d;comp++) {
     if (isFloat(comp)) {
@@ -202,147 +265,279 @@ void SimpleTiff::SaveImage(const char *filename,const struct ImgSpecs &specs)
   }
 
   if (separate) {
-    void *bcn    = writer.DefineTag(TiffTag::STRIPBYTECOUNTS,4,d);
     writer.DefineScalarTag(TiffTag::PLANARCONFIG,TiffTag::Planarconfig::SEPARATE);
-    ULONG offset = writer.LayoutTags();
-    for (comp = 0;comp < d;comp++) {
-      if (comp == 1 || comp == 2) {
-	bytesperrow  = (BitsOf(comp)  * ((w + sx - 1) / sx) + 7) >> 3;
-	bytesperrow *= (h + sy - 1) / sy;
+    coding.m_usPlanarConfig = TiffTag::Planarconfig::SEPARATE;
+    bytesperrow = ((BitsOf(0) * w) + 7) >> 3;
+    planes      = d;
+  } else {
+    writer.DefineScalarTag(TiffTag::PLANARCONFIG,TiffTag::Planarconfig::CONTIG);
+    coding.m_usPlanarConfig = TiffTag::Planarconfig::CONTIG;
+    bytesperrow = ((bpp * w) + 7) >> 3;
+    planes      = 1;
+  }
+  //
+  // Strips of about StripSize bytes unless specified otherwise. The
+  // strips of subsampled planes cover the rows of the full-resolution
+  // planes, hence must consist of complete subsampled rows.
+  rps = specs.RowsPerStrip;
+  if (rps == 0)
+    rps = (bytesperrow > 0)?(StripSize / bytesperrow):(h);
+  if (rps == 0)
+    rps = 1;
+  if (rps % sy)
+    rps += sy - rps % sy;
+  if (rps > h && h > 0)
+    rps = h;
+  spp   = (h + rps - 1) / rps;
+  count = spp * planes;
+  writer.DefineScalarTag(TiffTag::ROWSPERSTRIP,rps);
+  void *ofs = writer.DefineOffsetTag(TiffTag::STRIPOFFSETS,count);
+  void *bcn = writer.DefineOffsetTag(TiffTag::STRIPBYTECOUNTS,count);
+  //
+  units = new struct TiffUnit[count];
+  for(p = 0,i = 0;p < planes;p++) {
+    ULONG s;
+    for(s = 0;s < spp;s++,i++) {
+      ULONG y    = s * rps;
+      ULONG rows = (h - y < rps)?(h - y):(rps);
+      units[i].m_pucData = NULL;
+      units[i].m_ulBytes = 0;
+      units[i].m_usComp  = p;
+      units[i].m_ulX     = 0;
+      if (separate && (p == 1 || p == 2)) {
+	units[i].m_ulY      = y / sy;
+	units[i].m_ulWidth  = (w    + sx - 1) / sx;
+	units[i].m_ulHeight = (rows + sy - 1) / sy;
       } else {
-	bytesperrow  = ((BitsOf(comp) * w) + 7) >> 3;
-	bytesperrow *= h;
+	units[i].m_ulY      = y;
+	units[i].m_ulWidth  = w;
+	units[i].m_ulHeight = rows;
       }
-      writer.DefineTagValue(bcn,comp,bytesperrow);
-      writer.DefineTagValue(ofs,comp,offset);
-      if (offset + bytesperrow < offset)
-	throw "TIFF image growing too large";
-      offset += bytesperrow;
     }
+  }
+  //
+  // Without threads, one strip at a time is kept in memory.
+  if (m_pPool && m_pPool->ThreadsOf() > 1) {
+    batch = m_pPool->ThreadsOf() << 2;
   } else {
-    bytesperrow = ((bpp * w) + 7) >> 3;
-    writer.DefineScalarTag(TiffTag::PLANARCONFIG,TiffTag::Planarconfig::CONTIG);
-    writer.DefineScalarTag(TiffTag::STRIPBYTECOUNTS,h * bytesperrow);
-    writer.DefineTagValue(ofs,0,writer.LayoutTags());
+    batch = 1;
   }
-  
-  // Tags are now complete. Now write the IFD.
-  writer.WriteIFD();
+  //
+  try {
+    for(first = 0;first < count;first += batch) {
+      ULONG n = (count - first < batch)?(count - first):(batch);
+      if (n > 1) {
+	m_pCoding = &coding;
+	m_pUnits  = units + first;
+	m_pWriter = &writer;
+	m_pPool->Dispatch(this,n);
+	m_pCoding = NULL;
+	m_pUnits  = NULL;
+	m_pWriter = NULL;
+      } else {
+	EncodeUnit(coding,writer,units[first]);
+      }
+      for(i = first;i < first + n;i++) {
+	writer.DefineTagValue(ofs,i,writer.WriteStrip(units[i].m_pucData,units[i].m_ulBytes));
+	writer.DefineTagValue(bcn,i,units[i].m_ulBytes);
+	delete[] units[i].m_pucData;
+	units[i].m_pucData = NULL;
+      }
+    }
+    //
+    // Tags are now complete. Now write the IFD.
+    writer.WriteIFD();
+  } catch(...) {
+    m_pCoding = NULL;
+    m_pUnits  = NULL;
+    m_pWriter = NULL;
+    for(i = 0;i < count;i++)
+      delete[] units[i].m_pucData;
+    delete[] units;
+    throw;
+  }
+  delete[] units;
+}
+///
 
-    
-  if (separate) {
-    t = d;
-    d = 1;
+/// SimpleTiff::EncodeUnit
+// Pack and compress a single strip, keep its data in the unit.
+void SimpleTiff::EncodeUnit(const struct TiffCoding &coding,const class TiffWriter &writer,
+			    struct TiffUnit &unit)
+{
+  ULONG bits = 0;
+  ULONG bytesperrow,size;
+  UBYTE *buffer;
+  UWORD comp;
+
+  if (coding.m_usPlanarConfig == TiffTag::Planarconfig::SEPARATE) {
+    bits = BitsOf(unit.m_usComp);
   } else {
-    t = 1;
+    for(comp = 0;comp < DepthOf();comp++)
+      bits += BitsOf(comp);
   }
+  bytesperrow = (bits * unit.m_ulWidth + 7) >> 3;
+  if (unit.m_ulHeight > 0 && bytesperrow > MAX_ULONG / unit.m_ulHeight)
+    throw "TIFF image growing too large";
+  size   = bytesperrow * unit.m_ulHeight;
+  buffer = new UBYTE[size];
 
-  for(comq = 0;comq < t;comq ++) { 
-    
-    if (separate) {
-      if (comq == 1 || comq == 2) {
-	w          = (WidthOf()  + sx - 1) / sx;
-	h          = (HeightOf() + sy - 1) / sy;
-      } else {
-	w          = WidthOf();
-	h          = HeightOf();
+  try {
+    PackUnit(coding,writer,unit,buffer,bytesperrow);
+    switch(coding.m_iCompression) {
+    case TiffTag::Compression::LZW:
+      {
+	class LZWEncoder enc;
+	enc.Encode(buffer,size);
+	unit.m_ulBytes = enc.BytesOf();
+	unit.m_pucData = enc.Detach();
+      }
+      break;
+    case TiffTag::Compression::PACKBITS:
+      {
+	class PackBitsEncoder enc;
+	enc.Encode(buffer,size,bytesperrow);
+	unit.m_ulBytes = enc.BytesOf();
+	unit.m_pucData = enc.Detach();
       }
-      bytesperrow  = (BitsOf(comq)  * w + 7) >> 3;
-      buffer       = writer.GetStripBuffer(bytesperrow * h);
-    } else { 
-      w            = WidthOf();
-      h            = HeightOf();
-      bytesperrow  = ((bpp * w) + 7) >> 3;
-      buffer       = writer.GetStripBuffer(bytesperrow * h);
+      break;
+    case TiffTag::Compression::DEFLATE:
+      {
+	class DeflateEncoder enc;
+	enc.Encode(buffer,size);
+	unit.m_ulBytes = enc.BytesOf();
+	unit.m_pucData = enc.Detach();
+      }
+      break;
+    default:
+      // Uncompressed, the packed samples are the strip.
+      unit.m_ulBytes = size;
+      unit.m_pucData = buffer;
+      buffer         = NULL;
+      break;
     }
+  } catch(...) {
+    delete[] buffer;
+    throw;
+  }
+  delete[] buffer;
+}
+///
+
+/// SimpleTiff::PackUnit
+// Pack the samples of a strip into the buffer as they appear in the
+// file before compression, with rows of the given number of bytes.
+// With prediction, the difference to the sample left of it is packed
+// instead of the sample, except for the first column.
+void SimpleTiff::PackUnit(const struct TiffCoding &coding,const class TiffWriter &writer,
+			  const struct TiffUnit &unit,UBYTE *buffer,ULONG bytesperrow)
+{
+  UWORD comp;
+  UWORD comq  = unit.m_usComp;
+  UWORD d     = (coding.m_usPlanarConfig == TiffTag::Planarconfig::SEPARATE)?(1):(DepthOf());
+  UBYTE bps   = coding.m_ucBits;
+  bool  hdiff = coding.m_bPrediction;
+  ULONG w     = unit.m_ulWidth;
+  ULONG ye    = unit.m_ulY + unit.m_ulHeight;
+  ULONG x,y;
     
-    for(y = 0;y < h;y++) {
-      UBYTE *bptr = buffer;
-      switch(bps) {
-      case 8:
+  for(y = unit.m_ulY;y < ye;y++) {
+    UBYTE *bptr = buffer;
+    switch(bps) {
+    case 8:
+      for(x = 0;x < w;x++) {
+	for(comp = 0;comp < d;comp++) {
+	  struct ComponentLayout *cl = m_pComponent + comp + comq;
+	  const UBYTE *src = ((UBYTE *)cl->m_pPtr) + (cl->m_ulBytesPerRow * y) + (cl->m_ulBytesPerPixel * x);
+	  UBYTE v = *src;
+	  if (hdiff && x > 0)
+	    v -= *(src - cl->m_ulBytesPerPixel);
+	  *bptr = v;
+	  bptr++;
+	}
+      }
+      break;
+    case 16:
+      // Special hack for half-float which is internally represented as FLOAT
+      if (isFloat(0)) {
 	for(x = 0;x < w;x++) {
 	  for(comp = 0;comp < d;comp++) {
 	    struct ComponentLayout *cl = m_pComponent + comp + comq;
-	    *bptr = *(((UBYTE *)cl->m_pPtr) + (cl->m_ulBytesPerRow * y) + (cl->m_ulBytesPerPixel * x));
-	    bptr++;
-	  }
-	}
-	break;
-      case 16:
-	// Special hack for half-float which is internally represented as FLOAT
-	if (isFloat(0)) {
-	  for(x = 0;x < w;x++) {
-	    for(comp = 0;comp < d;comp++) {
-	      struct ComponentLayout *cl = m_pComponent + comp + comq;
-	      writer.PutUWORD(bptr,F2H(*(FLOAT *)(((UBYTE *)cl->m_pPtr)+(cl->m_ulBytesPerRow * y)+(cl->m_ulBytesPerPixel * x))));
-	    }
-	  }
-	} else {
-	  for(x = 0;x < w;x++) {
-	    for(comp = 0;comp < d;comp++) {
-	      struct ComponentLayout *cl = m_pComponent + comp + comq;
-	      writer.PutUWORD(bptr,*(UWORD *)(((UBYTE *)cl->m_pPtr)+(cl->m_ulBytesPerRow * y)+(cl->m_ulBytesPerPixel * x)));
-	    }
+	    writer.PutUWORD(bptr,F2H(*(FLOAT *)(((UBYTE *)cl->m_pPtr)+(cl->m_ulBytesPerRow * y)+(cl->m_ulBytesPerPixel * x))));
 	  }
 	}
-	break;
-      case 32:
+      } else {
 	for(x = 0;x < w;x++) {
 	  for(comp = 0;comp < d;comp++) {
 	    struct ComponentLayout *cl = m_pComponent + comp + comq;
-	    writer.PutULONG(bptr,*(ULONG *)(((UBYTE *)cl->m_pPtr)+(cl->m_ulBytesPerRow * y)+(cl->m_ulBytesPerPixel * x)));
+	    const UBYTE *src = ((UBYTE *)cl->m_pPtr)+(cl->m_ulBytesPerRow * y)+(cl->m_ulBytesPerPixel * x);
+	    UWORD v = *(const UWORD *)src;
+	    if (hdiff && x > 0)
+	      v -= *(const UWORD *)(src - cl->m_ulBytesPerPixel);
+	    writer.PutUWORD(bptr,v);
 	  }
 	}
-	break;
-      case 64:
+      }
+      break;
+    case 32:
+      for(x = 0;x < w;x++) {
+	for(comp = 0;comp < d;comp++) {
+	  struct ComponentLayout *cl = m_pComponent + comp + comq;
+	  const UBYTE *src = ((UBYTE *)cl->m_pPtr)+(cl->m_ulBytesPerRow * y)+(cl->m_ulBytesPerPixel * x);
+	  ULONG v = *(const ULONG *)src;
+	  if (hdiff && x > 0)
+	    v -= *(const ULONG *)(src - cl->m_ulBytesPerPixel);
+	  writer.PutULONG(bptr,v);
+	}
+      }
+      break;
+    case 64:
+      for(x = 0;x < w;x++) {
+	for(comp = 0;comp < d;comp++) {
+	  struct ComponentLayout *cl = m_pComponent + comp + comq;
+	  writer.PutUQUAD(bptr,*(UQUAD *)(((UBYTE *)cl->m_pPtr)+(cl->m_ulBytesPerRow * y)+(cl->m_ulBytesPerPixel * x)));
+	}
+      }
+      break;
+    default: // bit-packing, and bit depths vary.
+      // Bit-packing.
+      memset(buffer,0,bytesperrow);
+      {
+	UBYTE bitpos = 8;
 	for(x = 0;x < w;x++) {
 	  for(comp = 0;comp < d;comp++) {
 	    struct ComponentLayout *cl = m_pComponent + comp + comq;
-	    writer.PutUQUAD(bptr,*(UQUAD *)(((UBYTE *)cl->m_pPtr)+(cl->m_ulBytesPerRow * y)+(cl->m_ulBytesPerPixel * x)));
-	  }
-	}
-	break;
-      default: // bit-packing, and bit depths vary.
-	// Bit-packing.
-	memset(buffer,0,bytesperrow);
-	{
-	  UBYTE bitpos = 8;
-	  for(x = 0;x < w;x++) {
-	    for(comp = 0;comp < d;comp++) {
-	      struct ComponentLayout *cl = m_pComponent + comp + comq;
-	      UBYTE b = BitsOf(comp);
+	    UBYTE b = BitsOf(comp + comq);
 	      
-	      if (b <= 8) {
-		writer.PutBits(bptr,bitpos,b,
-			       *(((UBYTE *)cl->m_pPtr) + (cl->m_ulBytesPerRow * y) + (cl->m_ulBytesPerPixel * x)));
-	      } else if (b < 16) {
-		writer.PutBits(bptr,bitpos,b,
-			       *(UWORD *)(((UBYTE *)cl->m_pPtr) + (cl->m_ulBytesPerRow * y) + (cl->m_ulBytesPerPixel * x)));
-	      } else if (b == 16) {
-		if (isFloat(comp)) {
-		  writer.PutBits(bptr,bitpos,16,
-				 F2H(*(FLOAT *)(((UBYTE *)cl->m_pPtr) + (cl->m_ulBytesPerRow * y) + (cl->m_ulBytesPerPixel * x))));
-		} else {
-		  writer.PutBits(bptr,bitpos,16,
-				 *(UWORD *)(((UBYTE *)cl->m_pPtr) + (cl->m_ulBytesPerRow * y) + (cl->m_ulBytesPerPixel * x)));
-		}
-	      } else if (b <= 32) {
-		writer.PutBits(bptr,bitpos,32,
-			       *(ULONG *)(((UBYTE *)cl->m_pPtr) + (cl->m_ulBytesPerRow * y) + (cl->m_ulBytesPerPixel * x)));
+	    if (b <= 8) {
+	      writer.PutBits(bptr,bitpos,b,
+			     *(((UBYTE *)cl->m_pPtr) + (cl->m_ulBytesPerRow * y) + (cl->m_ulBytesPerPixel * x)));
+	    } else if (b < 16) {
+	      writer.PutBits(bptr,bitpos,b,
+			     *(UWORD *)(((UBYTE *)cl->m_pPtr) + (cl->m_ulBytesPerRow * y) + (cl->m_ulBytesPerPixel * x)));
+	    } else if (b == 16) {
+	      if (isFloat(comp + comq)) {
+		writer.PutBits(bptr,bitpos,16,
+			       F2H(*(FLOAT *)(((UBYTE *)cl->m_pPtr) + (cl->m_ulBytesPerRow * y) + (cl->m_ulBytesPerPixel * x))));
 	      } else {
-		throw "cannot write image files with varying bit depths containing more than 32 bits per pixel, sorry";
+		writer.PutBits(bptr,bitpos,16,
+			       *(UWORD *)(((UBYTE *)cl->m_pPtr) + (cl->m_ulBytesPerRow * y) + (cl->m_ulBytesPerPixel * x)));
 	      }
+	    } else if (b <= 32) {
+	      writer.PutBits(bptr,bitpos,32,
+			     *(ULONG *)(((UBYTE *)cl->m_pPtr) + (cl->m_ulBytesPerRow * y) + (cl->m_ulBytesPerPixel * x)));
+	    } else {
+	      throw "cannot write image files with varying bit depths containing more than 32 bits per pixel, sorry";
 	    }
 	  }
-	  if (bitpos < 8) {
-	    // bitpos = 8; // superflous, done anyhow.
-	    bptr++;
-	  }
+	}
+	if (bitpos < 8) {
+	  // bitpos = 8; // superflous, done anyhow.
+	  bptr++;
 	}
       }
-      buffer += bytesperrow;
     }
-    writer.PushStripBuffer();
+    buffer += bytesperrow;
   }
 }
 ///
@@ -648,168 +843,280 @@ void SimpleTiff::UnpackDataPaletized(UBYTE *buffer,bool bigendian,bool predictio
 }
 ///
 
-/// SimpleTiff::ReadTiled
-// Read tiled data through the tiff interface.
-void SimpleTiff::ReadTiled(class TiffParser &parser,int lzw,bool hdiff,
-			   UWORD imgconfig,
-			   ULONG tw,ULONG th,ULONG inv,
-			   const ULONG *bits,const ULONG *fmt,
-			   const ULONG *rm,const ULONG *gm,const ULONG *bm,
-			   DOUBLE scale)
+/// SimpleTiff::DecodeUnit
+// Decode a single strip or tile into the components.
+void SimpleTiff::DecodeUnit(const struct TiffCoding &coding,const struct TiffUnit &unit)
 {
-  ULONG   tilecount = parser.GetAddressableTiles();
-  ULONG   tile;
-  UWORD   comp      = 0; // current plane = tile.
-  ULONG   x         = 0;
-  ULONG   y         = 0;
-  ULONG   iwidth    = WidthOf();
-  ULONG   iheight   = HeightOf();
-  UWORD   d         = DepthOf();
-  UBYTE   b         = bits[0];
-  UBYTE   sx        = (d > 1)?(m_pComponent[1].m_ucSubX):(1);
-  UBYTE   sy        = (d > 1)?(m_pComponent[1].m_ucSubY):(1);
+  UBYTE *buffer    = unit.m_pucData;
+  ULONG  bytes     = unit.m_ulBytes;
+  bool   bigendian = coding.m_bBigEndian;
+  bool   hdiff     = coding.m_bPrediction;
+  ULONG  inv       = coding.m_ulInvert;
+  DOUBLE scale     = coding.m_dScale;
+  const ULONG *bits= coding.m_pulBits;
+  const ULONG *fmt = coding.m_pulFormat;
+  UWORD  comp      = unit.m_usComp;
+  ULONG  x         = unit.m_ulX;
+  ULONG  y         = unit.m_ulY;
+  ULONG  width     = unit.m_ulWidth;
+  ULONG  height    = unit.m_ulHeight;
+  UBYTE  sx        = coding.m_ucSubX;
+  UBYTE  sy        = coding.m_ucSubY;
+  UBYTE  b         = coding.m_ucBits;
+  UWORD  d         = DepthOf();
 
-  for(comp = 0;comp < d;comp++) {
-    if (bits[comp] != b || fmt[comp] != fmt[0]) {
-      b = 0;
+  if (coding.m_pulRed) {
+    const ULONG *rm = coding.m_pulRed;
+    const ULONG *gm = coding.m_pulGreen;
+    const ULONG *bm = coding.m_pulBlue;
+    assert(comp == 0 && d == 3);
+    switch(coding.m_iCompression) {
+    case TiffTag::Compression::NONE:
+      UnpackDataPaletized<TrivialDecoder>(buffer,bigendian,hdiff,x,y,width,height,bits[comp],bytes,
+					  rm,gm,bm);
+      break;
+    case TiffTag::Compression::PACKBITS:
+      UnpackDataPaletized<PackBitsDecoder>(buffer,bigendian,hdiff,x,y,width,height,bits[comp],bytes,
+					   rm,gm,bm);
+      break;
+    case TiffTag::Compression::DEFLATE:
+      UnpackDataPaletized<DeflateDecoder>(buffer,bigendian,hdiff,x,y,width,height,bits[comp],bytes,
+					  rm,gm,bm);
+      break;
+    case TiffTag::Compression::LZW:
+      UnpackDataPaletized<LZWDecoder>(buffer,bigendian,hdiff,x,y,width,height,bits[comp],bytes,
+				      rm,gm,bm);
       break;
     }
-  }
-  comp = 0;
-  
-  for(tile = 0;tile < tilecount;tile++) {
-    if (comp >= d) {
-      throw "extra data at end of TIFF file";
-    } else {
-      ULONG  width  = tw;
-      ULONG  height = th;
-      ULONG  bytes;
-      UBYTE *buffer;
-      
-      if (x + width  > iwidth) {
-	if (x >= iwidth)
-	  throw "extra data at end of TIFF file";
-	width  = iwidth - x;
-      }
-      if (y + height > iheight) {
-	if (y >= iheight)
-	  throw "extra data at end of TIFF file";
-	height = iheight - y;
-      }
-      
-      if (width == 0 || height == 0)
-	throw "extra data at end of TIFF file";
-      
-      buffer = parser.GetDataOfUnit(tile,bytes);
-      
-      if (rm) {
-	assert(comp == 0 && d == 3);
-	switch(lzw) {
-	case TiffTag::Compression::NONE:
-	  UnpackDataPaletized<TrivialDecoder>(buffer,parser.isBigEndian(),hdiff,x,y,width,height,bits[comp],bytes,
-					      rm,gm,bm);
+  } else {
+    switch(coding.m_usPlanarConfig) {
+    case TiffTag::Planarconfig::SEPARATE: 
+      if ((comp == 1 || comp == 2) && (sx > 1 || sy > 1)) {
+	// Sizes must be divisible by the subsampling factors to be valid.
+	if (width % sx != 0 || height % sy != 0 || x % sx != 0 || y % sy != 0)
+	  throw "invalid TIFF strip or tile dimensions not divisible by subsampling factors";
+	switch(coding.m_iCompression) {
+	case TiffTag::Compression::LZW:
+	  UnpackData<LZWDecoder>(buffer,bigendian,hdiff,comp,1,x / sx,y / sy,width / sx,height / sy,
+				 bits[comp],bits,fmt,bytes,inv,scale);
 	  break;
 	case TiffTag::Compression::PACKBITS:
-	  UnpackDataPaletized<PackBitsDecoder>(buffer,parser.isBigEndian(),hdiff,x,y,width,height,bits[comp],bytes,
-					       rm,gm,bm);
+	  UnpackData<PackBitsDecoder>(buffer,bigendian,hdiff,comp,1,x / sx,y / sy,width / sx,height / sy,
+				      bits[comp],bits,fmt,bytes,inv,scale);
 	  break;
-	case TiffTag::Compression::LZW:
-	  UnpackDataPaletized<LZWDecoder>(buffer,parser.isBigEndian(),hdiff,x,y,width,height,bits[comp],bytes,
-					  rm,gm,bm);
+	case TiffTag::Compression::DEFLATE:
+	  UnpackData<DeflateDecoder>(buffer,bigendian,hdiff,comp,1,x / sx,y / sy,width / sx,height / sy,
+				     bits[comp],bits,fmt,bytes,inv,scale);
+	  break;
+	case TiffTag::Compression::NONE:
+	  UnpackData<TrivialDecoder>(buffer,bigendian,hdiff,comp,1,x / sx,y / sy,width / sx,height / sy,
+				     bits[comp],bits,fmt,bytes,inv,scale);
 	  break;
 	}
-      } else {
-	switch(imgconfig) {
-	case TiffTag::Planarconfig::SEPARATE: 
-	  if ((comp == 1 || comp == 2) && (sx > 1 || sy > 1)) {
-	    // Sizes must be divisible by the subsampling factors to be valid.
-	    if (width % sx != 0 || height % sx != 0 || x % sx != 0 || y % sy != 0)
-	      throw "invalid TIFF tile dimensions not divisible by subsampling factors";
-	    switch(lzw) {
-	    case TiffTag::Compression::LZW:
-	      UnpackData<LZWDecoder>(buffer,parser.isBigEndian(),hdiff,comp,1,x / sx,y / sy,width / sx,height / sy,
+      } else { 
+	switch(coding.m_iCompression) {
+	case TiffTag::Compression::LZW:
+	  UnpackData<LZWDecoder>(buffer,bigendian,hdiff,comp,1,x     ,y     ,width     ,height     ,
+				 bits[comp],bits,fmt,bytes,inv,scale);
+	  break;
+	case TiffTag::Compression::PACKBITS:
+	  UnpackData<PackBitsDecoder>(buffer,bigendian,hdiff,comp,1,x     ,y     ,width     ,height     ,
+				      bits[comp],bits,fmt,bytes,inv,scale);
+	  break;
+	case TiffTag::Compression::DEFLATE:
+	  UnpackData<DeflateDecoder>(buffer,bigendian,hdiff,comp,1,x     ,y     ,width     ,height     ,
 				     bits[comp],bits,fmt,bytes,inv,scale);
-	      break;
-	    case TiffTag::Compression::PACKBITS:
-	      UnpackData<PackBitsDecoder>(buffer,parser.isBigEndian(),hdiff,comp,1,x / sx,y / sy,width / sx,height / sy,
-					  bits[comp],bits,fmt,bytes,inv,scale);
-	      break;
-	    case TiffTag::Compression::NONE:
-	      UnpackData<TrivialDecoder>(buffer,parser.isBigEndian(),hdiff,comp,1,x / sx,y / sy,width / sx,height / sy,
-					 bits[comp],bits,fmt,bytes,inv,scale);
-	      break;
-	    }
-	  } else { 
-	    switch(lzw) {
-	    case TiffTag::Compression::LZW:
-	      UnpackData<LZWDecoder>(buffer,parser.isBigEndian(),hdiff,comp,1,x     ,y     ,width     ,height     ,
+	  break;
+	case TiffTag::Compression::NONE:
+	  UnpackData<TrivialDecoder>(buffer,bigendian,hdiff,comp,1,x     ,y     ,width     ,height     ,
 				     bits[comp],bits,fmt,bytes,inv,scale);
-	      break;
-	    case TiffTag::Compression::PACKBITS:
-	      UnpackData<PackBitsDecoder>(buffer,parser.isBigEndian(),hdiff,comp,1,x     ,y     ,width     ,height     ,
-					  bits[comp],bits,fmt,bytes,inv,scale);
-	      break;
-	    case TiffTag::Compression::NONE:
-	      UnpackData<TrivialDecoder>(buffer,parser.isBigEndian(),hdiff,comp,1,x     ,y     ,width     ,height     ,
-					 bits[comp],bits,fmt,bytes,inv,scale);
-	      break;
-	    }
-	  }
 	  break;
-	case TiffTag::Planarconfig::CONTIG: 
-	  if (sx > 1 || sy > 1) {
-	    switch(lzw) {
-	    case TiffTag::Compression::NONE:
-	      UnpackDataYCbCr<TrivialDecoder>(buffer  ,parser.isBigEndian(),hdiff,x,y,width,height     ,b,bytes,sx,sy);
-	      break;
-	    case TiffTag::Compression::LZW:
-	      UnpackDataYCbCr<LZWDecoder>(buffer  ,parser.isBigEndian(),hdiff,x,y,width,height     ,b,bytes,sx,sy);
-	      break;
-	    case TiffTag::Compression::PACKBITS:
-	      UnpackDataYCbCr<PackBitsDecoder>(buffer  ,parser.isBigEndian(),hdiff,x,y,width,height     ,b,bytes,sx,sy);
-	      break;
-	    }
-	  } else { 
-	    switch(lzw) {
-	    case TiffTag::Compression::LZW:
-	      UnpackData<LZWDecoder>(buffer,parser.isBigEndian(),hdiff,0,d,x,y,width,height,b,bits,fmt,bytes,inv,scale);
-	      break;
-	    case TiffTag::Compression::PACKBITS:
-	      UnpackData<PackBitsDecoder>(buffer,parser.isBigEndian(),hdiff,0,d,x,y,width,height,b,bits,fmt,bytes,inv,scale);
-	      break;
-	    case TiffTag::Compression::NONE:
-	      UnpackData<TrivialDecoder>(buffer,parser.isBigEndian(),hdiff,0,d,x,y,width,height,b,bits,fmt,bytes,inv,scale);
-	      break;
-	    }
-	  }
+	}
+      }
+      break;
+    case TiffTag::Planarconfig::CONTIG: 
+      if (sx > 1 || sy > 1) {
+	switch(coding.m_iCompression) {
+	case TiffTag::Compression::NONE:
+	  UnpackDataYCbCr<TrivialDecoder>(buffer  ,bigendian,hdiff,x,y,width,height     ,b,bytes,sx,sy);
+	  break;
+	case TiffTag::Compression::LZW:
+	  UnpackDataYCbCr<LZWDecoder>(buffer  ,bigendian,hdiff,x,y,width,height     ,b,bytes,sx,sy);
+	  break;
+	case TiffTag::Compression::PACKBITS:
+	  UnpackDataYCbCr<PackBitsDecoder>(buffer  ,bigendian,hdiff,x,y,width,height     ,b,bytes,sx,sy);
+	  break;
+	case TiffTag::Compression::DEFLATE:
+	  UnpackDataYCbCr<DeflateDecoder>(buffer  ,bigendian,hdiff,x,y,width,height     ,b,bytes,sx,sy);
+	  break;
+	}
+      } else { 
+	switch(coding.m_iCompression) {
+	case TiffTag::Compression::LZW:
+	  UnpackData<LZWDecoder>(buffer,bigendian,hdiff,0,d,x,y,width,height,b,bits,fmt,bytes,inv,scale);
+	  break;
+	case TiffTag::Compression::PACKBITS:
+	  UnpackData<PackBitsDecoder>(buffer,bigendian,hdiff,0,d,x,y,width,height,b,bits,fmt,bytes,inv,scale);
+	  break;
+	case TiffTag::Compression::DEFLATE:
+	  UnpackData<DeflateDecoder>(buffer,bigendian,hdiff,0,d,x,y,width,height,b,bits,fmt,bytes,inv,scale);
+	  break;
+	case TiffTag::Compression::NONE:
+	  UnpackData<TrivialDecoder>(buffer,bigendian,hdiff,0,d,x,y,width,height,b,bits,fmt,bytes,inv,scale);
 	  break;
 	}
       }
-      
-      x += tw;
-      if (x >= iwidth) {
-	x  = 0;
-	y += th;
-	if (y >= iheight) {
-	  if (imgconfig == TiffTag::Planarconfig::SEPARATE) {
-	    comp++;
-	    x = 0;
-	    y = 0;
-	  } 
+      break;
+    }
+  }
+}
+///
+
+/// SimpleTiff::Run
+// Decode or encode the strip or tile of the given index while
+// working on the threads.
+void SimpleTiff::Run(ULONG item)
+{
+  if (m_pWriter) {
+    EncodeUnit(*m_pCoding,*m_pWriter,m_pUnits[item]);
+  } else {
+    DecodeUnit(*m_pCoding,m_pUnits[item]);
+  }
+}
+///
+
+/// SimpleTiff::DecodeUnits
+// Decode all strips or tiles. Without a pool, they are read one after
+// another into the buffer of the parser and decoded. Otherwise, the
+// file is mapped, or all units are read at once if it cannot be mapped,
+// and as the units are independent of each other, every thread decodes
+// units with its own decoder directly into the components.
+void SimpleTiff::DecodeUnits(class TiffParser &parser,const struct TiffCoding &coding,
+			     struct TiffUnit *units,ULONG count)
+{
+  ULONG i;
+
+  if (m_pPool && m_pPool->ThreadsOf() > 1 && count > 1) {
+    class MemoryMap map;
+    UBYTE *store  = NULL;
+    bool   mapped = map.Map(parser.FileOf());
+    UQUAD  total  = 0;
+    //
+    for(i = 0;i < count;i++) {
+      UQUAD offset = parser.GetOffsetOfUnit(i,units[i].m_ulBytes);
+      if (mapped) {
+	units[i].m_pucData = map.RangeOf(offset,units[i].m_ulBytes);
+	if (units[i].m_pucData == NULL)
+	  mapped = false; // truncated, reading reports the error.
+      }
+      total += units[i].m_ulBytes;
+    }
+    //
+    try {
+      if (!mapped) {
+	UBYTE *data;
+	if (total != UQUAD(size_t(total)))
+	  throw "TIFF image too large to be decoded in parallel";
+	store = data = new UBYTE[size_t(total)];
+	for(i = 0;i < count;i++) {
+	  parser.ReadUnit(i,data);
+	  units[i].m_pucData = data;
+	  data += units[i].m_ulBytes;
+	}
+      }
+      //
+      m_pCoding = &coding;
+      m_pUnits  = units;
+      m_pPool->Dispatch(this,count);
+    } catch(...) {
+      m_pCoding = NULL;
+      m_pUnits  = NULL;
+      delete[] store;
+      throw;
+    }
+    m_pCoding = NULL;
+    m_pUnits  = NULL;
+    delete[] store;
+  } else {
+    for(i = 0;i < count;i++) {
+      units[i].m_pucData = parser.GetDataOfUnit(i,units[i].m_ulBytes);
+      DecodeUnit(coding,units[i]);
+    }
+  }
+}
+///
+
+/// SimpleTiff::ReadTiled
+// Locate the tiles of the image and decode them.
+void SimpleTiff::ReadTiled(class TiffParser &parser,const struct TiffCoding &coding,ULONG tw,ULONG th)
+{
+  ULONG   tilecount = parser.GetAddressableTiles();
+  ULONG   tile;
+  UWORD   comp      = 0; // current plane = tile.
+  ULONG   x         = 0;
+  ULONG   y         = 0;
+  ULONG   iwidth    = WidthOf();
+  ULONG   iheight   = HeightOf();
+  UWORD   d         = DepthOf();
+  struct TiffUnit *units = new struct TiffUnit[tilecount];
+
+  try {
+    for(tile = 0;tile < tilecount;tile++) {
+      if (comp >= d) {
+	throw "extra data at end of TIFF file";
+      } else {
+	ULONG  width  = tw;
+	ULONG  height = th;
+	
+	if (x + width  > iwidth) {
+	  if (x >= iwidth)
+	    throw "extra data at end of TIFF file";
+	  width  = iwidth - x;
+	}
+	if (y + height > iheight) {
+	  if (y >= iheight)
+	    throw "extra data at end of TIFF file";
+	  height = iheight - y;
+	}
+	
+	if (width == 0 || height == 0)
+	  throw "extra data at end of TIFF file";
+	
+	units[tile].m_pucData  = NULL;
+	units[tile].m_ulBytes  = 0;
+	units[tile].m_usComp   = comp;
+	units[tile].m_ulX      = x;
+	units[tile].m_ulY      = y;
+	units[tile].m_ulWidth  = width;
+	units[tile].m_ulHeight = height;
+	
+	x += tw;
+	if (x >= iwidth) {
+	  x  = 0;
+	  y += th;
+	  if (y >= iheight) {
+	    if (coding.m_usPlanarConfig == TiffTag::Planarconfig::SEPARATE) {
+	      comp++;
+	      x = 0;
+	      y = 0;
+	    } 
+	  }
 	}
       }
     }
+    //
+    DecodeUnits(parser,coding,units,tilecount);
+  } catch(...) {
+    delete[] units;
+    throw;
   }
+  delete[] units;
 }
 ///
 
 /// SimpleTiff::ReadStriped
-// Read striped data through the tiff interface.
-void SimpleTiff::ReadStriped(class TiffParser &parser,int lzw,bool hdiff,
-			     UWORD imgconfig,
-			     ULONG inv,const ULONG *bits,const ULONG *fmt,
-			     const ULONG *rm,const ULONG *gm,const ULONG *bm,
-			     DOUBLE scale)
+// Locate the strips of the image and decode them.
+void SimpleTiff::ReadStriped(class TiffParser &parser,const struct TiffCoding &coding)
 {
   ULONG rps = 0;  // rows per strip
   ULONG nos;      // number of strips
@@ -820,127 +1127,145 @@ void SimpleTiff::ReadStriped(class TiffParser &parser,int lzw,bool hdiff,
   ULONG width   = WidthOf();
   ULONG height  = HeightOf();
   UWORD d       = DepthOf();
-  UBYTE b       = bits[0];
-  UBYTE sx      = (d > 1)?(m_pComponent[1].m_ucSubX):(1);
-  UBYTE sy      = (d > 1)?(m_pComponent[1].m_ucSubY):(1);
+  struct TiffUnit *units;
   
   rps     = parser.GetRowsPerStrip();
   nos     = parser.GetAddressableStrips();
+  units   = new struct TiffUnit[nos];
 
-  for(comp = 0;comp < d;comp++) {
-    if (bits[comp] != b || fmt[comp] != fmt[0]) {
-      b = 0;
-      break;
-    }
-  }
-  comp = 0;
-  
-  for(strip = 0;strip < nos;strip++) {
-    if (comp >= d) {
-      throw "unexpected extra data in TIFF image";
-    } else {
-      UBYTE *buffer;
-      ULONG  bytes;
-
-      // Compute the expected stripe height.
-      if (y + rps < height) {
-	h = rps;
+  try {
+    for(strip = 0;strip < nos;strip++) {
+      if (comp >= d) {
+	throw "unexpected extra data in TIFF image";
       } else {
-	if (height <= y)
-	  throw "unexpected extra data in TIFF image";
-	h = height - y;
-      }
-      
-      buffer = parser.GetDataOfUnit(strip,bytes);
-      if (rm) {
-	assert(comp == 0 && d == 3);
-	switch(lzw) {
-	  case TiffTag::Compression::NONE:
-	    UnpackDataPaletized<TrivialDecoder>(buffer,parser.isBigEndian(),hdiff,0,y,width,h,bits[comp],bytes,rm,gm,bm);
-	    break;
-	  case TiffTag::Compression::LZW:
-	    UnpackDataPaletized<LZWDecoder>(buffer,parser.isBigEndian(),hdiff,0,y,width,h,bits[comp],bytes,rm,gm,bm);
-	    break;
-	  case TiffTag::Compression::PACKBITS:
-	    UnpackDataPaletized<PackBitsDecoder>(buffer,parser.isBigEndian(),hdiff,0,y,width,h,bits[comp],bytes,rm,gm,bm);
-	    break;
+	// Compute the expected stripe height.
+	if (y + rps < height) {
+	  h = rps;
+	} else {
+	  if (height <= y)
+	    throw "unexpected extra data in TIFF image";
+	  h = height - y;
 	}
-      } else {
-	switch(imgconfig) {
-	case TiffTag::Planarconfig::SEPARATE:
-	  if ((comp == 1 || comp == 2) && (sx > 1 || sy > 1)) {
-	    // Sizes must be divisible by the subsampling factors to be valid.
-	    if (width % sx != 0 || h % sy != 0 || y % sy != 0)
-	      throw "invalid TIFF stripe dimensions not divisible by subsampling factors";
-	    switch(lzw) {
-	    case TiffTag::Compression::LZW:
-	      UnpackData<LZWDecoder>(buffer,parser.isBigEndian(),hdiff,comp,1,0,y / sy,width / sx,h / sy,
-				     bits[comp],bits,fmt,bytes,inv,scale);
-	      break;
-	    case TiffTag::Compression::PACKBITS:
-	      UnpackData<PackBitsDecoder>(buffer,parser.isBigEndian(),hdiff,comp,1,0,y / sy,width / sx,h / sy,
-					  bits[comp],bits,fmt,bytes,inv,scale);
-	      break;
-	    case TiffTag::Compression::NONE:
-	      UnpackData<TrivialDecoder>(buffer,parser.isBigEndian(),hdiff,comp,1,0,y / sy,width / sx,h / sy,
-					 bits[comp],bits,fmt,bytes,inv,scale);
-	      break;
-	    }
-	  } else {
-	    switch(lzw) {
-	    case TiffTag::Compression::LZW:
-	      UnpackData<LZWDecoder>(buffer,parser.isBigEndian(),hdiff,comp,1,0,y     ,width     ,h     ,
-				     bits[comp],bits,fmt,bytes,inv,scale);
-	      break;
-	    case TiffTag::Compression::PACKBITS:
-	      UnpackData<PackBitsDecoder>(buffer,parser.isBigEndian(),hdiff,comp,1,0,y     ,width     ,h     ,
-					  bits[comp],bits,fmt,bytes,inv,scale);
-	      break;
-	    case TiffTag::Compression::NONE:
-	      UnpackData<TrivialDecoder>(buffer,parser.isBigEndian(),hdiff,comp,1,0,y     ,width     ,h     ,
-					 bits[comp],bits,fmt,bytes,inv,scale);
-	      break;
-	    }
-	  }
-	  break;
-	case TiffTag::Planarconfig::CONTIG:
-	  if (sx > 1 || sy > 1) {
-	    switch(lzw) {
-	    case TiffTag::Compression::NONE:
-	      UnpackDataYCbCr<TrivialDecoder>(buffer,parser.isBigEndian(),hdiff,0,y,width,h     ,b,bytes,sx,sy);
-	      break;
-	    case TiffTag::Compression::LZW:
-	      UnpackDataYCbCr<LZWDecoder>(buffer,parser.isBigEndian(),hdiff,0,y,width,h     ,b,bytes,sx,sy);
-	      break;
-	    case TiffTag::Compression::PACKBITS:
-	      UnpackDataYCbCr<PackBitsDecoder>(buffer,parser.isBigEndian(),hdiff,0,y,width,h     ,b,bytes,sx,sy);
-	      break;
-	    }
-	  } else {
-	    switch(lzw) {
-	    case TiffTag::Compression::LZW:
-	      UnpackData<LZWDecoder>(buffer,parser.isBigEndian(),hdiff,0   ,d,0,y,width,h,b,bits,fmt,bytes,inv,scale);
-	      break;
-	    case TiffTag::Compression::PACKBITS:
-	      UnpackData<PackBitsDecoder>(buffer,parser.isBigEndian(),hdiff,0   ,d,0,y,width,h,b,bits,fmt,bytes,inv,scale);
-	      break;
-	    case TiffTag::Compression::NONE:
-	      UnpackData<TrivialDecoder>(buffer,parser.isBigEndian(),hdiff,0   ,d,0,y,width,h,b,bits,fmt,bytes,inv,scale);
-	      break;
-	    }
+	
+	units[strip].m_pucData  = NULL;
+	units[strip].m_ulBytes  = 0;
+	units[strip].m_usComp   = comp;
+	units[strip].m_ulX      = 0;
+	units[strip].m_ulY      = y;
+	units[strip].m_ulWidth  = width;
+	units[strip].m_ulHeight = h;
+	
+	y  += rps;
+	if (y >= height) {
+	  y = 0;
+	  if (coding.m_usPlanarConfig == TiffTag::Planarconfig::SEPARATE) {
+	    comp++;
 	  }
-	  break;
 	}
       }
-      y  += rps;
-      if (y >= height) {
-	y = 0;
-	if (imgconfig == TiffTag::Planarconfig::SEPARATE) {
-	  comp++;
+    }
+    //
+    DecodeUnits(parser,coding,units,nos);
+  } catch(...) {
+    delete[] units;
+    throw;
+  }
+  delete[] units;
+}
+///
+
+/// SimpleTiff::MapStriped
+// Check whether the strips of an uncompressed image already hold the
+// samples as the components describe them, i.e. all samples are
+// 8, 16, 32 or 64 bits wide and in the byte order of the host, no
+// conversion applies, and the strips of each plane follow each other
+// in the file. If so, map the file, point the components into it and
+// return true.
+bool SimpleTiff::MapStriped(class TiffParser &parser,int lzw,bool hdiff,UWORD imgconfig,
+			    ULONG inv,const ULONG *bits,const ULONG *fmt,
+			    const ULONG *rm,DOUBLE scale)
+{
+  ULONG width  = WidthOf();
+  ULONG height = HeightOf();
+  UWORD d      = DepthOf();
+  UBYTE b      = bits[0];
+  ULONG bytes  = b >> 3;
+  UWORD planes = (imgconfig == TiffTag::Planarconfig::SEPARATE)?(d):(1);
+  ULONG rps,spp,rowbytes;
+  const UQUAD *offset;
+  const UQUAD *count;
+  UWORD comp,p;
+  ULONG s;
+  
+  if (parser.isTiled() || lzw != TiffTag::Compression::NONE || hdiff || inv || rm)
+    return false;
+  //
+  if (b != 8 && b != 16 && b != 32 && b != 64)
+    return false;
+  for(comp = 0;comp < d;comp++) {
+    if (bits[comp] != b || fmt[comp] != fmt[0])
+      return false;
+    if (m_pComponent[comp].m_ucSubX != 1 || m_pComponent[comp].m_ucSubY != 1)
+      return false;
+  }
+  if (fmt[0] == TiffTag::Sampleformat::IEEEFP) {
+    if (b == 16 || scale != 1.0)
+      return false; // half-floats and scaled samples are converted.
+  } else if (b == 64) {
+    return false;
+  }
+  if (b > 8 && parser.isBigEndian() == MemoryMap::isLittleEndian())
+    return false;
+  //
+  // Check that the strips of each plane are contiguous.
+  rps = parser.GetRowsPerStrip();
+  if (rps == 0)
+    return false;
+  spp      = (rps >= height)?(1):((height + rps - 1) / rps);
+  rowbytes = width * bytes * ((planes == 1)?(d):(1));
+  if (parser.GetAddressableStrips() != spp * planes)
+    return false;
+  //
+  // Rows of components are addressed by 32-bit offsets, hence the
+  // mapped plane must not exceed 4GB.
+  if (UQUAD(rowbytes) * height > UQUAD(MAX_ULONG) + 1)
+    return false;
+  offset   = parser.GetStripOffset();
+  count    = parser.GetStripByteCount();
+  for(p = 0;p < planes;p++) {
+    for(s = 0;s < spp;s++) {
+      ULONG rows = (s + 1 < spp)?(rps):(height - s * rps);
+      if (offset[p * spp + s] != UQUAD(offset[p * spp]) + UQUAD(s) * rps * rowbytes ||
+	  count[p * spp + s] < UQUAD(rows) * rowbytes)
+	return false;
+    }
+  }
+  //
+  m_pMap = new class MemoryMap;
+  if (m_pMap->Map(parser.FileOf())) {
+    for(p = 0;p < planes;p++) {
+      if (m_pMap->RangeOf(offset[p * spp],UQUAD(rowbytes) * height,bytes) == NULL)
+	break;
+    }
+    if (p == planes) {
+      for(comp = 0;comp < d;comp++) {
+	struct ComponentLayout *cl = m_pComponent + comp;
+	if (planes == 1) {
+	  cl->m_pPtr            = m_pMap->DataOf() + size_t(offset[0]) + comp * bytes;
+	  cl->m_ulBytesPerPixel = d * bytes;
+	} else {
+	  cl->m_pPtr            = m_pMap->DataOf() + size_t(offset[comp * spp]);
+	  cl->m_ulBytesPerPixel = bytes;
 	}
+	cl->m_ulBytesPerRow     = rowbytes;
       }
+      return true;
     }
   }
+  delete m_pMap;
+  m_pMap = NULL;
+  //
+  return false;
 }
 ///
 
@@ -969,6 +1294,7 @@ void SimpleTiff::LoadImage(const char *basename,struct ImgSpecs &specs)
   int    lzw   = TiffTag::Compression::NONE;
   bool   hdiff = false;
   DOUBLE scale = 1.0;
+  struct TiffCoding coding;
 
   if (parser.isBigEndian()) {
     specs.LittleEndian = ImgSpecs::No;
@@ -982,6 +1308,10 @@ void SimpleTiff::LoadImage(const char *basename,struct ImgSpecs &specs)
   case TiffTag::Compression::PACKBITS:
     lzw = parser.GetCompression();
     break;
+  case TiffTag::Compression::DEFLATE:
+  case TiffTag::Compression::OLDDEFLATE:
+    lzw = TiffTag::Compression::DEFLATE;
+    break;
   default:
     throw "unsupported TIFF compression type, sorry";
     break;
@@ -1106,7 +1436,6 @@ void SimpleTiff::LoadImage(const char *basename,struct ImgSpecs &specs)
     c->m_bSigned         = (photo  == TiffTag::Photometric::PALETTE)?(false):
       (fmt[comp] != TiffTag::Sampleformat::UINT && 
        fmt[comp] != TiffTag::Sampleformat::VOID);
-    c->m_pData           = new UBYTE[c->m_ulWidth * c->m_ulHeight * bytesperpixel];
     cl->m_ulWidth        = c->m_ulWidth;
     cl->m_ulHeight       = c->m_ulHeight;
     cl->m_ucBits         = c->m_ucDepth;
@@ -1121,17 +1450,53 @@ void SimpleTiff::LoadImage(const char *basename,struct ImgSpecs &specs)
     }
     cl->m_ulBytesPerPixel= bytesperpixel;
     cl->m_ulBytesPerRow  = c->m_ulWidth * cl->m_ulBytesPerPixel;
+  }
+  //
+  // Uncompressed strips in the byte order of the host are used in place.
+  if (MapStriped(parser,lzw,hdiff,cnf,inv,bps,fmt,rpal,scale))
+    return;
+  //
+  for(comp = 0;comp < depth;comp++) {
+    struct TiffComponent *c    = m_ppComponents[comp];
+    struct ComponentLayout *cl = m_pComponent + comp;
+    UQUAD size                 = UQUAD(cl->m_ulBytesPerRow) * c->m_ulHeight;
+    //
+    // Rows of components are addressed by 32-bit offsets.
+    if (size > UQUAD(MAX_ULONG) + 1 || size != UQUAD(size_t(size)))
+      throw "TIFF image components larger than 4GB are not supported, sorry";
+    c->m_pData           = new UBYTE[size_t(size)];
     cl->m_pPtr           = c->m_pData;
   }
   
+  coding.m_iCompression   = lzw;
+  coding.m_bBigEndian     = parser.isBigEndian();
+  coding.m_bPrediction    = hdiff;
+  coding.m_usPlanarConfig = cnf;
+  coding.m_ulInvert       = inv;
+  coding.m_ucBits         = bps[0];
+  coding.m_pulBits        = bps;
+  coding.m_pulFormat      = fmt;
+  coding.m_pulRed         = rpal;
+  coding.m_pulGreen       = gpal;
+  coding.m_pulBlue        = bpal;
+  coding.m_ucSubX         = (depth > 1)?(m_pComponent[1].m_ucSubX):(1);
+  coding.m_ucSubY         = (depth > 1)?(m_pComponent[1].m_ucSubY):(1);
+  coding.m_dScale         = scale;
+  for(comp = 0;comp < depth && rpal == NULL;comp++) {
+    if (bps[comp] != bps[0] || fmt[comp] != fmt[0]) {
+      coding.m_ucBits     = 0;
+      break;
+    }
+  }
+  //
   if (parser.isTiled()) {
     ULONG tw        = parser.GetTileWidth();
     ULONG th        = parser.GetTileHeight();
     //
-    ReadTiled(parser,lzw,hdiff,cnf,tw,th,inv,bps,fmt,rpal,gpal,bpal,scale);
+    ReadTiled(parser,coding,tw,th);
   } else {
     //
-    ReadStriped(parser,lzw,hdiff,cnf,inv,bps,fmt,rpal,gpal,bpal,scale);
+    ReadStriped(parser,coding);
   }
 }
 ///
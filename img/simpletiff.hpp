@@ -34,15 +34,18 @@ and conversion framework.
 #include "imglayout.hpp"
 #include "std/string.hpp"
 #include "std/stdio.hpp"
+#include "tools/threadpool.hpp"
 ///
 
 /// Forwards
 struct ImgSpecs;
+class MemoryMap;
+class TiffWriter;
 ///
 
 /// SimpleTiff
 // This is the class for simple portable extended pixmap graphics.
-class SimpleTiff : public ImageLayout {
+class SimpleTiff : public ImageLayout, private ThreadPool::Job {
   //
   // A per-component buffer containing the component names.
   struct TiffComponent {
@@ -70,18 +73,102 @@ class SimpleTiff : public ImageLayout {
   // Number of entries here, required to release them properly.
   UWORD m_usCount;
   //
-  // Copy data for TIFF images written in "striped mode".
-  void ReadStriped(class TiffParser &parser,int lzw,bool hdiff,UWORD imgconfig,
-		   ULONG inv,const ULONG *bits,const ULONG *fmt,
-		   const ULONG *r,const ULONG *g,const ULONG *b,
-		   DOUBLE scale);
-  //
-  // Read tiled data through the tiff interface.
-  void ReadTiled(class TiffParser &parser,int lzw,bool hdiff,UWORD imgconfig,ULONG tw,ULONG th,
-		 ULONG inv,const ULONG *bits,const ULONG *fmt,
-		 const ULONG *r,const ULONG *g,const ULONG *b,
-		 DOUBLE scale);
-
+  // If the samples are used in place, the mapping of the file.
+  // The component data is then NULL.
+  class MemoryMap *m_pMap;
+  //
+  // The threads strips and tiles are decoded and encoded on, or NULL.
+  class ThreadPool *m_pPool;
+  //
+  // How the strips or tiles of the image are encoded.
+  struct TiffCoding {
+    int          m_iCompression;
+    bool         m_bBigEndian;
+    bool         m_bPrediction;
+    UWORD        m_usPlanarConfig;
+    ULONG        m_ulInvert;
+    //
+    // Bits per sample if identical for all components, zero otherwise,
+    // and the bits and sample formats of the individual components.
+    UBYTE        m_ucBits;
+    const ULONG *m_pulBits;
+    const ULONG *m_pulFormat;
+    //
+    // The palette, NULL if the image is not palettized.
+    const ULONG *m_pulRed;
+    const ULONG *m_pulGreen;
+    const ULONG *m_pulBlue;
+    //
+    // Subsampling of the chroma components.
+    UBYTE        m_ucSubX;
+    UBYTE        m_ucSubY;
+    //
+    DOUBLE       m_dScale;
+  };
+  //
+  // A strip or tile, its data as found in the file and the rectangle
+  // of the image it covers. For subsampled planes written by the saver,
+  // the rectangle is in samples of the plane.
+  struct TiffUnit {
+    UBYTE       *m_pucData;
+    ULONG        m_ulBytes;
+    //
+    // The component, always zero for interleaved samples.
+    UWORD        m_usComp;
+    ULONG        m_ulX;
+    ULONG        m_ulY;
+    ULONG        m_ulWidth;
+    ULONG        m_ulHeight;
+  };
+  //
+  // While strips or tiles are decoded or encoded on the threads, their
+  // coding and the units themselves.
+  const struct TiffCoding *m_pCoding;
+  struct TiffUnit         *m_pUnits;
+  //
+  // While strips are encoded on the threads, the writer defining the
+  // byte order. NULL while decoding.
+  const class TiffWriter  *m_pWriter;
+  //
+  // Size of the strips written if not specified otherwise.
+  enum {
+    StripSize = 1 << 16
+  };
+  //
+  // Check whether the strips of an uncompressed image already hold the
+  // samples as the components describe them. If so, map the file, point
+  // the components into it and return true.
+  bool MapStriped(class TiffParser &parser,int lzw,bool hdiff,UWORD imgconfig,
+		  ULONG inv,const ULONG *bits,const ULONG *fmt,
+		  const ULONG *r,DOUBLE scale);
+  //
+  // Locate the strips of the image and decode them.
+  void ReadStriped(class TiffParser &parser,const struct TiffCoding &coding);
+  //
+  // Locate the tiles of the image and decode them.
+  void ReadTiled(class TiffParser &parser,const struct TiffCoding &coding,ULONG tw,ULONG th);
+  //
+  // Decode all strips or tiles, on the threads of the pool if there is
+  // one. The data of the units is filled in here.
+  void DecodeUnits(class TiffParser &parser,const struct TiffCoding &coding,
+		   struct TiffUnit *units,ULONG count);
+  //
+  // Decode a single strip or tile into the components.
+  void DecodeUnit(const struct TiffCoding &coding,const struct TiffUnit &unit);
+  //
+  // Pack the samples of a strip into the buffer as they appear in the
+  // file before compression, with rows of the given number of bytes.
+  void PackUnit(const struct TiffCoding &coding,const class TiffWriter &writer,
+		const struct TiffUnit &unit,UBYTE *buffer,ULONG bytesperrow);
+  //
+  // Pack and compress a single strip, keep its data in the unit.
+  void EncodeUnit(const struct TiffCoding &coding,const class TiffWriter &writer,
+		  struct TiffUnit &unit);
+  //
+  // Decode or encode the strip or tile of the given index while
+  // working on the threads.
+  virtual void Run(ULONG item);
+  //
   // Unpack the data from the source buffer into the destination component.
   // The parser is the data source, comp the start component and cnt the number of
   // components to copy. xofs and y are offsets into the target plane where the data 
@@ -130,9 +217,18 @@ public:
   // destructor
   ~SimpleTiff(void);
   //
+  // Decode the strips or tiles of images loaded, and compress the
+  // strips of images saved from now on with the threads of the given
+  // pool. The pool must outlive the loading and saving.
+  void UsePool(class ThreadPool *pool)
+  {
+    m_pPool = pool;
+  }
+  //
   // Save an image to a level 1 file descriptor, given its
   // width, height and depth. We only support grey level and
-  // RGB here, no palette images.
+  // RGB here, no palette images. The specs select the
+  // compression and the number of rows per strip.
   void SaveImage(const char *basename,const struct ImgSpecs &specs);
   //
   // Load an image from a level 1 file descriptor, keep it within
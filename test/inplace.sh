@@ -0,0 +1,84 @@
+#! /bin/sh
+#######################################################################
+##
+## $Id$
+##
+#######################################################################
+##
+## This source file is part of difftest_ng, a universal image measuring
+## and conversion framework.
+##
+##  difftest_ng is free software: you can redistribute it and/or modify
+##  it under the terms of the GNU General Public License as published by
+##  the Free Software Foundation, either version 3 of the License, or
+##  (at your option) any later version.
+##
+##  difftest_ng is distributed in the hope that it will be useful,
+##  but WITHOUT ANY WARRANTY; without even the implied warranty of
+##  MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+##  GNU General Public License for more details.
+##
+##  You should have received a copy of the GNU General Public License
+##  along with difftest_ng.  If not, see <http://www.gnu.org/licenses/>.
+##
+#######################################################################
+##
+## Regression test: images loaded from a file that are saved back to
+## the same file. Uncompressed images are mapped into memory instead
+## of being read, so the saver must not pull the samples away under
+## the image when it truncates the file.
+##
+## Usage: inplace.sh [path to difftest_ng]
+##
+
+DIFFTEST=${1:-./difftest_ng}
+TMP=${TMPDIR:-/tmp}/difftest_inplace.$$
+FAILED=0
+
+mkdir -p $TMP || exit 1
+trap 'rm -rf $TMP' 0
+
+##
+## An RGB gradient and a wide grey-scale one, large enough that the
+## saver reads pages of the mapping well after it truncated the file.
+awk 'BEGIN { print "P3\n1024 1024\n255";
+	     for(y = 0;y < 1024;y++) for(x = 0;x < 1024;x++) print x % 256,y % 256,(x * y) % 251 }' > $TMP/rgb.ppm
+awk 'BEGIN { print "P2\n4096 1024\n255";
+	     for(y = 0;y < 1024;y++) for(x = 0;x < 4096;x++) print (x + y) % 256 }' > $TMP/grey.pgm
+
+##
+## check ref target [options]
+## Save the reference in the target format, then convert the target
+## onto itself with the given options and compare it to the reference.
+check() {
+    ref=$1
+    target=$2
+    shift 2
+    opts=${*:+ $*}
+    if ! $DIFFTEST --raw --convert "$target" $ref $ref > /dev/null 2>&1; then
+	echo "inplace: cannot create $target"
+	FAILED=1
+	return
+    fi
+    if ! $DIFFTEST "$@" --convert "$target" "$target" $ref > /dev/null 2>&1; then
+	echo "inplace: saving $target over itself$opts FAILED"
+	FAILED=1
+	return
+    fi
+    if ! $DIFFTEST --brief --pae == 0 "$target" $ref > /dev/null 2>&1; then
+	echo "inplace: $target differs after saving it over itself$opts FAILED"
+	FAILED=1
+	return
+    fi
+    echo "inplace: $target$opts ok"
+}
+
+check $TMP/rgb.ppm $TMP/a.ppm
+check $TMP/grey.pgm $TMP/b.pgm
+check $TMP/rgb.ppm $TMP/c.tif
+check $TMP/rgb.ppm $TMP/d.tif --tiffcompress lzw
+check $TMP/grey.pgm $TMP/e.tif --tiffcompress packbits --threads 2
+check $TMP/rgb.ppm $TMP/f.dpx
+check $TMP/rgb.ppm "$TMP/g.raw@1024x1024x3:{8=0}:{8=1}:{8=2}"
+
+exit $FAILED
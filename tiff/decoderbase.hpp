@@ -45,6 +45,19 @@ class DecoderBase {
   UBYTE *m_pucBufferEnd;
   //
 protected:
+  // Return the position of the next byte in the input buffer, and
+  // the end of the buffer, for decoders that consume the input in
+  // larger units themselves.
+  UBYTE *&InputOf(void)
+  {
+    return m_pucBuffer;
+  }
+  //
+  UBYTE *EndOf(void) const
+  {
+    return m_pucBufferEnd;
+  }
+  //
   // Return the next byte from the input buffer, throw on error.
   UBYTE Read(void)
   {
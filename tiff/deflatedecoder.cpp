@@ -0,0 +1,109 @@
+/*************************************************************************
+** Written by Thomas Richter (THOR Software) for Accusoft	        **
+** All Rights Reserved							**
+**************************************************************************
+
+This source file is part of difftest_ng, a universal image measuring
+and conversion framework.
+
+    difftest_ng is free software: you can redistribute it and/or modify
+    it under the terms of the GNU General Public License as published by
+    the Free Software Foundation, either version 3 of the License, or
+    (at your option) any later version.
+
+    difftest_ng is distributed in the hope that it will be useful,
+    but WITHOUT ANY WARRANTY; without even the implied warranty of
+    MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+    GNU General Public License for more details.
+
+    You should have received a copy of the GNU General Public License
+    along with difftest_ng.  If not, see <http://www.gnu.org/licenses/>.
+
+*************************************************************************/
+/*
+**
+** This file contains the logic to decode deflate (zlib) compressed
+** TIFF files.
+**
+** $Id$
+**
+*/
+
+/// Includes
+#include "config.h"
+#include "tiff/deflatedecoder.hpp"
+#include "tiff/tiffparser.hpp"
+#ifdef USE_ZLIB
+#include <zlib.h>
+#endif
+///
+
+/// DeflateDecoder::DeflateDecoder
+// Start a deflate decoder on the given data buffer with the given number of bytes in the buffer.
+DeflateDecoder::DeflateDecoder(UBYTE *buffer,ULONG size,bool bigendian)
+  : DecoderBase(buffer,size), DecoderFunctions<DeflateDecoder>(this,bigendian),
+    m_pStream(NULL), m_bEndOfStream(false), m_pucNextOutput(m_ucOutput), m_pucOutputEnd(m_ucOutput)
+{
+#ifdef USE_ZLIB
+  m_pStream = new z_stream;
+  m_pStream->zalloc   = Z_NULL;
+  m_pStream->zfree    = Z_NULL;
+  m_pStream->opaque   = Z_NULL;
+  m_pStream->next_in  = Z_NULL;
+  m_pStream->avail_in = 0;
+  if (inflateInit(m_pStream) != Z_OK) {
+    delete m_pStream;
+    throw "unable to initialize the inflater for the deflate compressed TIFF image";
+  }
+#else
+  throw "deflate support is not compiled in, sorry";
+#endif
+}
+///
+
+/// DeflateDecoder::~DeflateDecoder
+DeflateDecoder::~DeflateDecoder(void)
+{
+#ifdef USE_ZLIB
+  inflateEnd(m_pStream);
+  delete m_pStream;
+#endif
+}
+///
+
+/// DeflateDecoder::RefillBuffer
+// Refill the output buffer by inflating the next piece of the input.
+void DeflateDecoder::RefillBuffer(void)
+{
+#ifdef USE_ZLIB
+  int result;
+  //
+  if (m_bEndOfStream)
+    throw "run out of data in TIFF decompression, input stream is possibly corrupt";
+  //
+  m_pStream->next_in   = InputOf();
+  m_pStream->avail_in  = EndOf() - InputOf();
+  m_pStream->next_out  = m_ucOutput;
+  m_pStream->avail_out = OutputBufferSize;
+  //
+  result     = inflate(m_pStream,Z_NO_FLUSH);
+  InputOf()  = m_pStream->next_in;
+  //
+  switch(result) {
+  case Z_STREAM_END:
+    m_bEndOfStream = true;
+    break;
+  case Z_OK:
+  case Z_BUF_ERROR: // no progress, caught below.
+    break;
+  default:
+    throw "invalid deflate data in TIFF decompression, input stream is corrupt";
+  }
+  //
+  m_pucNextOutput = m_ucOutput;
+  m_pucOutputEnd  = m_pStream->next_out;
+  if (m_pucNextOutput >= m_pucOutputEnd)
+    throw "run out of data in TIFF decompression, input stream is possibly corrupt";
+#endif
+}
+///
@@ -0,0 +1,88 @@
+/*************************************************************************
+** Written by Thomas Richter (THOR Software) for Accusoft	        **
+** All Rights Reserved							**
+**************************************************************************
+
+This source file is part of difftest_ng, a universal image measuring
+and conversion framework.
+
+    difftest_ng is free software: you can redistribute it and/or modify
+    it under the terms of the GNU General Public License as published by
+    the Free Software Foundation, either version 3 of the License, or
+    (at your option) any later version.
+
+    difftest_ng is distributed in the hope that it will be useful,
+    but WITHOUT ANY WARRANTY; without even the implied warranty of
+    MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+    GNU General Public License for more details.
+
+    You should have received a copy of the GNU General Public License
+    along with difftest_ng.  If not, see <http://www.gnu.org/licenses/>.
+
+*************************************************************************/
+/*
+**
+** This file contains the logic to decode deflate (zlib) compressed
+** TIFF files.
+**
+** $Id$
+**
+*/
+
+#ifndef TIFF_DEFLATEDECODER_HPP
+#define TIFF_DEFLATEDECODER_HPP
+
+/// Includes
+#include "interface/types.hpp"
+#include "tiff/tiffparser.hpp"
+#include "tiff/decoderbase.hpp"
+#include "tiff/decoderfunctions.hpp"
+///
+
+/// Forwards
+struct z_stream_s;
+///
+
+/// class DeflateDecoder
+// The strip or tile is inflated piece by piece into an output buffer
+// the bytes are delivered from.
+class DeflateDecoder : public DecoderBase, public DecoderFunctions<DeflateDecoder> {
+  //
+  // The state of the inflater.
+  struct z_stream_s *m_pStream;
+  //
+  // Set as soon as the end of the zlib stream has been reached.
+  bool   m_bEndOfStream;
+  //
+  enum {
+    OutputBufferSize = (1 << 14) // bytes inflated at once.
+  };
+  //
+  // The inflated data, the next output byte to deliver and the end
+  // of the output.
+  UBYTE  m_ucOutput[OutputBufferSize];
+  UBYTE *m_pucNextOutput;
+  UBYTE *m_pucOutputEnd;
+  //
+  // Refill the output buffer by inflating the next piece of the input.
+  void RefillBuffer(void);
+public:
+  // Start a deflate decoder on the given data buffer with the given number of bytes in the buffer.
+  DeflateDecoder(UBYTE *buffer,ULONG size,bool bigendian);
+  //
+  ~DeflateDecoder(void);
+  //
+  // Return/Decode the next byte from the data
+  UBYTE GetUBYTE(void)
+  {
+    if (m_pucNextOutput >= m_pucOutputEnd) {
+      RefillBuffer();
+    }
+
+    return *m_pucNextOutput++;
+  }
+  //
+};
+///
+
+#endif
@@ -0,0 +1,63 @@
+/*************************************************************************
+** Written by Thomas Richter (THOR Software) for Accusoft	        **
+** All Rights Reserved							**
+**************************************************************************
+
+This source file is part of difftest_ng, a universal image measuring
+and conversion framework.
+
+    difftest_ng is free software: you can redistribute it and/or modify
+    it under the terms of the GNU General Public License as published by
+    the Free Software Foundation, either version 3 of the License, or
+    (at your option) any later version.
+
+    difftest_ng is distributed in the hope that it will be useful,
+    but WITHOUT ANY WARRANTY; without even the implied warranty of
+    MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+    GNU General Public License for more details.
+
+    You should have received a copy of the GNU General Public License
+    along with difftest_ng.  If not, see <http://www.gnu.org/licenses/>.
+
+*************************************************************************/
+/*
+**
+** This file contains the logic to encode strips of TIFF files with
+** deflate, i.e. as zlib streams.
+**
+** $Id$
+**
+*/
+
+/// Includes
+#include "config.h"
+#include "tiff/deflateencoder.hpp"
+#ifdef USE_ZLIB
+#include <zlib.h>
+#endif
+///
+
+/// DeflateEncoder::Encode
+// Encode the given bytes as a single zlib stream.
+void DeflateEncoder::Encode(const UBYTE *data,ULONG size)
+{
+#ifdef USE_ZLIB
+  uLong  bound = compressBound(size);
+  uLongf bytes = bound;
+  UBYTE *output;
+  //
+  if (bound < size || bound != ULONG(bound))
+    throw "TIFF strip growing too large";
+  //
+  output = Reserve(bound);
+  if (compress2(output,&bytes,data,size,Z_DEFAULT_COMPRESSION) != Z_OK)
+    throw "failed to deflate a strip of the TIFF image";
+  //
+  Advance(bytes);
+#else
+  (void)data;
+  (void)size;
+  throw "deflate support is not compiled in, sorry";
+#endif
+}
+///
@@ -0,0 +1,57 @@
+/*************************************************************************
+** Written by Thomas Richter (THOR Software) for Accusoft	        **
+** All Rights Reserved							**
+**************************************************************************
+
+This source file is part of difftest_ng, a universal image measuring
+and conversion framework.
+
+    difftest_ng is free software: you can redistribute it and/or modify
+    it under the terms of the GNU General Public License as published by
+    the Free Software Foundation, either version 3 of the License, or
+    (at your option) any later version.
+
+    difftest_ng is distributed in the hope that it will be useful,
+    but WITHOUT ANY WARRANTY; without even the implied warranty of
+    MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+    GNU General Public License for more details.
+
+    You should have received a copy of the GNU General Public License
+    along with difftest_ng.  If not, see <http://www.gnu.org/licenses/>.
+
+*************************************************************************/
+/*
+**
+** This file contains the logic to encode strips of TIFF files with
+** deflate, i.e. as zlib streams.
+**
+** $Id$
+**
+*/
+
+#ifndef TIFF_DEFLATEENCODER_HPP
+#define TIFF_DEFLATEENCODER_HPP
+
+/// Includes
+#include "interface/types.hpp"
+#include "tiff/encoderbase.hpp"
+///
+
+/// class DeflateEncoder
+class DeflateEncoder : public EncoderBase {
+  //
+public:
+  DeflateEncoder(void)
+  {
+  }
+  //
+  ~DeflateEncoder(void)
+  {
+  }
+  //
+  // Encode the given bytes as a single zlib stream.
+  void Encode(const UBYTE *data,ULONG size);
+};
+///
+
+#endif
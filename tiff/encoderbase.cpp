@@ -0,0 +1,66 @@
+/*************************************************************************
+** Written by Thomas Richter (THOR Software) for Accusoft	        **
+** All Rights Reserved							**
+**************************************************************************
+
+This source file is part of difftest_ng, a universal image measuring
+and conversion framework.
+
+    difftest_ng is free software: you can redistribute it and/or modify
+    it under the terms of the GNU General Public License as published by
+    the Free Software Foundation, either version 3 of the License, or
+    (at your option) any later version.
+
+    difftest_ng is distributed in the hope that it will be useful,
+    but WITHOUT ANY WARRANTY; without even the implied warranty of
+    MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+    GNU General Public License for more details.
+
+    You should have received a copy of the GNU General Public License
+    along with difftest_ng.  If not, see <http://www.gnu.org/licenses/>.
+
+*************************************************************************/
+/*
+**
+** This file contains the base class for all TIFF type buffer encoders.
+** They collect the compressed data of a strip in a buffer that grows
+** as needed.
+**
+** $Id$
+**
+*/
+
+/// Includes
+#include "tiff/encoderbase.hpp"
+#include "std/string.hpp"
+///
+
+/// EncoderBase::Reserve
+// Make room for the given number of bytes behind the data written
+// so far and return where they go.
+UBYTE *EncoderBase::Reserve(ULONG bytes)
+{
+  if (m_ulBytes + bytes < m_ulBytes)
+    throw "TIFF strip growing too large";
+  //
+  if (m_ulBytes + bytes > m_ulSize) {
+    ULONG  size = (m_ulSize)?(m_ulSize):(1UL << 12);
+    UBYTE *buffer;
+    //
+    while(m_ulBytes + bytes > size) {
+      if (size << 1 < size) {
+	size = m_ulBytes + bytes;
+	break;
+      }
+      size <<= 1;
+    }
+    buffer = new UBYTE[size];
+    if (m_ulBytes)
+      memcpy(buffer,m_pucBuffer,m_ulBytes);
+    delete[] m_pucBuffer;
+    m_pucBuffer = buffer;
+    m_ulSize    = size;
+  }
+  return m_pucBuffer + m_ulBytes;
+}
+///
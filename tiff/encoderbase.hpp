@@ -0,0 +1,92 @@
+/*************************************************************************
+** Written by Thomas Richter (THOR Software) for Accusoft	        **
+** All Rights Reserved							**
+**************************************************************************
+
+This source file is part of difftest_ng, a universal image measuring
+and conversion framework.
+
+    difftest_ng is free software: you can redistribute it and/or modify
+    it under the terms of the GNU General Public License as published by
+    the Free Software Foundation, either version 3 of the License, or
+    (at your option) any later version.
+
+    difftest_ng is distributed in the hope that it will be useful,
+    but WITHOUT ANY WARRANTY; without even the implied warranty of
+    MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+    GNU General Public License for more details.
+
+    You should have received a copy of the GNU General Public License
+    along with difftest_ng.  If not, see <http://www.gnu.org/licenses/>.
+
+*************************************************************************/
+/*
+**
+** This file contains the base class for all TIFF type buffer encoders.
+** They collect the compressed data of a strip in a buffer that grows
+** as needed.
+**
+** $Id$
+**
+*/
+
+#ifndef TIFF_ENCODERBASE_HPP
+#define TIFF_ENCODERBASE_HPP
+
+/// Includes
+#include "interface/types.hpp"
+///
+
+/// class EncoderBase
+class EncoderBase {
+  //
+  // The buffer, its size and the bytes written into it.
+  UBYTE *m_pucBuffer;
+  ULONG  m_ulSize;
+  ULONG  m_ulBytes;
+  //
+protected:
+  // Make room for the given number of bytes behind the data written
+  // so far and return where they go. Encoders write into this room
+  // and account for it with Advance.
+  UBYTE *Reserve(ULONG bytes);
+  //
+  // Mark the given number of bytes behind the data as written.
+  void Advance(ULONG bytes)
+  {
+    m_ulBytes += bytes;
+  }
+  //
+public:
+  EncoderBase(void)
+    : m_pucBuffer(NULL), m_ulSize(0), m_ulBytes(0)
+  {
+  }
+  //
+  ~EncoderBase(void)
+  {
+    delete[] m_pucBuffer;
+  }
+  //
+  // Return the number of bytes encoded.
+  ULONG BytesOf(void) const
+  {
+    return m_ulBytes;
+  }
+  //
+  // Hand the encoded data over to the caller who has to release
+  // it with delete[]. The encoder starts over empty.
+  UBYTE *Detach(void)
+  {
+    UBYTE *data = m_pucBuffer;
+    
+    m_pucBuffer = NULL;
+    m_ulSize    = 0;
+    m_ulBytes   = 0;
+
+    return data;
+  }
+};
+///
+
+#endif
@@ -34,153 +34,234 @@ and conversion framework.
 #include "tiff/lzwdecoder.hpp"
 #include "tiff/tiffparser.hpp"
 #include "std/assert.hpp"
+#include "std/string.hpp"
 ///
 
 /// LZWDecoder::LZWDecoder
 // Start an LZW decoder on the given data buffer with the given number of bytes in the buffer.
 LZWDecoder::LZWDecoder(UBYTE *buffer,ULONG size,bool bigendian)
   : DecoderBase(buffer,size), DecoderFunctions<LZWDecoder>(this,bigendian),
-    m_ucBitPos(8), m_ucBitsPerCode(9), m_usTableSize(0), 
-    m_pucNextOutput(&m_ucOutputBuffer[0])
+    m_uqBits(0), m_ucBitsAvail(0), m_ucBitsPerCode(9), m_usTableSize(0), 
+    m_usOldCode(0), m_ulOldPos(0), m_bPendingClear(false), m_pcError(NULL),
+    m_pucOutput(NULL), m_ulOutputSize(0), m_ulOutputBytes(0),
+    m_pucNextOutput(NULL), m_pucOutputEnd(NULL)
 {
+  int i;
+  
   if (size >= 2 && buffer[0] == 0 && (buffer[1] & 0x01)) {
     m_bLefty = true; // old style LZW code
   } else {
     m_bLefty = false;
   }
-}
-///
-
-/// LZWDecoder::~LZWDecoder
-LZWDecoder::~LZWDecoder(void)
-{
-}
-///
-
-/// LZWDecoder::InitializeTable
-// Initialize the table, including ClearCode and EOICode
-void LZWDecoder::InitializeTable()
-{
-  int i;
-
+  
+  // The single-byte strings never change.
   for(i = 0;i < 256;i++) {
-    m_ucCodeTable[i]   = i;          // this is the identity table
-    m_usPrefixTable[i] = LastPrefix; // doesn't have a prefix anymore.
+    m_usLengthTable[i] = 1;
+    m_ucFirstTable[i]  = i;
   }
-
-  // Entries 256 and 257 are reserved.
-  m_usTableSize   = EOICode + 1;
-  m_ucBitsPerCode = 9;
+  
+  // Zero-initialized as short strings may copy more bytes than they have.
+  m_pucOutput     = new UBYTE[m_ulOutputSize = OutputBufferSize]();
+  m_pucNextOutput = m_pucOutput;
+  m_pucOutputEnd  = m_pucOutput;
 }
 ///
 
-/// LZWDecoder::StringFromCode
-// Fill in the string encoded by the given code into the output table,
-// possibly enlarging the table. Note that this string is filled in in reverse
-// order, it is inverted by the read-out procedure. If reserve is given,
-// the indicated number of bytes are additionally reserved at the end of
-// the string (and thus at the beginning of the buffer)
-void LZWDecoder::StringFromCode(UWORD code,int reserve)
+/// LZWDecoder::~LZWDecoder
+LZWDecoder::~LZWDecoder(void)
 {
-  UBYTE *output = m_ucOutputBuffer + reserve;
-  
-  do {
-    assert(code != EOICode && code != ClearCode && code < m_usTableSize);
-    
-    // If there is no room in the table, something strange happened.
-    if (output >= &m_ucOutputBuffer[OutputBufferSize])
-      throw "LZW output buffer overflow, probably a corrupt LZW?";
-
-    *output++ = m_ucCodeTable[code];
-    code      = m_usPrefixTable[code];
-  } while(code != LastPrefix);
-    
-  m_pucNextOutput = output;
+  delete[] m_pucOutput;
 }
 ///
 
-/// LZWDecoder::AddToTable
-// Add an entry into the table which has as prefix the string that
-// belongs to the prefix code, and that has the given postfix character.
-void LZWDecoder::AddToTable(UWORD prefix,UBYTE postfix)
+/// LZWDecoder::ReserveOutput
+// Make room for the given number of bytes behind the first used
+// bytes of the output, return the output.
+UBYTE *LZWDecoder::ReserveOutput(ULONG used,ULONG bytes)
 {
-  assert(prefix != ClearCode && prefix != EOICode);
-  
-  if (m_usTableSize >= MaxTableSize)
-    throw "LZW dictionary overflow, probably a corrupt LZW stream";
-
-  m_ucCodeTable[m_usTableSize]   = postfix;
-  m_usPrefixTable[m_usTableSize] = prefix;
-
-  m_usTableSize++;
-  if (m_bLefty) {
-    if (m_usTableSize == 512)
-      m_ucBitsPerCode = 10;
-    if (m_usTableSize == 1024)
-      m_ucBitsPerCode = 11;
-    if (m_usTableSize == 2048)
-      m_ucBitsPerCode = 12;
-  } else {
-    if (m_usTableSize == 511)
-      m_ucBitsPerCode = 10;
-    if (m_usTableSize == 1023)
-      m_ucBitsPerCode = 11;
-    if (m_usTableSize == 2047)
-      m_ucBitsPerCode = 12;
+  if (used + bytes > m_ulOutputSize) {
+    ULONG  size = m_ulOutputSize;
+    UBYTE *output;
+    //
+    while(used + bytes > size) {
+      if (size << 1 < size)
+	throw "LZW output buffer overflow, probably a corrupt LZW?";
+      size <<= 1;
+    }
+    output = new UBYTE[size]();
+    memcpy(output,m_pucOutput,used);
+    delete[] m_pucOutput;
+    m_pucOutput    = output;
+    m_ulOutputSize = size;
   }
+  return m_pucOutput;
 }
 ///
 
 /// LZWDecoder::RefillBuffer
-// Refill the output buffer of the LZW decoder
+// Refill the output buffer of the LZW decoder by decoding the next
+// batch of codewords. The state is kept in locals while decoding as
+// the output would otherwise force the compiler to reload it after
+// every byte written.
 void LZWDecoder::RefillBuffer(void)
 {   
-  UWORD code;
-  
-  code = GetNextCode();
-  if (code == EOICode)
-    throw "reading past EOF of LZW input buffer";
-  
-  if (code == ClearCode) {
-    InitializeTable();
-
-    code = GetNextCode();
-
-    if (code == EOICode)
-      throw "reading past EOF of LZW input buffer";
-    
-    if (code == ClearCode)
-      throw "detected double ClearCode in LZW input buffer, LZW stream corrupt";
-    
-    StringFromCode(code);
-  } else {
+  UBYTE *input      = InputOf();
+  UBYTE *end        = EndOf();
+  UBYTE *output     = m_pucOutput;
+  UQUAD  bits       = m_uqBits;
+  UBYTE  avail      = m_ucBitsAvail;
+  UBYTE  width      = m_ucBitsPerCode;
+  UWORD  size       = m_usTableSize;
+  UWORD  old        = m_usOldCode;
+  ULONG  oldpos     = m_ulOldPos;
+  UWORD  early      = (m_bLefty)?(0):(1); // the new style switches one code early
+  bool   fresh      = false;              // set for the first code after ClearCode
+  const char *error = NULL;
+  ULONG  start,out;
+  UWORD  code;
+
+  if (m_pcError)
+    throw m_pcError;
+
+  if (m_bPendingClear) {
+    m_bPendingClear = false;
+    size            = EOICode + 1;
+    width           = 9;
+    m_ulOutputBytes = 0;
+    fresh           = true;
+  }
+  start = out = m_ulOutputBytes;
+
+  while(out - start < BatchSize) {
+    ULONG length;
+    //
+    // Get the next code.
+    if (avail < width) {
+      if (m_bLefty) {
+	while(avail <= 56 && input < end) {
+	  bits  |= UQUAD(*input++) << avail;
+	  avail += 8;
+	}
+      } else {
+	while(avail <= 56 && input < end) {
+	  bits   = (bits << 8) | *input++;
+	  avail += 8;
+	}
+      }
+      if (avail < width) {
+	error = "run out of data in TIFF decompression, input stream is possibly corrupt";
+	break;
+      }
+    }
+    avail -= width;
+    if (m_bLefty) {
+      code   = UWORD(bits & ((1UL << width) - 1));
+      bits >>= width;
+    } else {
+      code   = UWORD((bits >> avail) & ((1UL << width) - 1));
+    }
+    //
+    if (code == EOICode) {
+      error = "reading past EOF of LZW input buffer";
+      break;
+    }
     //
-    // Here: Not EOI, not ClearCode.
-    if (m_usTableSize < EOICode + 1)
-      throw "initial ClearCode missing in LZW stream";
+    if (code == ClearCode) {
+      if (fresh) {
+	error = "detected double ClearCode in LZW input buffer, LZW stream corrupt";
+	break;
+      }
+      if (out > start) {
+	// Deliver the output first, it starts over afterwards.
+	m_bPendingClear = true;
+	break;
+      }
+      size  = EOICode + 1;
+      width = 9;
+      start = out = 0;
+      fresh = true;
+      continue;
+    }
     //
-    // Is the just decoded code in the table?
-    if (code < m_usTableSize) {
-      StringFromCode(code); // Write out the code
-      // Add a new string into the table which has the prefix
-      // given from the previous code, and has a new postfix which is
-      // given by the first character of the string just decoded.
-      // ... below ...
-    } else if (code == m_usTableSize) {
+    if (size < EOICode + 1) {
+      error = "initial ClearCode missing in LZW stream";
+      break;
+    }
+    //
+    if (code < size) {
+      // Write out the string of the code. It is complete in the
+      // output before the current position.
+      length = m_usLengthTable[code];
+      if (out + length + CopySlack > m_ulOutputSize)
+	output = ReserveOutput(out,length + CopySlack);
+      if (code < ClearCode) {
+	output[out] = UBYTE(code);
+      } else if (length <= CopySlack) {
+	UQUAD v;
+	memcpy(&v,output + m_ulOffsetTable[code],sizeof(v));
+	memcpy(output + out,&v,sizeof(v));
+      } else {
+	memcpy(output + out,output + m_ulOffsetTable[code],length);
+      }
+    } else if (code == size && !fresh) {
       // Not in table. The new string is just the string from the previous
       // code, extended by a single character which is given by the
-      // first character of the output string.
-      StringFromCode(m_usOldCode,1);
-      // Extend the string by one character, namely the first in
-      // the buffer.
-      m_ucOutputBuffer[0] = m_pucNextOutput[-1];
-      //
-      // Add this code to the table. The new string is the old
-      // string extended by the first character.
-      // ... below ...
-    } else throw "detected invalid LZW code in TIFF input, LZW stream corrupt";
-    AddToTable(m_usOldCode,m_pucNextOutput[-1]);
+      // first character of the previous string.
+      length = m_usLengthTable[old] + 1;
+      if (out + length + CopySlack > m_ulOutputSize)
+	output = ReserveOutput(out,length + CopySlack);
+      if (old < ClearCode) {
+	output[out] = UBYTE(old);
+      } else {
+	memcpy(output + out,output + m_ulOffsetTable[old],length - 1);
+      }
+      output[out + length - 1] = m_ucFirstTable[old];
+    } else {
+      error = "detected invalid LZW code in TIFF input, LZW stream corrupt";
+      break;
+    }
+    //
+    // Add a new string into the table which has the prefix given from
+    // the previous code, and has a new postfix which is given by the
+    // first character of the string just decoded. The string of the
+    // previous code is followed by this string in the output, thus
+    // the new string is found there.
+    if (!fresh) {
+      if (size >= MaxTableSize) {
+	error = "LZW dictionary overflow, probably a corrupt LZW stream";
+	break;
+      }
+      m_ulOffsetTable[size] = oldpos;
+      m_usLengthTable[size] = m_usLengthTable[old] + 1;
+      m_ucFirstTable[size]  = m_ucFirstTable[old];
+      size++;
+      if (width < 12 && size == (1 << width) - early)
+	width++;
+    }
+    //
+    old     = code;
+    oldpos  = out;
+    out    += length;
+    fresh   = false;
+  }
+
+  InputOf()       = input;
+  m_uqBits        = bits;
+  m_ucBitsAvail   = avail;
+  m_ucBitsPerCode = width;
+  m_usTableSize   = size;
+  m_usOldCode     = old;
+  m_ulOldPos      = oldpos;
+  m_ulOutputBytes = out;
+  m_pucNextOutput = output + start;
+  m_pucOutputEnd  = output + out;
+
+  if (error) {
+    // Errors behind the output decoded so far only count once it
+    // has been delivered and more is requested.
+    if (out == start)
+      throw error;
+    m_pcError = error;
   }
-  m_usOldCode = code;
 }
 ///
@@ -41,10 +41,20 @@ and conversion framework.
 ///
 
 /// class LZWDecoder
+// Strings of the dictionary are not chased through prefix codes. Every
+// string is the string of the previous code extended by one byte, and
+// as such it is already part of the output decoded since the last
+// ClearCode. The table thus only keeps where the string starts in
+// this output, its length and its first byte, and strings are copied
+// forwards from there. Codes are decoded in batches from a 64 bit
+// buffer of input bits.
 class LZWDecoder : public DecoderBase, public DecoderFunctions<LZWDecoder> {
   //
-  // The current bit position in the code
-  UBYTE  m_ucBitPos;
+  // Bits read from the input, but not yet consumed by codes.
+  UQUAD  m_uqBits;
+  //
+  // Number of valid bits in the bit buffer.
+  UBYTE  m_ucBitsAvail;
   //
   // Number of bits per code, depends on the table size.
   UBYTE  m_ucBitsPerCode;
@@ -55,63 +65,58 @@ class LZWDecoder : public DecoderBase, public DecoderFunctions<LZWDecoder> {
   // The previous code just decoded before.
   UWORD  m_usOldCode;
   //
-  // Pointer in the output string buffer, namely where the next string
-  // from the output table is removed. Note that this is read end to start,
-  // in reverse order.
-  UBYTE *m_pucNextOutput;
+  // Position of the string of the previous code in the output.
+  ULONG  m_ulOldPos;
   //
   // Set for old-style compatibility LZW-codes that use a different bit-filling
   // order.
   bool   m_bLefty;
   //
+  // Set if a ClearCode ended the last batch. The output then starts
+  // over once it has been delivered.
+  bool   m_bPendingClear;
+  //
+  // An error found while decoding ahead. It is only reported once
+  // the output decoded before it has been delivered.
+  const char *m_pcError;
+  //
   enum {
     MaxTableSize     = (1 << 12) - 1 + 1024, // maximal number of entries allowed here.
-    OutputBufferSize = (1 << 16)
+    OutputBufferSize = (1 << 16),            // initial size of the output buffer.
+    BatchSize        = (1 << 12),            // output bytes decoded at once.
+    CopySlack        = 8                     // bytes short strings may copy beyond their end.
   };
   //
-  // The table is encoded in the following way: The first array contains the postfix,
-  // the second table the offset of the prefix in the postfix if there is one, or MAX_UWORD
-  // in case there is no prefix and the entry is the start of the string.
-  UBYTE m_ucCodeTable[MaxTableSize];
+  // For each code, the position of its string in the output, its
+  // length and its first byte.
+  ULONG m_ulOffsetTable[MaxTableSize];
   //
-  UWORD m_usPrefixTable[MaxTableSize];
+  UWORD m_usLengthTable[MaxTableSize];
   //
-  // The output buffer.
-  UBYTE m_ucOutputBuffer[OutputBufferSize];
+  UBYTE m_ucFirstTable[MaxTableSize];
   //
-  // Initialize the table, including ClearCode and EOICode
-  void InitializeTable();
+  // The output decoded since the last ClearCode, its size and
+  // the number of bytes in it.
+  UBYTE *m_pucOutput;
+  ULONG  m_ulOutputSize;
+  ULONG  m_ulOutputBytes;
   //
-  // Return the next code from the buffer.
-  UWORD GetNextCode(void)
-  {
-    if (m_bLefty) {
-      return ReadBitsReversed(m_ucBitPos,m_ucBitsPerCode,false);
-    } else {
-      return ReadBits(m_ucBitPos,m_ucBitsPerCode,false);
-    }
-  }
+  // The next output byte to deliver and the end of the output.
+  UBYTE *m_pucNextOutput;
+  UBYTE *m_pucOutputEnd;
   //
   // Special codes
   enum {
     ClearCode  = 256,		// re-initialize the string table
-    EOICode    = 257,           // end of data
-    LastPrefix = 0xffff         // last entry, no prefix anymore.
+    EOICode    = 257            // end of data
   };
   //
-  // Add an entry into the table which has as prefix the string that
-  // belongs to the prefix code, and that has the given postfix character.
-  void AddToTable(UWORD prefix,UBYTE postfix);
-  //
-  // Fill in the string encoded by the given code into the output table,
-  // possibly enlarging the table. Note that this string is filled in in reverse
-  // order, it is inverted by the read-out procedure. If reserve is given,
-  // the indicated number of bytes are additionally reserved at the end of
-  // the string (and thus at the beginning of the buffer)
-  void StringFromCode(UWORD code,int reserve = 0);
+  // Make room for the given number of bytes behind the first used
+  // bytes of the output, return the output.
+  UBYTE *ReserveOutput(ULONG used,ULONG bytes);
   //
   // Refill the output buffer of the LZW decoder by decoding the next
-  // codeword in the input buffer
+  // batch of codewords in the input buffer
   void RefillBuffer(void);
 public:
   // Start an LZW decoder on the given data buffer with the given number of bytes in the buffer.
@@ -123,13 +128,12 @@ public:
   UBYTE GetUBYTE(void)
   {
     // Need to refill the output buffer?
-    if (m_pucNextOutput <= m_ucOutputBuffer) {
+    if (m_pucNextOutput >= m_pucOutputEnd) {
       RefillBuffer();
     }
     
     // Deliver the next output character.
-    // Note that this is reversed.
-    return *(--m_pucNextOutput);
+    return *m_pucNextOutput++;
   }  
   //
 };
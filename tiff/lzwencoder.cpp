@@ -0,0 +1,115 @@
+/*************************************************************************
+** Written by Thomas Richter (THOR Software) for Accusoft	        **
+** All Rights Reserved							**
+**************************************************************************
+
+This source file is part of difftest_ng, a universal image measuring
+and conversion framework.
+
+    difftest_ng is free software: you can redistribute it and/or modify
+    it under the terms of the GNU General Public License as published by
+    the Free Software Foundation, either version 3 of the License, or
+    (at your option) any later version.
+
+    difftest_ng is distributed in the hope that it will be useful,
+    but WITHOUT ANY WARRANTY; without even the implied warranty of
+    MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+    GNU General Public License for more details.
+
+    You should have received a copy of the GNU General Public License
+    along with difftest_ng.  If not, see <http://www.gnu.org/licenses/>.
+
+*************************************************************************/
+/*
+**
+** This file contains the logic to encode strips of TIFF files with LZW.
+**
+** $Id$
+**
+*/
+
+/// Includes
+#include "tiff/lzwencoder.hpp"
+#include "std/string.hpp"
+///
+
+/// LZWEncoder::Encode
+// Encode the given bytes as a single LZW stream. The stream starts
+// with a ClearCode, and the table is started over by another one
+// once it is full.
+void LZWEncoder::Encode(const UBYTE *data,ULONG size)
+{
+  UBYTE *start,*output;
+  UQUAD  bits  = 0;
+  UBYTE  avail = 0;
+  UBYTE  width = 9;
+  ULONG  next  = FirstCode;
+  ULONG  bound;
+  UWORD  ent;
+  ULONG  i;
+  //
+  // Every byte creates at most one code of twelve bits, plus the
+  // ClearCodes, the last code, EOICode and the padding bits.
+  bound = size + (size >> 1);
+  if (bound < size)
+    throw "TIFF strip growing too large";
+  bound += (size >> 11) + 16;
+  if (bound < size)
+    throw "TIFF strip growing too large";
+  start = output = Reserve(bound);
+  //
+  memset(m_ulHashKey,0,sizeof(m_ulHashKey));
+  PutCode(output,bits,avail,ClearCode,width);
+  //
+  if (size > 0) {
+    ent = *data++;
+    for(i = 1;i < size;i++) {
+      UBYTE c   = *data++;
+      ULONG key = ((ULONG(ent) << 8) | c) + 1;
+      ULONG h   = HashOf(key);
+      //
+      while(m_ulHashKey[h]) {
+	if (m_ulHashKey[h] == key)
+	  break;
+	h = (h + 1) & (HashSize - 1);
+      }
+      if (m_ulHashKey[h]) {
+	// The string continues, extend it.
+	ent = m_usHashCode[h];
+	continue;
+      }
+      //
+      // The string ends here, the new one is the old one extended by c.
+      PutCode(output,bits,avail,ent,width);
+      m_ulHashKey[h]  = key;
+      m_usHashCode[h] = next++;
+      ent             = c;
+      if (next == FullCode) {
+	PutCode(output,bits,avail,ClearCode,width);
+	memset(m_ulHashKey,0,sizeof(m_ulHashKey));
+	next  = FirstCode;
+	width = 9;
+      } else if (next > (1UL << width) - 1) {
+	width++;
+      }
+    }
+    //
+    // The decoder adds the entry for the last code as well and widens
+    // the code for EOICode accordingly.
+    PutCode(output,bits,avail,ent,width);
+    if (++next == FullCode) {
+      PutCode(output,bits,avail,ClearCode,width);
+      width = 9;
+    } else if (next > (1UL << width) - 1) {
+      width++;
+    }
+  }
+  PutCode(output,bits,avail,EOICode,width);
+  //
+  // Pad the last byte with zeros.
+  if (avail > 0)
+    *output++ = UBYTE(bits << (8 - avail));
+  //
+  Advance(output - start);
+}
+///
@@ -0,0 +1,97 @@
+/*************************************************************************
+** Written by Thomas Richter (THOR Software) for Accusoft	        **
+** All Rights Reserved							**
+**************************************************************************
+
+This source file is part of difftest_ng, a universal image measuring
+and conversion framework.
+
+    difftest_ng is free software: you can redistribute it and/or modify
+    it under the terms of the GNU General Public License as published by
+    the Free Software Foundation, either version 3 of the License, or
+    (at your option) any later version.
+
+    difftest_ng is distributed in the hope that it will be useful,
+    but WITHOUT ANY WARRANTY; without even the implied warranty of
+    MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+    GNU General Public License for more details.
+
+    You should have received a copy of the GNU General Public License
+    along with difftest_ng.  If not, see <http://www.gnu.org/licenses/>.
+
+*************************************************************************/
+/*
+**
+** This file contains the logic to encode strips of TIFF files with LZW.
+**
+** $Id$
+**
+*/
+
+#ifndef TIFF_LZWENCODER_HPP
+#define TIFF_LZWENCODER_HPP
+
+/// Includes
+#include "interface/types.hpp"
+#include "tiff/encoderbase.hpp"
+///
+
+/// class LZWEncoder
+// Writes the new style LZW codes of TIFF 6.0, i.e. codes are packed
+// starting at the most significant bit, and the code size grows one
+// code early. The strings of the dictionary are found by hashing the
+// code of their prefix together with their last byte.
+class LZWEncoder : public EncoderBase {
+  //
+  // Special codes
+  enum {
+    ClearCode  = 256,		// re-initialize the string table
+    EOICode    = 257,           // end of data
+    FirstCode  = 258,           // the first code of a multi-byte string
+    FullCode   = (1 << 12) - 2  // the table is started over at this size
+  };
+  //
+  enum {
+    HashBits   = 13,
+    HashSize   = 1 << HashBits
+  };
+  //
+  // The hash table. An entry holds the prefix code shifted up by eight
+  // bits, or'd with the last byte, plus one such that zero marks an
+  // empty entry. The code of the string is kept in a second table.
+  ULONG m_ulHashKey[HashSize];
+  UWORD m_usHashCode[HashSize];
+  //
+  // Return the slot a string of the given key is hashed to first.
+  static ULONG HashOf(ULONG key)
+  {
+    return (key * 2654435761UL) >> (32 - HashBits) & (HashSize - 1);
+  }
+  //
+  // Pack a code of the given width into the output, flush complete
+  // bytes from the bit buffer.
+  static void PutCode(UBYTE *&output,UQUAD &bits,UBYTE &avail,UWORD code,UBYTE width)
+  {
+    bits   = (bits << width) | code;
+    avail += width;
+    while(avail >= 8) {
+      avail    -= 8;
+      *output++ = UBYTE(bits >> avail);
+    }
+  }
+  //
+public:
+  LZWEncoder(void)
+  {
+  }
+  //
+  ~LZWEncoder(void)
+  {
+  }
+  //
+  // Encode the given bytes as a single LZW stream.
+  void Encode(const UBYTE *data,ULONG size);
+};
+///
+
+#endif
@@ -0,0 +1,90 @@
+/*************************************************************************
+** Written by Thomas Richter (THOR Software) for Accusoft	        **
+** All Rights Reserved							**
+**************************************************************************
+
+This source file is part of difftest_ng, a universal image measuring
+and conversion framework.
+
+    difftest_ng is free software: you can redistribute it and/or modify
+    it under the terms of the GNU General Public License as published by
+    the Free Software Foundation, either version 3 of the License, or
+    (at your option) any later version.
+
+    difftest_ng is distributed in the hope that it will be useful,
+    but WITHOUT ANY WARRANTY; without even the implied warranty of
+    MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+    GNU General Public License for more details.
+
+    You should have received a copy of the GNU General Public License
+    along with difftest_ng.  If not, see <http://www.gnu.org/licenses/>.
+
+*************************************************************************/
+/*
+**
+** This file contains the logic to encode strips of TIFF files with
+** packbits.
+**
+** $Id$
+**
+*/
+
+/// Includes
+#include "tiff/packbitsencoder.hpp"
+#include "std/assert.hpp"
+#include "std/string.hpp"
+///
+
+/// PackBitsEncoder::EncodeRow
+// Pack a single row of the given number of bytes.
+void PackBitsEncoder::EncodeRow(const UBYTE *row,ULONG bytes)
+{
+  const UBYTE *end = row + bytes;
+  UBYTE *start,*output;
+  //
+  // Literals take one header byte per 128 bytes.
+  start = output = Reserve(bytes + (bytes >> 7) + 1);
+  //
+  while(row < end) {
+    ULONG run = 1;
+    //
+    while(row + run < end && run < 128 && row[run] == row[0])
+      run++;
+    //
+    if (run >= 3) {
+      *output++ = UBYTE(257 - run); // i.e. 1 - run as a signed byte.
+      *output++ = row[0];
+      row      += run;
+    } else {
+      const UBYTE *literal = row;
+      //
+      // Copy up to the next run, which cannot start at the first byte.
+      do {
+	row++;
+      } while(row < end && row - literal < 128 &&
+	      !(row + 2 < end && row[0] == row[1] && row[1] == row[2]));
+      *output++ = UBYTE(row - literal - 1);
+      memcpy(output,literal,row - literal);
+      output   += row - literal;
+    }
+  }
+  //
+  Advance(output - start);
+}
+///
+
+/// PackBitsEncoder::Encode
+// Encode the given bytes, consisting of rows of the given
+// number of bytes each.
+void PackBitsEncoder::Encode(const UBYTE *data,ULONG size,ULONG bytesperrow)
+{
+  assert(bytesperrow > 0);
+  
+  while(size > 0) {
+    ULONG bytes = (size < bytesperrow)?(size):(bytesperrow);
+    EncodeRow(data,bytes);
+    data += bytes;
+    size -= bytes;
+  }
+}
+///
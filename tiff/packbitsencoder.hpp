@@ -0,0 +1,64 @@
+/*************************************************************************
+** Written by Thomas Richter (THOR Software) for Accusoft	        **
+** All Rights Reserved							**
+**************************************************************************
+
+This source file is part of difftest_ng, a universal image measuring
+and conversion framework.
+
+    difftest_ng is free software: you can redistribute it and/or modify
+    it under the terms of the GNU General Public License as published by
+    the Free Software Foundation, either version 3 of the License, or
+    (at your option) any later version.
+
+    difftest_ng is distributed in the hope that it will be useful,
+    but WITHOUT ANY WARRANTY; without even the implied warranty of
+    MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+    GNU General Public License for more details.
+
+    You should have received a copy of the GNU General Public License
+    along with difftest_ng.  If not, see <http://www.gnu.org/licenses/>.
+
+*************************************************************************/
+/*
+**
+** This file contains the logic to encode strips of TIFF files with
+** packbits.
+**
+** $Id$
+**
+*/
+
+#ifndef TIFF_PACKBITSENCODER_HPP
+#define TIFF_PACKBITSENCODER_HPP
+
+/// Includes
+#include "interface/types.hpp"
+#include "tiff/encoderbase.hpp"
+///
+
+/// class PackBitsEncoder
+// Runs of three or more identical bytes are replicated, all other
+// bytes are copied literally. As required by TIFF, every row is
+// packed separately.
+class PackBitsEncoder : public EncoderBase {
+  //
+  // Pack a single row of the given number of bytes.
+  void EncodeRow(const UBYTE *row,ULONG bytes);
+  //
+public:
+  PackBitsEncoder(void)
+  {
+  }
+  //
+  ~PackBitsEncoder(void)
+  {
+  }
+  //
+  // Encode the given bytes, consisting of rows of the given
+  // number of bytes each.
+  void Encode(const UBYTE *data,ULONG size,ULONG bytesperrow);
+};
+///
+
+#endif
@@ -42,9 +42,10 @@ and conversion framework.
 /// TiffParser::TiffParser
 // Construct the tiff parser from a file name.
 TiffParser::TiffParser(const char *filename)
-  : m_pFile(NULL), m_pulBitsPerPixel(NULL), m_pulColorMap(NULL), 
+  : m_pFile(NULL), m_pucIFD(NULL), m_ulEntries(0),
+    m_pulBitsPerPixel(NULL), m_pulColorMap(NULL), 
     m_pulSubsampling(NULL), m_pulSampleFormats(NULL),
-    m_pulStripByteCount(NULL), m_pulStripOffset(NULL),
+    m_puqStripByteCount(NULL), m_puqStripOffset(NULL),
     m_ulUnits(0), m_pucBuffer(NULL), m_ulBufferSize(0)
 {
   char header[4];
@@ -71,15 +72,27 @@ TiffParser::TiffParser(const char *filename)
       return; // not necessary;
     }
     
-    if ((m_bBigEndian  && (header[2] != 0  || header[3] != 42)) ||
-	(!m_bBigEndian && (header[2] != 42 || header[3] != 0))) {
+    if ((m_bBigEndian  && header[2] == 0  && header[3] == 42) ||
+	(!m_bBigEndian && header[2] == 42 && header[3] == 0)) {
+      m_bBigTIFF = false;
+    } else if ((m_bBigEndian  && header[2] == 0  && header[3] == 43) ||
+	       (!m_bBigEndian && header[2] == 43 && header[3] == 0)) {
+      // BigTIFF: the size of the offsets follows, and a reserved word.
+      m_bBigTIFF = true;
+      if (GetWord() != 8 || GetWord() != 0) {
+	ImageLayout::PostError("%s is a BigTIFF file with an unsupported offset size",filename);
+	return; // not necessary
+      }
+    } else {
       ImageLayout::PostError("%s contains an invalid TIFF version number",filename);
       return; // not necessary
     }
 
-    // Now get the location of the first IFD
-    m_ulIFDPos = GetLong();
+    // Now get the location of the first IFD, and read it.
+    m_uqIFDPos = GetOffset();
+    ReadIFD();
   } catch(...) {
+    delete[] m_pucIFD;
     fclose(m_pFile);
     throw;
   }
@@ -92,12 +105,13 @@ TiffParser::~TiffParser(void)
   if (m_pFile) {
     fclose(m_pFile); m_pFile = NULL;
   }
+  delete[] m_pucIFD;
   delete[] m_pulBitsPerPixel;
   delete[] m_pulColorMap;
   delete[] m_pulSubsampling;
   delete[] m_pulSampleFormats;
-  delete[] m_pulStripByteCount;
-  delete[] m_pulStripOffset;
+  delete[] m_puqStripByteCount;
+  delete[] m_puqStripOffset;
   delete[] m_pucBuffer;
 }
 ///
@@ -158,6 +172,24 @@ ULONG TiffParser::GetLong(void)
 }
 ///
 
+/// TiffParser::GetQuad
+// Read an eight-byte entry, be endian-aware.
+UQUAD TiffParser::GetQuad(void)
+{
+  ULONG lo,hi;
+
+  if (m_bBigEndian) {
+    hi = GetLong();
+    lo = GetLong();
+  } else {
+    lo = GetLong();
+    hi = GetLong();
+  }
+
+  return UQUAD(lo) | (UQUAD(hi) << 32);
+}
+///
+
 /// TiffParser::GetFloat
 // Read a single-precision IEEE float.
 FLOAT TiffParser::GetFloat(void)
@@ -181,17 +213,8 @@ DOUBLE TiffParser::GetDouble(void)
     UQUAD uq;
     DOUBLE d;
   } u;
-  ULONG lo,hi;
-
-  if (m_bBigEndian) {
-    hi = GetLong();
-    lo = GetLong();
-  } else {
-    lo = GetLong();
-    hi = GetLong();
-  }
 
-  u.uq = UQUAD(lo) | (UQUAD(hi) << 32);
+  u.uq = GetQuad();
 
   return u.d;
 }
@@ -199,44 +222,82 @@ DOUBLE TiffParser::GetDouble(void)
 
 /// TiffParser::Seek
 // Seek to the indicated offset, throw on error.
-void TiffParser::Seek(ULONG pos)
+void TiffParser::Seek(UQUAD pos)
 {  
-  if (pos > MAX_LONG) {
-    ImageLayout::PostError("Error parsing %s: file offset is beyond 2GB barrier",m_pcFilename);
+#ifdef HAVE_FSEEKO64
+  if (pos != UQUAD(off64_t(pos)) || off64_t(pos) < 0) {
+    ImageLayout::PostError("Error parsing %s: file offset is beyond the range of the system",m_pcFilename);
   }
   
-  if (fseek(m_pFile,pos,SEEK_SET) < 0) {
+  if (fseeko64(m_pFile,off64_t(pos),SEEK_SET) < 0) {
     ImageLayout::PostError("%s: cannot seek in TIFF file %s",strerror(errno),m_pcFilename);
   }
+#else
+  if (pos != UQUAD(long(pos)) || long(pos) < 0) {
+    ImageLayout::PostError("Error parsing %s: file offset is beyond the range of the system",m_pcFilename);
+  }
+  
+  if (fseek(m_pFile,long(pos),SEEK_SET) < 0) {
+    ImageLayout::PostError("%s: cannot seek in TIFF file %s",strerror(errno),m_pcFilename);
+  }
+#endif
 }
 ///
 
-/// TiffParser::FindTag
-// Position the file pointer on the tiff tag at the IFD starting
-// at the indicated position. Return true if this entry exists.
-// Return false otherwise. Note that this is not very fast as a 
-// lot of seeking is done, but nevermind.
-bool TiffParser::FindTag(UWORD matchtag)
+/// TiffParser::ReadBytes
+// Read the given number of bytes from the current position of
+// the file into the buffer, throw on error.
+void TiffParser::ReadBytes(UBYTE *buffer,ULONG size)
 {
-  UWORD entries;
+  errno = 0;
+  if (fread(buffer,sizeof(UBYTE),size,m_pFile) != size) {
+    if (errno) {
+      ImageLayout::PostError("%s: while reading the TIFF file %s",strerror(errno),m_pcFilename);
+    } else {
+      ImageLayout::PostError("unexpected EOF, file %s is truncated",m_pcFilename);
+    }
+  }
+}
+///
+
+/// TiffParser::ReadIFD
+// Read all entries of the IFD at m_uqIFDPos into memory. Each
+// entry consists of the tag, the type, the count and the value
+// or offset field. The latter two are four bytes in TIFF and
+// eight bytes in BigTIFF.
+void TiffParser::ReadIFD(void)
+{
+  ULONG size = (m_bBigTIFF)?(2+2+8+8):(2+2+4+4);
+  UQUAD entries;
+
+  Seek(m_uqIFDPos);
   
-  Seek(m_ulIFDPos);
+  entries = (m_bBigTIFF)?(GetQuad()):(GetWord());
+  if (entries > MAX_UWORD)
+    ImageLayout::PostError("%s contains too many IFD entries, invalid TIFF",m_pcFilename);
+  
+  m_ulEntries = ULONG(entries);
+  m_pucIFD    = new UBYTE[m_ulEntries * size];
+  ReadBytes(m_pucIFD,m_ulEntries * size);
+}
+///
 
-  entries = GetWord();
-  while(entries) {
-    UWORD tag = GetWord();
-    if (tag == matchtag)
-      return true; // found the entry.
-    //
-    // Otherwise, skip the entry. It follows a type field, followed by a four-byte count field,
-    // followed by a value/offset field.
-    GetWord();
-    GetLong();
-    GetLong();
-    entries--;
+/// TiffParser::FindTag
+// Find the tiff tag in the entries of the IFD. Return a pointer
+// to the type field of the entry if it exists, NULL otherwise.
+UBYTE *TiffParser::FindTag(UWORD matchtag)
+{
+  ULONG size   = (m_bBigTIFF)?(2+2+8+8):(2+2+4+4);
+  UBYTE *entry = m_pucIFD;
+  ULONG i;
+
+  for(i = 0;i < m_ulEntries;i++,entry += size) {
+    UBYTE *p = entry;
+    if (GetUWORD(p) == matchtag)
+      return p; // found the entry, the type follows.
   }
 
-  return false;
+  return NULL;
 }
 ///
 
@@ -245,28 +306,41 @@ bool TiffParser::FindTag(UWORD matchtag)
 // true if found, otherwise return false.
 bool TiffParser::GetScalarTag(UWORD matchtag,ULONG &value)
 {
-  if (FindTag(matchtag)) {
-    UWORD type  = GetWord();
-    ULONG count = GetLong();
+  UBYTE *p = FindTag(matchtag);
+  
+  if (p) {
+    UWORD type  = GetUWORD(p);
+    UQUAD count = GetOffset(p);
     if (count != 1) {
       ImageLayout::PostError("Expected a scalar type when parsing tag %d in file %s, invalid TIFF",matchtag,m_pcFilename);
       return false;
     }
-    // Only numeric types are supported here.
+    // Only numeric types are supported here. The value is
+    // directly in the entry.
     switch(type) {
     case 1: // byte entry.
-      value = GetByte(); // directly in the entry.
+      value = *p;
       return true;
     case 3: // short entry.
-      value = GetWord();
+      value = GetUWORD(p);
       return true;
     case 4: // long entry.
-      value = GetLong();
+      value = GetULONG(p);
       return true;
-    default:
-      ImageLayout::PostError("Expected a numeric integer type when parsing tag %d in file %s, invalid TIFF",matchtag,m_pcFilename);
-      return false;
+    case 16: // long8 entry, BigTIFF only.
+      if (m_bBigTIFF) {
+	UQUAD v = GetUQUAD(p);
+	if (v > MAX_ULONG) {
+	  ImageLayout::PostError("Value of tag %d in file %s is out of range",matchtag,m_pcFilename);
+	  return false;
+	}
+	value = ULONG(v);
+	return true;
+      }
+      break;
     }
+    ImageLayout::PostError("Expected a numeric integer type when parsing tag %d in file %s, invalid TIFF",matchtag,m_pcFilename);
+    return false;
   }
   return false;
 }
@@ -278,9 +352,11 @@ bool TiffParser::GetScalarTag(UWORD matchtag,ULONG &value)
 // also floating point tags.
 bool TiffParser::GetScalarTag(UWORD matchtag,DOUBLE &value)
 {
-  if (FindTag(matchtag)) {
-    UWORD type  = GetWord();
-    ULONG count = GetLong();
+  UBYTE *p = FindTag(matchtag);
+  
+  if (p) {
+    UWORD type  = GetUWORD(p);
+    UQUAD count = GetOffset(p);
     if (count != 1) {
       ImageLayout::PostError("Expected a scalar type when parsing tag %d in file %s, invalid TIFF",matchtag,m_pcFilename);
       return false;
@@ -288,25 +364,32 @@ bool TiffParser::GetScalarTag(UWORD matchtag,DOUBLE &value)
     // Only numeric types are supported here.
     switch(type) {
     case 1: // byte entry.
-      value = GetByte(); // directly in the entry.
+      value = *p; // directly in the entry.
       return true;
     case 3: // short entry.
-      value = GetWord();
+      value = GetUWORD(p);
       return true;
     case 4: // long entry.
-      value = GetLong();
+      value = GetULONG(p);
       return true;
     case 6: // Byte
-      value = (BYTE)(GetByte());
+      value = (BYTE)(*p);
       return true;
     case 8: // signed word.
-      value = (WORD)(GetWord());
+      value = (WORD)(GetUWORD(p));
       return true;
     case 9: // signed long.
-      value = (LONG)(GetLong());
+      value = (LONG)(GetULONG(p));
       return true;
     case 11: // A single precision IEEE float.
-      value = GetFloat();
+      {
+	union {
+	  ULONG ul;
+	  FLOAT f;
+	} u;
+	u.ul  = GetULONG(p);
+	value = u.f;
+      }
       return true;
     default:
       ImageLayout::PostError("Expected a numeric integer type when parsing tag %d in file %s, invalid TIFF",matchtag,m_pcFilename);
@@ -320,73 +403,121 @@ bool TiffParser::GetScalarTag(UWORD matchtag,DOUBLE &value)
 /// TiffParser::GetVectorTag
 // Read a vectorial type from the TIFF directory,
 // return true if found, then the type is allocated and the size is
-// returned. Otherwise, false is returned.
-bool TiffParser::GetVectorTag(UWORD matchtag,ULONG &size,ULONG *&vector)
+// returned. Otherwise, false is returned. This keeps 64-bit entries
+// as they are. Values that do not fit into the entry are read in
+// one go.
+bool TiffParser::GetVectorTag(UWORD matchtag,ULONG &size,UQUAD *&vector)
 {
-  ULONG *tmp = NULL;
+  UQUAD *tmp  = NULL;
+  UBYTE *data = NULL;
+  UBYTE *p    = FindTag(matchtag);
   assert(vector == NULL);
 
-  try {
-    if (FindTag(matchtag)) {
-      ULONG i;
-      UWORD type  = GetWord();
-      ULONG count = GetLong();
-      //
+  if (p) {
+    ULONG i,bytes = 0;
+    UWORD type    = GetUWORD(p);
+    UQUAD count   = GetOffset(p);
+    // At most four bytes fit into the IFD of a TIFF, and eight into
+    // that of a BigTIFF. Otherwise, it is an offset into the file.
+    ULONG room    = (m_bBigTIFF)?(8):(4);
+    //
+    switch(type) {
+    case 1: // byte entry.
+      bytes = 1;
+      break;
+    case 3: // short entry.
+      bytes = 2;
+      break;
+    case 4: // long entry.
+      bytes = 4;
+      break;
+    case 16: // long8 entry, BigTIFF only.
+      if (m_bBigTIFF)
+	bytes = 8;
+      break;
+    }
+    if (bytes == 0) {
+      ImageLayout::PostError("Expected a numeric integer type when parsing tag %d in file %s, invalid TIFF",matchtag,m_pcFilename);
+      return false;
+    }
+    if (count > MAX_ULONG >> 3) {
+      ImageLayout::PostError("Tag %d in file %s contains too many entries, invalid TIFF",matchtag,m_pcFilename);
+      return false;
+    }
+    //
+    try {
       // Note that count == 0 is also a valid count.
-      tmp         = new ULONG[count];
+      tmp = new UQUAD[ULONG(count)];
+      if (count * bytes > room) {
+	data = new UBYTE[ULONG(count) * bytes];
+	Seek(GetOffset(p)); // is an offset.
+	ReadBytes(data,ULONG(count) * bytes);
+	p    = data;
+      }
       switch(type) {
-      case 1: // byte entry.
-	// At most four bytes fit into the IFD. Otherwise, it is an offset into the file.
-	if (count <= 4) {
-	  for(i = 0;i < count;i++) {
-	    tmp[i] = GetByte();
-	  }
-	} else {
-	  Seek(GetLong()); // is an offset.
-	  for(i = 0;i < count;i++) {
-	    tmp[i] = GetByte();
-	  }
+      case 1:
+	for(i = 0;i < count;i++) {
+	  tmp[i] = *p++;
 	}
 	break;
-      case 3: // short entry.
-	// At most two shorts fit into the IFD. Otherwise, it is an offset into the file.
-	if (count <= 2) {
-	  for(i = 0;i < count;i++) {
-	    tmp[i] = GetWord();
-	  }
-	} else {
-	  Seek(GetLong()); // is an offset.
-	  for(i = 0;i < count;i++) {
-	    tmp[i] = GetWord();
-	  }
+      case 3:
+	for(i = 0;i < count;i++) {
+	  tmp[i] = GetUWORD(p);
 	}
 	break;
       case 4:
-	if (count <= 1) {
-	  for(i = 0;i < count;i++) { // or zero...
-	    tmp[i] = GetLong();
-	  }
-	} else {
-	  Seek(GetLong()); // is an offset.
-	  for(i = 0;i < count;i++) {
-	    tmp[i] = GetLong();
-	  }
+	for(i = 0;i < count;i++) {
+	  tmp[i] = GetULONG(p);
 	}
 	break;
-      default:
-	ImageLayout::PostError("Expected a numeric integer type when parsing tag %d in file %s, invalid TIFF",matchtag,m_pcFilename);
+      case 16:
+	for(i = 0;i < count;i++) {
+	  tmp[i] = GetUQUAD(p);
+	}
 	break;
       }
-      size   = count;
-      vector = tmp;
-      return true;
-    } else {
-      // Not found, do nothing.
-      return false;
+    } catch(...) {
+      delete[] data;
+      delete[] tmp;
+      throw;
+    }
+    delete[] data;
+    size   = ULONG(count);
+    vector = tmp;
+    return true;
+  }
+  // Not found, do nothing.
+  return false;
+}
+///
+
+/// TiffParser::GetVectorTag
+// Read a vectorial type from the TIFF directory,
+// return true if found, then the type is allocated and the size is
+// returned. Otherwise, false is returned.
+bool TiffParser::GetVectorTag(UWORD matchtag,ULONG &size,ULONG *&vector)
+{
+  UQUAD *tmp = NULL;
+  ULONG count,i;
+  assert(vector == NULL);
+
+  if (GetVectorTag(matchtag,count,tmp)) {
+    try {
+      vector = new ULONG[count];
+      for(i = 0;i < count;i++) {
+	if (tmp[i] > MAX_ULONG)
+	  ImageLayout::PostError("Value of tag %d in file %s is out of range",matchtag,m_pcFilename);
+	vector[i] = ULONG(tmp[i]);
+      }
+    } catch(...) {
+      delete[] vector;
+      vector = NULL;
+      delete[] tmp;
+      throw;
     }
-  } catch(...) {
     delete[] tmp;
-    throw;
+    size = count;
+    return true;
   }
   return false;
 }
@@ -727,19 +858,19 @@ ULONG TiffParser::GetAddressableStrips(void)
 
 /// TiffParser::GetStripByteCount
 // Return the number of bytes for each strip.
-const ULONG *TiffParser::GetStripByteCount(void)
+const UQUAD *TiffParser::GetStripByteCount(void)
 {
   ULONG count;
   
-  if (m_pulStripByteCount)
-    return m_pulStripByteCount;
+  if (m_puqStripByteCount)
+    return m_puqStripByteCount;
 
-  if (GetVectorTag(TiffTag::STRIPBYTECOUNTS,count,m_pulStripByteCount)) {
+  if (GetVectorTag(TiffTag::STRIPBYTECOUNTS,count,m_puqStripByteCount)) {
     ULONG strips = GetAddressableStrips();
     if (count != strips)
       ImageLayout::PostError("%s does not define the proper number of strip byte counts, %d are specified, %d expected",
 		m_pcFilename,strips,count);
-    return m_pulStripByteCount;
+    return m_puqStripByteCount;
   }
 
   ImageLayout::PostError("%s does not define the number of bytes for each strip, invalid TIFF",m_pcFilename);
@@ -749,19 +880,19 @@ const ULONG *TiffParser::GetStripByteCount(void)
 
 /// TiffParser::GetStripOffset
 // Return the file offsets into the strips.
-const ULONG *TiffParser::GetStripOffset(void)
+const UQUAD *TiffParser::GetStripOffset(void)
 {
   ULONG count;
 
-  if (m_pulStripOffset)
-    return m_pulStripOffset;
+  if (m_puqStripOffset)
+    return m_puqStripOffset;
 
-  if (GetVectorTag(TiffTag::STRIPOFFSETS,count,m_pulStripOffset)) {
+  if (GetVectorTag(TiffTag::STRIPOFFSETS,count,m_puqStripOffset)) {
     ULONG strips = GetAddressableStrips();
     if (count != strips)
       ImageLayout::PostError("%s does not define the proper number of strip byte counts, %d are specified, %d expected",
 		m_pcFilename,strips,count);
-    return m_pulStripOffset;
+    return m_puqStripOffset;
   }
   ImageLayout::PostError("%s does not define the file offsets for each strip, invalid TIFF",m_pcFilename);
   return NULL;
@@ -862,26 +993,26 @@ ULONG TiffParser::GetAddressableTiles(void)
 
 /// TiffParser::GetTileByteCount
 // Return the array of tile byte counts, one entry per tile.
-const ULONG *TiffParser::GetTileByteCount(void)
+const UQUAD *TiffParser::GetTileByteCount(void)
 {
   ULONG cnt;
   
-  if (m_pulStripByteCount)
-    return m_pulStripByteCount;
+  if (m_puqStripByteCount)
+    return m_puqStripByteCount;
 
-  if (GetVectorTag(TiffTag::TILEBYTECOUNTS,cnt,m_pulStripByteCount)) {
+  if (GetVectorTag(TiffTag::TILEBYTECOUNTS,cnt,m_puqStripByteCount)) {
     ULONG tiles = GetAddressableTiles();
     if (tiles != cnt)
       ImageLayout::PostError("%s does not define the proper number of byte counts for all tiles, expected %d found %d",
 		m_pcFilename,tiles,cnt);
-    return m_pulStripByteCount;
-  } else if (GetVectorTag(TiffTag::STRIPBYTECOUNTS,cnt,m_pulStripByteCount)) {
+    return m_puqStripByteCount;
+  } else if (GetVectorTag(TiffTag::STRIPBYTECOUNTS,cnt,m_puqStripByteCount)) {
     // Bummer! Some images store this in the STRIPBYTECOUNTS!
     ULONG tiles = GetAddressableTiles();
     if (tiles != cnt)
       ImageLayout::PostError("%s does not define the proper number of byte counts for all tiles, expected %d found %d",
 		m_pcFilename,tiles,cnt);
-    return m_pulStripByteCount;
+    return m_puqStripByteCount;
   }
 
   ImageLayout::PostError("%s does not define the tile byte counts, invalid TIFF",m_pcFilename);
@@ -891,26 +1022,26 @@ const ULONG *TiffParser::GetTileByteCount(void)
 
 /// TiffParser::GetTileOffset
 // Return the array of tile file offsets, one entry per tile.
-const ULONG *TiffParser::GetTileOffset(void)
+const UQUAD *TiffParser::GetTileOffset(void)
 {
   ULONG cnt;
   
-  if (m_pulStripOffset)
-    return m_pulStripOffset;
+  if (m_puqStripOffset)
+    return m_puqStripOffset;
 
-  if (GetVectorTag(TiffTag::TILEOFFSETS,cnt,m_pulStripOffset)) {
+  if (GetVectorTag(TiffTag::TILEOFFSETS,cnt,m_puqStripOffset)) {
     ULONG tiles = GetAddressableTiles();
     if (tiles != cnt)
       ImageLayout::PostError("%s does not define the proper number of offsets for all tiles, expected %d found %d",
 		m_pcFilename,tiles,cnt);
-    return m_pulStripOffset;
-  } else if (GetVectorTag(TiffTag::STRIPOFFSETS,cnt,m_pulStripOffset)) {
+    return m_puqStripOffset;
+  } else if (GetVectorTag(TiffTag::STRIPOFFSETS,cnt,m_puqStripOffset)) {
     // Bummer! Some images store this in the strip offsets!
     ULONG tiles = GetAddressableTiles();
     if (tiles != cnt)
       ImageLayout::PostError("%s does not define the proper number of offsets for all tiles, expected %d found %d",
 		m_pcFilename,tiles,cnt);
-    return m_pulStripOffset;
+    return m_puqStripOffset;
   }
 
   ImageLayout::PostError("%s does not define the tile offsets, invalid TIFF",m_pcFilename);
@@ -918,15 +1049,11 @@ const ULONG *TiffParser::GetTileOffset(void)
 }
 ///
 
-/// TiffParser::GetDataOfUnit
-// Return the data for addressable unit "i" (where i is either
-// a tile, tile component, stripe or stripe component). The
-// data is *not* endian-corrected, but read in in raw.
-UBYTE *TiffParser::GetDataOfUnit(ULONG i,ULONG &size)
+/// TiffParser::GetOffsetOfUnit
+// Return the file offset and the size of addressable unit "i".
+UQUAD TiffParser::GetOffsetOfUnit(ULONG i,ULONG &size)
 {
-  ULONG bufsiz;
-  
-  if (m_pulStripOffset == NULL || m_pulStripByteCount == NULL) {
+  if (m_puqStripOffset == NULL || m_puqStripByteCount == NULL) {
     if (isTiled()) {
       GetTileByteCount();
       GetTileOffset();
@@ -938,22 +1065,41 @@ UBYTE *TiffParser::GetDataOfUnit(ULONG i,ULONG &size)
   assert(m_ulUnits > 0);
   assert(i < m_ulUnits);
 
-  bufsiz = m_pulStripByteCount[i];
+  if (m_puqStripByteCount[i] > MAX_ULONG)
+    ImageLayout::PostError("%s contains a strip or tile too large to be processed",m_pcFilename);
+
+  size = ULONG(m_puqStripByteCount[i]);
+  return m_puqStripOffset[i];
+}
+///
+
+/// TiffParser::ReadUnit
+// Read the raw data of addressable unit "i" into the given buffer,
+// which must hold as many bytes as GetOffsetOfUnit returns.
+void TiffParser::ReadUnit(ULONG i,UBYTE *buffer)
+{
+  ULONG bufsiz;
+  
+  Seek(GetOffsetOfUnit(i,bufsiz));
+  ReadBytes(buffer,bufsiz);
+}
+///
+
+/// TiffParser::GetDataOfUnit
+// Return the data for addressable unit "i" (where i is either
+// a tile, tile component, stripe or stripe component). The
+// data is *not* endian-corrected, but read in in raw.
+UBYTE *TiffParser::GetDataOfUnit(ULONG i,ULONG &size)
+{
+  ULONG bufsiz;
+
+  GetOffsetOfUnit(i,bufsiz);
   if (bufsiz > m_ulBufferSize || m_pucBuffer == NULL) {
     delete[] m_pucBuffer;m_pucBuffer = NULL;
     m_pucBuffer = new UBYTE[m_ulBufferSize = bufsiz];
   }
 
-  Seek(m_pulStripOffset[i]);
-
-  errno = 0;
-  if (fread(m_pucBuffer,sizeof(UBYTE),bufsiz,m_pFile) != bufsiz) {
-    if (errno) {
-      ImageLayout::PostError("%s: while reading the TIFF file %s",strerror(errno),m_pcFilename);
-    } else {
-      ImageLayout::PostError("unexpected EOF, file %s is truncated",m_pcFilename);
-    }
-  }
+  ReadUnit(i,m_pucBuffer);
 
   size = bufsiz;
   return m_pucBuffer;
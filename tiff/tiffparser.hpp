@@ -51,8 +51,16 @@ class TiffParser {
   // An indicator for the endianness. True for bigendian.
   bool        m_bBigEndian;
   //
+  // An indicator for BigTIFF files, i.e. version 43 files with
+  // 64-bit offsets and counts.
+  bool        m_bBigTIFF;
+  //
   // Location of the first IFD. Note that we only support one of them.
-  ULONG       m_ulIFDPos;
+  UQUAD       m_uqIFDPos;
+  //
+  // The entries of the IFD, read in one go, and their number.
+  UBYTE      *m_pucIFD;
+  ULONG       m_ulEntries;
   //
   // The bits per pixel value.
   ULONG      *m_pulBitsPerPixel;
@@ -67,10 +75,10 @@ class TiffParser {
   ULONG      *m_pulSampleFormats;
   //
   // The number of compressed bytes in each strip.
-  ULONG      *m_pulStripByteCount;
+  UQUAD      *m_puqStripByteCount;
   //
   // The file offset for each stripe.
-  ULONG      *m_pulStripOffset;
+  UQUAD      *m_puqStripOffset;
   //
   // The number of units/strips in the image.
   ULONG       m_ulUnits;
@@ -90,6 +98,16 @@ class TiffParser {
   // Read a four-byte entry, be endian-aware.
   ULONG GetLong(void);
   //
+  // Read an eight-byte entry, be endian-aware.
+  UQUAD GetQuad(void);
+  //
+  // Read a file offset or a count, four bytes in TIFF and eight
+  // bytes in BigTIFF.
+  UQUAD GetOffset(void)
+  {
+    return (m_bBigTIFF)?(GetQuad()):(GetLong());
+  }
+  //
   // Read a floating point single precision IEEE value.
   FLOAT GetFloat(void);
   //
@@ -97,13 +115,25 @@ class TiffParser {
   DOUBLE GetDouble(void);
   //
   // Seek to the indicated offset, throw on error.
-  void  Seek(ULONG pos);
+  void  Seek(UQUAD pos);
+  //
+  // Read the given number of bytes from the current position of
+  // the file into the buffer, throw on error.
+  void  ReadBytes(UBYTE *buffer,ULONG size);
   //
-  // Position the file pointer on the tiff tag at the IFD starting
-  // at the indicated position. Return true if this entry exists.
-  // Return false otherwise. Note that this is not very fast as a 
-  // lot of seeking is done, but nevermind.
-  bool FindTag(UWORD tag);
+  // Read all entries of the IFD at m_uqIFDPos into memory.
+  void  ReadIFD(void);
+  //
+  // Find the tiff tag in the entries of the IFD. Return a pointer
+  // to the type field of the entry if it exists, NULL otherwise.
+  UBYTE *FindTag(UWORD tag);
+  //
+  // Get a file offset or a count from a buffer, endian-corrected.
+  // These are four bytes in TIFF and eight bytes in BigTIFF.
+  UQUAD GetOffset(UBYTE *&buffer)
+  {
+    return (m_bBigTIFF)?(GetUQUAD(buffer)):(GetULONG(buffer));
+  }
   //
   // Read a scalar entry from the TIFF directory, return
   // true if found, otherwise return false.
@@ -119,6 +149,10 @@ class TiffParser {
   // returned. Otherwise, false is returned.
   bool GetVectorTag(UWORD matchtag,ULONG &size,ULONG *&vector);
   //
+  // Read a vectorial type as above, though keep 64-bit entries as
+  // they are. This is used for file offsets and byte counts.
+  bool GetVectorTag(UWORD matchtag,ULONG &size,UQUAD *&vector);
+  //
 public:
   TiffParser(const char *filename);
   //
@@ -130,6 +164,12 @@ public:
     return m_bBigEndian;
   }
   //
+  // Return the stream the file is read from.
+  FILE  *FileOf(void) const
+  {
+    return m_pFile;
+  }
+  //
   // Get a couple of elementary TIFF properties.
   ULONG  GetImageWidth(void);
   ULONG  GetImageHeight(void);
@@ -187,10 +227,10 @@ public:
   ULONG  GetAddressableStrips(void);
   //
   // Return the number of bytes for each strip.
-  const ULONG *GetStripByteCount(void);
+  const UQUAD *GetStripByteCount(void);
   //
   // Return the file offsets into the strips.
-  const ULONG *GetStripOffset(void);
+  const UQUAD *GetStripOffset(void);
   //
   //
   // The following calls make only sense if isTiled() returns true
@@ -212,16 +252,23 @@ public:
   ULONG  GetAddressableTiles(void);
   //
   // Return the array of tile byte counts, one entry per tile.
-  const ULONG *GetTileByteCount(void);
+  const UQUAD *GetTileByteCount(void);
   //
   // Return the array of tile file offsets, one entry per tile.
-  const ULONG *GetTileOffset(void);
+  const UQUAD *GetTileOffset(void);
   //
   // Return the data for addressable unit "i" (where i is either
   // a tile, tile component, stripe or stripe component). The
   // data is *not* endian-corrected, but read in in raw.
   UBYTE *GetDataOfUnit(ULONG i,ULONG &size);
   //
+  // Return the file offset and the size of addressable unit "i".
+  UQUAD  GetOffsetOfUnit(ULONG i,ULONG &size);
+  //
+  // Read the raw data of addressable unit "i" into the given buffer,
+  // which must hold as many bytes as GetOffsetOfUnit returns.
+  void   ReadUnit(ULONG i,UBYTE *buffer);
+  //
   // Get the sample value to NITS conversion factor, or 1.0 if it is
   // not recorded.
   DOUBLE GetScaleFactor(void);
@@ -65,13 +65,15 @@ struct TiffTag {
   // Possible values for compression we support.
   struct Compression {
     enum {
-      NONE     = 1,
-      LZW      = 5,
-      PACKBITS = 32773
+      NONE       = 1,
+      LZW        = 5,
+      DEFLATE    = 8,     // zlib streams, as specified by Adobe
+      PACKBITS   = 32773,
+      OLDDEFLATE = 32946  // the same, under the code used before
     };
   };
   //
-  // Possible values for the predictor (only for LZW)
+  // Possible values for the predictor (only for LZW and deflate)
   struct Predictor {
     enum {
       NONE  = 1,
@@ -39,10 +39,10 @@ and conversion framework.
 
 /// TiffWriter::TiffWriter
 // Create a new tiff writer from a file name.
-TiffWriter::TiffWriter(const char *filename,bool bigendian)
+TiffWriter::TiffWriter(const char *filename,bool bigendian,bool bigtiff)
   : m_pFile(NULL), m_pcFilename(filename), 
-    m_pucStrip(NULL), m_ulBufferSize(0),
-    m_pTags(NULL), m_bBigEndian(bigendian)
+    m_uqOffset(0), m_uqIFDOffset(0),
+    m_pTags(NULL), m_bBigEndian(bigendian), m_bBigTIFF(bigtiff)
 {
   m_pFile = fopen(filename,"wb");
   if (m_pFile == NULL) {
@@ -56,7 +56,14 @@ TiffWriter::TiffWriter(const char *filename,bool bigendian)
     PutByte('I');
     PutByte('I');
   }
-  PutWord(42); // the magic number
+  if (m_bBigTIFF) {
+    PutWord(43); // the magic number
+    PutWord(8);  // the size of offsets
+    PutWord(0);  // reserved
+  } else {
+    PutWord(42); // the magic number
+  }
+  PutOffset(0);  // the offset of the IFD, filled in by WriteIFD.
 }
 ///
 
@@ -68,8 +75,6 @@ TiffWriter::~TiffWriter(void)
 
   fclose(m_pFile);
 
-  delete[] m_pucStrip;
-
   while((t = m_pTags)) {
     m_pTags = t->ti_pNext;
     delete t;
@@ -84,6 +89,7 @@ void TiffWriter::PutByte(UBYTE out)
   if (fwrite(&out,sizeof(out),1,m_pFile) != 1) {
     ImageLayout::PostError("%s: unable to write to the TIFF file %s",strerror(errno),m_pcFilename);
   }
+  m_uqOffset++;
 }
 ///
 
@@ -115,6 +121,44 @@ void TiffWriter::PutLong(ULONG out)
 }
 ///
 
+/// TiffWriter::PutQuad
+// Write a 64 bit quad to output
+void TiffWriter::PutQuad(UQUAD out)
+{
+  if (m_bBigEndian) {
+    PutLong(ULONG(out >> 32));
+    PutLong(ULONG(out));
+  } else {
+    PutLong(ULONG(out));
+    PutLong(ULONG(out >> 32));
+  }
+}
+///
+
+/// TiffWriter::PutValue
+// Write a tag value of the given type, return its size in bytes.
+ULONG TiffWriter::PutValue(UWORD type,UQUAD value)
+{
+  switch(type) {
+  case 1:
+    PutByte(UBYTE(value));
+    return 1;
+  case 3:
+    PutWord(UWORD(value));
+    return 2;
+  case 4:
+  case 11: // Actually, this is a float.
+    PutLong(ULONG(value));
+    return 4;
+  case 16:
+    PutQuad(value);
+    return 8;
+  }
+  assert(false);
+  return 0;
+}
+///
+
 /// TiffWriter::DefineTag
 // Create a new tag of the given tag value, given type and given
 // count.
@@ -123,8 +167,8 @@ void *TiffWriter::DefineTag(UWORD tag,UWORD type,ULONG count)
   struct Tag **prev = &m_pTags;
   struct Tag *t;
 
-  // only byte,word,long,float supported here.
-  assert(type == 1 || type == 3 || type == 4 || type == 11);
+  // only byte,word,long,float and long8 supported here.
+  assert(type == 1 || type == 3 || type == 4 || type == 11 || (type == 16 && m_bBigTIFF));
 
   // Find the tag where we should attach to.
   while(*prev) {
@@ -140,22 +184,32 @@ void *TiffWriter::DefineTag(UWORD tag,UWORD type,ULONG count)
   t->ti_usTag   = tag;
   t->ti_usType  = type;
   t->ti_ulCount = count;
-  t->ti_pulData = new ULONG[count];
+  t->ti_puqData = new UQUAD[count];
 
   return t;
 }
 ///
 
+/// TiffWriter::DefineOffsetTag
+// Create a tag for file offsets or byte counts of the given count.
+// These are LONGs in TIFF and LONG8s in BigTIFF.
+void *TiffWriter::DefineOffsetTag(UWORD tag,ULONG count)
+{
+  return DefineTag(tag,(m_bBigTIFF)?(16):(4),count);
+}
+///
+
 /// TiffWriter::DefineTagValue
 // Fill in a tag value for the given tag at the given index.
-void TiffWriter::DefineTagValue(void *t,ULONG index,ULONG value)
+void TiffWriter::DefineTagValue(void *t,ULONG index,UQUAD value)
 {
   struct Tag *tag = (struct Tag *)t;
   assert(tag);
-  assert(tag->ti_pulData);
+  assert(tag->ti_puqData);
   assert(index < tag->ti_ulCount);
+  assert(tag->ti_usType == 16 || value <= MAX_ULONG);
 
-  tag->ti_pulData[index] = value;
+  tag->ti_puqData[index] = value;
 }
 ///
 
@@ -166,7 +220,7 @@ void TiffWriter::DefineScalarTag(UWORD tag,ULONG value)
   struct Tag *t;
 
   t = (struct Tag *)DefineTag(tag,(value > MAX_UWORD)?(4):(3),1);
-  t->ti_pulData[0] = value;
+  t->ti_puqData[0] = value;
 }
 ///
 
@@ -183,77 +237,84 @@ void TiffWriter::DefineFloatTag(UWORD tag,FLOAT value)
   u.f = value;
 
   t = (struct Tag *)DefineTag(tag,11,1);
-  t->ti_pulData[0] = u.ul;
+  t->ti_puqData[0] = u.ul;
 }
 ///
 
 /// TiffWriter::LayoutTags
-// Layout the tags, compute all the offsets needed, and return
-// the first available offset for the image data.
-ULONG TiffWriter::LayoutTags(void)
+// Layout the tags behind the data written so far, compute all the
+// offsets needed.
+void TiffWriter::LayoutTags(void)
 {
   struct Tag *ti = m_pTags;
-  ULONG offset   = 4 + 4 + 2; // header + IFD pointer + directory size.
+  ULONG room     = (m_bBigTIFF)?(8):(4); // bytes of a value in an entry.
+  UQUAD offset;
+  //
+  // The IFD starts at a word boundary.
+  m_uqIFDOffset = m_uqOffset + (m_uqOffset & 1);
+  offset        = m_uqIFDOffset + ((m_bBigTIFF)?(8):(2)); // directory size.
   //
   // First, compute the size required for the tags itself.
   while(ti) {
-    offset += 2+2+4+4; // the entry itself.
+    offset += 2+2+room+room; // the entry itself.
     ti = ti->ti_pNext;
   }
   // Add up the end of IFD chain entry.
-  offset += 4;
+  offset += room;
   //
   // Now check which of the tags require links because data cannot be
   // fit into the data.
   ti = m_pTags;
   while(ti) {
-    ULONG sz = 0,mx = 0;
+    UQUAD sz = 0;
     switch(ti->ti_usType) {
     case 1:
       sz = 1; // type = byte
-      mx = MAX_LONG;
       break;
     case 3:
       sz = 2; // type = word
-      mx = MAX_LONG >> 1;
       break;
     case 4:
     case 11:
       sz = 4; // type = long
-      mx = MAX_LONG >> 2;
+      break;
+    case 16:
+      sz = 8; // type = long8
       break;
     default:
       assert(false);
     }
-    if (ti->ti_ulCount > mx)
-      ImageLayout::PostError("too much tag data for the TIFF file %s",m_pcFilename);
     sz *= ti->ti_ulCount;
-    // If more than four bytes required, need to allocate extra storage.
-    if (sz > 4) {
-      ti->ti_ulOffset = offset; // allocate this offset.
-      offset = (offset + sz + 1) & (~1); // align to a word boundary.
-      if (offset < ti->ti_ulOffset)
-	ImageLayout::PostError("too much tag data for the TIFF file %s",m_pcFilename);
+    // If more than fits into the entry, need to allocate extra storage.
+    if (sz > room) {
+      ti->ti_uqOffset = offset; // allocate this offset.
+      offset = (offset + sz + 1) & (~UQUAD(1)); // align to a word boundary.
     } else {
-      ti->ti_ulOffset = 0;      // no offset required
+      ti->ti_uqOffset = 0;      // no offset required
     }
     //
     // Next one.
     ti = ti->ti_pNext;
   }
-
-  return offset;
+  //
+  // Classic TIFF files cannot address beyond 4GB.
+  if (!m_bBigTIFF && offset > MAX_ULONG)
+    throw "TIFF image growing too large, use BigTIFF instead";
 }
 ///
 
 /// TiffWriter::WriteIFD
-// Write out the IFD for the image and the tag data
+// Write out the IFD for the image and the tag data behind the
+// strips, and link it from the header.
 void TiffWriter::WriteIFD(void)
 {
   struct Tag *ti = m_pTags;
+  ULONG room     = (m_bBigTIFF)?(8):(4);
   UWORD count    = 0;
   //
-  PutLong(4 + 4); // Offset to the IFD: skip the header, the IFD location.
+  LayoutTags();
+  if (m_uqIFDOffset > m_uqOffset)
+    PutByte(0); // align the IFD to a word boundary.
   //
   // Count the dir entries.
   while(ti) {
@@ -263,100 +324,78 @@ void TiffWriter::WriteIFD(void)
     ti = ti->ti_pNext;
   }
   //
-  PutWord(count);
+  if (m_bBigTIFF) {
+    PutQuad(count);
+  } else {
+    PutWord(count);
+  }
   //
   // Now write the tags itself.
   ti = m_pTags;
   while(ti) {
     PutWord(ti->ti_usTag);
     PutWord(ti->ti_usType);
-    PutLong(ti->ti_ulCount);
+    PutOffset(ti->ti_ulCount);
     //
     // Either put the data directly, or the offset.
-    if (ti->ti_ulOffset) {
-      PutLong(ti->ti_ulOffset);
+    if (ti->ti_uqOffset) {
+      PutOffset(ti->ti_uqOffset);
     } else {
-      switch(ti->ti_usType) {
-      case 1:
-	PutByte((ti->ti_ulCount > 0)?(ti->ti_pulData[0]):(0));
-	PutByte((ti->ti_ulCount > 1)?(ti->ti_pulData[1]):(0));
-	PutByte((ti->ti_ulCount > 2)?(ti->ti_pulData[2]):(0));
-	PutByte((ti->ti_ulCount > 3)?(ti->ti_pulData[3]):(0));
-	break;
-      case 3:
-	PutWord((ti->ti_ulCount > 0)?(ti->ti_pulData[0]):(0));
-	PutWord((ti->ti_ulCount > 1)?(ti->ti_pulData[1]):(0));
-	break;
-      case 4:
-      case 11: // Actually, this is a float.
-	PutLong((ti->ti_ulCount > 0)?(ti->ti_pulData[0]):(0));
-	break;
+      ULONG i,sz = 0;
+      for(i = 0;i < ti->ti_ulCount;i++) {
+	sz += PutValue(ti->ti_usType,ti->ti_puqData[i]);
+      }
+      // Fill the remaining bytes of the entry.
+      while(sz < room) {
+	PutByte(0);
+	sz++;
       }
     }
     ti = ti->ti_pNext;
   }
   //
   // Write the link to the next IFD: There is none.
-  PutLong(0);
+  PutOffset(0);
   //
   // Now write the data linked to by the offsets.
   ti = m_pTags;
   while(ti) {
-    if (ti->ti_ulOffset) {
-      ULONG i;
-      switch(ti->ti_usType) {
-      case 1:
-	for(i = 0;i < ti->ti_ulCount;i++) {
-	  PutByte(ti->ti_pulData[i]);
-	}
-	// Align to byte boundary.
-	if (ti->ti_ulCount & 1)
-	  PutByte(0);
-	break;
-      case 3:
-	for(i = 0;i < ti->ti_ulCount;i++) {
-	  PutWord(ti->ti_pulData[i]);
-	}
-	break; 
-      case 4:
-      case 11:
-	for(i = 0;i < ti->ti_ulCount;i++) {
-	  PutLong(ti->ti_pulData[i]);
-	}
-	break;
+    if (ti->ti_uqOffset) {
+      ULONG i,sz = 0;
+      for(i = 0;i < ti->ti_ulCount;i++) {
+	sz += PutValue(ti->ti_usType,ti->ti_puqData[i]);
       }
+      // Align to word boundary.
+      if (sz & 1)
+	PutByte(0);
     }
     ti = ti->ti_pNext;
   }
-}
-///
-
-/// TiffWriter::GetStripBuffer
-// Allocate a buffer for a stripe to put data into.
-UBYTE *TiffWriter::GetStripBuffer(ULONG sz)
-{
-  if (m_pucStrip && m_ulBufferSize >= sz) {
-    m_ulStripData = sz;
-    return m_pucStrip;
+  //
+  // Finally, link the IFD from the header.
+  if (fseek(m_pFile,(m_bBigTIFF)?(8):(4),SEEK_SET) != 0) {
+    ImageLayout::PostError("%s: unable to write to the TIFF file %s",strerror(errno),m_pcFilename);
   }
-
-  delete[] m_pucStrip;m_pucStrip = NULL;
-
-  m_pucStrip = new UBYTE[m_ulBufferSize = m_ulStripData = sz];
-
-  return m_pucStrip;
+  PutOffset(m_uqIFDOffset);
 }
 ///
 
-/// TiffWriter::PushStripBuffer
-// Write the strip buffer out.
-void TiffWriter::PushStripBuffer(void)
+/// TiffWriter::WriteStrip
+// Write the data of a strip, return the offset it was written to.
+UQUAD TiffWriter::WriteStrip(const UBYTE *data,ULONG size)
 {
-  if (m_pucStrip && m_ulStripData) {
-    if (fwrite(m_pucStrip,sizeof(UBYTE),m_ulStripData,m_pFile) != m_ulStripData) {
+  UQUAD offset = m_uqOffset;
+  
+  if (!m_bBigTIFF && offset + size > MAX_ULONG)
+    throw "TIFF image growing too large, use BigTIFF instead";
+
+  if (size) {
+    if (fwrite(data,sizeof(UBYTE),size,m_pFile) != size) {
       ImageLayout::PostError("%s: cannot write out TIFF image data to %s",strerror(errno),m_pcFilename);
     }
+    m_uqOffset += size;
   }
+
+  return offset;
 }
 ///
-
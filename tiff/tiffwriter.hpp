@@ -48,14 +48,13 @@ class TiffWriter {
   // The name of the file.
   const char *m_pcFilename;
   //
-  // The stripe buffer and its buffer size.
-  UBYTE      *m_pucStrip;
+  // The number of bytes written so far, i.e. the offset of the
+  // next byte in the file.
+  UQUAD       m_uqOffset;
   //
-  // The stripe buffer size.
-  ULONG       m_ulBufferSize;
-  //
-  // Valid data in the buffer.
-  ULONG       m_ulStripData;
+  // The offset of the IFD. It follows the image data such that
+  // strips can be written before their sizes are known.
+  UQUAD       m_uqIFDOffset;
   //
   // A single tag. These get sorted into a singly-linked list, then
   // offset-allocated.
@@ -74,25 +73,28 @@ class TiffWriter {
     //
     // The allocated offset in the file
     // if any. Zero if in-line.
-    ULONG       ti_ulOffset;
+    UQUAD       ti_uqOffset;
     //
     // The data (allocated).
-    ULONG      *ti_pulData;
+    UQUAD      *ti_puqData;
     //
   public:
     Tag(void)
-      : ti_pNext(NULL), ti_ulCount(0), ti_ulOffset(0), ti_pulData(NULL)
+      : ti_pNext(NULL), ti_ulCount(0), ti_uqOffset(0), ti_puqData(NULL)
     { }
     //
     ~Tag(void)
     {
-      delete[] ti_pulData;
+      delete[] ti_puqData;
     }
   }          *m_pTags; // List of tags, sorted in ascending order.
   //
   // A big or little endian format?
   bool        m_bBigEndian;
   //
+  // Write a BigTIFF with 64-bit offsets and counts instead of a TIFF?
+  bool        m_bBigTIFF;
+  //
   // A couple of helpers.
   // Note that we write in little-endian since that seems to be more
   // common.
@@ -106,9 +108,29 @@ class TiffWriter {
   // Write a long.
   void PutLong(ULONG out);
   //
+  // Write a quad.
+  void PutQuad(UQUAD out);
+  //
+  // Write a file offset or count, four bytes in TIFF and eight bytes
+  // in BigTIFF.
+  void PutOffset(UQUAD out)
+  {
+    if (m_bBigTIFF) {
+      PutQuad(out);
+    } else {
+      PutLong(ULONG(out));
+    }
+  }
+  //
+  // Write a tag value of the given type, return its size in bytes.
+  ULONG PutValue(UWORD type,UQUAD value);
+  //
+  // Layout the tags behind the data written so far, compute all the
+  // offsets needed.
+  void LayoutTags(void);
   //
 public:
-  TiffWriter(const char *filename,bool bigendian = false);
+  TiffWriter(const char *filename,bool bigendian = false,bool bigtiff = false);
   //
   ~TiffWriter(void);
   //
@@ -116,8 +138,12 @@ public:
   // count.
   void *DefineTag(UWORD tag,UWORD type,ULONG count);
   //
+  // Create a tag for file offsets or byte counts of the given count.
+  // These are LONGs in TIFF and LONG8s in BigTIFF.
+  void *DefineOffsetTag(UWORD tag,ULONG count);
+  //
   // Fill in a tag value for the given tag at the given index.
-  void DefineTagValue(void *tag,ULONG index,ULONG value);
+  void DefineTagValue(void *tag,ULONG index,UQUAD value);
   //
   // Create a simple scalar tag and define its value.
   void DefineScalarTag(UWORD tag,ULONG value);
@@ -125,19 +151,14 @@ public:
   // Create a scalar tag based on a floating point value.
   void DefineFloatTag(UWORD tag,FLOAT value);
   //
-  // Layout the tags, compute all the offsets needed, and return
-  // the first available offset for the image data.
-  ULONG LayoutTags(void);
+  // Write the data of a strip, return the offset it was written to.
+  UQUAD WriteStrip(const UBYTE *data,ULONG size);
   //
-  // Write out the IFD for the image and the tag data
+  // Write out the IFD for the image and the tag data behind the
+  // strips, and link it from the header. All strips must have been
+  // written before.
   void WriteIFD(void);
   //
-  // Allocate a buffer for a stripe to put data into.
-  UBYTE *GetStripBuffer(ULONG sz);
-  //
-  // Write the strip buffer out.
-  void PushStripBuffer(void);
-  //
   // Write bits aligned into a buffer
   static void PutBits(UBYTE *&buffer,UBYTE &bitpos,UBYTE bps,ULONG value)
   {
@@ -161,7 +182,7 @@ public:
   }
   //
   // Write UWORD into a buffer.
-  void PutUWORD(UBYTE *&buffer,UWORD d)
+  void PutUWORD(UBYTE *&buffer,UWORD d) const
   {
     if (m_bBigEndian) {
       *buffer++ = d >> 8;
@@ -173,7 +194,7 @@ public:
   }
   //
   // Write ULONG in little endian into a buffer.
-  void PutULONG(UBYTE *&buffer,ULONG d)
+  void PutULONG(UBYTE *&buffer,ULONG d) const
   {
     if (m_bBigEndian) {
       *buffer++ = d >> 24;
@@ -189,7 +210,7 @@ public:
   }
   //
   // Write UQUAD in little endian into a buffer.
-  void PutUQUAD(UBYTE *&buffer,UQUAD d)
+  void PutUQUAD(UBYTE *&buffer,UQUAD d) const
   {
     if (m_bBigEndian) {
       *buffer++ = d >> 56;
@@ -0,0 +1,262 @@
+/*************************************************************************
+** Written by Thomas Richter (THOR Software) for Accusoft	        **
+** All Rights Reserved							**
+**************************************************************************
+
+This source file is part of difftest_ng, a universal image measuring
+and conversion framework.
+
+    difftest_ng is free software: you can redistribute it and/or modify
+    it under the terms of the GNU General Public License as published by
+    the Free Software Foundation, either version 3 of the License, or
+    (at your option) any later version.
+
+    difftest_ng is distributed in the hope that it will be useful,
+    but WITHOUT ANY WARRANTY; without even the implied warranty of
+    MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+    GNU General Public License for more details.
+
+    You should have received a copy of the GNU General Public License
+    along with difftest_ng.  If not, see <http://www.gnu.org/licenses/>.
+
+*************************************************************************/
+
+/*
+**
+** A pool of sample buffers for the filters on the agenda.
+**
+** $Id$
+**
+*/
+
+/// Includes
+#include "tools/bufferpool.hpp"
+#include "img/imglayout.hpp"
+#include "std/string.hpp"
+///
+
+/// BufferPool::~BufferPool
+BufferPool::~BufferPool(void)
+{
+  struct Buffer *buf;
+  struct Table *table;
+
+  while((buf = m_pBuffers)) {
+    m_pBuffers = buf->m_pNext;
+    delete[] buf->m_pucMemory;
+    delete buf;
+  }
+
+  while((table = m_pTables)) {
+    m_pTables = table->m_pNext;
+    delete[] table->m_pucMemory;
+    delete table;
+  }
+}
+///
+
+/// BufferPool::ClassOf
+// Return the size of the class a request of the given size falls
+// into. Sizes are rounded up to a multiple of an eighth to a quarter
+// of the size, giving four to eight classes per power of two.
+size_t BufferPool::ClassOf(size_t size)
+{
+  size_t step = 64;
+
+  while((step << 3) <= size)
+    step <<= 1;
+
+  return (size + step - 1) & ~(step - 1);
+}
+///
+
+/// BufferPool::isReferenced
+// Check whether one of the components of the image points into the
+// given buffer. Cropped images point inside the buffer rather than
+// to its start.
+bool BufferPool::isReferenced(const struct Buffer *buf,const class ImageLayout *img)
+{
+  UWORD comp;
+
+  if (img == NULL)
+    return false;
+
+  for(comp = 0;comp < img->DepthOf();comp++) {
+    const UBYTE *ptr = (const UBYTE *)img->DataOf(comp);
+    if (ptr >= buf->m_pucMemory && ptr < buf->m_pucMemory + buf->m_Size)
+      return true;
+  }
+
+  return false;
+}
+///
+
+/// BufferPool::Trim
+// Release all free buffers of a size class other than the given one.
+// They were left over from images of a different size or sample type
+// and are unlikely to be requested again.
+void BufferPool::Trim(size_t size)
+{
+  struct Buffer **prev = &m_pBuffers;
+  struct Buffer *buf;
+
+  while((buf = *prev)) {
+    if (buf->m_bFree && buf->m_Size != size) {
+      *prev = buf->m_pNext;
+      delete[] buf->m_pucMemory;
+      delete buf;
+    } else {
+      prev = &buf->m_pNext;
+    }
+  }
+}
+///
+
+/// BufferPool::Allocate
+// Return a buffer of at least the given size, either a free one of
+// the same size class or a new one.
+UBYTE *BufferPool::Allocate(size_t size)
+{
+  struct Buffer *buf;
+
+  size = ClassOf(size);
+
+  for(buf = m_pBuffers;buf;buf = buf->m_pNext) {
+    if (buf->m_bFree && buf->m_Size == size) {
+      buf->m_bFree = false;
+      return buf->m_pucMemory;
+    }
+  }
+  //
+  // Nothing fits, make room before allocating a new one.
+  Trim(size);
+  //
+  buf              = new struct Buffer;
+  buf->m_pucMemory = NULL;
+  try {
+    buf->m_pucMemory = new UBYTE[size];
+  } catch(...) {
+    delete buf;
+    throw;
+  }
+  buf->m_Size      = size;
+  buf->m_bFree     = false;
+  buf->m_pNext     = m_pBuffers;
+  m_pBuffers       = buf;
+
+  return buf->m_pucMemory;
+}
+///
+
+/// BufferPool::TableOf
+// Return the lookup table of the given size identified by the key of
+// keysize bytes, creating it if it does not yet exist. Then fresh is
+// set and the caller has to fill it in.
+UBYTE *BufferPool::TableOf(const void *key,size_t keysize,size_t size,bool &fresh)
+{
+  struct Table *table;
+
+  for(table = m_pTables;table;table = table->m_pNext) {
+    if (table->m_Size == size && table->m_KeySize == keysize &&
+	memcmp(table->m_pucMemory + size,key,keysize) == 0) {
+      fresh = false;
+      return table->m_pucMemory;
+    }
+  }
+  //
+  table              = new struct Table;
+  table->m_pucMemory = NULL;
+  try {
+    table->m_pucMemory = new UBYTE[size + keysize];
+  } catch(...) {
+    delete table;
+    throw;
+  }
+  memcpy(table->m_pucMemory + size,key,keysize);
+  table->m_Size      = size;
+  table->m_KeySize   = keysize;
+  table->m_pNext     = m_pTables;
+  m_pTables          = table;
+
+  fresh = true;
+  return table->m_pucMemory;
+}
+///
+
+/// BufferPool::Recycle
+// Return all buffers no component of the given images points into to
+// the pool. Buffers only referenced by filters that have been
+// superseded by later steps of the agenda thus become available again.
+void BufferPool::Recycle(const class ImageLayout *org,const class ImageLayout *dst)
+{
+  struct Buffer *buf;
+
+  for(buf = m_pBuffers;buf;buf = buf->m_pNext) {
+    if (!buf->m_bFree && !isReferenced(buf,org) && !isReferenced(buf,dst))
+      buf->m_bFree = true;
+  }
+}
+///
+
+/// BufferPool::ExtentOf
+// Return the first byte of the samples of the component and the byte
+// behind its last sample.
+void BufferPool::ExtentOf(const class ImageLayout *img,UWORD comp,const UBYTE *&start,const UBYTE *&end)
+{
+  ULONG w = img->WidthOf(comp);
+  ULONG h = img->HeightOf(comp);
+
+  start = (const UBYTE *)img->DataOf(comp);
+  end   = start;
+  if (start && w > 0 && h > 0)
+    end += size_t(h - 1) * img->BytesPerRow(comp) + size_t(w - 1) * img->BytesPerPixel(comp) +
+      ImageLayout::SuggestBPP(img->BitsOf(comp),img->isFloat(comp));
+}
+///
+
+/// BufferPool::isProtected
+// Check whether the samples of the component overlap those of the
+// protected images.
+bool BufferPool::isProtected(const class ImageLayout *img,UWORD comp) const
+{
+  const class ImageLayout *prot[2] = {m_pProtectedOrg,m_pProtectedDst};
+  const UBYTE *start,*end;
+  int i;
+
+  ExtentOf(img,comp,start,end);
+  if (start == end)
+    return false;
+
+  for(i = 0;i < 2;i++) {
+    UWORD c;
+    //
+    if (prot[i] == NULL)
+      continue;
+    for(c = 0;c < prot[i]->DepthOf();c++) {
+      const UBYTE *pstart,*pend;
+      //
+      ExtentOf(prot[i],c,pstart,pend);
+      if (start < pend && pstart < end)
+	return true;
+    }
+  }
+
+  return false;
+}
+///
+
+/// BufferPool::isWritable
+// Check whether the samples of the image may be overwritten, i.e. do
+// not belong to a protected image.
+bool BufferPool::isWritable(const class ImageLayout *img) const
+{
+  UWORD comp;
+
+  for(comp = 0;comp < img->DepthOf();comp++) {
+    if (isProtected(img,comp))
+      return false;
+  }
+
+  return true;
+}
+///
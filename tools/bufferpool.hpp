@@ -0,0 +1,143 @@
+/*************************************************************************
+** Written by Thomas Richter (THOR Software) for Accusoft	        **
+** All Rights Reserved							**
+**************************************************************************
+
+This source file is part of difftest_ng, a universal image measuring
+and conversion framework.
+
+    difftest_ng is free software: you can redistribute it and/or modify
+    it under the terms of the GNU General Public License as published by
+    the Free Software Foundation, either version 3 of the License, or
+    (at your option) any later version.
+
+    difftest_ng is distributed in the hope that it will be useful,
+    but WITHOUT ANY WARRANTY; without even the implied warranty of
+    MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+    GNU General Public License for more details.
+
+    You should have received a copy of the GNU General Public License
+    along with difftest_ng.  If not, see <http://www.gnu.org/licenses/>.
+
+*************************************************************************/
+
+/*
+**
+** A pool of sample buffers for the filters on the agenda. Buffers are
+** handed out in size classes, and once the images no longer refer to
+** a buffer, it is reused for the next request of the same class. A
+** chain of filters thus works on about two frames per image instead
+** of allocating fresh ones for every step. All buffers are released
+** with the pool, which therefore has to outlive the images that refer
+** to them.
+**
+** The pool also keeps track of images whose samples must stay intact,
+** such as the copies --restore returns to. Filters working in place
+** only overwrite samples no such image refers to, and take buffers
+** from the pool otherwise.
+**
+** Finally, the pool keeps lookup tables of filters for the complete
+** run, such that they are not rebuilt for every band or frame.
+**
+** $Id$
+**
+*/
+
+#ifndef TOOLS_BUFFERPOOL_HPP
+#define TOOLS_BUFFERPOOL_HPP
+
+/// Includes
+#include "interface/types.hpp"
+#include "std/stddef.hpp"
+///
+
+/// Forwards
+class ImageLayout;
+///
+
+/// Class BufferPool
+class BufferPool {
+  //
+  // A buffer handed out by the pool.
+  struct Buffer {
+    struct Buffer *m_pNext;
+    //
+    // The memory and its size, which is that of the size class.
+    UBYTE         *m_pucMemory;
+    size_t         m_Size;
+    //
+    // Set if the buffer may be handed out again.
+    bool           m_bFree;
+  }                *m_pBuffers;
+  //
+  // A lookup table kept until the pool is destroyed.
+  struct Table {
+    struct Table *m_pNext;
+    //
+    // The table, followed by the key identifying it.
+    UBYTE        *m_pucMemory;
+    size_t        m_Size;
+    size_t        m_KeySize;
+  }                *m_pTables;
+  //
+  // The images whose samples must not be overwritten, NULL if none.
+  const class ImageLayout *m_pProtectedOrg;
+  const class ImageLayout *m_pProtectedDst;
+  //
+  // Check whether one of the components of the image points into the
+  // given buffer.
+  static bool isReferenced(const struct Buffer *buf,const class ImageLayout *img);
+  //
+  // Return the first byte of the samples of the component and the
+  // byte behind its last sample.
+  static void ExtentOf(const class ImageLayout *img,UWORD comp,const UBYTE *&start,const UBYTE *&end);
+  //
+  // Check whether the samples of the component overlap those of the
+  // protected images.
+  bool isProtected(const class ImageLayout *img,UWORD comp) const;
+  //
+  // Release all free buffers of a size class other than the given one.
+  void Trim(size_t size);
+  //
+public:
+  BufferPool(void)
+    : m_pBuffers(NULL), m_pTables(NULL), m_pProtectedOrg(NULL), m_pProtectedDst(NULL)
+  {
+  }
+  //
+  ~BufferPool(void);
+  //
+  // Return the size of the class a request of the given size falls
+  // into. Classes are spaced such that at most a quarter is wasted.
+  static size_t ClassOf(size_t size);
+  //
+  // Return a buffer of at least the given size.
+  UBYTE *Allocate(size_t size);
+  //
+  // Return all buffers no component of the given images points into
+  // to the pool. Either image may be NULL.
+  void Recycle(const class ImageLayout *org,const class ImageLayout *dst);
+  //
+  // Return the lookup table of the given size identified by the key
+  // of keysize bytes, which must distinguish all tables of all filters.
+  // The table remains valid until the pool is destroyed. If it is
+  // new, fresh is set and the caller has to fill it in.
+  UBYTE *TableOf(const void *key,size_t keysize,size_t size,bool &fresh);
+  //
+  // Protect the samples of the given images from being overwritten,
+  // replacing the images protected before. Either may be NULL. The
+  // images must remain valid until they are no longer protected.
+  void Protect(const class ImageLayout *org,const class ImageLayout *dst)
+  {
+    m_pProtectedOrg = org;
+    m_pProtectedDst = dst;
+  }
+  //
+  // Check whether the samples of the image may be overwritten, i.e.
+  // do not belong to a protected image.
+  bool isWritable(const class ImageLayout *img) const;
+};
+///
+
+///
+#endif
@@ -0,0 +1,118 @@
+/*************************************************************************
+** Written by Thomas Richter (THOR Software) for Accusoft	        **
+** All Rights Reserved							**
+**************************************************************************
+
+This source file is part of difftest_ng, a universal image measuring
+and conversion framework.
+
+    difftest_ng is free software: you can redistribute it and/or modify
+    it under the terms of the GNU General Public License as published by
+    the Free Software Foundation, either version 3 of the License, or
+    (at your option) any later version.
+
+    difftest_ng is distributed in the hope that it will be useful,
+    but WITHOUT ANY WARRANTY; without even the implied warranty of
+    MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+    GNU General Public License for more details.
+
+    You should have received a copy of the GNU General Public License
+    along with difftest_ng.  If not, see <http://www.gnu.org/licenses/>.
+
+*************************************************************************/
+
+/*
+**
+** Inline approximations of the logarithm and the exponential to base
+** two, and powers built from them. They avoid the library calls and
+** branches, such that loops over samples can be vectorized. Powers
+** of positive numbers are within a relative error of 2e-9 of the
+** library functions for exponents up to 100, and the error grows
+** linearly with the exponent.
+**
+** $Id$
+**
+*/
+
+#ifndef TOOLS_FASTMATH_HPP
+#define TOOLS_FASTMATH_HPP
+
+/// Includes
+#include "interface/types.hpp"
+#include "std/string.hpp"
+///
+
+/// FastLog2
+// Return the logarithm to base two of a positive normalized number,
+// with an absolute error below 3e-11.
+inline double FastLog2(double x)
+{
+  const UQUAD onebits  = 0x3ff0000000000000ULL;
+  const UQUAD sqrthalf = 0x3fe6a09e667f3bcdULL;
+  const UQUAD magic    = 0x4330000000000000ULL; // 2^52
+  UQUAD bits,ebits;
+  double e,m,s,s2;
+  //
+  // Split into an exponent and a mantissa between sqrt(1/2) and sqrt(2).
+  // The exponent is converted through the mantissa of 2^52 as plain SSE2
+  // cannot convert 64 bit integers.
+  memcpy(&bits,&x,sizeof(bits));
+  ebits = (bits + (onebits - sqrthalf)) >> 52;
+  bits -= (ebits - 1023) << 52;
+  memcpy(&m,&bits,sizeof(m));
+  ebits |= magic;
+  memcpy(&e,&ebits,sizeof(e));
+  e    -= 4503599627370496.0 + 1023.0;
+  //
+  // log(m) = 2 atanh(s) with s = (m-1)/(m+1) below 0.1716.
+  s     = (m - 1.0) / (m + 1.0);
+  s2    = s * s;
+  return e + s * (2.8853900817779268 + s2 * (0.96179669392597561 + s2 * (0.57707801635558536 +
+		  s2 * (0.41219858311113240 + s2 * (0.32059889797532520 + s2 * 0.26230818925253880)))));
+}
+///
+
+/// FastExp2
+// Return two to the power of the argument, with a relative error
+// below 3e-13. Arguments are clamped to the range of normalized
+// numbers.
+inline double FastExp2(double y)
+{
+  UQUAD pbits;
+  double z,p;
+  LONG k;
+  //
+  y = (y < -1022.0)?(-1022.0):((y > 1023.0)?(1023.0):(y));
+  //
+  // Split into the nearest integer k and a remainder of at most 1/2,
+  // whose power is a polynomial. k is then added to the exponent. The
+  // offset keeps the argument of the truncation positive.
+  k = LONG(y + 1024.5) - 1024;
+  z = (y - k) * 0.69314718055994531;
+  p = 1.0 + z * (1.0 + z * (1.0 / 2 + z * (1.0 / 6 + z * (1.0 / 24 + z * (1.0 / 120 + z * (1.0 / 720 +
+      z * (1.0 / 5040 + z * (1.0 / 40320 + z * (1.0 / 362880 + z * (1.0 / 3628800))))))))));
+  memcpy(&pbits,&p,sizeof(pbits));
+  pbits += UQUAD(QUAD(k)) << 52;
+  memcpy(&p,&pbits,sizeof(p));
+  return p;
+}
+///
+
+/// FastLog
+// Return the natural logarithm of a positive normalized number.
+inline double FastLog(double x)
+{
+  return 0.69314718055994531 * FastLog2(x);
+}
+///
+
+/// FastPow
+// Return x to the power of y for positive x.
+inline double FastPow(double x,double y)
+{
+  return FastExp2(y * FastLog2(x));
+}
+///
+
+///
+#endif
@@ -27,30 +27,42 @@ and conversion framework.
 **
 ** $Id: fft.cpp,v 1.8 2017/01/31 11:58:05 thor Exp $
 **
-** This class implements a complex fast fourier transformation.
+** This class implements a two-dimensional fast fourier transformation
+** of real data. As the spectrum of real data is symmetric, only the
+** coefficients of the non-negative horizontal frequencies are kept.
 **
 */
 
 /// Includes
 #include "interface/types.hpp"
 #include "tools/fft.hpp"
+#include "tools/fftplan.hpp"
 #include "std/string.hpp"
 #include "std/math.hpp"
-#ifdef USE_GSL
 #include <new>
 ///
 
 /// FFT::FFT
 // Create an FFT class for a window of the given dimensions.
-FFT::FFT(ULONG width,ULONG height,bool window)
-  : m_ulWidth(width), m_ulHeight(height), m_pdData(new double[(width << 1) * height]),
-    m_pdHWindow(window?new double[width]:NULL), m_pdVWindow(window?new double[height]:NULL), m_bWindow(window),
-    m_pHorizontalTable(NULL), m_pVerticalTable(NULL),
-    m_pHorizontalWorkspace(NULL), m_pVerticalWorkspace(NULL)
+FFT::FFT(ULONG width,ULONG height,bool window,class ThreadPool *pool)
+  : m_ulWidth(width), m_ulHeight(height), m_pdData(NULL),
+    m_pdHWindow(NULL), m_pdVWindow(NULL), m_bWindow(window),
+    m_pHorizontalPlan(FFTPlan::PlanOf(width)), m_pVerticalPlan(FFTPlan::PlanOf(height)),
+    m_pdScratch(NULL), m_ulScratch(0), m_pPool(pool), m_Pass(RowsForwards)
 {
   ULONG i;
+
+  // Rows are transformed in place, columns in a gathered block.
+  m_ulScratch = m_pHorizontalPlan->ScratchOf();
+  if (m_pVerticalPlan->ScratchOf() + ((ColumnBlock * height) << 1) > m_ulScratch)
+    m_ulScratch = m_pVerticalPlan->ScratchOf() + ((ColumnBlock * height) << 1);
+  
+  m_pdData    = new double[ModuloOf() * height];
+  m_pdScratch = new double[m_ulScratch];
   
   if (window) {
+    m_pdHWindow = new double[width];
+    m_pdVWindow = new double[height];
     for(i = 0;i < width;i++) {
       m_pdHWindow[i] = sin(M_PI * i / (width - 1));
     }
@@ -58,7 +70,6 @@ FFT::FFT(ULONG width,ULONG height,bool window)
       m_pdVWindow[i] = sin(M_PI * i / (height - 1));
     }
   }
-  //memset(m_pdData,0,(width << 1) * height * sizeof(double));
 }
 ///
 
@@ -69,62 +80,139 @@ FFT::~FFT(void)
   delete[] m_pdData;
   delete[] m_pdHWindow;
   delete[] m_pdVWindow;
+  delete[] m_pdScratch;
+}
+///
 
-  if (m_pHorizontalTable)
-    gsl_fft_complex_wavetable_free(m_pHorizontalTable);
-
-  if (m_pVerticalTable)
-    gsl_fft_complex_wavetable_free(m_pVerticalTable);
+/// FFT::Window
+// Apply the hamming window function
+void FFT::Window(double *data,double *window,ULONG stride,ULONG dimension)
+{
+  ULONG x;
 
-  if (m_pHorizontalWorkspace)
-    gsl_fft_complex_workspace_free(m_pHorizontalWorkspace);
+  for(x = 0;x < dimension;x++) {
+    *data *= *window;
+    data  += stride;
+    window++;
+  }
+}
+///
 
-  if (m_pVerticalWorkspace)
-    gsl_fft_complex_workspace_free(m_pVerticalWorkspace);
+/// FFT::RunRows
+// Transform a batch of rows of the current pass.
+void FFT::RunRows(ULONG item,double *scratch)
+{
+  ULONG y    = item * RowBatch;
+  ULONG last = y + RowBatch;
+
+  if (last > m_ulHeight)
+    last = m_ulHeight;
+
+  for(;y < last;y++) {
+    double *row = m_pdData + y * ModuloOf();
+    if (m_Pass == RowsForwards) {
+      // From real samples to the non-negative frequencies.
+      if (m_bWindow)
+	Window(row,m_pdHWindow,1,m_ulWidth);
+      m_pHorizontalPlan->RealForwards(row,scratch);
+    } else {
+      // The horizontal window, if any, applies to the real samples.
+      m_pHorizontalPlan->RealBackwards(row,scratch);
+      if (m_bWindow)
+	Window(row,m_pdHWindow,1,m_ulWidth);
+    }
+  }
 }
 ///
 
-/// FFT::initTables
-// Create and initialize the prequisites for the FFT.
-void FFT::initTables(void)
+/// FFT::RunColumns
+// Transform a block of columns of the current pass. The block is
+// gathered into consecutive memory, one column after another, such
+// that every row of the data is only visited once per block. The
+// vertical window only applies to the real parts.
+void FFT::RunColumns(ULONG item,double *scratch)
 {
-  std::bad_alloc err;
-  
-  if (m_pHorizontalTable == NULL) {
-    m_pHorizontalTable = gsl_fft_complex_wavetable_alloc(m_ulWidth);
-    if (m_pHorizontalTable == NULL)
-      throw err;
-  }  
-  if (m_pVerticalTable == NULL) {
-    m_pVerticalTable = gsl_fft_complex_wavetable_alloc(m_ulHeight);
-    if (m_pVerticalTable == NULL)
-      throw err;
+  ULONG x0      = item * ColumnBlock;
+  ULONG count   = SpectrumWidthOf() - x0;
+  ULONG column  = m_ulHeight << 1;
+  double *block = scratch;
+  double *work  = scratch + ColumnBlock * column;
+  ULONG c,y;
+
+  if (count > ColumnBlock)
+    count = ColumnBlock;
+
+  for(y = 0;y < m_ulHeight;y++) {
+    const double *row = m_pdData + y * ModuloOf() + (x0 << 1);
+    double *dst       = block + (y << 1);
+    double w          = (m_bWindow)?(m_pdVWindow[y]):(1.0);
+    for(c = 0;c < count;c++,row += 2,dst += column) {
+      dst[0] = row[0] * w;
+      dst[1] = row[1];
+    }
   }
 
-  if (m_pHorizontalWorkspace == NULL) {
-    m_pHorizontalWorkspace = gsl_fft_complex_workspace_alloc(m_ulWidth);
-    if (m_pHorizontalWorkspace == NULL)
-      throw err;
+  for(c = 0;c < count;c++) {
+    if (m_Pass == ColumnsForwards) {
+      m_pVerticalPlan->Forwards(block + c * column,1,work);
+    } else {
+      m_pVerticalPlan->Backwards(block + c * column,1,work);
+    }
   }
-  
-  if (m_pVerticalWorkspace == NULL) {
-    m_pVerticalWorkspace = gsl_fft_complex_workspace_alloc(m_ulHeight);
-    if (m_pVerticalWorkspace == NULL)
-      throw err;
+
+  for(y = 0;y < m_ulHeight;y++) {
+    double *row       = m_pdData + y * ModuloOf() + (x0 << 1);
+    const double *src = block + (y << 1);
+    for(c = 0;c < count;c++,row += 2,src += column) {
+      row[0] = src[0];
+      row[1] = src[1];
+    }
   }
 }
 ///
 
-/// FFT::Window
-// Apply the hamming window function
-void FFT::Window(double *data,double *window,ULONG stride,ULONG dimension)
+/// FFT::Run
+// Run a work item of the current pass on a thread of the pool.
+void FFT::Run(ULONG item)
 {
-  ULONG x;
+  double *scratch = new double[m_ulScratch];
 
-  for(x = 0;x < dimension;x++) {
-    *data *= *window;
-    data  += stride;
-    window++;
+  try {
+    if (m_Pass == RowsForwards || m_Pass == RowsBackwards) {
+      RunRows(item,scratch);
+    } else {
+      RunColumns(item,scratch);
+    }
+  } catch(...) {
+    delete[] scratch;
+    throw;
+  }
+
+  delete[] scratch;
+}
+///
+
+/// FFT::RunPass
+// Run all work items of the given pass.
+void FFT::RunPass(Pass pass)
+{
+  bool  rows  = (pass == RowsForwards || pass == RowsBackwards);
+  ULONG items = (rows)?((m_ulHeight + RowBatch - 1) / RowBatch):
+    ((SpectrumWidthOf() + ColumnBlock - 1) / ColumnBlock);
+  ULONG i;
+
+  m_Pass = pass;
+
+  if (m_pPool && m_pPool->ThreadsOf() > 1 && items > 1) {
+    m_pPool->Dispatch(this,items);
+  } else {
+    for(i = 0;i < items;i++) {
+      if (rows) {
+	RunRows(i,m_pdScratch);
+      } else {
+	RunColumns(i,m_pdScratch);
+      }
+    }
   }
 }
 ///
@@ -133,24 +221,9 @@ void FFT::Window(double *data,double *window,ULONG stride,ULONG dimension)
 // Run the forwards FFT. The result is then again in DataOf().
 void FFT::ForwardsFFT(void)
 {
-  ULONG x,y;
-
-  initTables();
-
-  // First horizontally,
-  for(y = 0;y < m_ulHeight;y++) {
-    if (m_bWindow)
-      Window(m_pdData + (y * ModuloOf()),m_pdHWindow,2,m_ulWidth);
-    if (gsl_fft_complex_forward(m_pdData + (y * ModuloOf()),1,m_ulWidth,m_pHorizontalTable,m_pHorizontalWorkspace))
-      throw "FFT forwards transformation failed";
-  }
-  // then vertically.
-  for(x = 0;x < m_ulWidth;x++) {
-    if (m_bWindow)
-      Window(m_pdData + (x << 1),m_pdVWindow,ModuloOf(),m_ulHeight);
-    if (gsl_fft_complex_forward(m_pdData + (x << 1),ModuloOf() >> 1,m_ulHeight,m_pVerticalTable,m_pVerticalWorkspace))
-      throw "FFT forwards transformation failed";
-  }
+  // First horizontally, then vertically.
+  RunPass(RowsForwards);
+  RunPass(ColumnsForwards);
 }
 ///
 
@@ -158,24 +231,7 @@ void FFT::ForwardsFFT(void)
 // Run the backwards FFT.
 void FFT::BackwardsFFT(void)
 { 
-  ULONG x,y;
-  
-  initTables();
-
-  for(x = 0;x < m_ulWidth;x++) {
-    if (m_bWindow)
-      Window(m_pdData + (x << 1),m_pdVWindow,ModuloOf(),m_ulHeight);
-    if (gsl_fft_complex_backward(m_pdData + (x << 1),ModuloOf() >> 1,m_ulHeight,m_pVerticalTable,m_pVerticalWorkspace))
-      throw "FFT backwards transformation failed";
-  }
-  for(y = 0;y < m_ulHeight;y++) {
-    if (m_bWindow)
-      Window(m_pdData + (y * ModuloOf()),m_pdHWindow,2,m_ulWidth);
-    if (gsl_fft_complex_backward(m_pdData + (y * ModuloOf()),1,m_ulWidth,m_pHorizontalTable,m_pHorizontalWorkspace))
-      throw "FFT backwards transformation failed";
-  }
-  
+  RunPass(ColumnsBackwards);
+  RunPass(RowsBackwards);
 }
 ///
-
-#endif
@@ -27,7 +27,12 @@ and conversion framework.
 **
 ** $Id: fft.hpp,v 1.7 2017/01/31 11:58:05 thor Exp $
 **
-** This class implements a complex fast fourier transformation.
+** This class implements a two-dimensional fast fourier transformation
+** of real data. As the spectrum of real data is symmetric, only the
+** coefficients of the non-negative horizontal frequencies are kept.
+** Rows are transformed in batches, columns in blocks that are
+** gathered into contiguous memory first, and batches and blocks are
+** distributed over the threads of a pool if one is given.
 **
 */
 
@@ -36,12 +41,15 @@ and conversion framework.
 
 /// Includes
 #include "interface/types.hpp"
-#ifdef USE_GSL
-#include <gsl/gsl_fft_complex.h>
+#include "tools/threadpool.hpp"
+///
+
+/// Forwards
+class FFTPlan;
 ///
 
 /// Class FFT
-class FFT {
+class FFT : private ThreadPool::Job {
   // This class works, unlike most other classes here, on floating point data.
   //
   // Dimensions of the array here.
@@ -60,39 +68,72 @@ class FFT {
   // Apply windowing?
   bool    m_bWindow;
   //
-  // The wave tables for horizontal and vertical transformation.
-  gsl_fft_complex_wavetable *m_pHorizontalTable;
-  gsl_fft_complex_wavetable *m_pVerticalTable;
-  //
-  // Workspaces
-  gsl_fft_complex_workspace *m_pHorizontalWorkspace;
-  gsl_fft_complex_workspace *m_pVerticalWorkspace;
-  //
-  // Create and initialize the prequisites for the FFT.
-  void initTables(void);
+  // The plans for the real transformation of the rows and the
+  // complex transformation of the columns. These are shared.
+  const class FFTPlan *m_pHorizontalPlan;
+  const class FFTPlan *m_pVerticalPlan;
+  //
+  // Scratch memory for the work items run on the calling thread, and
+  // its size in doubles.
+  double *m_pdScratch;
+  ULONG   m_ulScratch;
+  //
+  // The threads working on the transformation, or NULL.
+  class ThreadPool *m_pPool;
+  //
+  // The pass the work items currently belong to.
+  enum Pass {
+    RowsForwards,
+    ColumnsForwards,
+    ColumnsBackwards,
+    RowsBackwards
+  }       m_Pass;
+  //
+  // Rows transformed by one work item, and columns transformed by
+  // one work item. The columns of a block share the cache lines of
+  // the rows.
+  enum {
+    RowBatch    = 16,
+    ColumnBlock = 16
+  };
   //
   // Apply the hamming window function
   void Window(double *data,double *window,ULONG stride,ULONG dimension);
   //
+  // Run all work items of the given pass.
+  void RunPass(Pass pass);
+  //
+  // Run the given batch of rows or block of columns of the current
+  // pass with the given scratch memory.
+  void RunRows(ULONG item,double *scratch);
+  void RunColumns(ULONG item,double *scratch);
+  //
+  // Run a work item of the current pass on a thread of the pool.
+  virtual void Run(ULONG item);
+  //
 public:
-  // Create an FFT class for a window of the given dimensions.
-  FFT(ULONG width,ULONG height,bool window);
+  // Create an FFT class for a window of the given dimensions. If a
+  // pool is given, its threads share the transformations.
+  FFT(ULONG width,ULONG height,bool window,class ThreadPool *pool = NULL);
   //
   // Destroy the FFT again.
   ~FFT(void);
   //
-  // Get access to the origin of the FFT window. This contains real/imaginary components
-  // interleaved
+  // Get access to the origin of the FFT window. Before the forwards
+  // transformation and after the backwards transformation, each row
+  // contains width real samples. After the forwards transformation,
+  // each row contains the width / 2 + 1 coefficients of the
+  // non-negative horizontal frequencies with real/imaginary
+  // components interleaved.
   double *DataOf(void)
   {
     return m_pdData;
   }
   //
-  // The modulo/stride of the above array. This is in elements in the array entries, not in numbers
-  // because each number takes two slots.
+  // The modulo/stride of the above array in doubles.
   ULONG ModuloOf(void)
   {
-    return m_ulWidth << 1;
+    return SpectrumWidthOf() << 1;
   }
   //
   // Run the forwards FFT. The result is then again in DataOf().
@@ -101,7 +142,7 @@ public:
   // Run the backwards FFT.
   void BackwardsFFT(void);
   //
-  // Return width and height of the array. Note that this counts complex entries, not real ones.
+  // Return width and height of the array in samples.
   ULONG WidthOf(void) const
   {
     return m_ulWidth;
@@ -111,10 +152,30 @@ public:
   {
     return m_ulHeight;
   }
+  //
+  // Return the number of complex coefficients per row of the
+  // transformed data.
+  ULONG SpectrumWidthOf(void) const
+  {
+    return (m_ulWidth >> 1) + 1;
+  }
+  //
+  // Return the squared magnitude of the coefficient at the given
+  // frequencies of the complete spectrum, which is taken from the
+  // symmetric coefficient for negative horizontal frequencies.
+  double SquareMagnitudeOf(ULONG x,ULONG y) const
+  {
+    const double *data;
+    //
+    if (x >= SpectrumWidthOf()) {
+      x = m_ulWidth - x;
+      y = (y)?(m_ulHeight - y):(0);
+    }
+    data = m_pdData + y * (SpectrumWidthOf() << 1) + (x << 1);
+    return data[0] * data[0] + data[1] * data[1];
+  }
 };
 ///
 
 ///
 #endif
-#endif
-  
@@ -0,0 +1,568 @@
+/*************************************************************************
+** Written by Thomas Richter (THOR Software) for Accusoft	        **
+** All Rights Reserved							**
+**************************************************************************
+
+This source file is part of difftest_ng, a universal image measuring
+and conversion framework.
+
+    difftest_ng is free software: you can redistribute it and/or modify
+    it under the terms of the GNU General Public License as published by
+    the Free Software Foundation, either version 3 of the License, or
+    (at your option) any later version.
+
+    difftest_ng is distributed in the hope that it will be useful,
+    but WITHOUT ANY WARRANTY; without even the implied warranty of
+    MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+    GNU General Public License for more details.
+
+    You should have received a copy of the GNU General Public License
+    along with difftest_ng.  If not, see <http://www.gnu.org/licenses/>.
+
+*************************************************************************/
+
+/*
+**
+** Plans for one-dimensional fast fourier transformations
+**
+** $Id$
+**
+** A plan keeps the factorization and the twiddle factors for one
+** transformation size. Plans are created once per size, kept in a
+** cache for the lifetime of the program and are read-only after
+** creation, thus can be shared by all transformations of this size,
+** also across threads. The transformation is a mixed-radix
+** Cooley-Tukey algorithm with special butterflies for the radices
+** 2,3,4 and 5 and a generic one for all other factors.
+**
+*/
+
+/// Includes
+#include "interface/types.hpp"
+#include "tools/fftplan.hpp"
+#include "tools/threadpool.hpp"
+#include "std/math.hpp"
+#include "std/assert.hpp"
+#include <new>
+///
+
+/// Class FFTPlanCache
+// Keeps all plans created so far and releases them at program exit.
+class FFTPlanCache {
+public:
+  //
+  // The first plan.
+  class FFTPlan *m_pFirst;
+  //
+#ifdef USE_THREADPOOL
+  //
+  // Protects the list as plans may be requested from several threads.
+  pthread_mutex_t m_Mutex;
+#endif
+  //
+  FFTPlanCache(void)
+    : m_pFirst(NULL)
+  {
+#ifdef USE_THREADPOOL
+    pthread_mutex_init(&m_Mutex,NULL);
+#endif
+  }
+  //
+  ~FFTPlanCache(void)
+  {
+    class FFTPlan *plan;
+
+    while((plan = m_pFirst)) {
+      m_pFirst = plan->m_pNext;
+      delete plan;
+    }
+#ifdef USE_THREADPOOL
+    pthread_mutex_destroy(&m_Mutex);
+#endif
+  }
+};
+///
+
+/// Statics
+static class FFTPlanCache Cache;
+///
+
+/// Multiply
+// Complex multiplication.
+static inline void Multiply(double &re,double &im,
+			    double are,double aim,double bre,double bim)
+{
+  re = are * bre - aim * bim;
+  im = are * bim + aim * bre;
+}
+///
+
+/// FFTPlan::FFTPlan
+// Create the plan for the given size. Use PlanOf() instead.
+FFTPlan::FFTPlan(ULONG size)
+  : m_pNext(NULL), m_ulSize(size), m_pulFactors(NULL), m_ulMaxRadix(0),
+    m_pTwiddle(NULL), m_pHalf(NULL)
+{
+  ULONG n = size;
+  ULONG p = 4;
+  ULONG k,count = 0;
+  ULONG root    = ULONG(floor(sqrt(double(size))));
+
+  // Sizes have at most 32 factors.
+  m_pulFactors = new ULONG[2 * 32];
+  m_pTwiddle   = new struct Complex[size];
+  //
+  for(k = 0;k < size;k++) {
+    double phase = -2.0 * M_PI * double(k) / double(size);
+    m_pTwiddle[k].re = cos(phase);
+    m_pTwiddle[k].im = sin(phase);
+  }
+  //
+  // Factor four first, then two, then the odd numbers. Everything
+  // remaining above the square root is a prime.
+  if (n > 1) {
+    do {
+      while(n % p) {
+	switch(p) {
+	case 4:
+	  p = 2;
+	  break;
+	case 2:
+	  p = 3;
+	  break;
+	default:
+	  p += 2;
+	  break;
+	}
+	if (p > root)
+	  p = n;
+      }
+      n /= p;
+      m_pulFactors[count++] = p;
+      m_pulFactors[count++] = n;
+      if (p > m_ulMaxRadix)
+	m_ulMaxRadix = p;
+    } while(n > 1);
+  }
+  //
+  if ((size & 1) == 0)
+    m_pHalf = FindPlan(size >> 1);
+}
+///
+
+/// FFTPlan::~FFTPlan
+FFTPlan::~FFTPlan(void)
+{
+  delete[] m_pulFactors;
+  delete[] m_pTwiddle;
+}
+///
+
+/// FFTPlan::FindPlan
+// Find or create the plan for the given size in the cache. The
+// cache must be locked.
+const class FFTPlan *FFTPlan::FindPlan(ULONG size)
+{
+  class FFTPlan *plan;
+
+  for(plan = Cache.m_pFirst;plan;plan = plan->m_pNext) {
+    if (plan->m_ulSize == size)
+      return plan;
+  }
+
+  plan           = new class FFTPlan(size);
+  plan->m_pNext  = Cache.m_pFirst;
+  Cache.m_pFirst = plan;
+
+  return plan;
+}
+///
+
+/// FFTPlan::PlanOf
+// Return the plan for the given size.
+const class FFTPlan *FFTPlan::PlanOf(ULONG size)
+{
+  const class FFTPlan *plan;
+
+  assert(size > 0);
+
+#ifdef USE_THREADPOOL
+  pthread_mutex_lock(&Cache.m_Mutex);
+  try {
+    plan = FindPlan(size);
+  } catch(...) {
+    pthread_mutex_unlock(&Cache.m_Mutex);
+    throw;
+  }
+  pthread_mutex_unlock(&Cache.m_Mutex);
+#else
+  plan = FindPlan(size);
+#endif
+
+  return plan;
+}
+///
+
+/// FFTPlan::Butterfly2
+void FFTPlan::Butterfly2(struct Complex *out,ULONG f,ULONG m) const
+{
+  struct Complex *out2      = out + m;
+  const struct Complex *tw  = m_pTwiddle;
+  double re,im;
+
+  do {
+    Multiply(re,im,out2->re,out2->im,tw->re,tw->im);
+    tw       += f;
+    out2->re  = out->re - re;
+    out2->im  = out->im - im;
+    out->re  += re;
+    out->im  += im;
+    out++,out2++;
+  } while(--m);
+}
+///
+
+/// FFTPlan::Butterfly3
+void FFTPlan::Butterfly3(struct Complex *out,ULONG f,ULONG m) const
+{
+  const struct Complex *tw1 = m_pTwiddle;
+  const struct Complex *tw2 = m_pTwiddle;
+  double epi3               = m_pTwiddle[f * m].im;
+  ULONG  m2                 = m << 1;
+  ULONG  k                  = m;
+  struct Complex s0,s1,s2,s3;
+
+  do {
+    Multiply(s1.re,s1.im,out[m].re,out[m].im,tw1->re,tw1->im);
+    Multiply(s2.re,s2.im,out[m2].re,out[m2].im,tw2->re,tw2->im);
+    s3.re = s1.re + s2.re;
+    s3.im = s1.im + s2.im;
+    s0.re = (s1.re - s2.re) * epi3;
+    s0.im = (s1.im - s2.im) * epi3;
+    tw1  += f;
+    tw2  += f << 1;
+    //
+    out[m].re  = out->re - 0.5 * s3.re;
+    out[m].im  = out->im - 0.5 * s3.im;
+    out->re   += s3.re;
+    out->im   += s3.im;
+    out[m2].re = out[m].re + s0.im;
+    out[m2].im = out[m].im - s0.re;
+    out[m].re -= s0.im;
+    out[m].im += s0.re;
+    out++;
+  } while(--k);
+}
+///
+
+/// FFTPlan::Butterfly4
+void FFTPlan::Butterfly4(struct Complex *out,ULONG f,ULONG m) const
+{
+  const struct Complex *tw1 = m_pTwiddle;
+  const struct Complex *tw2 = m_pTwiddle;
+  const struct Complex *tw3 = m_pTwiddle;
+  ULONG  m2                 = m << 1;
+  ULONG  m3                 = m2 + m;
+  ULONG  k                  = m;
+  struct Complex s0,s1,s2,s3,s4,s5;
+
+  do {
+    Multiply(s0.re,s0.im,out[m].re,out[m].im,tw1->re,tw1->im);
+    Multiply(s1.re,s1.im,out[m2].re,out[m2].im,tw2->re,tw2->im);
+    Multiply(s2.re,s2.im,out[m3].re,out[m3].im,tw3->re,tw3->im);
+    tw1  += f;
+    tw2  += f << 1;
+    tw3  += f * 3;
+    //
+    s5.re = out->re - s1.re;
+    s5.im = out->im - s1.im;
+    s4.re = out->re + s1.re;
+    s4.im = out->im + s1.im;
+    s3.re = s0.re + s2.re;
+    s3.im = s0.im + s2.im;
+    s2.re = s0.re - s2.re;
+    s2.im = s0.im - s2.im;
+    //
+    out[m2].re = s4.re - s3.re;
+    out[m2].im = s4.im - s3.im;
+    out->re    = s4.re + s3.re;
+    out->im    = s4.im + s3.im;
+    out[m].re  = s5.re + s2.im;
+    out[m].im  = s5.im - s2.re;
+    out[m3].re = s5.re - s2.im;
+    out[m3].im = s5.im + s2.re;
+    out++;
+  } while(--k);
+}
+///
+
+/// FFTPlan::Butterfly5
+void FFTPlan::Butterfly5(struct Complex *out,ULONG f,ULONG m) const
+{
+  const struct Complex ya = m_pTwiddle[f * m];
+  const struct Complex yb = m_pTwiddle[2 * f * m];
+  struct Complex *out0    = out;
+  struct Complex *out1    = out0 + m;
+  struct Complex *out2    = out1 + m;
+  struct Complex *out3    = out2 + m;
+  struct Complex *out4    = out3 + m;
+  struct Complex s0,s1,s2,s3,s4,s5,s6,s7,s8,s9,s10,s11,s12;
+  ULONG u;
+
+  for(u = 0;u < m;u++) {
+    const struct Complex *tw = m_pTwiddle;
+    s0 = *out0;
+    Multiply(s1.re,s1.im,out1->re,out1->im,tw[u * f].re,tw[u * f].im);
+    Multiply(s2.re,s2.im,out2->re,out2->im,tw[2 * u * f].re,tw[2 * u * f].im);
+    Multiply(s3.re,s3.im,out3->re,out3->im,tw[3 * u * f].re,tw[3 * u * f].im);
+    Multiply(s4.re,s4.im,out4->re,out4->im,tw[4 * u * f].re,tw[4 * u * f].im);
+    //
+    s7.re  = s1.re + s4.re;
+    s7.im  = s1.im + s4.im;
+    s10.re = s1.re - s4.re;
+    s10.im = s1.im - s4.im;
+    s8.re  = s2.re + s3.re;
+    s8.im  = s2.im + s3.im;
+    s9.re  = s2.re - s3.re;
+    s9.im  = s2.im - s3.im;
+    //
+    out0->re += s7.re + s8.re;
+    out0->im += s7.im + s8.im;
+    //
+    s5.re  = s0.re + s7.re * ya.re + s8.re * yb.re;
+    s5.im  = s0.im + s7.im * ya.re + s8.im * yb.re;
+    s6.re  = s10.im * ya.im + s9.im * yb.im;
+    s6.im  = -s10.re * ya.im - s9.re * yb.im;
+    out1->re = s5.re - s6.re;
+    out1->im = s5.im - s6.im;
+    out4->re = s5.re + s6.re;
+    out4->im = s5.im + s6.im;
+    //
+    s11.re = s0.re + s7.re * yb.re + s8.re * ya.re;
+    s11.im = s0.im + s7.im * yb.re + s8.im * ya.re;
+    s12.re = -s10.im * yb.im + s9.im * ya.im;
+    s12.im = s10.re * yb.im - s9.re * ya.im;
+    out2->re = s11.re + s12.re;
+    out2->im = s11.im + s12.im;
+    out3->re = s11.re - s12.re;
+    out3->im = s11.im - s12.im;
+    //
+    out0++,out1++,out2++,out3++,out4++;
+  }
+}
+///
+
+/// FFTPlan::ButterflyGeneric
+// The butterfly for any other radix, which is quadratic in the radix.
+void FFTPlan::ButterflyGeneric(struct Complex *out,ULONG f,ULONG m,ULONG p,
+			       struct Complex *scratch) const
+{
+  ULONG u,k,q,q1;
+  double re,im;
+
+  for(u = 0;u < m;u++) {
+    for(q1 = 0,k = u;q1 < p;q1++,k += m) {
+      scratch[q1] = out[k];
+    }
+    for(q1 = 0,k = u;q1 < p;q1++,k += m) {
+      ULONG tw = 0;
+      out[k]   = scratch[0];
+      for(q = 1;q < p;q++) {
+	tw += f * k;
+	if (tw >= m_ulSize)
+	  tw -= m_ulSize;
+	Multiply(re,im,scratch[q].re,scratch[q].im,m_pTwiddle[tw].re,m_pTwiddle[tw].im);
+	out[k].re += re;
+	out[k].im += im;
+      }
+    }
+  }
+}
+///
+
+/// FFTPlan::Transform
+// Transform the n / f entries of the input spaced f entries apart
+// into consecutive output entries, where factors points to the
+// factorization of the remaining transformation.
+void FFTPlan::Transform(struct Complex *out,const struct Complex *in,ULONG f,
+			const ULONG *factors,struct Complex *scratch) const
+{
+  ULONG p                 = factors[0];
+  ULONG m                 = factors[1];
+  struct Complex *current = out;
+  struct Complex *end     = out + p * m;
+
+  if (m == 1) {
+    do {
+      *current = *in;
+      in      += f;
+    } while(++current != end);
+  } else {
+    // Decimation in time: the p interleaved subsequences first.
+    do {
+      Transform(current,in,f * p,factors + 2,scratch);
+      in += f;
+    } while((current += m) != end);
+  }
+
+  switch(p) {
+  case 2:
+    Butterfly2(out,f,m);
+    break;
+  case 3:
+    Butterfly3(out,f,m);
+    break;
+  case 4:
+    Butterfly4(out,f,m);
+    break;
+  case 5:
+    Butterfly5(out,f,m);
+    break;
+  default:
+    ButterflyGeneric(out,f,m,p,scratch);
+    break;
+  }
+}
+///
+
+/// FFTPlan::Run
+// Run the complex transformation of the entries in data, spaced
+// stride entries apart, in place. The data is conjugated on the
+// way in and out if inverse is set, which gives the backwards
+// transformation.
+void FFTPlan::Run(double *data,ULONG stride,bool inverse,double *scratch) const
+{
+  struct Complex *in  = (struct Complex *)scratch;
+  struct Complex *out = in + m_ulSize;
+  double sign         = (inverse)?(-1.0):(1.0);
+  ULONG k,step        = stride << 1;
+
+  if (m_ulSize <= 1)
+    return;
+
+  for(k = 0;k < m_ulSize;k++) {
+    in[k].re = data[k * step + 0];
+    in[k].im = data[k * step + 1] * sign;
+  }
+
+  Transform(out,in,1,m_pulFactors,out + m_ulSize);
+
+  for(k = 0;k < m_ulSize;k++) {
+    data[k * step + 0] = out[k].re;
+    data[k * step + 1] = out[k].im * sign;
+  }
+}
+///
+
+/// FFTPlan::RealForwards
+// Run the forwards transformation of n real numbers in place. The
+// array must hold n / 2 + 1 complex numbers, and receives the
+// coefficients of the non-negative frequencies.
+void FFTPlan::RealForwards(double *data,double *scratch) const
+{
+  struct Complex *z = (struct Complex *)data;
+  ULONG n           = m_ulSize;
+  ULONG k;
+
+  if (m_pHalf == NULL) {
+    // Odd size, run the complex transformation with zero
+    // imaginary parts and keep the first half.
+    struct Complex *buf = (struct Complex *)scratch;
+    for(k = 0;k < n;k++) {
+      buf[k].re = data[k];
+      buf[k].im = 0.0;
+    }
+    Run(scratch,1,false,scratch + (n << 1));
+    for(k = 0;k <= (n >> 1);k++) {
+      z[k] = buf[k];
+    }
+  } else {
+    // Even size. The even samples are the real, the odd samples the
+    // imaginary parts of a complex signal of half the size whose
+    // transformation is then split into the transformations of the
+    // even and odd samples.
+    ULONG m = n >> 1;
+    m_pHalf->Run(data,1,false,scratch);
+    //
+    z[m].re = z[0].re - z[0].im;
+    z[m].im = 0.0;
+    z[0].re = z[0].re + z[0].im;
+    z[0].im = 0.0;
+    //
+    for(k = 1;k <= (m >> 1);k++) {
+      struct Complex a = z[k];
+      struct Complex b = z[m - k];
+      const struct Complex &w = m_pTwiddle[k];
+      double ere = 0.5 * (a.re + b.re);
+      double eim = 0.5 * (a.im - b.im);
+      double ore = 0.5 * (a.im + b.im);
+      double oim = 0.5 * (b.re - a.re);
+      double tre,tim;
+      Multiply(tre,tim,w.re,w.im,ore,oim);
+      z[k].re     =  ere + tre;
+      z[k].im     =  eim + tim;
+      z[m - k].re =  ere - tre;
+      z[m - k].im = -eim + tim;
+    }
+  }
+}
+///
+
+/// FFTPlan::RealBackwards
+// Run the backwards transformation of the n / 2 + 1 complex
+// coefficients of the non-negative frequencies of a real signal
+// in place. The array receives the n real numbers.
+void FFTPlan::RealBackwards(double *data,double *scratch) const
+{
+  struct Complex *z = (struct Complex *)data;
+  ULONG n           = m_ulSize;
+  ULONG k;
+
+  if (m_pHalf == NULL) {
+    // Odd size, complete the spectrum by symmetry and run the
+    // complex transformation.
+    struct Complex *buf = (struct Complex *)scratch;
+    buf[0].re = z[0].re;
+    buf[0].im = 0.0;
+    for(k = 1;k <= (n >> 1);k++) {
+      buf[k]         = z[k];
+      buf[n - k].re  = z[k].re;
+      buf[n - k].im  = -z[k].im;
+    }
+    Run(scratch,1,true,scratch + (n << 1));
+    for(k = 0;k < n;k++) {
+      data[k] = buf[k].re;
+    }
+  } else {
+    // Even size. Merge the transformations of the even and odd
+    // samples into the transformation of a complex signal of half
+    // the size, run its backwards transformation and interpret the
+    // result as pairs of even and odd samples. Omitting the factor
+    // of one half here gives the same scale as the complex
+    // transformation of the full size.
+    ULONG m   = n >> 1;
+    double re = z[0].re;
+    //
+    z[0].re   = re + z[m].re;
+    z[0].im   = re - z[m].re;
+    //
+    for(k = 1;k <= (m >> 1);k++) {
+      struct Complex a = z[k];
+      struct Complex b = z[m - k];
+      const struct Complex &w = m_pTwiddle[k];
+      double ere = a.re + b.re;
+      double eim = a.im - b.im;
+      double dre = a.re - b.re;
+      double dim = a.im + b.im;
+      double ore,oim;
+      // The odd part is the difference rotated by the conjugate twiddle.
+      Multiply(ore,oim,dre,dim,w.re,-w.im);
+      z[k].re     =  ere - oim;
+      z[k].im     =  eim + ore;
+      z[m - k].re =  ere + oim;
+      z[m - k].im = -eim + ore;
+    }
+    m_pHalf->Run(data,1,true,scratch);
+  }
+}
+///
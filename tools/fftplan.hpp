@@ -0,0 +1,156 @@
+/*************************************************************************
+** Written by Thomas Richter (THOR Software) for Accusoft	        **
+** All Rights Reserved							**
+**************************************************************************
+
+This source file is part of difftest_ng, a universal image measuring
+and conversion framework.
+
+    difftest_ng is free software: you can redistribute it and/or modify
+    it under the terms of the GNU General Public License as published by
+    the Free Software Foundation, either version 3 of the License, or
+    (at your option) any later version.
+
+    difftest_ng is distributed in the hope that it will be useful,
+    but WITHOUT ANY WARRANTY; without even the implied warranty of
+    MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+    GNU General Public License for more details.
+
+    You should have received a copy of the GNU General Public License
+    along with difftest_ng.  If not, see <http://www.gnu.org/licenses/>.
+
+*************************************************************************/
+
+/*
+**
+** Plans for one-dimensional fast fourier transformations
+**
+** $Id$
+**
+** A plan keeps the factorization and the twiddle factors for one
+** transformation size. Plans are created once per size, kept in a
+** cache for the lifetime of the program and are read-only after
+** creation, thus can be shared by all transformations of this size,
+** also across threads. The transformation is a mixed-radix
+** Cooley-Tukey algorithm with special butterflies for the radices
+** 2,3,4 and 5 and a generic one for all other factors.
+**
+*/
+
+#ifndef TOOLS_FFTPLAN_HPP
+#define TOOLS_FFTPLAN_HPP
+
+/// Includes
+#include "interface/types.hpp"
+///
+
+/// Class FFTPlan
+class FFTPlan {
+  //
+  // A complex number as stored in the arrays, real part first.
+  struct Complex {
+    double re;
+    double im;
+  };
+  //
+  // The next plan in the cache.
+  class FFTPlan *m_pNext;
+  //
+  // Number of complex entries transformed.
+  ULONG          m_ulSize;
+  //
+  // The factors of the size, each as a pair of the radix and the
+  // size of the remaining transformation.
+  ULONG         *m_pulFactors;
+  //
+  // The largest radix, which defines the scratch required by the
+  // generic butterfly.
+  ULONG          m_ulMaxRadix;
+  //
+  // The twiddle factors exp(-2 pi i k / n) for all k < n.
+  struct Complex *m_pTwiddle;
+  //
+  // For real transformations of even size the plan of half the
+  // size. Its result is split into the coefficients of the even and
+  // odd samples by the twiddle factors of this plan.
+  const class FFTPlan *m_pHalf;
+  //
+  // Create the plan for the given size. Use PlanOf() instead.
+  FFTPlan(ULONG size);
+  //
+  ~FFTPlan(void);
+  //
+  // Find or create the plan for the given size in the cache. The
+  // cache must be locked.
+  static const class FFTPlan *FindPlan(ULONG size);
+  //
+  // The cache releases all plans at program exit.
+  friend class FFTPlanCache;
+  //
+  // Transform the n / f entries of the input spaced f entries apart
+  // into consecutive output entries, where factors points to the
+  // factorization of the remaining transformation.
+  void Transform(struct Complex *out,const struct Complex *in,ULONG f,
+		 const ULONG *factors,struct Complex *scratch) const;
+  //
+  // The butterflies.
+  void Butterfly2(struct Complex *out,ULONG f,ULONG m) const;
+  void Butterfly3(struct Complex *out,ULONG f,ULONG m) const;
+  void Butterfly4(struct Complex *out,ULONG f,ULONG m) const;
+  void Butterfly5(struct Complex *out,ULONG f,ULONG m) const;
+  void ButterflyGeneric(struct Complex *out,ULONG f,ULONG m,ULONG p,struct Complex *scratch) const;
+  //
+  // Run the complex transformation of the entries in data, spaced
+  // stride entries apart, in place. The data is conjugated on the
+  // way in and out if inverse is set, which gives the backwards
+  // transformation.
+  void Run(double *data,ULONG stride,bool inverse,double *scratch) const;
+  //
+public:
+  //
+  // Return the plan for the given size.
+  static const class FFTPlan *PlanOf(ULONG size);
+  //
+  // Return the size of the transformation.
+  ULONG SizeOf(void) const
+  {
+    return m_ulSize;
+  }
+  //
+  // Return the number of doubles of scratch memory any of the
+  // transformations below requires.
+  ULONG ScratchOf(void) const
+  {
+    return 6 * m_ulSize + (m_ulMaxRadix << 1);
+  }
+  //
+  // Run the forwards or backwards transformation of n complex
+  // numbers, stored as pairs of real and imaginary part, in place.
+  // The stride is in complex numbers. Neither direction is
+  // normalized.
+  void Forwards(double *data,ULONG stride,double *scratch) const
+  {
+    Run(data,stride,false,scratch);
+  }
+  //
+  void Backwards(double *data,ULONG stride,double *scratch) const
+  {
+    Run(data,stride,true,scratch);
+  }
+  //
+  // Run the forwards transformation of n real numbers in place. The
+  // array must hold n / 2 + 1 complex numbers, and receives the
+  // coefficients of the non-negative frequencies. The remaining
+  // ones are the complex conjugates of these.
+  void RealForwards(double *data,double *scratch) const;
+  //
+  // Run the backwards transformation of the n / 2 + 1 complex
+  // coefficients of the non-negative frequencies of a real signal
+  // in place. The array receives the n real numbers. Not
+  // normalized.
+  void RealBackwards(double *data,double *scratch) const;
+};
+///
+
+///
+#endif
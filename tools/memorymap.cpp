@@ -0,0 +1,241 @@
+/*************************************************************************
+** Written by Thomas Richter (THOR Software) for Accusoft	        **
+** All Rights Reserved							**
+**************************************************************************
+
+This source file is part of difftest_ng, a universal image measuring
+and conversion framework.
+
+    difftest_ng is free software: you can redistribute it and/or modify
+    it under the terms of the GNU General Public License as published by
+    the Free Software Foundation, either version 3 of the License, or
+    (at your option) any later version.
+
+    difftest_ng is distributed in the hope that it will be useful,
+    but WITHOUT ANY WARRANTY; without even the implied warranty of
+    MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+    GNU General Public License for more details.
+
+    You should have received a copy of the GNU General Public License
+    along with difftest_ng.  If not, see <http://www.gnu.org/licenses/>.
+
+*************************************************************************/
+
+/*
+**
+** A private, copy-on-write mapping of a complete file into memory.
+**
+** $Id$
+**
+*/
+
+/// Includes
+#include "tools/memorymap.hpp"
+#include "tools/threadpool.hpp"
+#include "tools/profile.hpp"
+#include "std/assert.hpp"
+#include "std/string.hpp"
+#include "std/unistd.hpp"
+#if defined(_POSIX_MAPPED_FILES) && _POSIX_MAPPED_FILES > 0
+#include <sys/types.h>
+#include <sys/stat.h>
+#include <sys/mman.h>
+#define USE_MEMORYMAP
+#ifndef MAP_ANONYMOUS
+#define MAP_ANONYMOUS MAP_ANON
+#endif
+#endif
+///
+
+#ifdef USE_MEMORYMAP
+/// class MemoryMapList
+// Keeps all mappings alive such that the mappings of a file can be
+// found before the file is overwritten.
+class MemoryMapList {
+public:
+  //
+  // The first mapping.
+  class MemoryMap *m_pFirst;
+  //
+#ifdef USE_THREADPOOL
+  //
+  // Protects the list as images may be loaded by several threads.
+  pthread_mutex_t m_Mutex;
+#endif
+  //
+  MemoryMapList(void)
+    : m_pFirst(NULL)
+  {
+#ifdef USE_THREADPOOL
+    pthread_mutex_init(&m_Mutex,NULL);
+#endif
+  }
+  //
+  ~MemoryMapList(void)
+  {
+#ifdef USE_THREADPOOL
+    pthread_mutex_destroy(&m_Mutex);
+#endif
+  }
+  //
+  void Lock(void)
+  {
+#ifdef USE_THREADPOOL
+    pthread_mutex_lock(&m_Mutex);
+#endif
+  }
+  //
+  void Unlock(void)
+  {
+#ifdef USE_THREADPOOL
+    pthread_mutex_unlock(&m_Mutex);
+#endif
+  }
+};
+///
+
+/// Statics
+static class MemoryMapList Mappings;
+///
+#endif
+
+/// MemoryMap::~MemoryMap
+MemoryMap::~MemoryMap(void)
+{
+#ifdef USE_MEMORYMAP
+  if (m_pucData) {
+    class MemoryMap **prev;
+    //
+    Mappings.Lock();
+    for(prev = &Mappings.m_pFirst;*prev;prev = &(*prev)->m_pNext) {
+      if (*prev == this) {
+	*prev = m_pNext;
+	break;
+      }
+    }
+    Mappings.Unlock();
+    munmap(m_pucData,size_t(m_uqSize));
+  }
+#endif
+}
+///
+
+/// MemoryMap::Map
+// Map the complete file the stream refers to. Returns false if
+// the file cannot be mapped.
+bool MemoryMap::Map(FILE *file)
+{
+  assert(m_pucData == NULL);
+#ifdef USE_MEMORYMAP
+  struct stat st;
+  void *data;
+  int fd = fileno(file);
+  //
+  if (fd < 0 || fstat(fd,&st) != 0 || !S_ISREG(st.st_mode) || st.st_size <= 0)
+    return false;
+  //
+  // Files that do not fit into the address space are read as usual.
+  if (UQUAD(st.st_size) != UQUAD(size_t(st.st_size)))
+    return false;
+  //
+  // Writable and private such that filters working in place
+  // get their own copy of the pages they touch.
+  data = mmap(NULL,size_t(st.st_size),PROT_READ | PROT_WRITE,MAP_PRIVATE,fd,0);
+  if (data == MAP_FAILED)
+    return false;
+  //
+  m_pucData  = (UBYTE *)data;
+  m_uqSize   = UQUAD(st.st_size);
+  m_uqDevice = UQUAD(st.st_dev);
+  m_uqInode  = UQUAD(st.st_ino);
+  //
+  Mappings.Lock();
+  m_pNext           = Mappings.m_pFirst;
+  Mappings.m_pFirst = this;
+  Mappings.Unlock();
+  //
+  // Pages are otherwise read when first touched, which would
+  // charge the file access to whatever touches them first.
+  if (Profile::isActive())
+    Prefault();
+  return true;
+#else
+  (void)file;
+  return false;
+#endif
+}
+///
+
+/// MemoryMap::Prefault
+// Read all pages of the mapping in from the file.
+void MemoryMap::Prefault(void)
+{
+#ifdef USE_MEMORYMAP
+  const volatile UBYTE *data = m_pucData;
+  long pagesize              = sysconf(_SC_PAGESIZE);
+  size_t step                = (pagesize > 0)?(size_t(pagesize)):(4096);
+  size_t size                = size_t(m_uqSize);
+  size_t offset;
+  UBYTE sum                  = 0;
+  //
+  // Reading suffices, written pages are copied on demand anyhow.
+  for(offset = 0;offset < size;offset += step)
+    sum ^= data[offset];
+  (void)sum;
+#endif
+}
+///
+
+/// MemoryMap::Detach
+// Replace the pages of the mapping by anonymous memory holding
+// the same data, at the same address.
+void MemoryMap::Detach(void)
+{
+#ifdef USE_MEMORYMAP
+  size_t size = size_t(m_uqSize);
+  void *copy  = mmap(NULL,size,PROT_READ | PROT_WRITE,MAP_PRIVATE | MAP_ANONYMOUS,-1,0);
+  //
+  if (copy == MAP_FAILED)
+    throw "out of memory, cannot detach an image from the file it is about to overwrite";
+  //
+  memcpy(copy,m_pucData,size);
+  if (mmap(m_pucData,size,PROT_READ | PROT_WRITE,MAP_PRIVATE | MAP_ANONYMOUS | MAP_FIXED,-1,0) == MAP_FAILED) {
+    munmap(copy,size);
+    throw "failed to detach an image from the file it is about to overwrite";
+  }
+  memcpy(m_pucData,copy,size);
+  munmap(copy,size);
+  //
+  m_bDetached = true;
+#endif
+}
+///
+
+/// MemoryMap::DetachFile
+// Detach all mappings of the named file from it such that it can be
+// overwritten. Does nothing if the file does not exist or is not mapped.
+void MemoryMap::DetachFile(const char *filename)
+{
+#ifdef USE_MEMORYMAP
+  struct stat st;
+  class MemoryMap *map;
+  //
+  if (stat(filename,&st) != 0)
+    return;
+  //
+  Mappings.Lock();
+  try {
+    for(map = Mappings.m_pFirst;map;map = map->m_pNext) {
+      if (!map->m_bDetached && map->m_uqDevice == UQUAD(st.st_dev) && map->m_uqInode == UQUAD(st.st_ino))
+	map->Detach();
+    }
+  } catch(...) {
+    Mappings.Unlock();
+    throw;
+  }
+  Mappings.Unlock();
+#else
+  (void)filename;
+#endif
+}
+///
@@ -0,0 +1,132 @@
+/*************************************************************************
+** Written by Thomas Richter (THOR Software) for Accusoft	        **
+** All Rights Reserved							**
+**************************************************************************
+
+This source file is part of difftest_ng, a universal image measuring
+and conversion framework.
+
+    difftest_ng is free software: you can redistribute it and/or modify
+    it under the terms of the GNU General Public License as published by
+    the Free Software Foundation, either version 3 of the License, or
+    (at your option) any later version.
+
+    difftest_ng is distributed in the hope that it will be useful,
+    but WITHOUT ANY WARRANTY; without even the implied warranty of
+    MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+    GNU General Public License for more details.
+
+    You should have received a copy of the GNU General Public License
+    along with difftest_ng.  If not, see <http://www.gnu.org/licenses/>.
+
+*************************************************************************/
+
+/*
+**
+** A private, copy-on-write mapping of a complete file into memory.
+** Loaders of uncompressed formats point the component layout directly
+** into the mapping instead of copying the samples. Modifications of
+** the image go to private pages and never reach the file. If the
+** system cannot map files, mapping simply fails and the loaders
+** fall back to reading the data. As pages not yet touched are still
+** read from the file, the mappings of a file are detached from it
+** before it is overwritten. While profiling, all pages are read in
+** when the file is mapped such that the time spent on reading the
+** file is attributed to loading the image, not to the first filter
+** touching the samples.
+**
+** $Id$
+**
+*/
+
+#ifndef TOOLS_MEMORYMAP_HPP
+#define TOOLS_MEMORYMAP_HPP
+
+/// Includes
+#include "interface/types.hpp"
+#include "std/stdio.hpp"
+///
+
+/// Class MemoryMap
+class MemoryMap {
+  //
+  // The next mapping of all mappings currently alive.
+  class MemoryMap *m_pNext;
+  //
+  // Start of the mapping, or NULL if nothing is mapped.
+  UBYTE *m_pucData;
+  //
+  // Size of the mapping in bytes, identical to the file size.
+  UQUAD  m_uqSize;
+  //
+  // Device and inode of the mapped file, identifying the file
+  // regardless of its name.
+  UQUAD  m_uqDevice;
+  UQUAD  m_uqInode;
+  //
+  // Set if the mapping has been detached from the file and is
+  // backed by memory of its own.
+  bool   m_bDetached;
+  //
+  // Replace the pages of the mapping by anonymous memory holding
+  // the same data, at the same address.
+  void Detach(void);
+  //
+  // Read all pages of the mapping in from the file.
+  void Prefault(void);
+  //
+public:
+  MemoryMap(void)
+    : m_pNext(NULL), m_pucData(NULL), m_uqSize(0), m_uqDevice(0), m_uqInode(0),
+      m_bDetached(false)
+  {
+  }
+  //
+  ~MemoryMap(void);
+  //
+  // Map the complete file the stream refers to. Returns false if
+  // the file cannot be mapped, e.g. because it is not a regular file,
+  // is empty or the system does not support mappings.
+  bool Map(FILE *file);
+  //
+  // Detach all mappings of the named file from it such that it can be
+  // overwritten, which would otherwise pull the samples away under the
+  // images referring to them. Savers call this before opening their
+  // target. Does nothing if the file does not exist or is not mapped.
+  static void DetachFile(const char *filename);
+  //
+  // Return the start of the mapping.
+  UBYTE *DataOf(void) const
+  {
+    return m_pucData;
+  }
+  //
+  // Return the size of the mapping in bytes.
+  UQUAD SizeOf(void) const
+  {
+    return m_uqSize;
+  }
+  //
+  // Return a pointer to size bytes at the given offset of the mapping
+  // if they are all within the file and the offset is a multiple of
+  // the alignment. Returns NULL otherwise.
+  UBYTE *RangeOf(UQUAD offset,UQUAD size,ULONG align = 1) const
+  {
+    if (m_pucData == NULL || offset % align != 0 ||
+	offset > m_uqSize || size > m_uqSize - offset)
+      return NULL;
+    return m_pucData + offset;
+  }
+  //
+  // Return true if the host stores multi-byte samples little endian.
+  static bool isLittleEndian(void)
+  {
+    const UWORD probe = 1;
+
+    return *(const UBYTE *)&probe == 1;
+  }
+};
+///
+
+///
+#endif
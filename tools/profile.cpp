@@ -0,0 +1,179 @@
+/*************************************************************************
+** Written by Thomas Richter (THOR Software) for Accusoft	        **
+** All Rights Reserved							**
+**************************************************************************
+
+This source file is part of difftest_ng, a universal image measuring
+and conversion framework.
+
+    difftest_ng is free software: you can redistribute it and/or modify
+    it under the terms of the GNU General Public License as published by
+    the Free Software Foundation, either version 3 of the License, or
+    (at your option) any later version.
+
+    difftest_ng is distributed in the hope that it will be useful,
+    but WITHOUT ANY WARRANTY; without even the implied warranty of
+    MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+    GNU General Public License for more details.
+
+    You should have received a copy of the GNU General Public License
+    along with difftest_ng.  If not, see <http://www.gnu.org/licenses/>.
+
+*************************************************************************/
+
+/*
+**
+** Collects the time, the number of samples touched and the growth of
+** the peak memory use of the stages of a run.
+**
+** $Id$
+**
+*/
+
+/// Includes
+#include "tools/profile.hpp"
+#include "tools/timer.hpp"
+#include "std/string.hpp"
+#include "std/unistd.hpp"
+#if defined(_POSIX_VERSION)
+#include <sys/resource.h>
+#define USE_GETRUSAGE
+#endif
+///
+
+/// Profile::m_pActive
+// The profile probes report to.
+class Profile *Profile::m_pActive = NULL;
+///
+
+/// Profile::Profile
+// Create a profile and make it the active one.
+Profile::Profile(void)
+  : m_pStages(NULL), m_ppLastStage(&m_pStages)
+{
+  m_pActive = this;
+}
+///
+
+/// Profile::~Profile
+Profile::~Profile(void)
+{
+  struct Stage *stage;
+
+  if (m_pActive == this)
+    m_pActive = NULL;
+
+  while((stage = m_pStages)) {
+    m_pStages = stage->m_pNext;
+    delete stage;
+  }
+}
+///
+
+/// Profile::PeakResidentOf
+// Return the peak resident set size of the process in kilobytes,
+// zero if unknown.
+UQUAD Profile::PeakResidentOf(void)
+{
+#ifdef USE_GETRUSAGE
+  struct rusage usage;
+
+  if (getrusage(RUSAGE_SELF,&usage) == 0 && usage.ru_maxrss > 0) {
+#ifdef __APPLE__
+    // Darwin counts bytes.
+    return UQUAD(usage.ru_maxrss) >> 10;
+#else
+    return UQUAD(usage.ru_maxrss);
+#endif
+  }
+#endif
+  return 0;
+}
+///
+
+/// Profile::AddStage
+// Add the measurements of a stage, combine them with those of an
+// earlier stage of the same name and detail.
+void Profile::AddStage(const char *name,const char *detail,double seconds,
+		       UQUAD samples,UQUAD bytes,UQUAD peakgrowth)
+{
+  struct Stage *stage;
+
+  if (detail == NULL)
+    detail = "";
+
+  for(stage = m_pStages;stage;stage = stage->m_pNext) {
+    if (!strcmp(stage->m_pcName,name) && !strcmp(stage->m_pcDetail,detail))
+      break;
+  }
+
+  if (stage == NULL) {
+    stage = new struct Stage;
+    stage->m_pcName       = name;
+    stage->m_ulCalls      = 0;
+    stage->m_dSeconds     = 0.0;
+    stage->m_uqSamples    = 0;
+    stage->m_uqBytes      = 0;
+    stage->m_uqPeakGrowth = 0;
+    try {
+      stage->m_pcDetail   = new char[strlen(detail) + 1];
+    } catch(...) {
+      delete stage;
+      throw;
+    }
+    strcpy(stage->m_pcDetail,detail);
+    *m_ppLastStage = stage;
+    m_ppLastStage  = &stage->m_pNext;
+  }
+
+  stage->m_ulCalls++;
+  stage->m_dSeconds     += seconds;
+  stage->m_uqSamples    += samples;
+  stage->m_uqBytes      += bytes;
+  stage->m_uqPeakGrowth += peakgrowth;
+}
+///
+
+/// Profile::Probe::Probe
+Profile::Probe::Probe(void)
+  : m_pProfile(m_pActive), m_dStart(0.0), m_uqPeak(0)
+{
+  if (m_pProfile) {
+    m_uqPeak = PeakResidentOf();
+    m_dStart = Timer::Now();
+  }
+}
+///
+
+/// Profile::Probe::Record
+// Record the stage the probe measured since its creation.
+void Profile::Probe::Record(const char *name,const char *detail,UQUAD samples,UQUAD bytes)
+{
+  if (m_pProfile) {
+    double seconds = Timer::Now() - m_dStart;
+    UQUAD  peak    = PeakResidentOf();
+    //
+    m_pProfile->AddStage(name,detail,seconds,samples,bytes,(peak > m_uqPeak)?(peak - m_uqPeak):(0));
+  }
+}
+///
+
+/// Profile::Print
+// Print all stages as a table.
+void Profile::Print(FILE *out) const
+{
+  const struct Stage *stage;
+
+  fprintf(out,"%-16s %6s %10s %10s %10s %10s  %s\n",
+	  "stage","calls","seconds","Msamples","MB/s","+peak MB","detail");
+
+  for(stage = m_pStages;stage;stage = stage->m_pNext) {
+    double mbs = 0.0;
+    if (stage->m_dSeconds > 0.0)
+      mbs = stage->m_uqBytes / (stage->m_dSeconds * 1024.0 * 1024.0);
+    fprintf(out,"%-16s %6lu %10.4f %10.3f %10.1f %10.1f  %s\n",
+	    stage->m_pcName,(unsigned long)stage->m_ulCalls,stage->m_dSeconds,
+	    stage->m_uqSamples * 1e-6,mbs,stage->m_uqPeakGrowth / 1024.0,stage->m_pcDetail);
+  }
+}
+///
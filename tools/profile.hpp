@@ -0,0 +1,128 @@
+/*************************************************************************
+** Written by Thomas Richter (THOR Software) for Accusoft	        **
+** All Rights Reserved							**
+**************************************************************************
+
+This source file is part of difftest_ng, a universal image measuring
+and conversion framework.
+
+    difftest_ng is free software: you can redistribute it and/or modify
+    it under the terms of the GNU General Public License as published by
+    the Free Software Foundation, either version 3 of the License, or
+    (at your option) any later version.
+
+    difftest_ng is distributed in the hope that it will be useful,
+    but WITHOUT ANY WARRANTY; without even the implied warranty of
+    MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+    GNU General Public License for more details.
+
+    You should have received a copy of the GNU General Public License
+    along with difftest_ng.  If not, see <http://www.gnu.org/licenses/>.
+
+*************************************************************************/
+
+/*
+**
+** Collects the time, the number of samples touched and the growth of
+** the peak memory use of the stages of a run: loading and saving images,
+** copying them and running the meters on them. Stages of the same name
+** and detail are combined. Profiling is enabled by creating a Profile,
+** which installs itself as the active profile. Without an active
+** profile, probes cost a single pointer test.
+**
+** $Id$
+**
+*/
+
+#ifndef TOOLS_PROFILE_HPP
+#define TOOLS_PROFILE_HPP
+
+/// Includes
+#include "interface/types.hpp"
+#include "std/stdio.hpp"
+///
+
+/// Class Profile
+class Profile {
+  //
+  // A stage of the run, or all stages of the same name and detail.
+  struct Stage {
+    struct Stage *m_pNext;
+    //
+    // What ran, and on what. The name must remain valid while the
+    // profile exists, the detail is copied.
+    const char   *m_pcName;
+    char         *m_pcDetail;
+    //
+    // How often the stage ran.
+    ULONG         m_ulCalls;
+    //
+    // The seconds it took in total.
+    double        m_dSeconds;
+    //
+    // The number of samples and bytes of sample data touched.
+    UQUAD         m_uqSamples;
+    UQUAD         m_uqBytes;
+    //
+    // The growth of the peak resident set size in kilobytes.
+    UQUAD         m_uqPeakGrowth;
+    //
+    Stage(void)
+      : m_pNext(NULL), m_pcDetail(NULL)
+    { }
+    //
+    ~Stage(void)
+    {
+      delete[] m_pcDetail;
+    }
+  }                    *m_pStages,**m_ppLastStage;
+  //
+  // The profile probes report to, NULL if not profiling.
+  static class Profile *m_pActive;
+  //
+  // Add the measurements of a stage.
+  void AddStage(const char *name,const char *detail,double seconds,
+		UQUAD samples,UQUAD bytes,UQUAD peakgrowth);
+  //
+public:
+  //
+  // Measures a single stage if profiling is active.
+  class Probe {
+    //
+    // The profile to report to, NULL if not profiling.
+    class Profile *m_pProfile;
+    //
+    // Time and peak resident set size when the probe was created.
+    double         m_dStart;
+    UQUAD          m_uqPeak;
+    //
+  public:
+    Probe(void);
+    //
+    // Record the stage the probe measured since its creation. The
+    // name must remain valid as long as the profile.
+    void Record(const char *name,const char *detail,UQUAD samples,UQUAD bytes);
+  };
+  //
+  // Create a profile and make it the active one.
+  Profile(void);
+  //
+  ~Profile(void);
+  //
+  // Return true if a profile is active.
+  static bool isActive(void)
+  {
+    return m_pActive != NULL;
+  }
+  //
+  // Return the peak resident set size of the process in kilobytes,
+  // zero if unknown.
+  static UQUAD PeakResidentOf(void);
+  //
+  // Print all stages as a table.
+  void Print(FILE *out) const;
+};
+///
+
+///
+#endif
@@ -0,0 +1,315 @@
+/*************************************************************************
+** Written by Thomas Richter (THOR Software) for Accusoft	        **
+** All Rights Reserved							**
+**************************************************************************
+
+This source file is part of difftest_ng, a universal image measuring
+and conversion framework.
+
+    difftest_ng is free software: you can redistribute it and/or modify
+    it under the terms of the GNU General Public License as published by
+    the Free Software Foundation, either version 3 of the License, or
+    (at your option) any later version.
+
+    difftest_ng is distributed in the hope that it will be useful,
+    but WITHOUT ANY WARRANTY; without even the implied warranty of
+    MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+    GNU General Public License for more details.
+
+    You should have received a copy of the GNU General Public License
+    along with difftest_ng.  If not, see <http://www.gnu.org/licenses/>.
+
+*************************************************************************/
+
+/*
+**
+** Vectorized sums of squared and absolute differences of contiguous
+** 8 and 16 bit integer samples. The sums are accumulated in 64 bit
+** integers and hence exact. The instruction set (SSE2, AVX2 or
+** AVX-512) is selected at runtime, with a plain C fallback.
+**
+** $Id$
+**
+*/
+
+/// Includes
+#include "tools/simddiff.hpp"
+#if defined(__GNUC__) && (__GNUC__ >= 5 || defined(__clang__)) && (defined(__x86_64__) || defined(__i386__))
+#include <immintrin.h>
+#define USE_X86_SIMD
+#endif
+///
+
+/// Statics
+int SIMDDiff::m_iLevel = -1;
+///
+
+/// SIMDDiff::Detect
+// Detect the instruction set to use.
+int SIMDDiff::Detect(void)
+{
+#ifdef USE_X86_SIMD
+  __builtin_cpu_init();
+  if (__builtin_cpu_supports("avx512bw"))
+    return AVX512;
+  if (__builtin_cpu_supports("avx2"))
+    return AVX2;
+  if (__builtin_cpu_supports("sse2"))
+    return SSE2;
+#endif
+  return Scalar;
+}
+///
+
+/// ScalarDiff
+// The fallback for machines without vector units, and for the
+// samples at the end of a row that do not fill a vector.
+template<typename T>
+static void ScalarDiff(const T *org,const T *dst,ULONG n,UQUAD &square,UQUAD &absolute)
+{
+  UQUAD sq = 0,ab = 0;
+  ULONG i;
+
+  for(i = 0;i < n;i++) {
+    LONG  d  = LONG(org[i]) - LONG(dst[i]);
+    UQUAD ad = (d < 0)?(-d):(d);
+    sq += ad * ad;
+    ab += ad;
+  }
+
+  square   += sq;
+  absolute += ab;
+}
+///
+
+#ifdef USE_X86_SIMD
+/// Vector kernels
+// The kernels for the three vector widths are identical up to the names
+// of the intrinsics, hence they are generated from the following macros.
+// Each of them processes all full vectors of the row and returns the
+// number of samples done. The bias maps signed samples to unsigned ones,
+// which does not change the differences.
+//
+// The unmasked 32 bit unpacks of AVX-512 pass an undefined vector
+// through which GCC reports as uninitialized, hence the zero-masked
+// forms with a full mask are used there. They are otherwise identical.
+#define UNPACKLO32_mm(a,b)     _mm_unpacklo_epi32(a,b)
+#define UNPACKHI32_mm(a,b)     _mm_unpackhi_epi32(a,b)
+#define UNPACKLO32_mm256(a,b)  _mm256_unpacklo_epi32(a,b)
+#define UNPACKHI32_mm256(a,b)  _mm256_unpackhi_epi32(a,b)
+#define UNPACKLO32_mm512(a,b)  _mm512_maskz_unpacklo_epi32(0xffff,a,b)
+#define UNPACKHI32_mm512(a,b)  _mm512_maskz_unpackhi_epi32(0xffff,a,b)
+//
+// 8 bit samples: Differences fit into 16 bits, their squares are
+// summed pairwise by madd into 32 bit lanes which are flushed into
+// 64 bit lanes before they can overflow. The absolute differences are
+// summed by sad directly into 64 bit lanes.
+#define DIFF8_KERNEL(name,isa,vec,pfx,si,lanes)			\
+__attribute__((target(isa)))						\
+static ULONG name(const UBYTE *org,const UBYTE *dst,ULONG n,UBYTE bias,	\
+		  UQUAD &square,UQUAD &absolute)			\
+{									\
+  const vec zero = pfx##_setzero_##si();				\
+  const vec flip = pfx##_set1_epi8(char(bias));				\
+  vec sq64       = zero;						\
+  vec ab64       = zero;						\
+  UQUAD out[lanes / 8];							\
+  ULONG i = 0,k;							\
+									\
+  while(n - i >= lanes) {						\
+    ULONG blocks = (n - i) / lanes;					\
+    vec   sq32   = zero;						\
+    if (blocks > 4096)							\
+      blocks = 4096;							\
+    do {								\
+      vec a  = pfx##_xor_##si(pfx##_loadu_##si((const vec *)(org + i)),flip); \
+      vec b  = pfx##_xor_##si(pfx##_loadu_##si((const vec *)(dst + i)),flip); \
+      vec d0 = pfx##_sub_epi16(pfx##_unpacklo_epi8(a,zero),pfx##_unpacklo_epi8(b,zero)); \
+      vec d1 = pfx##_sub_epi16(pfx##_unpackhi_epi8(a,zero),pfx##_unpackhi_epi8(b,zero)); \
+      sq32   = pfx##_add_epi32(sq32,pfx##_add_epi32(pfx##_madd_epi16(d0,d0), \
+						    pfx##_madd_epi16(d1,d1))); \
+      ab64   = pfx##_add_epi64(ab64,pfx##_sad_epu8(a,b));		\
+      i     += lanes;							\
+    } while(--blocks);							\
+    sq64 = pfx##_add_epi64(sq64,UNPACKLO32##pfx(sq32,zero));	\
+    sq64 = pfx##_add_epi64(sq64,UNPACKHI32##pfx(sq32,zero));	\
+  }									\
+									\
+  pfx##_storeu_##si((vec *)out,sq64);					\
+  for(k = 0;k < lanes / 8;k++)						\
+    square += out[k];							\
+  pfx##_storeu_##si((vec *)out,ab64);					\
+  for(k = 0;k < lanes / 8;k++)						\
+    absolute += out[k];							\
+									\
+  return i;								\
+}
+//
+// 16 bit samples: The absolute differences are formed by saturated
+// subtraction, and their squares as full 32 bit products from the low
+// and high halves of the 16 bit multiplication. These are widened to
+// 64 bits immediately. The absolute differences are summed in 32 bit
+// lanes and flushed before they can overflow.
+#define DIFF16_KERNEL(name,isa,vec,pfx,si,lanes)			\
+__attribute__((target(isa)))						\
+static ULONG name(const UWORD *org,const UWORD *dst,ULONG n,UWORD bias,	\
+		  UQUAD &square,UQUAD &absolute)			\
+{									\
+  const vec zero = pfx##_setzero_##si();				\
+  const vec flip = pfx##_set1_epi16(short(bias));			\
+  vec sq64       = zero;						\
+  vec ab64       = zero;						\
+  UQUAD out[lanes / 4];							\
+  ULONG i = 0,k;							\
+									\
+  while(n - i >= lanes) {						\
+    ULONG blocks = (n - i) / lanes;					\
+    vec   ab32   = zero;						\
+    if (blocks > 8192)							\
+      blocks = 8192;							\
+    do {								\
+      vec a  = pfx##_xor_##si(pfx##_loadu_##si((const vec *)(org + i)),flip); \
+      vec b  = pfx##_xor_##si(pfx##_loadu_##si((const vec *)(dst + i)),flip); \
+      vec ad = pfx##_or_##si(pfx##_subs_epu16(a,b),pfx##_subs_epu16(b,a)); \
+      vec lo = pfx##_mullo_epi16(ad,ad);				\
+      vec hi = pfx##_mulhi_epu16(ad,ad);				\
+      vec p0 = pfx##_unpacklo_epi16(lo,hi);				\
+      vec p1 = pfx##_unpackhi_epi16(lo,hi);				\
+      sq64   = pfx##_add_epi64(sq64,UNPACKLO32##pfx(p0,zero));	\
+      sq64   = pfx##_add_epi64(sq64,UNPACKHI32##pfx(p0,zero));	\
+      sq64   = pfx##_add_epi64(sq64,UNPACKLO32##pfx(p1,zero));	\
+      sq64   = pfx##_add_epi64(sq64,UNPACKHI32##pfx(p1,zero));	\
+      ab32   = pfx##_add_epi32(ab32,pfx##_unpacklo_epi16(ad,zero));	\
+      ab32   = pfx##_add_epi32(ab32,pfx##_unpackhi_epi16(ad,zero));	\
+      i     += lanes;							\
+    } while(--blocks);							\
+    ab64 = pfx##_add_epi64(ab64,UNPACKLO32##pfx(ab32,zero));	\
+    ab64 = pfx##_add_epi64(ab64,UNPACKHI32##pfx(ab32,zero));	\
+  }									\
+									\
+  pfx##_storeu_##si((vec *)out,sq64);					\
+  for(k = 0;k < lanes / 4;k++)						\
+    square += out[k];							\
+  pfx##_storeu_##si((vec *)out,ab64);					\
+  for(k = 0;k < lanes / 4;k++)						\
+    absolute += out[k];							\
+									\
+  return i;								\
+}
+
+DIFF8_KERNEL(Diff8SSE2,"sse2",__m128i,_mm,si128,16)
+DIFF8_KERNEL(Diff8AVX2,"avx2",__m256i,_mm256,si256,32)
+DIFF8_KERNEL(Diff8AVX512,"avx512f,avx512bw",__m512i,_mm512,si512,64)
+DIFF16_KERNEL(Diff16SSE2,"sse2",__m128i,_mm,si128,8)
+DIFF16_KERNEL(Diff16AVX2,"avx2",__m256i,_mm256,si256,16)
+DIFF16_KERNEL(Diff16AVX512,"avx512f,avx512bw",__m512i,_mm512,si512,32)
+///
+#endif
+
+/// SIMDDiff::Accumulate
+// Add the sum of the squared and absolute differences of n 8 bit
+// unsigned samples to square and absolute.
+void SIMDDiff::Accumulate(const UBYTE *org,const UBYTE *dst,ULONG n,UQUAD &square,UQUAD &absolute)
+{
+  ULONG done = 0;
+
+#ifdef USE_X86_SIMD
+  switch(LevelOf()) {
+  case AVX512:
+    done = Diff8AVX512(org,dst,n,0x00,square,absolute);
+    break;
+  case AVX2:
+    done = Diff8AVX2(org,dst,n,0x00,square,absolute);
+    break;
+  case SSE2:
+    done = Diff8SSE2(org,dst,n,0x00,square,absolute);
+    break;
+  case Scalar:
+    break;
+  }
+#endif
+
+  ScalarDiff(org + done,dst + done,n - done,square,absolute);
+}
+///
+
+/// SIMDDiff::Accumulate
+// Add the sum of the squared and absolute differences of n 8 bit
+// signed samples to square and absolute.
+void SIMDDiff::Accumulate(const BYTE *org,const BYTE *dst,ULONG n,UQUAD &square,UQUAD &absolute)
+{
+  ULONG done = 0;
+
+#ifdef USE_X86_SIMD
+  switch(LevelOf()) {
+  case AVX512:
+    done = Diff8AVX512((const UBYTE *)org,(const UBYTE *)dst,n,0x80,square,absolute);
+    break;
+  case AVX2:
+    done = Diff8AVX2((const UBYTE *)org,(const UBYTE *)dst,n,0x80,square,absolute);
+    break;
+  case SSE2:
+    done = Diff8SSE2((const UBYTE *)org,(const UBYTE *)dst,n,0x80,square,absolute);
+    break;
+  case Scalar:
+    break;
+  }
+#endif
+
+  ScalarDiff(org + done,dst + done,n - done,square,absolute);
+}
+///
+
+/// SIMDDiff::Accumulate
+// Add the sum of the squared and absolute differences of n 16 bit
+// unsigned samples to square and absolute.
+void SIMDDiff::Accumulate(const UWORD *org,const UWORD *dst,ULONG n,UQUAD &square,UQUAD &absolute)
+{
+  ULONG done = 0;
+
+#ifdef USE_X86_SIMD
+  switch(LevelOf()) {
+  case AVX512:
+    done = Diff16AVX512(org,dst,n,0x0000,square,absolute);
+    break;
+  case AVX2:
+    done = Diff16AVX2(org,dst,n,0x0000,square,absolute);
+    break;
+  case SSE2:
+    done = Diff16SSE2(org,dst,n,0x0000,square,absolute);
+    break;
+  case Scalar:
+    break;
+  }
+#endif
+
+  ScalarDiff(org + done,dst + done,n - done,square,absolute);
+}
+///
+
+/// SIMDDiff::Accumulate
+// Add the sum of the squared and absolute differences of n 16 bit
+// signed samples to square and absolute.
+void SIMDDiff::Accumulate(const WORD *org,const WORD *dst,ULONG n,UQUAD &square,UQUAD &absolute)
+{
+  ULONG done = 0;
+
+#ifdef USE_X86_SIMD
+  switch(LevelOf()) {
+  case AVX512:
+    done = Diff16AVX512((const UWORD *)org,(const UWORD *)dst,n,0x8000,square,absolute);
+    break;
+  case AVX2:
+    done = Diff16AVX2((const UWORD *)org,(const UWORD *)dst,n,0x8000,square,absolute);
+    break;
+  case SSE2:
+    done = Diff16SSE2((const UWORD *)org,(const UWORD *)dst,n,0x8000,square,absolute);
+    break;
+  case Scalar:
+    break;
+  }
+#endif
+
+  ScalarDiff(org + done,dst + done,n - done,square,absolute);
+}
+///
@@ -0,0 +1,84 @@
+/*************************************************************************
+** Written by Thomas Richter (THOR Software) for Accusoft	        **
+** All Rights Reserved							**
+**************************************************************************
+
+This source file is part of difftest_ng, a universal image measuring
+and conversion framework.
+
+    difftest_ng is free software: you can redistribute it and/or modify
+    it under the terms of the GNU General Public License as published by
+    the Free Software Foundation, either version 3 of the License, or
+    (at your option) any later version.
+
+    difftest_ng is distributed in the hope that it will be useful,
+    but WITHOUT ANY WARRANTY; without even the implied warranty of
+    MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+    GNU General Public License for more details.
+
+    You should have received a copy of the GNU General Public License
+    along with difftest_ng.  If not, see <http://www.gnu.org/licenses/>.
+
+*************************************************************************/
+
+/*
+**
+** Vectorized sums of squared and absolute differences of contiguous
+** 8 and 16 bit integer samples. The sums are accumulated in 64 bit
+** integers and hence exact. The instruction set (SSE2, AVX2 or
+** AVX-512) is selected at runtime, with a plain C fallback.
+**
+** $Id$
+**
+*/
+
+#ifndef TOOLS_SIMDDIFF_HPP
+#define TOOLS_SIMDDIFF_HPP
+
+/// Includes
+#include "interface/types.hpp"
+///
+
+/// Class SIMDDiff
+class SIMDDiff {
+  //
+public:
+  //
+  // The available instruction sets.
+  enum Level {
+    Scalar,
+    SSE2,
+    AVX2,
+    AVX512
+  };
+  //
+private:
+  //
+  // The instruction set used, or -1 if not yet detected.
+  static int m_iLevel;
+  //
+  // Detect the instruction set to use.
+  static int Detect(void);
+  //
+public:
+  //
+  // Return the instruction set in use.
+  static Level LevelOf(void)
+  {
+    if (m_iLevel < 0)
+      m_iLevel = Detect();
+
+    return Level(m_iLevel);
+  }
+  //
+  // Add the sum of the squared differences and the sum of the absolute
+  // differences of n samples to square and absolute.
+  static void Accumulate(const UBYTE *org,const UBYTE *dst,ULONG n,UQUAD &square,UQUAD &absolute);
+  static void Accumulate(const BYTE  *org,const BYTE  *dst,ULONG n,UQUAD &square,UQUAD &absolute);
+  static void Accumulate(const UWORD *org,const UWORD *dst,ULONG n,UQUAD &square,UQUAD &absolute);
+  static void Accumulate(const WORD  *org,const WORD  *dst,ULONG n,UQUAD &square,UQUAD &absolute);
+};
+///
+
+///
+#endif
@@ -0,0 +1,215 @@
+/*************************************************************************
+** Written by Thomas Richter (THOR Software) for Accusoft	        **
+** All Rights Reserved							**
+**************************************************************************
+
+This source file is part of difftest_ng, a universal image measuring
+and conversion framework.
+
+    difftest_ng is free software: you can redistribute it and/or modify
+    it under the terms of the GNU General Public License as published by
+    the Free Software Foundation, either version 3 of the License, or
+    (at your option) any later version.
+
+    difftest_ng is distributed in the hope that it will be useful,
+    but WITHOUT ANY WARRANTY; without even the implied warranty of
+    MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+    GNU General Public License for more details.
+
+    You should have received a copy of the GNU General Public License
+    along with difftest_ng.  If not, see <http://www.gnu.org/licenses/>.
+
+*************************************************************************/
+
+/*
+**
+** A simple pool of worker threads. A job is split into a number of
+** independent work items which are distributed over the threads. If
+** the build does not support threads, all items run on the calling
+** thread.
+**
+** $Id$
+**
+*/
+
+/// Includes
+#include "tools/threadpool.hpp"
+#include "std/unistd.hpp"
+#include <new>
+///
+
+/// ThreadPool::ThreadPool
+ThreadPool::ThreadPool(ULONG threads)
+  : m_ulThreads(threads)
+{
+  if (m_ulThreads == 0)
+    m_ulThreads = ProcessorsOf();
+#ifdef USE_THREADPOOL
+  m_pThreads     = NULL;
+  m_ulStarted    = 0;
+  m_pJob         = NULL;
+  m_ulNext       = 0;
+  m_ulItems      = 0;
+  m_ulPending    = 0;
+  m_ulGeneration = 0;
+  m_bShutdown    = false;
+  m_pcError      = NULL;
+  //
+  pthread_mutex_init(&m_Mutex,NULL);
+  pthread_cond_init(&m_Wakeup,NULL);
+  pthread_cond_init(&m_Done,NULL);
+  //
+  if (m_ulThreads > 1) {
+    m_pThreads = new pthread_t[m_ulThreads - 1];
+    while(m_ulStarted < m_ulThreads - 1) {
+      if (pthread_create(m_pThreads + m_ulStarted,NULL,&WorkerEntry,this))
+	break; // Run with what we have.
+      m_ulStarted++;
+    }
+  }
+  m_ulThreads = m_ulStarted + 1;
+#else
+  m_ulThreads = 1;
+#endif
+}
+///
+
+/// ThreadPool::~ThreadPool
+ThreadPool::~ThreadPool(void)
+{
+#ifdef USE_THREADPOOL
+  ULONG i;
+
+  pthread_mutex_lock(&m_Mutex);
+  m_bShutdown = true;
+  pthread_cond_broadcast(&m_Wakeup);
+  pthread_mutex_unlock(&m_Mutex);
+  //
+  for(i = 0;i < m_ulStarted;i++) {
+    pthread_join(m_pThreads[i],NULL);
+  }
+  delete[] m_pThreads;
+  //
+  pthread_cond_destroy(&m_Done);
+  pthread_cond_destroy(&m_Wakeup);
+  pthread_mutex_destroy(&m_Mutex);
+#endif
+}
+///
+
+/// ThreadPool::ProcessorsOf
+// Return the number of processors available to the process.
+ULONG ThreadPool::ProcessorsOf(void)
+{
+#if defined(HAVE_SYSCONF) && defined(_SC_NPROCESSORS_ONLN)
+  long n = sysconf(_SC_NPROCESSORS_ONLN);
+  if (n > 0)
+    return n;
+#endif
+  return 1;
+}
+///
+
+#ifdef USE_THREADPOOL
+/// ThreadPool::WorkerEntry
+// Entry point of the workers.
+void *ThreadPool::WorkerEntry(void *pool)
+{
+  ((class ThreadPool *)pool)->Worker();
+
+  return NULL;
+}
+///
+
+/// ThreadPool::Drain
+// Work on the items of the current job until none are left.
+// Must be called with the mutex locked, and returns with the mutex
+// locked.
+void ThreadPool::Drain(class Job *job)
+{
+  while(m_ulNext < m_ulItems) {
+    ULONG item = m_ulNext++;
+    pthread_mutex_unlock(&m_Mutex);
+    //
+    // Errors cannot cross threads, so keep the first one
+    // and let the dispatcher re-throw it.
+    const char *error = NULL;
+    try {
+      job->Run(item);
+    } catch(const char *err) {
+      error = err;
+    } catch(const std::bad_alloc &) {
+      error = "out of memory";
+    } catch(...) {
+      error = "unknown error in worker thread";
+    }
+    //
+    pthread_mutex_lock(&m_Mutex);
+    if (error && m_pcError == NULL)
+      m_pcError = error;
+    if (--m_ulPending == 0)
+      pthread_cond_broadcast(&m_Done);
+  }
+}
+///
+
+/// ThreadPool::Worker
+// Main loop of the workers.
+void ThreadPool::Worker(void)
+{
+  ULONG generation = 0;
+
+  pthread_mutex_lock(&m_Mutex);
+  for(;;) {
+    while(!m_bShutdown && (m_pJob == NULL || generation == m_ulGeneration)) {
+      pthread_cond_wait(&m_Wakeup,&m_Mutex);
+    }
+    if (m_bShutdown)
+      break;
+    generation = m_ulGeneration;
+    Drain(m_pJob);
+  }
+  pthread_mutex_unlock(&m_Mutex);
+}
+///
+#endif
+
+/// ThreadPool::Dispatch
+// Run the items 0..items-1 of the job and return once all of them
+// are done.
+void ThreadPool::Dispatch(class Job *job,ULONG items)
+{
+#ifdef USE_THREADPOOL
+  if (m_ulStarted > 0 && items > 1) {
+    const char *error;
+    //
+    pthread_mutex_lock(&m_Mutex);
+    m_pJob      = job;
+    m_ulNext    = 0;
+    m_ulItems   = items;
+    m_ulPending = items;
+    m_pcError   = NULL;
+    m_ulGeneration++;
+    pthread_cond_broadcast(&m_Wakeup);
+    //
+    // The calling thread helps out.
+    Drain(job);
+    while(m_ulPending > 0) {
+      pthread_cond_wait(&m_Done,&m_Mutex);
+    }
+    m_pJob  = NULL;
+    error   = m_pcError;
+    pthread_mutex_unlock(&m_Mutex);
+    //
+    if (error)
+      throw error;
+    return;
+  }
+#endif
+  ULONG item;
+
+  for(item = 0;item < items;item++) {
+    job->Run(item);
+  }
+}
+///
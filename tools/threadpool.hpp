@@ -0,0 +1,140 @@
+/*************************************************************************
+** Written by Thomas Richter (THOR Software) for Accusoft	        **
+** All Rights Reserved							**
+**************************************************************************
+
+This source file is part of difftest_ng, a universal image measuring
+and conversion framework.
+
+    difftest_ng is free software: you can redistribute it and/or modify
+    it under the terms of the GNU General Public License as published by
+    the Free Software Foundation, either version 3 of the License, or
+    (at your option) any later version.
+
+    difftest_ng is distributed in the hope that it will be useful,
+    but WITHOUT ANY WARRANTY; without even the implied warranty of
+    MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+    GNU General Public License for more details.
+
+    You should have received a copy of the GNU General Public License
+    along with difftest_ng.  If not, see <http://www.gnu.org/licenses/>.
+
+*************************************************************************/
+
+/*
+**
+** A simple pool of worker threads. A job is split into a number of
+** independent work items which are distributed over the threads. If
+** the build does not support threads, all items run on the calling
+** thread.
+**
+** $Id$
+**
+*/
+
+#ifndef TOOLS_THREADPOOL_HPP
+#define TOOLS_THREADPOOL_HPP
+
+/// Includes
+#include "interface/types.hpp"
+#if defined(USE_MULTITHREADING) && defined(HAVE_PTHREAD_H)
+#include <pthread.h>
+#define USE_THREADPOOL
+#endif
+///
+
+/// Class ThreadPool
+class ThreadPool {
+  //
+public:
+  //
+  // A job the pool works on. The job is split into work items
+  // that must be independent of each other.
+  class Job {
+  public:
+    virtual ~Job(void)
+    {
+    }
+    //
+    // Run the work item of the given index.
+    virtual void Run(ULONG item) = 0;
+  };
+  //
+private:
+  //
+  // Number of threads, including the calling thread.
+  ULONG        m_ulThreads;
+  //
+#ifdef USE_THREADPOOL
+  //
+  // The worker threads, one less than the thread count as the
+  // calling thread also works on the items.
+  pthread_t   *m_pThreads;
+  //
+  // Number of worker threads that were actually started.
+  ULONG        m_ulStarted;
+  //
+  // Protects all the state below.
+  pthread_mutex_t m_Mutex;
+  //
+  // Signalled when a new job arrives or the pool shuts down.
+  pthread_cond_t  m_Wakeup;
+  //
+  // Signalled when the last item of the current job is done.
+  pthread_cond_t  m_Done;
+  //
+  // The current job, if any.
+  class Job   *m_pJob;
+  //
+  // The next item to hand out, the number of items in total,
+  // and the number of items not yet completed.
+  ULONG        m_ulNext;
+  ULONG        m_ulItems;
+  ULONG        m_ulPending;
+  //
+  // Incremented for every job such that workers can tell a new
+  // job from the one they just finished.
+  ULONG        m_ulGeneration;
+  //
+  // Set on destruction to terminate the workers.
+  bool         m_bShutdown;
+  //
+  // The first error thrown by a work item, re-thrown by Dispatch.
+  const char  *m_pcError;
+  //
+  // Entry point of the workers.
+  static void *WorkerEntry(void *pool);
+  //
+  // Main loop of the workers.
+  void Worker(void);
+  //
+  // Work on the items of the current job until none are left.
+  // Must be called with the mutex locked.
+  void Drain(class Job *job);
+#endif
+  //
+public:
+  //
+  // Create a pool for the given number of threads. Zero selects
+  // the number of available processors.
+  ThreadPool(ULONG threads);
+  //
+  ~ThreadPool(void);
+  //
+  // Return the number of threads working on a job.
+  ULONG ThreadsOf(void) const
+  {
+    return m_ulThreads;
+  }
+  //
+  // Run the items 0..items-1 of the job and return once all of them
+  // are done. The order in which items run is unspecified.
+  void Dispatch(class Job *job,ULONG items);
+  //
+  // Return the number of processors available to the process.
+  static ULONG ProcessorsOf(void);
+};
+///
+
+///
+#endif
@@ -0,0 +1,72 @@
+/*************************************************************************
+** Written by Thomas Richter (THOR Software) for Accusoft	        **
+** All Rights Reserved							**
+**************************************************************************
+
+This source file is part of difftest_ng, a universal image measuring
+and conversion framework.
+
+    difftest_ng is free software: you can redistribute it and/or modify
+    it under the terms of the GNU General Public License as published by
+    the Free Software Foundation, either version 3 of the License, or
+    (at your option) any later version.
+
+    difftest_ng is distributed in the hope that it will be useful,
+    but WITHOUT ANY WARRANTY; without even the implied warranty of
+    MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+    GNU General Public License for more details.
+
+    You should have received a copy of the GNU General Public License
+    along with difftest_ng.  If not, see <http://www.gnu.org/licenses/>.
+
+*************************************************************************/
+
+/*
+**
+** A simple wall-clock stopwatch for reporting how long the stages of a
+** run took.
+**
+** $Id$
+**
+*/
+
+/// Includes
+#include "tools/timer.hpp"
+#include "config.h"
+#include "std/unistd.hpp"
+#if defined(_POSIX_TIMERS) && _POSIX_TIMERS > 0 && \
+  defined(_POSIX_MONOTONIC_CLOCK) && _POSIX_MONOTONIC_CLOCK >= 0
+#include <time.h>
+#define USE_MONOTONIC
+#elif defined(HAVE_GETTIMEOFDAY) && defined(HAVE_SYS_TIME_H)
+#include <sys/time.h>
+#define USE_GETTIMEOFDAY
+#else
+#include <time.h>
+#endif
+///
+
+/// Timer::Now
+// Return the current wall-clock time in seconds from an arbitrary
+// origin.
+double Timer::Now(void)
+{
+#if defined(USE_MONOTONIC)
+  struct timespec ts;
+  
+  // Not affected by adjustments of the system time.
+  clock_gettime(CLOCK_MONOTONIC,&ts);
+  
+  return double(ts.tv_sec) + double(ts.tv_nsec) * 1e-9;
+#elif defined(USE_GETTIMEOFDAY)
+  struct timeval tv;
+  
+  gettimeofday(&tv,NULL);
+  
+  return double(tv.tv_sec) + double(tv.tv_usec) * 1e-6;
+#else
+  // Wall-clock time on Windows, process time elsewhere.
+  return double(clock()) / CLOCKS_PER_SEC;
+#endif
+}
+///
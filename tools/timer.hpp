@@ -0,0 +1,71 @@
+/*************************************************************************
+** Written by Thomas Richter (THOR Software) for Accusoft	        **
+** All Rights Reserved							**
+**************************************************************************
+
+This source file is part of difftest_ng, a universal image measuring
+and conversion framework.
+
+    difftest_ng is free software: you can redistribute it and/or modify
+    it under the terms of the GNU General Public License as published by
+    the Free Software Foundation, either version 3 of the License, or
+    (at your option) any later version.
+
+    difftest_ng is distributed in the hope that it will be useful,
+    but WITHOUT ANY WARRANTY; without even the implied warranty of
+    MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+    GNU General Public License for more details.
+
+    You should have received a copy of the GNU General Public License
+    along with difftest_ng.  If not, see <http://www.gnu.org/licenses/>.
+
+*************************************************************************/
+
+/*
+**
+** A simple wall-clock stopwatch for reporting how long the stages of a
+** run took.
+**
+** $Id$
+**
+*/
+
+#ifndef TOOLS_TIMER_HPP
+#define TOOLS_TIMER_HPP
+
+/// Includes
+#include "interface/types.hpp"
+///
+
+/// Class Timer
+class Timer {
+  //
+  // The time the stopwatch was started, in seconds.
+  double m_dStart;
+  //
+public:
+  Timer(void)
+    : m_dStart(Now())
+  {
+  }
+  //
+  // Restart the stopwatch.
+  void Start(void)
+  {
+    m_dStart = Now();
+  }
+  //
+  // Return the seconds since the stopwatch was started.
+  double ElapsedOf(void) const
+  {
+    return Now() - m_dStart;
+  }
+  //
+  // Return the current wall-clock time in seconds from an arbitrary
+  // origin.
+  static double Now(void);
+};
+///
+
+///
+#endif